@@ -120,6 +120,49 @@ ActorObserver& currentActorMetrics() {
   return IoContext::current().getActorOrThrow().getMetrics();
 }
 
+void addListReadUnits(size_t cachedReadBytes, size_t uncachedReadBytes, bool completelyCached) {
+  auto& actorMetrics = currentActorMetrics();
+  if (cachedReadBytes || uncachedReadBytes) {
+    size_t totalReadBytes = cachedReadBytes + uncachedReadBytes;
+    uint32_t totalUnits = billingUnits(totalReadBytes);
+
+    // If we went to disk, we want to ensure we bill at least 1 uncached unit.
+    // Otherwise, we disable this behavior, to ensure a fully cached list will have
+    // uncachedUnits == 0.
+    auto billAtLeastOne = completelyCached ? BillAtLeastOne::NO : BillAtLeastOne::YES;
+    uint32_t uncachedUnits = billingUnits(uncachedReadBytes, billAtLeastOne);
+    uint32_t cachedUnits = totalUnits - uncachedUnits;
+
+    actorMetrics.addUncachedStorageReadUnits(uncachedUnits);
+    actorMetrics.addCachedStorageReadUnits(cachedUnits);
+  } else {
+    // We bill 1 uncached read unit if there was no results from the list.
+    actorMetrics.addUncachedStorageReadUnits(1);
+  }
+}
+
+void addGetMultipleReadUnits(
+    uint32_t cachedUnits, uint32_t uncachedUnits, size_t numInputKeys, size_t numResults) {
+  auto& actorMetrics = currentActorMetrics();
+  actorMetrics.addCachedStorageReadUnits(cachedUnits);
+
+  size_t leftoverKeys = 0;
+  if (numInputKeys >= numResults) {
+    leftoverKeys = numInputKeys - numResults;
+  } else {
+    KJ_LOG(ERROR, "More returned pairs than provided input keys in getMultipleResultsToMap",
+        numInputKeys, numResults);
+  }
+
+  // leftover keys weren't in the result set, but potentially still
+  // had to be queried for existence.
+  //
+  // TODO(someday): This isn't quite accurate -- we do cache negative entries.
+  // Billing will still be correct today, but if we do ever start billing
+  // only for uncached reads, we'll need to address this.
+  actorMetrics.addUncachedStorageReadUnits(leftoverKeys + uncachedUnits);
+}
+
 jsg::JsRef<jsg::JsValue> listResultsToMap(
     jsg::Lock& js, ActorCacheOps::GetResultList value, bool completelyCached) {
   return js
@@ -133,25 +176,7 @@ jsg::JsRef<jsg::JsValue> listResultsToMap(
       bytesRef += entry.key.size() + entry.value.size();
       map.set(js, entry.key, deserializeV8Value(js, entry.key, entry.value));
     }
-    auto& actorMetrics = currentActorMetrics();
-    if (cachedReadBytes || uncachedReadBytes) {
-      size_t totalReadBytes = cachedReadBytes + uncachedReadBytes;
-      uint32_t totalUnits = billingUnits(totalReadBytes);
-
-      // If we went to disk, we want to ensure we bill at least 1 uncached unit.
-      // Otherwise, we disable this behavior, to ensure a fully cached list will have
-      // uncachedUnits == 0.
-      auto billAtLeastOne = completelyCached ? BillAtLeastOne::NO : BillAtLeastOne::YES;
-      uint32_t uncachedUnits = billingUnits(uncachedReadBytes, billAtLeastOne);
-      uint32_t cachedUnits = totalUnits - uncachedUnits;
-
-      actorMetrics.addUncachedStorageReadUnits(uncachedUnits);
-      actorMetrics.addCachedStorageReadUnits(cachedUnits);
-    } else {
-      // We bill 1 uncached read unit if there was no results from the list.
-      actorMetrics.addUncachedStorageReadUnits(1);
-    }
-
+    addListReadUnits(cachedReadBytes, uncachedReadBytes, completelyCached);
     return jsg::JsValue(map);
   }).addRef(js);
 }
@@ -170,30 +195,55 @@ getMultipleResultsToMap(size_t numInputKeys) {
         unitsRef += billingUnits(entry.key.size() + entry.value.size());
         map.set(js, entry.key, deserializeV8Value(js, entry.key, entry.value));
       }
-      auto& actorMetrics = currentActorMetrics();
-      actorMetrics.addCachedStorageReadUnits(cachedUnits);
-
-      size_t leftoverKeys = 0;
-      if (numInputKeys >= value.size()) {
-        leftoverKeys = numInputKeys - value.size();
-      } else {
-        KJ_LOG(ERROR, "More returned pairs than provided input keys in getMultipleResultsToMap",
-            numInputKeys, value.size());
-      }
-
-      // leftover keys weren't in the result set, but potentially still
-      // had to be queried for existence.
-      //
-      // TODO(someday): This isn't quite accurate -- we do cache negative entries.
-      // Billing will still be correct today, but if we do ever start billing
-      // only for uncached reads, we'll need to address this.
-      actorMetrics.addUncachedStorageReadUnits(leftoverKeys + uncachedUnits);
-
+      addGetMultipleReadUnits(cachedUnits, uncachedUnits, numInputKeys, value.size());
       return jsg::JsValue(map);
     }).addRef(js);
   };
 }
 
+// Builds the same map as listResultsToMap() or getMultipleResultsToMap(), but from rows handed
+// out by tryListBorrowed() or tryGetBorrowed(), deserializing each value straight out of the
+// storage engine's buffer. `read` makes the borrowed call and returns its result; if it returns
+// false then the cache doesn't support borrowed reads and we return none.
+//
+// Borrowed reads complete synchronously, so rows are billed the same way as the immediately
+// available GetResultList that the cache would otherwise have returned: as uncached, within a
+// completely cached result.
+kj::Maybe<jsg::JsRef<jsg::JsValue>> tryReadBorrowedToMap(jsg::Lock& js,
+    kj::FunctionParam<bool(ActorCacheOps::BorrowedRowCallback)> read,
+    kj::Maybe<size_t> numInputKeys) {
+  return js.withinHandleScope([&]() -> kj::Maybe<jsg::JsRef<jsg::JsValue>> {
+    // Only allocate the map once we know the read is supported.
+    kj::Maybe<jsg::JsMap> maybeMap;
+    auto getMap = [&]() -> jsg::JsMap& {
+      KJ_IF_SOME(map, maybeMap) {
+        return map;
+      }
+      return maybeMap.emplace(js.map());
+    };
+
+    size_t numResults = 0;
+    size_t readBytes = 0;
+    uint32_t readUnits = 0;
+    bool supported = read([&](ActorCacheOps::KeyPtr key, ActorCacheOps::ValuePtr value) {
+      ++numResults;
+      readBytes += key.size() + value.size();
+      readUnits += billingUnits(key.size() + value.size());
+      getMap().set(js, key, deserializeV8Value(js, key, value));
+    });
+    if (!supported) {
+      return kj::none;
+    }
+
+    KJ_IF_SOME(n, numInputKeys) {
+      addGetMultipleReadUnits(0, readUnits, n, numResults);
+    } else {
+      addListReadUnits(0, readBytes, true);
+    }
+    return jsg::JsValue(getMap()).addRef(js);
+  });
+}
+
 kj::Promise<void> updateStorageWriteUnit(
     IoContext& context, ActorObserver& metrics, uint32_t units) {
   // The ActorObserver& reference here is guaranteed to outlive this task, so
@@ -270,7 +320,22 @@ jsg::Promise<jsg::JsRef<jsg::JsValue>> DurableObjectStorageOperations::get(jsg::
 
 jsg::Promise<jsg::JsRef<jsg::JsValue>> DurableObjectStorageOperations::getOne(
     jsg::Lock& js, kj::String key, const GetOptions& options) {
-  auto result = getCache(OP_GET).get(kj::str(key), options);
+  auto& cache = getCache(OP_GET);
+
+  // Try to deserialize the value straight out of the storage engine's buffer. Like any other
+  // immediately available result, this is billed as a cached read.
+  kj::Maybe<jsg::JsValue> borrowedValue;
+  uint32_t borrowedUnits = 1;
+  if (cache.tryGetBorrowed(kj::arrayPtr(&key, 1), options,
+          [&](ActorCacheOps::KeyPtr, ActorCacheOps::ValuePtr value) {
+    borrowedUnits = billingUnits(value.size());
+    borrowedValue = deserializeV8Value(js, key, value);
+  })) {
+    currentActorMetrics().addCachedStorageReadUnits(borrowedUnits);
+    return js.resolvedPromise(kj::mv(borrowedValue).orDefault(js.undefined()).addRef(js));
+  }
+
+  auto result = cache.get(kj::str(key), options);
   return transformCacheResultWithCacheStatus(js, kj::mv(result), options,
       [key = kj::mv(key)](jsg::Lock& js, kj::Maybe<ActorCacheOps::Value> value, bool cached) {
     uint32_t units = 1;
@@ -406,9 +471,16 @@ jsg::Promise<jsg::JsRef<jsg::JsValue>> DurableObjectStorageOperations::list(
   auto options = configureOptions(kj::mv(maybeOptions).orDefault(ListOptions{}));
   ActorCacheOps::ReadOptions readOptions = options;
 
-  auto result = reverse
-      ? getCache(OP_LIST).listReverse(kj::mv(start), kj::mv(end), limit, readOptions)
-      : getCache(OP_LIST).list(kj::mv(start), kj::mv(end), limit, readOptions);
+  auto& cache = getCache(OP_LIST);
+  KJ_IF_SOME(map, tryReadBorrowedToMap(js, [&](ActorCacheOps::BorrowedRowCallback callback) {
+    auto endPtr = end.map([](kj::String& e) -> ActorCacheOps::KeyPtr { return e; });
+    return cache.tryListBorrowed(start, endPtr, limit, reverse, readOptions, callback);
+  }, kj::none)) {
+    return js.resolvedPromise(kj::mv(map));
+  }
+
+  auto result = reverse ? cache.listReverse(kj::mv(start), kj::mv(end), limit, readOptions)
+                        : cache.list(kj::mv(start), kj::mv(end), limit, readOptions);
   return transformCacheResultWithCacheStatus(js, kj::mv(result), options, &listResultsToMap);
 }
 
@@ -554,9 +626,15 @@ jsg::Promise<bool> DurableObjectStorageOperations::deleteOne(
 jsg::Promise<jsg::JsRef<jsg::JsValue>> DurableObjectStorageOperations::getMultiple(
     jsg::Lock& js, kj::Array<kj::String> keys, const GetOptions& options) {
   auto numKeys = keys.size();
+  auto& cache = getCache(OP_GET);
+  KJ_IF_SOME(map, tryReadBorrowedToMap(js, [&](ActorCacheOps::BorrowedRowCallback callback) {
+    return cache.tryGetBorrowed(keys, options, callback);
+  }, numKeys)) {
+    return js.resolvedPromise(kj::mv(map));
+  }
 
   return transformCacheResult(
-      js, getCache(OP_GET).get(kj::mv(keys), options), options, getMultipleResultsToMap(numKeys));
+      js, cache.get(kj::mv(keys), options), options, getMultipleResultsToMap(numKeys));
 }
 
 jsg::Promise<void> DurableObjectStorageOperations::putMultiple(
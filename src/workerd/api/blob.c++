@@ -13,16 +13,36 @@
 namespace workerd::api {
 
 namespace {
-// Concatenate an array of segments (parameter to Blob constructor).
-jsg::BufferSource concat(jsg::Lock& js, jsg::Optional<Blob::Bits> maybeBits) {
-  // TODO(perf): Make it so that a Blob can keep references to the input data rather than copy it.
-  //   Note that we can't keep references to ArrayBuffers since they are mutable, but we can
-  //   reference other Blobs in the input.
+kj::String normalizeType(kj::String type) {
+  // This does not properly parse mime types. We have the new workerd::MimeType impl
+  // but that handles mime types a bit more strictly than this. Ideally we'd be able to
+  // switch over to it but there's a non-zero risk of breaking running code. We might need
+  // a compat flag to switch at some point but for now we'll keep this as it is.
+
+  // https://www.w3.org/TR/FileAPI/#constructorBlob step 3 inexplicably insists that if the
+  // type contains non-printable-ASCII characters we should discard it, and otherwise we should
+  // lower-case it.
+  for (char& c: type) {
+    if (static_cast<signed char>(c) < 0x20) {
+      // Throw it away.
+      return nullptr;
+    } else if ('A' <= c && c <= 'Z') {
+      c = c - 'A' + 'a';
+    }
+  }
+
+  return kj::mv(type);
+}
 
+}  // namespace
+
+kj::OneOf<jsg::BufferSource, kj::Array<Blob::Segment>> Blob::concat(
+    jsg::Lock& js, jsg::Optional<Bits> maybeBits) {
   auto bits = kj::mv(maybeBits).orDefault(nullptr);
 
   auto maxBlobSize = Worker::Isolate::from(js).getLimitEnforcer().getBlobSizeLimit();
   size_t size = 0;
+  bool hasBlobs = false;
   for (auto& part: bits) {
     size_t partSize = 0;
     KJ_SWITCH_ONEOF(part) {
@@ -33,7 +53,8 @@ jsg::BufferSource concat(jsg::Lock& js, jsg::Optional<Blob::Bits> maybeBits) {
         partSize = text.size();
       }
       KJ_CASE_ONEOF(blob, jsg::Ref<Blob>) {
-        partSize = blob->getData().size();
+        partSize = blob->getSize();
+        hasBlobs = true;
       }
     }
 
@@ -57,81 +78,113 @@ jsg::BufferSource concat(jsg::Lock& js, jsg::Optional<Blob::Bits> maybeBits) {
     size += partSize;
   }
 
-  auto backing = jsg::BackingStore::alloc<v8::ArrayBuffer>(js, size);
-  auto result = jsg::BufferSource(js, kj::mv(backing));
-
-  if (size == 0) return kj::mv(result);
+  // Copies the given non-Blob parts into one new buffer. We can't keep references to
+  // ArrayBuffers since they are mutable, and strings have already been converted.
+  using Part = kj::OneOf<kj::Array<const byte>, kj::String, jsg::Ref<Blob>>;
+  auto copyParts = [&](kj::ArrayPtr<const Part> parts, size_t partsSize) {
+    auto backing = jsg::BackingStore::alloc<v8::ArrayBuffer>(js, partsSize);
+    auto result = jsg::BufferSource(js, kj::mv(backing));
+    auto view = result.asArrayPtr();
+    for (auto& part: parts) {
+      kj::ArrayPtr<const byte> bytes;
+      KJ_SWITCH_ONEOF(part) {
+        KJ_CASE_ONEOF(b, kj::Array<const byte>) {
+          bytes = b;
+        }
+        KJ_CASE_ONEOF(text, kj::String) {
+          bytes = text.asBytes();
+        }
+        KJ_CASE_ONEOF(blob, jsg::Ref<Blob>) {
+          KJ_UNREACHABLE;
+        }
+      }
+      KJ_ASSERT(view.size() >= bytes.size());
+      view.first(bytes.size()).copyFrom(bytes);
+      view = view.slice(bytes.size());
+    }
+    KJ_ASSERT(view == nullptr);
+    return result;
+  };
 
-  auto view = result.asArrayPtr();
+  if (!hasBlobs) {
+    return copyParts(bits, size);
+  }
 
-  for (auto& part: bits) {
-    KJ_SWITCH_ONEOF(part) {
+  // Reference the Blobs' bytes rather than copying them. Runs of other parts between them are
+  // copied into a new Blob each.
+  kj::Vector<Segment> segments;
+  size_t runStart = 0;
+  size_t runSize = 0;
+  auto flushRun = [&](size_t runEnd) {
+    if (runSize > 0) {
+      auto owner = js.alloc<Blob>(js, copyParts(bits.slice(runStart, runEnd), runSize), kj::str());
+      auto data = owner->data;
+      segments.add(Segment{kj::mv(owner), data});
+    }
+    runSize = 0;
+  };
+  for (auto i: kj::indices(bits)) {
+    KJ_SWITCH_ONEOF(bits[i]) {
       KJ_CASE_ONEOF(bytes, kj::Array<const byte>) {
-        if (bytes.size() == 0) continue;
-        KJ_ASSERT(view.size() >= bytes.size());
-        view.first(bytes.size()).copyFrom(bytes);
-        view = view.slice(bytes.size());
+        if (runSize == 0) runStart = i;
+        runSize += bytes.size();
       }
       KJ_CASE_ONEOF(text, kj::String) {
-        auto byteLength = text.asBytes().size();
-        if (byteLength == 0) continue;
-        KJ_ASSERT(view.size() >= byteLength);
-        view.first(byteLength).copyFrom(text.asBytes());
-        view = view.slice(byteLength);
+        if (runSize == 0) runStart = i;
+        runSize += text.size();
       }
       KJ_CASE_ONEOF(blob, jsg::Ref<Blob>) {
-        auto data = blob->getData();
-        if (data.size() == 0) continue;
-        KJ_ASSERT(view.size() >= data.size());
-        view.first(data.size()).copyFrom(data);
-        view = view.slice(data.size());
+        flushRun(i);
+        KJ_SWITCH_ONEOF(blob->ownData) {
+          KJ_CASE_ONEOF(parts, kj::Array<Segment>) {
+            // Take the rope's segments, so that ropes never nest.
+            for (auto& segment: parts) {
+              segments.add(Segment{segment.owner.addRef(), segment.data});
+            }
+          }
+          KJ_CASE_ONEOF_DEFAULT {
+            if (blob->size > 0) {
+              auto data = blob->data;
+              segments.add(Segment{kj::mv(blob), data});
+            }
+          }
+        }
       }
     }
   }
+  flushRun(bits.size());
 
-  KJ_ASSERT(view == nullptr);
-
-  return kj::mv(result);
-}
-
-kj::String normalizeType(kj::String type) {
-  // This does not properly parse mime types. We have the new workerd::MimeType impl
-  // but that handles mime types a bit more strictly than this. Ideally we'd be able to
-  // switch over to it but there's a non-zero risk of breaking running code. We might need
-  // a compat flag to switch at some point but for now we'll keep this as it is.
-
-  // https://www.w3.org/TR/FileAPI/#constructorBlob step 3 inexplicably insists that if the
-  // type contains non-printable-ASCII characters we should discard it, and otherwise we should
-  // lower-case it.
-  for (char& c: type) {
-    if (static_cast<signed char>(c) < 0x20) {
-      // Throw it away.
-      return nullptr;
-    } else if ('A' <= c && c <= 'Z') {
-      c = c - 'A' + 'a';
-    }
-  }
-
-  return kj::mv(type);
+  return segments.releaseAsArray();
 }
 
-}  // namespace
-
 Blob::Blob(kj::Array<byte> data, kj::String type)
     : ownData(kj::mv(data)),
       data(ownData.get<kj::Array<kj::byte>>()),
+      size(this->data.size()),
       type(kj::mv(type)) {}
 
 Blob::Blob(jsg::Lock& js, jsg::BufferSource data, kj::String type)
     : ownData(kj::mv(data)),
       data(ownData.get<jsg::BufferSource>().asArrayPtr()),
+      size(this->data.size()),
       type(kj::mv(type)) {}
 
 Blob::Blob(jsg::Ref<Blob> parent, kj::ArrayPtr<const byte> data, kj::String type)
     : ownData(kj::mv(parent)),
       data(data),
+      size(data.size()),
       type(kj::mv(type)) {}
 
+Blob::Blob(kj::Array<Segment> segments, kj::String type): size(0), type(kj::mv(type)) {
+  for (auto& segment: segments) {
+    size += segment.data.size();
+  }
+  if (segments.size() == 1) {
+    data = segments[0].data;
+  }
+  ownData = kj::mv(segments);
+}
+
 jsg::Ref<Blob> Blob::constructor(
     jsg::Lock& js, jsg::Optional<Bits> bits, jsg::Optional<Options> options) {
   kj::String type;  // note: default value is intentionally empty string
@@ -141,45 +194,99 @@ jsg::Ref<Blob> Blob::constructor(
     }
   }
 
-  return js.alloc<Blob>(js, concat(js, kj::mv(bits)), kj::mv(type));
+  KJ_SWITCH_ONEOF(concat(js, kj::mv(bits))) {
+    KJ_CASE_ONEOF(buffer, jsg::BufferSource) {
+      return js.alloc<Blob>(js, kj::mv(buffer), kj::mv(type));
+    }
+    KJ_CASE_ONEOF(segments, kj::Array<Segment>) {
+      return js.alloc<Blob>(kj::mv(segments), kj::mv(type));
+    }
+  }
+  KJ_UNREACHABLE;
 }
 
 kj::ArrayPtr<const byte> Blob::getData() const {
   FeatureObserver::maybeRecordUse(FeatureObserver::Feature::BLOB_GET_DATA);
+  if (data == nullptr && size > 0) {
+    // A rope that hasn't been flattened yet.
+    auto result = kj::heapArray<byte>(size);
+    copyTo(result);
+    data = result;
+    flattened = kj::mv(result);
+  }
   return data;
 }
 
+kj::Array<kj::ArrayPtr<const byte>> Blob::getPieces() const {
+  if (data != nullptr) {
+    return kj::arr(data);
+  }
+  KJ_IF_SOME(segments, ownData.tryGet<kj::Array<Segment>>()) {
+    return KJ_MAP(segment, segments) { return segment.data; };
+  }
+  return nullptr;
+}
+
+void Blob::copyTo(kj::ArrayPtr<byte> dest) const {
+  KJ_ASSERT(dest.size() == size);
+  for (auto piece: getPieces()) {
+    dest.first(piece.size()).copyFrom(piece);
+    dest = dest.slice(piece.size());
+  }
+}
+
 jsg::Ref<Blob> Blob::slice(jsg::Lock& js,
     jsg::Optional<int> maybeStart,
     jsg::Optional<int> maybeEnd,
     jsg::Optional<kj::String> type) {
   int start = maybeStart.orDefault(0);
-  int end = maybeEnd.orDefault(data.size());
+  int end = maybeEnd.orDefault(size);
 
   if (start < 0) {
     // Negative value interpreted as offset from end.
-    start += data.size();
+    start += size;
   }
   // Clamp start to range.
   if (start < 0) {
     start = 0;
-  } else if (start > data.size()) {
-    start = data.size();
+  } else if (start > size) {
+    start = size;
   }
 
   if (end < 0) {
     // Negative value interpreted as offset from end.
-    end += data.size();
+    end += size;
   }
   // Clamp end to range.
   if (end < start) {
     end = start;
-  } else if (end > data.size()) {
-    end = data.size();
+  } else if (end > size) {
+    end = size;
+  }
+
+  auto normalizedType = normalizeType(kj::mv(type).orDefault(nullptr));
+
+  KJ_IF_SOME(segments, ownData.tryGet<kj::Array<Segment>>()) {
+    if (data == nullptr) {
+      // Take the segments that overlap the slice, trimming the first and last, so that slicing a
+      // rope doesn't flatten it.
+      kj::Vector<Segment> result;
+      size_t sliceStart = start;
+      size_t sliceEnd = end;
+      size_t offset = 0;
+      for (auto& segment: segments) {
+        size_t segmentStart = offset;
+        offset += segment.data.size();
+        if (offset <= sliceStart || segmentStart >= sliceEnd) continue;
+        auto from = kj::max(sliceStart, segmentStart) - segmentStart;
+        auto to = kj::min(sliceEnd, offset) - segmentStart;
+        result.add(Segment{segment.owner.addRef(), segment.data.slice(from, to)});
+      }
+      return js.alloc<Blob>(result.releaseAsArray(), kj::mv(normalizedType));
+    }
   }
 
-  return js.alloc<Blob>(
-      JSG_THIS, data.slice(start, end), normalizeType(kj::mv(type).orDefault(nullptr)));
+  return js.alloc<Blob>(JSG_THIS, data.slice(start, end), kj::mv(normalizedType));
 }
 
 jsg::Promise<jsg::BufferSource> Blob::arrayBuffer(jsg::Lock& js) {
@@ -187,8 +294,8 @@ jsg::Promise<jsg::BufferSource> Blob::arrayBuffer(jsg::Lock& js) {
   // We use BufferSource here instead of kj::Array<kj::byte> to ensure that the
   // resulting backing store is associated with the isolate, which is necessary
   // for when we start making use of v8 sandboxing.
-  auto backing = jsg::BackingStore::alloc<v8::ArrayBuffer>(js, data.size());
-  backing.asArrayPtr().copyFrom(data);
+  auto backing = jsg::BackingStore::alloc<v8::ArrayBuffer>(js, size);
+  copyTo(backing.asArrayPtr());
   return js.resolvedPromise(jsg::BufferSource(js, kj::mv(backing)));
 }
 
@@ -196,19 +303,25 @@ jsg::Promise<jsg::BufferSource> Blob::bytes(jsg::Lock& js) {
   // We use BufferSource here instead of kj::Array<kj::byte> to ensure that the
   // resulting backing store is associated with the isolate, which is necessary
   // for when we start making use of v8 sandboxing.
-  auto backing = jsg::BackingStore::alloc<v8::Uint8Array>(js, data.size());
-  backing.asArrayPtr().copyFrom(data);
+  auto backing = jsg::BackingStore::alloc<v8::Uint8Array>(js, size);
+  copyTo(backing.asArrayPtr());
   return js.resolvedPromise(jsg::BufferSource(js, kj::mv(backing)));
 }
 
 jsg::Promise<kj::String> Blob::text(jsg::Lock& js) {
   FeatureObserver::maybeRecordUse(FeatureObserver::Feature::BLOB_AS_TEXT);
-  return js.resolvedPromise(kj::str(data.asChars()));
+  auto result = kj::heapString(size);
+  copyTo(result.asBytes());
+  return js.resolvedPromise(kj::mv(result));
 }
 
 class Blob::BlobInputStream final: public ReadableStreamSource {
  public:
-  BlobInputStream(jsg::Ref<Blob> blob): unread(blob->data), blob(kj::mv(blob)) {}
+  BlobInputStream(jsg::Ref<Blob> blob)
+      : pieces(blob->getPieces()),
+        unread(pieces),
+        remaining(blob->size),
+        blob(kj::mv(blob)) {}
 
   // Attempt to read a maximum of maxBytes from the remaining unread content of the blob
   // into the given buffer. It is the caller's responsibility to ensure that buffer has
@@ -217,32 +330,40 @@ class Blob::BlobInputStream final: public ReadableStreamSource {
   // The buffer must be kept alive by the caller until the returned promise is fulfilled.
   // The returned promise is fulfilled with the actual number of bytes read.
   kj::Promise<size_t> tryRead(void* buffer, size_t minBytes, size_t maxBytes) override {
-    size_t amount = kj::min(maxBytes, unread.size());
-    if (amount > 0) {
-      memcpy(buffer, unread.begin(), amount);
-      unread = unread.slice(amount, unread.size());
+    auto out = kj::arrayPtr(static_cast<byte*>(buffer), maxBytes);
+    size_t total = 0;
+    while (out.size() > 0 && unread.size() > 0) {
+      auto& piece = unread.front();
+      size_t amount = kj::min(out.size(), piece.size());
+      out.first(amount).copyFrom(piece.first(amount));
+      out = out.slice(amount);
+      piece = piece.slice(amount);
+      total += amount;
+      if (piece.size() == 0) unread = unread.slice(1);
     }
-    return amount;
+    remaining -= total;
+    return total;
   }
 
   // Returns the number of bytes remaining to be read for the given encoding if that
   // encoding is supported. This implementation only supports StreamEncoding::IDENTITY.
   kj::Maybe<uint64_t> tryGetLength(StreamEncoding encoding) override {
     if (encoding == StreamEncoding::IDENTITY) {
-      return unread.size();
+      return remaining;
     } else {
       return kj::none;
     }
   }
 
-  // Write all of the remaining unread content of the blob to output.
-  // If end is true, output.end() will be called once the write has been completed.
-  // Importantly, the WritableStreamSink must be kept alive by the caller until the
+  // Write all of the remaining unread content of the blob to output, in a single write of all
+  // the remaining pieces. If end is true, output.end() will be called once the write has been
+  // completed. Importantly, the WritableStreamSink must be kept alive by the caller until the
   // returned promise is fulfilled.
   kj::Promise<DeferredProxy<void>> pumpTo(WritableStreamSink& output, bool end) override {
-    if (unread.size() != 0) {
+    if (remaining != 0) {
       auto promise = output.write(unread);
       unread = nullptr;
+      remaining = 0;
 
       co_await promise;
 
@@ -255,7 +376,9 @@ class Blob::BlobInputStream final: public ReadableStreamSource {
   }
 
  private:
-  kj::ArrayPtr<const byte> unread;
+  kj::Array<kj::ArrayPtr<const byte>> pieces;
+  kj::ArrayPtr<kj::ArrayPtr<const byte>> unread;
+  size_t remaining;
   jsg::Ref<Blob> blob;
 };
 
@@ -277,6 +400,11 @@ File::File(
       name(kj::mv(name)),
       lastModified(lastModified) {}
 
+File::File(kj::Array<Segment> segments, kj::String name, kj::String type, double lastModified)
+    : Blob(kj::mv(segments), kj::mv(type)),
+      name(kj::mv(name)),
+      lastModified(lastModified) {}
+
 File::File(jsg::Ref<Blob> parent,
     kj::ArrayPtr<const byte> data,
     kj::String name,
@@ -304,7 +432,15 @@ jsg::Ref<File> File::constructor(
     lastModified = dateNow();
   }
 
-  return js.alloc<File>(js, concat(js, kj::mv(bits)), kj::mv(name), kj::mv(type), lastModified);
+  KJ_SWITCH_ONEOF(concat(js, kj::mv(bits))) {
+    KJ_CASE_ONEOF(buffer, jsg::BufferSource) {
+      return js.alloc<File>(js, kj::mv(buffer), kj::mv(name), kj::mv(type), lastModified);
+    }
+    KJ_CASE_ONEOF(segments, kj::Array<Segment>) {
+      return js.alloc<File>(kj::mv(segments), kj::mv(name), kj::mv(type), lastModified);
+    }
+  }
+  KJ_UNREACHABLE;
 }
 
 }  // namespace workerd::api
@@ -12,11 +12,26 @@ namespace workerd::api {
 class ReadableStream;
 
 // An implementation of the Web Platform Standard Blob API
+//
+// Since a Blob is immutable, a Blob constructed from other Blobs, or sliced from one, references
+// their bytes rather than copying them. A Blob assembled from several such pieces is a "rope": a
+// list of segments, each a range of bytes owned by some other Blob. Reading a rope (arrayBuffer(),
+// text(), stream()) copies each segment straight to its destination; only getData(), which must
+// return contiguous bytes, flattens it, once.
 class Blob: public jsg::Object {
+ private:
+  struct Segment {
+    jsg::Ref<Blob> owner;
+    kj::ArrayPtr<const byte> data;
+  };
+
  public:
   Blob(jsg::Lock& js, jsg::BufferSource data, kj::String type);
   Blob(jsg::Ref<Blob> parent, kj::ArrayPtr<const byte> data, kj::String type);
+  Blob(kj::Array<Segment> segments, kj::String type);
 
+  // Returns the content as contiguous bytes. For a rope, this copies the segments into a new
+  // buffer the first time it is called; prefer the JS read methods where that matters.
   kj::ArrayPtr<const byte> getData() const KJ_LIFETIMEBOUND;
 
   // ---------------------------------------------------------------------------
@@ -35,7 +50,7 @@ class Blob: public jsg::Object {
       jsg::Lock& js, jsg::Optional<Bits> bits, jsg::Optional<Options> options);
 
   int getSize() const {
-    return data.size();
+    return size;
   }
   kj::StringPtr getType() const {
     return type;
@@ -83,6 +98,14 @@ class Blob: public jsg::Object {
       KJ_CASE_ONEOF(data, kj::Array<kj::byte>) {
         tracker.trackField("ownData", data);
       }
+      KJ_CASE_ONEOF(segments, kj::Array<Segment>) {
+        for (auto& segment: segments) {
+          tracker.trackField("segment", segment.owner);
+        }
+      }
+    }
+    KJ_IF_SOME(f, flattened) {
+      tracker.trackField("flattened", f);
     }
     tracker.trackField("type", type);
   }
@@ -95,10 +118,28 @@ class Blob: public jsg::Object {
   // The Variation that uses kj::Array<kj::byte> only is used only in very
   // specific cases (i.e. the internal fiddle service) where we parse FormData
   // outside of the isolate lock.
-  kj::OneOf<jsg::BufferSource, kj::Array<kj::byte>, jsg::Ref<Blob>> ownData;
-  kj::ArrayPtr<const byte> data;
+  //
+  // A rope holds its segments instead; see the class comment.
+  kj::OneOf<jsg::BufferSource, kj::Array<kj::byte>, jsg::Ref<Blob>, kj::Array<Segment>> ownData;
+
+  // The content, if contiguous. For a rope of more than one segment, this is null until getData()
+  // flattens the rope into `flattened`.
+  mutable kj::ArrayPtr<const byte> data;
+  mutable kj::Maybe<kj::Array<byte>> flattened;
+
+  size_t size;
   kj::String type;
 
+  // Returns the content as a list of contiguous pieces, without flattening.
+  kj::Array<kj::ArrayPtr<const byte>> getPieces() const;
+
+  // Copies the content into `dest`, which must be exactly `size` bytes.
+  void copyTo(kj::ArrayPtr<byte> dest) const;
+
+  // Builds the content of a Blob from the parts passed to the Blob or File constructor.
+  static kj::OneOf<jsg::BufferSource, kj::Array<Segment>> concat(
+      jsg::Lock& js, jsg::Optional<Bits> maybeBits);
+
   void visitForGc(jsg::GcVisitor& visitor) {
     KJ_SWITCH_ONEOF(ownData) {
       KJ_CASE_ONEOF(b, jsg::BufferSource) {
@@ -108,6 +149,11 @@ class Blob: public jsg::Object {
         visitor.visit(b);
       }
       KJ_CASE_ONEOF(b, kj::Array<kj::byte>) {}
+      KJ_CASE_ONEOF(segments, kj::Array<Segment>) {
+        for (auto& segment: segments) {
+          visitor.visit(segment.owner);
+        }
+      }
     }
   }
 
@@ -129,6 +175,7 @@ class File: public Blob {
       kj::String name,
       kj::String type,
       double lastModified);
+  File(kj::Array<Segment> segments, kj::String name, kj::String type, double lastModified);
 
   struct Options {
     jsg::Optional<kj::String> type;
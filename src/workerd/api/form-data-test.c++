@@ -0,0 +1,106 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "form-data.h"
+
+#include <kj/test.h>
+
+namespace workerd::api {
+namespace {
+
+// Records parts as a string like "name|filename|type|data;", for easy comparison.
+class RecordingHandler final: public MultipartParser::Handler {
+ public:
+  kj::Vector<char> record;
+
+  void startPart(kj::StringPtr name,
+      kj::Maybe<kj::StringPtr> filename,
+      kj::Maybe<kj::StringPtr> type) override {
+    record.addAll(kj::str(name, "|", filename.orDefault("-"_kj), "|", type.orDefault("-"_kj), "|"));
+  }
+
+  void partData(kj::ArrayPtr<const kj::byte> data) override {
+    KJ_EXPECT(data.size() > 0);
+    record.addAll(data.asChars());
+  }
+
+  void endPart() override {
+    record.add(';');
+  }
+};
+
+kj::String parseInChunks(kj::StringPtr body, kj::StringPtr boundary, size_t chunkSize) {
+  RecordingHandler handler;
+  MultipartParser parser(boundary, handler);
+  auto input = body.asBytes();
+  while (input.size() > 0) {
+    auto chunk = input.first(kj::min(chunkSize, input.size()));
+    parser.write(chunk);
+    input = input.slice(chunk.size());
+  }
+  parser.end();
+  return kj::str(handler.record.asPtr());
+}
+
+constexpr auto BODY = "preamble\r\n"
+                      "--xyzzy\r\n"
+                      "Content-Disposition: form-data; name=\"field\"\r\n"
+                      "\r\n"
+                      "value with --xyzz and \r\n-- in it\r\n"
+                      "--xyzzy\n"
+                      "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\n"
+                      "Content-Type: text/plain\n"
+                      "\n"
+                      "file\ncontents\n"
+                      "--xyzzy\r\n"
+                      "Content-Disposition: form-data; name=\"empty\"\r\n"
+                      "\r\n"
+                      "\r\n"
+                      "--xyzzy--\r\n"
+                      "epilogue"_kj;
+
+constexpr auto EXPECTED = "field|-|-|value with --xyzz and \r\n-- in it;"
+                          "file|a.txt|text/plain|file\ncontents;"
+                          "empty|-|-|;"_kj;
+
+KJ_TEST("MultipartParser gives the same result however the body is split") {
+  for (size_t chunkSize = 1; chunkSize <= BODY.size(); chunkSize++) {
+    KJ_EXPECT(parseInChunks(BODY, "xyzzy", chunkSize) == EXPECTED, chunkSize);
+  }
+}
+
+KJ_TEST("MultipartParser streams part data without waiting for the part to end") {
+  RecordingHandler handler;
+  MultipartParser parser("b", handler);
+  parser.write("--b\r\nContent-Disposition: form-data; name=\"big\"\r\n\r\n"_kj.asBytes());
+
+  auto data = kj::heapArray<char>(10000);
+  data.asPtr().fill('x');
+  parser.write(data.asBytes());
+
+  // Everything except the few bytes that might be the start of the boundary has been delivered.
+  KJ_EXPECT(handler.record.size() > data.size());
+
+  parser.write("\r\n--b--"_kj.asBytes());
+  parser.end();
+  KJ_EXPECT(handler.record.size() == kj::str("big|-|-|;").size() + data.size());
+}
+
+KJ_TEST("MultipartParser rejects malformed bodies") {
+  auto parse = [](kj::StringPtr body) { parseInChunks(body, "b", 3); };
+
+  KJ_EXPECT_THROW_MESSAGE("No initial boundary string", parse(""));
+  KJ_EXPECT_THROW_MESSAGE("No initial boundary string", parse("no boundary here"));
+  KJ_EXPECT_THROW_MESSAGE("No initial boundary string", parse("--b"));
+  KJ_EXPECT_THROW_MESSAGE("Boundary string was not succeeded by CRLF, LF, or '--'", parse("--bx"));
+  KJ_EXPECT_THROW_MESSAGE("No multipart message header termination found",
+      parse("--b\r\nContent-Disposition: form-data; name=\"a\"\r\n"));
+  KJ_EXPECT_THROW_MESSAGE("No subsequent boundary string after multipart message",
+      parse("--b\r\nContent-Disposition: form-data; name=\"a\"\r\n\r\ntruncated"));
+  KJ_EXPECT_THROW_MESSAGE("missing a name",
+      parse("--b\r\nContent-Disposition: form-data\r\n\r\nx\r\n--b--"));
+}
+
+}  // namespace
+}  // namespace workerd::api
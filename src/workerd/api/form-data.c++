@@ -14,7 +14,6 @@
 #include <kj/vector.h>
 
 #include <algorithm>
-#include <regex>
 
 #if !_MSC_VER
 #include <strings.h>
@@ -23,15 +22,6 @@
 namespace workerd::api {
 
 namespace {
-// Like split() in kj/compat/url.c++, but splits at a substring rather than a character.
-kj::ArrayPtr<const char> splitAtSubString(kj::ArrayPtr<const char>& text, kj::StringPtr subString) {
-  // TODO(perf): Use a Boyer-Moore search?
-  auto iter = std::search(text.begin(), text.end(), subString.begin(), subString.end());
-  auto result = kj::arrayPtr(text.begin(), iter - text.begin());
-  text =
-      text.slice(kj::min(text.size(), result.end() - text.begin() + subString.size()), text.size());
-  return result;
-}
 
 struct FormDataHeaderTable {
   kj::HttpHeaderId contentDispositionId;
@@ -145,106 +135,355 @@ void assertUtf8(const auto& params) {
 }  // namespace
 
 // =======================================================================================
-// FormData implementation
+// MultipartParser implementation
+
+MultipartParser::BoundaryMatcher::BoundaryMatcher(kj::ArrayPtr<const char> needle)
+    : needle(needle) {
+  // When the last byte of the window doesn't complete a match, slide the window so that the
+  // rightmost occurrence of that byte in the needle (excluding its final position) lines up
+  // with it, or past it entirely if it doesn't occur.
+  for (auto& s: skip) {
+    s = needle.size();
+  }
+  for (size_t i = 0; i + 1 < needle.size(); i++) {
+    skip[static_cast<kj::byte>(needle[i])] = needle.size() - 1 - i;
+  }
+}
 
-void FormData::parseFormDataImpl(
-    kj::ArrayPtr<const char> rawText, kj::StringPtr boundary, ParseCallback callback) {
-  // multipart/form-data messages are delimited by <CRLF>--<boundary>. We want to be able to handle
-  // omitted carriage returns, though, so our delimiter only matches against a preceding line feed.
-  const auto delimiter = kj::str("\n--", boundary);
-
-  // We want to slice off the delimiter's preceding newline for the initial search, because the very
-  // first instance does not require one. In every subsequent multipart message, the preceding
-  // newline is required.
-  auto message = splitAtSubString(rawText, delimiter.slice(1));
-
-  JSG_REQUIRE(rawText.size() > 0, TypeError,
-      "No initial boundary string (or you have a truncated message).");
-
-  static const auto done = [](kj::ArrayPtr<const char>& body) {
-    // Consume any (CR)LF characters that trailed the boundary and indicate continuation, or consume
-    // the terminal "--" characters and indicate termination, or throw an error.
-    if (body.startsWith("\n"_kj)) {
-      body = body.slice(1, body.size());
-    } else if (body.startsWith("\r\n"_kj)) {
-      body = body.slice(2, body.size());
-    } else if (body.startsWith("--"_kj)) {
-      // We're done!
-      return true;
+kj::Maybe<size_t> MultipartParser::BoundaryMatcher::find(kj::ArrayPtr<const char> haystack) const {
+  size_t last = needle.size() - 1;
+  for (size_t pos = 0; pos + needle.size() <= haystack.size();
+       pos += skip[static_cast<kj::byte>(haystack[pos + last])]) {
+    if (haystack[pos + last] == needle[last] &&
+        memcmp(haystack.begin() + pos, needle.begin(), last) == 0) {
+      return pos;
+    }
+  }
+  return kj::none;
+}
+
+MultipartParser::MultipartParser(kj::StringPtr boundary, Handler& handler)
+    : handler(handler),
+      // multipart/form-data messages are delimited by <CRLF>--<boundary>. We want to be able to
+      // handle omitted carriage returns, though, so our delimiter only matches against a preceding
+      // line feed.
+      delimiter(kj::str("\n--", boundary)),
+      firstMatcher(delimiter.slice(1)),
+      matcher(delimiter) {}
+
+void MultipartParser::write(kj::ArrayPtr<const kj::byte> data) {
+  auto input = data.asChars();
+
+  // If the previous write left input over, top it up from `input` until the parser gets past it.
+  // Topping up by at least the amount already buffered keeps this linear even for long headers.
+  while (buffered.size() > 0 && input.size() > 0) {
+    size_t before = buffered.size();
+    size_t take = kj::min(input.size(), kj::max(before, delimiter.size()));
+    buffered.addAll(input.first(take));
+    size_t consumed = consume(buffered.asPtr(), false);
+    if (consumed >= before) {
+      // Everything that was buffered has been parsed. Carry on from `input` itself, so that the
+      // bulk of it is parsed in place rather than copied.
+      buffered.clear();
+      input = input.slice(consumed - before);
     } else {
-      JSG_FAIL_REQUIRE(TypeError, "Boundary string was not succeeded by CRLF, LF, or '--'.");
+      if (consumed > 0) {
+        auto rest = kj::heapArray<char>(buffered.asPtr().slice(consumed));
+        buffered.clear();
+        buffered.addAll(rest);
+      }
+      input = input.slice(take);
     }
-    return false;
-  };
+  }
 
-  constexpr auto staticRegexFlags =
-      std::regex_constants::ECMAScript | std::regex_constants::optimize;
+  if (input.size() > 0) {
+    buffered.addAll(input.slice(consume(input, false)));
+  }
+}
 
-  static const auto headerTerminationRegex = std::regex("\r?\n\r?\n", staticRegexFlags);
+void MultipartParser::end() {
+  consume(buffered.asPtr(), true);
+  buffered.clear();
+}
 
-  std::cmatch match;
+size_t MultipartParser::consume(kj::ArrayPtr<const char> input, bool atEnd) {
+  auto begin = input.begin();
+
+  for (;;) {
+    switch (state) {
+      case State::PREAMBLE: {
+        size_t needleSize = delimiter.size() - 1;
+        KJ_IF_SOME(found, firstMatcher.find(input)) {
+          input = input.slice(found + needleSize);
+          state = State::AFTER_FIRST_BOUNDARY;
+          continue;
+        }
+        JSG_REQUIRE(
+            !atEnd, TypeError, "No initial boundary string (or you have a truncated message).");
+        // Keep anything that might be the start of the boundary.
+        input = input.slice(input.size() - kj::min(input.size(), needleSize - 1));
+        return input.begin() - begin;
+      }
 
-  auto& formDataHeaderTable = getFormDataHeaderTable();
+      case State::AFTER_FIRST_BOUNDARY:
+      case State::AFTER_BOUNDARY: {
+        if (input.size() == 0) {
+          if (state == State::AFTER_FIRST_BOUNDARY) {
+            JSG_REQUIRE(!atEnd, TypeError,
+                "No initial boundary string (or you have a truncated message).");
+          } else {
+            JSG_REQUIRE(
+                !atEnd, TypeError, "No subsequent boundary string after multipart message.");
+          }
+          return input.begin() - begin;
+        }
 
-  while (!done(rawText)) {
-    JSG_REQUIRE(std::regex_search(rawText.begin(), rawText.end(), match, headerTerminationRegex),
-        TypeError, "No multipart message header termination found.");
+        // Consume any (CR)LF characters that trailed the boundary and indicate continuation, or
+        // the terminal "--" characters that indicate termination, or throw an error.
+        if (input.startsWith("\n"_kj)) {
+          input = input.slice(1);
+          state = State::HEADERS;
+        } else if (input.startsWith("\r\n"_kj)) {
+          input = input.slice(2);
+          state = State::HEADERS;
+        } else if (input.startsWith("--"_kj)) {
+          // We're done!
+          state = State::DONE;
+        } else if (input.size() == 1 && (input[0] == '\r' || input[0] == '-') && !atEnd) {
+          // Need to see the next character to know.
+          return input.begin() - begin;
+        } else {
+          JSG_FAIL_REQUIRE(TypeError, "Boundary string was not succeeded by CRLF, LF, or '--'.");
+        }
+        continue;
+      }
 
-    // TODO(cleanup): Use kj-http to parse multipart headers. Right now that API isn't public, so
-    //   I'm just using a regex. For reference, multipart/form-data supports the following three
-    //   headers (https://tools.ietf.org/html/rfc7578#section-4.8):
-    //
-    //   Content-Disposition        (required)
-    //   Content-Type               (optional, recommended for files)
-    //   Content-Transfer-Encoding  (for 7-bit encoding, deprecated in HTTP contexts)
-    //
-    // TODO(soon): Read the Content-Type to support files.
+      case State::HEADERS: {
+        // Headers end with a blank line, i.e. "\r?\n\r?\n".
+        kj::Maybe<size_t> headersEnd;
+        for (size_t i = 0; i + 1 < input.size(); i++) {
+          if (input[i] != '\n') continue;
+          if (input[i + 1] == '\n') {
+            headersEnd = i + 2;
+            break;
+          } else if (input[i + 1] == '\r' && i + 2 < input.size() && input[i + 2] == '\n') {
+            headersEnd = i + 3;
+            break;
+          }
+        }
 
-    auto headersText = kj::str(rawText.first(match[0].second - rawText.begin()));
-    rawText = rawText.slice(match[0].second - rawText.begin(), rawText.size());
+        KJ_IF_SOME(headersSize, headersEnd) {
+          startPart(input.first(headersSize));
+          input = input.slice(headersSize);
+          state = State::BODY;
+          continue;
+        }
+        JSG_REQUIRE(!atEnd, TypeError, "No multipart message header termination found.");
+        return input.begin() - begin;
+      }
 
-    kj::HttpHeaders headers(*formDataHeaderTable.table);
-    JSG_REQUIRE(headers.tryParse(headersText), TypeError, "FormData part had invalid headers.");
+      case State::BODY: {
+        KJ_IF_SOME(found, matcher.find(input)) {
+          auto data = input.first(found);
+          // If we skipped a CR, we must avoid including it in the message data.
+          if (data.size() > 0 && data.back() == '\r') {
+            data = data.first(data.size() - 1);
+          }
+          if (data.size() > 0) {
+            handler.partData(data.asBytes());
+          }
+          handler.endPart();
+          input = input.slice(found + delimiter.size());
+          state = State::AFTER_BOUNDARY;
+          continue;
+        }
+        JSG_REQUIRE(!atEnd, TypeError, "No subsequent boundary string after multipart message.");
+
+        // Hand over everything except what might be the start of the delimiter, along with the
+        // CR that may precede it.
+        size_t safe = input.size() - kj::min(input.size(), delimiter.size());
+        if (safe > 0) {
+          handler.partData(input.first(safe).asBytes());
+          input = input.slice(safe);
+        }
+        return input.begin() - begin;
+      }
 
-    kj::StringPtr disposition =
-        JSG_REQUIRE_NONNULL(headers.get(formDataHeaderTable.contentDispositionId), TypeError,
-            "No valid Content-Disposition header found in FormData part.");
+      case State::DONE:
+        return input.end() - begin;
+    }
+    KJ_UNREACHABLE;
+  }
+}
 
-    kj::Maybe<kj::String> maybeName;
-    kj::Maybe<kj::String> filename;
-    {
-      p::IteratorInput<char, const char*> input(disposition.begin(), disposition.end());
-      auto result = JSG_REQUIRE_NONNULL(contentDisposition(input), TypeError,
-          "Invalid Content-Disposition header found in FormData part.");
-      JSG_REQUIRE(kj::get<0>(result) == "form-data"_kj.asArray(), TypeError,
-          "Content-Disposition header for FormData part must have the value \"form-data\", "
-          "possibly followed by parameters. Got: \"",
-          kj::get<0>(result), "\"");
-
-      for (auto& param: kj::get<1>(result)) {
-        if (kj::get<0>(param) == "name"_kj.asArray()) {
-          maybeName = kj::str(kj::get<1>(param));
-        } else if (kj::get<0>(param) == "filename"_kj.asArray()) {
-          filename = kj::str(kj::get<1>(param));
-        }
+void MultipartParser::startPart(kj::ArrayPtr<const char> headersText) {
+  // TODO(cleanup): Use kj-http to parse multipart headers. Right now that API isn't public, so
+  //   we parse them as a standalone header block. For reference, multipart/form-data supports the
+  //   following three headers (https://tools.ietf.org/html/rfc7578#section-4.8):
+  //
+  //   Content-Disposition        (required)
+  //   Content-Type               (optional, recommended for files)
+  //   Content-Transfer-Encoding  (for 7-bit encoding, deprecated in HTTP contexts)
+
+  auto& formDataHeaderTable = getFormDataHeaderTable();
+  auto ownHeadersText = kj::str(headersText);
+
+  kj::HttpHeaders headers(*formDataHeaderTable.table);
+  JSG_REQUIRE(headers.tryParse(ownHeadersText), TypeError, "FormData part had invalid headers.");
+
+  kj::StringPtr disposition =
+      JSG_REQUIRE_NONNULL(headers.get(formDataHeaderTable.contentDispositionId), TypeError,
+          "No valid Content-Disposition header found in FormData part.");
+
+  kj::Maybe<kj::String> maybeName;
+  kj::Maybe<kj::String> filename;
+  {
+    p::IteratorInput<char, const char*> input(disposition.begin(), disposition.end());
+    auto result = JSG_REQUIRE_NONNULL(contentDisposition(input), TypeError,
+        "Invalid Content-Disposition header found in FormData part.");
+    JSG_REQUIRE(kj::get<0>(result) == "form-data"_kj.asArray(), TypeError,
+        "Content-Disposition header for FormData part must have the value \"form-data\", "
+        "possibly followed by parameters. Got: \"",
+        kj::get<0>(result), "\"");
+
+    for (auto& param: kj::get<1>(result)) {
+      if (kj::get<0>(param) == "name"_kj.asArray()) {
+        maybeName = kj::str(kj::get<1>(param));
+      } else if (kj::get<0>(param) == "filename"_kj.asArray()) {
+        filename = kj::str(kj::get<1>(param));
       }
     }
+  }
 
-    kj::String name = JSG_REQUIRE_NONNULL(kj::mv(maybeName), TypeError,
-        "Content-Disposition header in FormData part is missing a name.");
+  kj::String name = JSG_REQUIRE_NONNULL(kj::mv(maybeName), TypeError,
+      "Content-Disposition header in FormData part is missing a name.");
 
-    kj::Maybe<kj::StringPtr> type = headers.get(kj::HttpHeaderId::CONTENT_TYPE);
+  handler.startPart(name, filename.map([](auto& str) { return str.asPtr(); }),
+      headers.get(kj::HttpHeaderId::CONTENT_TYPE));
+}
 
-    message = splitAtSubString(rawText, delimiter);
-    JSG_REQUIRE(
-        rawText.size() > 0, TypeError, "No subsequent boundary string after multipart message.");
+// =======================================================================================
+// FormData implementation
+
+void FormData::parseFormDataImpl(
+    kj::ArrayPtr<const char> rawText, kj::StringPtr boundary, ParseCallback callback) {
+  // With the whole body at hand, the parser reports each part's data as a single piece pointing
+  // into `rawText`, so we can pass it along without copying.
+  class PartCollector final: public MultipartParser::Handler {
+  public:
+    PartCollector(ParseCallback& callback): callback(callback) {}
+
+    void startPart(kj::StringPtr name,
+        kj::Maybe<kj::StringPtr> filename,
+        kj::Maybe<kj::StringPtr> type) override {
+      this->name = kj::str(name);
+      this->filename = filename.map([](kj::StringPtr s) { return kj::str(s); });
+      this->type = type.map([](kj::StringPtr s) { return kj::str(s); });
+      data = nullptr;
+      joined.clear();
+    }
 
-    if (message.size() > 0) {
-      // If we skipped a CR, we must avoid including it in the message data.
-      message = message.first(message.size() - uint(message.back() == '\r'));
+    void partData(kj::ArrayPtr<const kj::byte> piece) override {
+      if (data.size() == 0) {
+        data = piece;
+      } else {
+        // Not expected, but handle it anyway.
+        if (joined.size() == 0) joined.addAll(data);
+        joined.addAll(piece);
+        data = joined;
+      }
+    }
+
+    void endPart() override {
+      callback(name, filename.map([](auto& str) { return str.asPtr(); }),
+          type.map([](auto& str) { return str.asPtr(); }), data);
     }
 
-    callback(name, filename.map([](auto& str) { return str.asPtr(); }), type, message.asBytes());
+  private:
+    ParseCallback& callback;
+    kj::String name;
+    kj::Maybe<kj::String> filename;
+    kj::Maybe<kj::String> type;
+    kj::ArrayPtr<const kj::byte> data;
+    kj::Vector<kj::byte> joined;
+  };
+
+  PartCollector collector(callback);
+  MultipartParser parser(boundary, collector);
+  parser.write(rawText.asBytes());
+  parser.end();
+}
+
+kj::Array<FormData::EntryWithoutLock> FormData::StreamingParser::end() {
+  parser.end();
+  return entries.releaseAsArray();
+}
+
+void FormData::StreamingParser::startPart(
+    kj::StringPtr name, kj::Maybe<kj::StringPtr> filename, kj::Maybe<kj::StringPtr> type) {
+  current = EntryWithoutLock{
+    .name = kj::str(name),
+    .filename = filename.map([](kj::StringPtr s) { return kj::str(s); }),
+    .type = type.map([](kj::StringPtr s) { return kj::str(s); }),
+  };
+}
+
+void FormData::StreamingParser::partData(kj::ArrayPtr<const kj::byte> data) {
+  currentData.addAll(data);
+}
+
+void FormData::StreamingParser::endPart() {
+  auto entry = KJ_ASSERT_NONNULL(kj::mv(current));
+  current = kj::none;
+  if (entry.filename == kj::none) {
+    entry.value = kj::str(currentData.asPtr().asChars());
+    currentData.clear();
+  } else {
+    entry.value = currentData.releaseAsArray();
+  }
+  entries.add(kj::mv(entry));
+}
+
+kj::Maybe<kj::String> FormData::tryGetMultipartBoundary(kj::StringPtr contentType) {
+  KJ_IF_SOME(parsed, MimeType::tryParse(contentType)) {
+    if (MimeType::FORM_DATA == parsed) {
+      auto& boundary = JSG_REQUIRE_NONNULL(parsed.params().find("boundary"_kj), TypeError,
+          "No boundary string in Content-Type header. The multipart/form-data MIME "
+          "type requires a boundary parameter, e.g. 'Content-Type: multipart/form-data; "
+          "boundary=\"abcd\"'. See RFC 7578, section 4.");
+      return kj::str(boundary);
+    }
+  }
+  return kj::none;
+}
+
+void FormData::addEntries(
+    jsg::Lock& js, kj::Array<EntryWithoutLock> entries, bool convertFilesToStrings) {
+  data.reserve(data.size() + entries.size());
+  for (auto& entry: entries) {
+    KJ_SWITCH_ONEOF(entry.value) {
+      KJ_CASE_ONEOF(text, kj::String) {
+        data.add(FormData::Entry{
+          .name = js.accountedKjString(kj::mv(entry.name)),
+          .value = js.accountedKjString(kj::mv(text)),
+        });
+      }
+      KJ_CASE_ONEOF(bytes, kj::Array<kj::byte>) {
+        if (convertFilesToStrings) {
+          data.add(FormData::Entry{
+            .name = js.accountedKjString(kj::mv(entry.name)),
+            .value = js.accountedKjString(kj::str(bytes.asChars())),
+          });
+        } else {
+          // Hand the part's bytes to V8 as they are, rather than copying them.
+          auto backing = jsg::BackingStore::from<v8::ArrayBuffer>(js, kj::mv(bytes));
+          jsg::BufferSource buffer(js, kj::mv(backing));
+          data.add(FormData::Entry{.name = kj::mv(entry.name),
+            .value = js.alloc<File>(js, kj::mv(buffer), KJ_ASSERT_NONNULL(kj::mv(entry.filename)),
+                kj::mv(entry.type).orDefault(kj::str()), dateNow())});
+        }
+      }
+    }
   }
 }
 
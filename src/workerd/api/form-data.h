@@ -11,6 +11,84 @@
 
 namespace workerd::api {
 
+// Incrementally parses a multipart/form-data body (RFC 7578), so that a body can be parsed as it
+// arrives rather than buffered in full first. Feed the body to `write()` in pieces of any size,
+// then call `end()`; parts are reported to the Handler as they are found. Malformed bodies cause
+// a TypeError to be thrown from whichever call discovers the problem.
+//
+// Part data is reported in pieces too. The parser only holds back the few bytes at the end of
+// each write that might turn out to be the start of the next boundary, and the headers of a part
+// until they are complete.
+class MultipartParser {
+public:
+  class Handler {
+  public:
+    // A new part begins, with the given Content-Disposition parameters and Content-Type.
+    virtual void startPart(kj::StringPtr name,
+                           kj::Maybe<kj::StringPtr> filename,
+                           kj::Maybe<kj::StringPtr> type) = 0;
+
+    // More of the current part's data. Never called with an empty piece.
+    virtual void partData(kj::ArrayPtr<const kj::byte> data) = 0;
+
+    // The current part's data is complete.
+    virtual void endPart() = 0;
+  };
+
+  MultipartParser(kj::StringPtr boundary, Handler& handler);
+  KJ_DISALLOW_COPY_AND_MOVE(MultipartParser);
+
+  void write(kj::ArrayPtr<const kj::byte> data);
+
+  // Call when the whole body has been written. Throws if the body was truncated.
+  void end();
+
+private:
+  // Finds a fixed string using the Boyer-Moore-Horspool algorithm, with the skip table computed
+  // once up front. Boundaries are searched for across the entire body, so this matters for large
+  // uploads: most bytes are skipped over without being compared.
+  class BoundaryMatcher {
+  public:
+    explicit BoundaryMatcher(kj::ArrayPtr<const char> needle);
+
+    kj::Maybe<size_t> find(kj::ArrayPtr<const char> haystack) const;
+
+  private:
+    kj::ArrayPtr<const char> needle;
+    uint skip[256];
+  };
+
+  enum class State {
+    PREAMBLE,              // Looking for the first boundary.
+    AFTER_FIRST_BOUNDARY,  // Expecting the line break after the first boundary.
+    AFTER_BOUNDARY,        // Expecting the line break or "--" after a subsequent boundary.
+    HEADERS,               // Looking for the end of a part's headers.
+    BODY,                  // Looking for the boundary that ends a part's data.
+    DONE,                  // The final boundary has been seen; the rest is ignored.
+  };
+
+  Handler& handler;
+
+  // Boundaries other than the first must begin a line, so we search for "\n--<boundary>". The
+  // first may appear anywhere, so it is searched for without the line feed.
+  kj::String delimiter;
+  BoundaryMatcher firstMatcher;
+  BoundaryMatcher matcher;
+
+  State state = State::PREAMBLE;
+
+  // Input left over from the previous write() which the parser couldn't get past without seeing
+  // more.
+  kj::Vector<char> buffered;
+
+  // Parses as much of `input` as possible and returns how much was consumed. The remainder must
+  // be presented again, with more input appended, unless `atEnd` is true, in which case anything
+  // left unparsed is an error.
+  size_t consume(kj::ArrayPtr<const char> input, bool atEnd);
+
+  void startPart(kj::ArrayPtr<const char> headersText);
+};
+
 // Implements the FormData interface as prescribed by:
 // https://xhr.spec.whatwg.org/#interface-formdata
 //
@@ -55,6 +133,39 @@ public:
     kj::OneOf<kj::Array<kj::byte>, kj::String> value;
   };
 
+  // Collects the entries of a multipart/form-data body without needing the isolate lock, so that
+  // the body can be parsed while it is still streaming in. Once the body has been written in full,
+  // pass the result of `end()` to `addEntries()`.
+  class StreamingParser final: private MultipartParser::Handler {
+  public:
+    explicit StreamingParser(kj::StringPtr boundary): parser(boundary, *this) {}
+
+    void write(kj::ArrayPtr<const kj::byte> data) { parser.write(data); }
+    kj::Array<EntryWithoutLock> end();
+
+  private:
+    MultipartParser parser;
+    kj::Vector<EntryWithoutLock> entries;
+    kj::Maybe<EntryWithoutLock> current;
+    kj::Vector<kj::byte> currentData;
+
+    void startPart(kj::StringPtr name,
+                   kj::Maybe<kj::StringPtr> filename,
+                   kj::Maybe<kj::StringPtr> type) override;
+    void partData(kj::ArrayPtr<const kj::byte> data) override;
+    void endPart() override;
+  };
+
+  // If `contentType` is multipart/form-data, returns its boundary parameter, throwing if it is
+  // missing. Returns kj::none for any other content type.
+  static kj::Maybe<kj::String> tryGetMultipartBoundary(kj::StringPtr contentType);
+
+  // Adds entries produced by a StreamingParser to this FormData. `convertFilesToStrings` is as for
+  // `parse()`.
+  void addEntries(jsg::Lock& js,
+                  kj::Array<EntryWithoutLock> entries,
+                  bool convertFilesToStrings);
+
   // Provided for cases where parsing FormData outside of any direct JS
   // API usage (such as in fiddle internally).
   static kj::Array<EntryWithoutLock> parseWithoutLock(kj::ArrayPtr<const char> rawText,
@@ -100,21 +100,18 @@ constexpr bool requireValidHeaderValue(kj::StringPtr value) {
 
 Headers::Headers(jsg::Lock& js, jsg::Dict<jsg::ByteString, jsg::ByteString> dict)
     : guard(Guard::NONE) {
-  headers.reserve(dict.fields.size() + 16);
+  storage->headers.reserve(dict.fields.size() + 16);
   for (auto& field: dict.fields) {
     append(js, kj::mv(field.name), kj::mv(field.value));
   }
 }
 
-Headers::Headers(jsg::Lock& js, const Headers& other, Guard guard): guard(guard) {
-  headers.reserve(other.headers.size() + 16);
-  for (const auto& header: other.headers) {
-    headers.insert(header.clone(js));
-  }
-}
+Headers::Headers(jsg::Lock& js, const Headers& other, Guard guard)
+    : storage(kj::addRef(*other.storage)),
+      guard(guard) {}
 
 Headers::Headers(jsg::Lock& js, const kj::HttpHeaders& other, Guard guard): guard(guard) {
-  headers.reserve(other.size() + 16);
+  storage->headers.reserve(other.size() + 16);
   other.forEach([this, &js](auto name, auto value) {
     appendUnguarded(js, name, jsg::ByteString(kj::str(value)));
   });
@@ -124,10 +121,22 @@ jsg::Ref<Headers> Headers::clone(jsg::Lock& js) const {
   return js.alloc<Headers>(js, *this, guard);
 }
 
+Headers::HeaderTable& Headers::mutableHeaders(jsg::Lock& js) {
+  if (storage->isShared()) {
+    auto copy = kj::refcounted<Storage>();
+    copy->headers.reserve(storage->headers.size() + 16);
+    for (const auto& header: storage->headers) {
+      copy->headers.insert(header.clone(js));
+    }
+    storage = kj::mv(copy);
+  }
+  return storage->headers;
+}
+
 // Fill in the given HttpHeaders with these headers. Note that strings are inserted by
 // reference, so the output must be consumed immediately.
 void Headers::shallowCopyTo(kj::HttpHeaders& out) {
-  for (const auto& entry: headers.ordered<1>()) {
+  for (const auto& entry: storage->headers.ordered<1>()) {
     for (const auto& value: entry.values) {
       out.add(entry.getName(), value);
     }
@@ -140,43 +149,62 @@ bool Headers::hasLowerCase(kj::StringPtr name) {
     KJ_DREQUIRE(!('A' <= c && c <= 'Z'));
   }
 #endif
-  return headers.find(name) != kj::none;
+  return storage->headers.find(name) != kj::none;
 }
 
-kj::Array<Headers::DisplayedHeader> Headers::getDisplayedHeaders(
-    jsg::Lock& js, DisplayedHeaderOption option) {
-  // The fetch spec requires that iterators over Headers remain stable across mutations.
-  // So we need to make a copy of the headers to pass off to the iterators.
-  // The list is also required to be sorted by header name, with all header names lower-cased.
+Headers::IteratorState Headers::startIteration(jsg::Lock& js) {
+  return IteratorState{
+    .storage = kj::addRef(*storage),
+    .cursor = storage->headers.ordered<1>().begin(),
+    .splitSetCookie = FeatureFlags::get(js).getHttpHeadersGetSetCookie(),
+  };
+}
 
-  bool includeValues = option != DisplayedHeaderOption::KEYONLY;
+kj::Maybe<Headers::DisplayedHeader> Headers::nextDisplayedHeader(
+    jsg::Lock& js, IteratorState& state, DisplayedHeaderOption option) {
+  // The list is required to be sorted by header name, with all header names lower-cased, which
+  // the tree index gives us.
+  if (state.cursor == state.storage->headers.ordered<1>().end()) {
+    return kj::none;
+  }
 
-  kj::Vector<Headers::DisplayedHeader> copy(headers.size());
-
-  auto getSetCookie = FeatureFlags::get(js).getHttpHeadersGetSetCookie();
-
-  for (const auto& entry: headers.ordered<1>()) {
-    auto nameStr = js.str(toLower(entry.getName()));
-    if (getSetCookie && strcasecmp(entry.getName().cStr(), "set-cookie") == 0) {
-      copy.reserve(entry.values.size() - 1);
-      // For set-cookie entries, we iterate each individually without
-      // combining them.
-      for (const auto& value: entry.values) {
-        copy.add(Headers::DisplayedHeader{
-          .key = jsg::JsRef(js, nameStr),
-          .value = includeValues ? jsg::JsRef(js, js.str(value)) : jsg::JsRef(js, js.str()),
-        });
-      }
-      continue;
+  auto& entry = *state.cursor;
+  bool includeValues = option != DisplayedHeaderOption::KEYONLY;
+  auto key = jsg::JsRef(js, entry.getDisplayedName(js));
+
+  if (state.splitSetCookie && strcasecmp(entry.getName().cStr(), "set-cookie") == 0) {
+    // For set-cookie entries, we iterate each individually without combining them.
+    auto& value = entry.values[state.valueIndex++];
+    if (state.valueIndex == entry.values.size()) {
+      ++state.cursor;
+      state.valueIndex = 0;
     }
+    return Headers::DisplayedHeader{
+      .key = kj::mv(key),
+      .value = includeValues ? jsg::JsRef(js, js.str(value)) : jsg::JsRef(js, js.str()),
+    };
+  }
 
-    copy.add(Headers::DisplayedHeader{
-      .key = jsg::JsRef(js, nameStr),
-      .value = includeValues ? jsg::JsRef(js, js.str(kj::strArray(entry.values, ", ")))
-                             : jsg::JsRef(js, js.str()),
-    });
+  ++state.cursor;
+  return Headers::DisplayedHeader{
+    .key = kj::mv(key),
+    .value = includeValues ? jsg::JsRef(js, js.str(kj::strArray(entry.values, ", ")))
+                           : jsg::JsRef(js, js.str()),
+  };
+}
+
+kj::Array<Headers::DisplayedHeader> Headers::getDisplayedHeaders(
+    jsg::Lock& js, DisplayedHeaderOption option) {
+  kj::Vector<Headers::DisplayedHeader> result(storage->headers.size());
+  auto state = startIteration(js);
+  while (true) {
+    KJ_IF_SOME(header, nextDisplayedHeader(js, state, option)) {
+      result.add(kj::mv(header));
+    } else {
+      break;
+    }
   }
-  return copy.releaseAsArray();
+  return result.releaseAsArray();
 }
 
 jsg::Ref<Headers> Headers::constructor(jsg::Lock& js, jsg::Optional<Initializer> init) {
@@ -230,11 +258,12 @@ kj::Maybe<jsg::ByteString> Headers::get(jsg::Lock& js, jsg::ByteString name) {
 }
 
 kj::Maybe<jsg::ByteString> Headers::getNoChecks(jsg::Lock& js, kj::StringPtr name) {
-  return headers.find(name).map([](const auto& entry) { return kj::strArray(entry.values, ", "); });
+  return storage->headers.find(name).map(
+      [](const auto& entry) { return kj::strArray(entry.values, ", "); });
 }
 
 kj::ArrayPtr<jsg::ByteString> Headers::getSetCookie() {
-  KJ_IF_SOME(found, headers.find("set-cookie"_kj)) {
+  KJ_IF_SOME(found, storage->headers.find("set-cookie"_kj)) {
     return found.values.asPtr();
   }
   return nullptr;
@@ -255,7 +284,7 @@ kj::ArrayPtr<jsg::ByteString> Headers::getAll(jsg::ByteString name) {
 
 bool Headers::has(jsg::ByteString name) {
   JSG_REQUIRE(requireValidHeaderName(name), TypeError, "Invalid header name.");
-  return headers.find(name) != kj::none;
+  return storage->headers.find(name) != kj::none;
 }
 
 void Headers::set(jsg::Lock& js, jsg::ByteString name, jsg::ByteString value) {
@@ -272,7 +301,9 @@ void Headers::setValueChecked(jsg::Lock& js, kj::StringPtr name, jsg::ByteString
 
 void Headers::setUnguarded(jsg::Lock& js, kj::StringPtr name, jsg::ByteString value) {
   kj::uint hash = hashCode(name);
-  headers.findOrCreate(hash, [&]() { return Header(js, hash, name); }).set(js, kj::mv(value));
+  mutableHeaders(js)
+      .findOrCreate(hash, [&]() { return Header(js, hash, name); })
+      .set(js, kj::mv(value));
 }
 
 void Headers::append(jsg::Lock& js, jsg::ByteString name, jsg::ByteString value) {
@@ -289,59 +320,56 @@ void Headers::appendValueChecked(jsg::Lock& js, kj::StringPtr name, jsg::ByteStr
 
 void Headers::appendUnguarded(jsg::Lock& js, kj::StringPtr name, jsg::ByteString value) {
   auto hash = hashCode(name);
-  headers.findOrCreate(hash, [&]() { return Header(js, hash, name); }).add(js, kj::mv(value));
+  mutableHeaders(js)
+      .findOrCreate(hash, [&]() { return Header(js, hash, name); })
+      .add(js, kj::mv(value));
 }
 
-void Headers::delete_(jsg::ByteString name) {
+void Headers::delete_(jsg::Lock& js, jsg::ByteString name) {
   JSG_REQUIRE(guard == Guard::NONE, TypeError, "Can't modify immutable headers.");
   JSG_REQUIRE(requireValidHeaderName(name), TypeError, "Invalid header name.");
-  headers.eraseMatch(name);
+  if (storage->headers.find(name) != kj::none) {
+    mutableHeaders(js).eraseMatch(name);
+  }
 }
 
-// There are a couple implementation details of the Headers iterators worth calling out.
-//
-// 1. Each iterator gets its own copy of the keys and/or values of the headers. While nauseating
-//    from a performance perspective, this solves both the iterator -> iterable lifetime dependence
-//    and the iterator invalidation issue: i.e., it's impossible for a user to unsafely modify the
-//    Headers data structure while iterating over it, because they are simply two separate data
-//    structures. By empirical testing, this seems to be how Chrome implements Headers iteration.
-//
-//    Other alternatives bring their own pitfalls. We could store a Ref of the parent Headers
-//    object, solving the lifetime issue. To solve the iterator invalidation issue, we could store a
-//    copy of the currently-iterated-over key and use std::upper_bound() to find the next entry
-//    every time we want to increment the iterator (making the increment operation O(lg n) rather
-//    than O(1)); or we could make each Header entry in the map store a set of back-pointers to all
-//    live iterators pointing to it, with delete_() incrementing all iterators in the set whenever
-//    it deletes a header entry. Neither hack appealed to me.
-//
-// 2. Notice that the next() member function of the iterator classes moves the string(s) they
-//    contain, rather than making a copy of them as in the FormData iterators. This is safe to do
-//    because, unlike FormData, these iterators have their own copies of the strings, and since they
-//    are forward-only iterators, we know we won't need the strings again.
+// The fetch spec requires that iterators over Headers remain stable across mutations. Each
+// iterator holds a reference to the header storage as it was when the iterator was created, and
+// any mutation of the Headers while the storage is shared copies it first (see mutableHeaders()).
+// So creating an iterator is O(1), and the copy is only paid for if the script actually modifies
+// the headers while an iterator is still alive.
 //
-// TODO(perf): On point 1, perhaps we could avoid most copies by using a copy-on-write strategy
-//   applied to the header map elements? We'd still copy the whole data structure to avoid iterator
-//   invalidation, but the elements would be cheaper to copy.
+// The displayed names and values are produced lazily, one entry per call to next().
 
 jsg::Ref<Headers::EntryIterator> Headers::entries(jsg::Lock& js) {
-  return js.alloc<EntryIterator>(IteratorState<DisplayedHeader>{getDisplayedHeaders(js)});
+  return js.alloc<EntryIterator>(startIteration(js));
 }
 jsg::Ref<Headers::KeyIterator> Headers::keys(jsg::Lock& js) {
-  auto headers = getDisplayedHeaders(js, DisplayedHeaderOption::KEYONLY);
-  kj::Vector<jsg::JsRef<jsg::JsString>> keysCopy(headers.size());
-  for (auto& entry: headers) {
-    keysCopy.add(kj::mv(entry.key));
-  }
-  return js.alloc<KeyIterator>(IteratorState<jsg::JsRef<jsg::JsString>>{keysCopy.releaseAsArray()});
+  return js.alloc<KeyIterator>(startIteration(js));
 }
 jsg::Ref<Headers::ValueIterator> Headers::values(jsg::Lock& js) {
-  auto headers = getDisplayedHeaders(js);
-  kj::Vector<jsg::JsRef<jsg::JsString>> valueCopy(headers.size());
-  for (auto& entry: headers) {
-    valueCopy.add(kj::mv(entry.value));
-  }
-  return js.alloc<ValueIterator>(
-      IteratorState<jsg::JsRef<jsg::JsString>>{valueCopy.releaseAsArray()});
+  return js.alloc<ValueIterator>(startIteration(js));
+}
+
+kj::Maybe<kj::Array<jsg::JsRef<jsg::JsString>>> Headers::entryIteratorNext(
+    jsg::Lock& js, IteratorState& state) {
+  return nextDisplayedHeader(js, state, DisplayedHeaderOption::DEFAULT).map([](auto&& header) {
+    return kj::arr(kj::mv(header.key), kj::mv(header.value));
+  });
+}
+
+kj::Maybe<jsg::JsRef<jsg::JsString>> Headers::keyIteratorNext(
+    jsg::Lock& js, IteratorState& state) {
+  return nextDisplayedHeader(js, state, DisplayedHeaderOption::KEYONLY).map([](auto&& header) {
+    return kj::mv(header.key);
+  });
+}
+
+kj::Maybe<jsg::JsRef<jsg::JsString>> Headers::valueIteratorNext(
+    jsg::Lock& js, IteratorState& state) {
+  return nextDisplayedHeader(js, state, DisplayedHeaderOption::DEFAULT).map([](auto&& header) {
+    return kj::mv(header.value);
+  });
 }
 
 void Headers::forEach(jsg::Lock& js,
@@ -356,8 +384,14 @@ void Headers::forEach(jsg::Lock& js,
   }
   callback.setReceiver(js.v8Ref(receiver));
 
-  for (const auto& entry: getDisplayedHeaders(js)) {
-    callback(js, entry.value.getHandle(js), entry.key.getHandle(js), JSG_THIS);
+  // Like the iterators, walk a snapshot, so that the callback may modify the headers.
+  auto state = startIteration(js);
+  while (true) {
+    KJ_IF_SOME(entry, nextDisplayedHeader(js, state, DisplayedHeaderOption::DEFAULT)) {
+      callback(js, entry.value.getHandle(js), entry.key.getHandle(js), JSG_THIS);
+    } else {
+      break;
+    }
   }
 }
 
@@ -441,6 +475,13 @@ static kj::HashMap<uint, uint> makeCommonHeaderMap() {
   return result;
 }
 
+// The common header names, lower-cased as the iterators display them.
+static kj::ArrayPtr<const kj::String> getLowerCaseCommonHeaderList() {
+  static const kj::Array<kj::String> LIST =
+      KJ_MAP(name, getCommonHeaderList()) { return toLower(name); };
+  return LIST;
+}
+
 static const kj::HashMap<uint, uint>& getCommonHeaderMap() {
   static const kj::HashMap<uint, uint> MAP = makeCommonHeaderMap();
   return MAP;
@@ -463,14 +504,14 @@ void Headers::serialize(jsg::Lock& js, jsg::Serializer& serializer) {
 
   // Write the count of headers.
   uint count = 0;
-  for (const auto& entry: headers.ordered<1>()) {
+  for (const auto& entry: storage->headers.ordered<1>()) {
     count += entry.values.size();
   }
   serializer.writeRawUint32(count);
 
   // Now write key/values.
   auto& commonHeaders = getCommonHeaderMap();
-  for (const auto& header: headers.ordered<1>()) {
+  for (const auto& header: storage->headers.ordered<1>()) {
     auto commonId = commonHeaders.find(header.hash);
     for (const auto& value: header.values) {
       KJ_IF_SOME(c, commonId) {
@@ -491,7 +532,7 @@ jsg::Ref<Headers> Headers::deserialize(
   KJ_REQUIRE(guard <= static_cast<uint>(Guard::NONE), "unknown guard value");
 
   uint count = deserializer.readRawUint32();
-  result->headers.reserve(count);
+  result->storage->headers.reserve(count);
 
   auto commonHeaders = getCommonHeaderList();
   for (auto i KJ_UNUSED: kj::zeroTo(count)) {
@@ -573,6 +614,21 @@ kj::StringPtr Headers::Header::getName() const {
   KJ_UNREACHABLE;
 }
 
+jsg::JsString Headers::Header::getDisplayedName(jsg::Lock& js) const {
+  KJ_SWITCH_ONEOF(nameOrIndex) {
+    KJ_CASE_ONEOF(idx, uint) {
+      // Common names are interned, so displaying them doesn't allocate a new string each time.
+      auto list = getLowerCaseCommonHeaderList();
+      KJ_ASSERT(idx < list.size());
+      return js.strIntern(list[idx]);
+    }
+    KJ_CASE_ONEOF(name, kj::String) {
+      return js.str(toLower(name));
+    }
+  }
+  KJ_UNREACHABLE;
+}
+
 void Headers::Header::add(jsg::Lock& js, jsg::ByteString value) {
   memoryAdjustment.adjustNow(js, value.size());
   values.add(kj::mv(value));
@@ -12,10 +12,101 @@
 namespace workerd::api {
 class Headers final: public jsg::Object {
 private:
-  template <typename T>
+  struct Header {
+    kj::uint hash;
+    kj::OneOf<uint, kj::String> nameOrIndex;
+    kj::StringPtr getName() const;
+
+    // The lower-cased name, as iterators display it.
+    jsg::JsString getDisplayedName(jsg::Lock& js) const;
+
+    // We intentionally do not comma-concatenate header values of the same name, as we need to be
+    // able to re-serialize them separately. This is particularly important for the Set-Cookie
+    // header, which uses a date format that requires a comma. This would normally suggest using a
+    // std::multimap, but we also need to be able to display the values in comma-concatenated form
+    // via Headers.entries()[1] in order to be Fetch-conformant. Storing a vector of strings in a
+    // std::map makes this easier, and also makes it easy to honor the "first header name casing is
+    // used for all duplicate header names" rule[2] that the Fetch spec mandates.
+    //
+    // See: 1: https://fetch.spec.whatwg.org/#concept-header-list-sort-and-combine
+    //      2: https://fetch.spec.whatwg.org/#concept-header-list-append
+    kj::Vector<jsg::ByteString> values;
+    jsg::ExternalMemoryAdjustment memoryAdjustment;
+
+    Header clone(jsg::Lock& js) const;
+
+    Header(jsg::Lock& js, kj::uint hash, kj::StringPtr name);
+
+    void add(jsg::Lock& js, jsg::ByteString value);
+
+    void set(jsg::Lock& js, jsg::ByteString value);
+
+    JSG_MEMORY_INFO(Header) {
+      KJ_SWITCH_ONEOF(nameOrIndex) {
+        KJ_CASE_ONEOF(idx, uint) {}
+        KJ_CASE_ONEOF(str, kj::String) {
+          tracker.trackField("name", str);
+        }
+      }
+      for (const auto& value : values) {
+        tracker.trackField(nullptr, value);
+      }
+    }
+
+   private:
+    Header(jsg::Lock& js, kj::OneOf<uint, kj::String> nameOrIndex,
+          kj::Array<jsg::ByteString> values, kj::uint hash);
+  };
+
+  struct HeaderCallbacks {
+    constexpr kj::uint keyForRow(const Header& header) const {
+      return header.hash;
+    }
+    constexpr bool matches(const Header& header, kj::uint key) const {
+      return header.hash == key;
+    }
+    constexpr bool matches(const Header& header, kj::StringPtr name) const {
+      return Headers::hashCode(name) == keyForRow(header);
+    }
+    constexpr uint hashCode(kj::uint hash) const { return hash; }
+    constexpr uint hashCode(kj::StringPtr name) const {
+      return Headers::hashCode(name);
+    }
+  };
+
+  struct HeaderTreeCallbacks {
+    constexpr kj::StringPtr keyForRow(const Header& header) const {
+      return header.getName();
+    }
+    constexpr bool isBefore(const Header& header, kj::StringPtr name) const {
+      return strcasecmp(header.getName().cStr(), name.cStr()) < 0;
+    }
+    constexpr bool matches(const Header& header, kj::StringPtr name) const {
+      return strcasecmp(header.getName().cStr(), name.cStr()) == 0;
+    }
+  };
+
+  using HeaderTable = kj::Table<Header, kj::HashIndex<HeaderCallbacks>,
+                                kj::TreeIndex<HeaderTreeCallbacks>>;
+
+  // The header list. Copies of a Headers object, and the iterators created from one, share the
+  // same Storage until one of the sharers is modified: mutableHeaders() copies the table first if
+  // anyone else still holds a reference to it. This makes clone() and iteration O(1), which
+  // matters for Workers that pass the same headers through many Requests and Responses.
+  struct Storage final: public kj::Refcounted {
+    HeaderTable headers;
+  };
+
+  // Iterators walk the Storage the Headers had when the iterator was created. Since any later
+  // mutation of the Headers copies the Storage rather than modifying it, the iterator is never
+  // invalidated and never observes the mutation, as the fetch spec requires.
   struct IteratorState {
-    kj::Array<T> copy;
-    decltype(copy.begin()) cursor = copy.begin();
+    kj::Own<Storage> storage;
+    decltype(kj::instance<HeaderTable&>().ordered<1>().begin()) cursor;
+
+    // Set-Cookie values are displayed one at a time when the getSetCookie() compat flag is on.
+    bool splitSetCookie;
+    size_t valueIndex = 0;
   };
 
 public:
@@ -34,7 +125,7 @@ public:
   };
 
   Headers(): guard(Guard::NONE) {
-    headers.reserve(16);
+    storage->headers.reserve(16);
   }
   explicit Headers(jsg::Lock& js, jsg::Dict<jsg::ByteString, jsg::ByteString> dict);
   explicit Headers(jsg::Lock& js, const Headers& other, Guard guard = Guard::NONE);
@@ -44,7 +135,7 @@ public:
   Headers& operator=(Headers&&) = delete;
 
   // Make a copy of this Headers object, and preserve the guard. The normal copy constructor sets
-  // the copy's guard to NONE.
+  // the copy's guard to NONE. Copies share storage until either one is modified.
   jsg::Ref<Headers> clone(jsg::Lock& js) const;
 
   // Fill in the given HttpHeaders with these headers. Note that strings are inserted by
@@ -111,7 +202,7 @@ public:
   void appendValueChecked(jsg::Lock& js, kj::StringPtr name, jsg::ByteString value);
   void appendUnguarded(jsg::Lock& js, kj::StringPtr name, jsg::ByteString value);
 
-  void delete_(jsg::ByteString name);
+  void delete_(jsg::Lock& js, jsg::ByteString name);
 
   void forEach(jsg::Lock& js,
                jsg::Function<void(jsg::JsString, jsg::JsString, jsg::Ref<Headers>)>,
@@ -121,16 +212,16 @@ public:
 
   JSG_ITERATOR(EntryIterator, entries,
                 kj::Array<jsg::JsRef<jsg::JsString>>,
-                IteratorState<DisplayedHeader>,
+                IteratorState,
                 entryIteratorNext)
   JSG_ITERATOR(KeyIterator, keys,
                 jsg::JsRef<jsg::JsString>,
-                IteratorState<jsg::JsRef<jsg::JsString>>,
-                keyOrValueIteratorNext)
+                IteratorState,
+                keyIteratorNext)
   JSG_ITERATOR(ValueIterator, values,
                 jsg::JsRef<jsg::JsString>,
-                IteratorState<jsg::JsRef<jsg::JsString>>,
-                keyOrValueIteratorNext)
+                IteratorState,
+                valueIteratorNext)
 
   // JavaScript API.
 
@@ -174,7 +265,7 @@ public:
   JSG_SERIALIZABLE(rpc::SerializationTag::HEADERS);
 
   void visitForMemoryInfo(jsg::MemoryTracker& tracker) const {
-    for (const auto& entry : headers) {
+    for (const auto& entry : storage->headers) {
       tracker.trackField("header", entry);
     }
   }
@@ -182,98 +273,23 @@ public:
   static kj::uint hashCode(kj::StringPtr name);
 
 private:
-  struct Header {
-    kj::uint hash;
-    kj::OneOf<uint, kj::String> nameOrIndex;
-    kj::StringPtr getName() const;
-
-    // We intentionally do not comma-concatenate header values of the same name, as we need to be
-    // able to re-serialize them separately. This is particularly important for the Set-Cookie
-    // header, which uses a date format that requires a comma. This would normally suggest using a
-    // std::multimap, but we also need to be able to display the values in comma-concatenated form
-    // via Headers.entries()[1] in order to be Fetch-conformant. Storing a vector of strings in a
-    // std::map makes this easier, and also makes it easy to honor the "first header name casing is
-    // used for all duplicate header names" rule[2] that the Fetch spec mandates.
-    //
-    // See: 1: https://fetch.spec.whatwg.org/#concept-header-list-sort-and-combine
-    //      2: https://fetch.spec.whatwg.org/#concept-header-list-append
-    kj::Vector<jsg::ByteString> values;
-    jsg::ExternalMemoryAdjustment memoryAdjustment;
-
-    Header clone(jsg::Lock& js) const;
-
-    Header(jsg::Lock& js, kj::uint hash, kj::StringPtr name);
-
-    void add(jsg::Lock& js, jsg::ByteString value);
-
-    void set(jsg::Lock& js, jsg::ByteString value);
-
-    JSG_MEMORY_INFO(Header) {
-      KJ_SWITCH_ONEOF(nameOrIndex) {
-        KJ_CASE_ONEOF(idx, uint) {}
-        KJ_CASE_ONEOF(str, kj::String) {
-          tracker.trackField("name", str);
-        }
-      }
-      for (const auto& value : values) {
-        tracker.trackField(nullptr, value);
-      }
-    }
-
-   private:
-    Header(jsg::Lock& js, kj::OneOf<uint, kj::String> nameOrIndex,
-          kj::Array<jsg::ByteString> values, kj::uint hash);
-  };
-
-  struct HeaderCallbacks {
-    constexpr kj::uint keyForRow(const Header& header) const {
-      return header.hash;
-    }
-    constexpr bool matches(const Header& header, kj::uint key) const {
-      return header.hash == key;
-    }
-    constexpr bool matches(const Header& header, kj::StringPtr name) const {
-      return Headers::hashCode(name) == keyForRow(header);
-    }
-    constexpr uint hashCode(kj::uint hash) const { return hash; }
-    constexpr uint hashCode(kj::StringPtr name) const {
-      return Headers::hashCode(name);
-    }
-  };
+  kj::Own<Storage> storage = kj::refcounted<Storage>();
 
-  struct HeaderTreeCallbacks {
-    constexpr kj::StringPtr keyForRow(const Header& header) const {
-      return header.getName();
-    }
-    constexpr bool isBefore(const Header& header, kj::StringPtr name) const {
-      return strcasecmp(header.getName().cStr(), name.cStr()) < 0;
-    }
-    constexpr bool matches(const Header& header, kj::StringPtr name) const {
-      return strcasecmp(header.getName().cStr(), name.cStr()) == 0;
-    }
-  };
+  Guard guard;
 
-  kj::Table<Header, kj::HashIndex<HeaderCallbacks>,
-                    kj::TreeIndex<HeaderTreeCallbacks>> headers;
+  // Returns the header table for modification, first copying it if it is shared.
+  HeaderTable& mutableHeaders(jsg::Lock& js);
 
-  Guard guard;
+  IteratorState startIteration(jsg::Lock& js);
+  static kj::Maybe<DisplayedHeader> nextDisplayedHeader(
+      jsg::Lock& js, IteratorState& state, DisplayedHeaderOption option);
 
   static kj::Maybe<kj::Array<jsg::JsRef<jsg::JsString>>> entryIteratorNext(
-      jsg::Lock& js, auto& state) {
-    if (state.cursor == state.copy.end()) {
-      return kj::none;
-    }
-    auto& ret = *state.cursor++;
-    return kj::arr(kj::mv(ret.key), kj::mv(ret.value));
-  }
-
-  static kj::Maybe<jsg::JsRef<jsg::JsString>> keyOrValueIteratorNext(jsg::Lock& js, auto& state) {
-    if (state.cursor == state.copy.end()) {
-      return kj::none;
-    }
-    auto& ret = *state.cursor++;
-    return kj::mv(ret);
-  }
+      jsg::Lock& js, IteratorState& state);
+  static kj::Maybe<jsg::JsRef<jsg::JsString>> keyIteratorNext(
+      jsg::Lock& js, IteratorState& state);
+  static kj::Maybe<jsg::JsRef<jsg::JsString>> valueIteratorNext(
+      jsg::Lock& js, IteratorState& state);
 };
 
 }  // namespace workerd::api
@@ -54,7 +54,8 @@ const LolHtmlDisposer<T, lolhtmlFree> LolHtmlDisposer<T, lolhtmlFree>::INSTANCE;
 // We cannot use a kj::Own<T> because lol_html_str_t is a struct, not a pointer, so instead we
 // have this LolString RAII wrapper.
 //
-// Use `kj::str(LolString.asChars())` to allocate your own copy of a LolString.
+// Use `kj::str(LolString.asChars())` to allocate your own copy of a LolString, or asJsString() to
+// hand it to JavaScript.
 class LolString {
  public:
   explicit LolString(lol_html_str_t s): chars(s.data, s.len) {}
@@ -84,6 +85,19 @@ class LolString {
     }
   }
 
+  // Copies the string straight into a V8 string, without an intermediate kj::String. (It can't be
+  // an external string, since lol-html's buffer is freed along with the LolString.)
+  jsg::JsString asJsString(jsg::Lock& js) const {
+    return js.str(chars);
+  }
+
+  // Like asJsString(), but for tag and attribute names, which repeat throughout a document: looks
+  // the name up in V8's string table, so each distinct name is only allocated once.
+  jsg::JsString asInternedJsString(jsg::Lock& js) const {
+    return jsg::JsString(jsg::check(v8::String::NewFromUtf8(
+        js.v8Isolate, chars.begin(), v8::NewStringType::kInternalized, chars.size())));
+  }
+
  private:
   kj::ArrayPtr<const char> chars;
 };
@@ -215,6 +229,25 @@ struct UnregisteredDocumentHandlers {
 using UnregisteredElementOrDocumentHandlers =
     kj::OneOf<UnregisteredElementHandlers, UnregisteredDocumentHandlers>;
 
+// Counts the handler functions that a Rewriter will register for these handlers.
+size_t countCallbacks(kj::ArrayPtr<UnregisteredElementOrDocumentHandlers> unregisteredHandlers) {
+  size_t count = 0;
+  for (auto& handlers: unregisteredHandlers) {
+    KJ_SWITCH_ONEOF(handlers) {
+      KJ_CASE_ONEOF(elementHandlers, UnregisteredElementHandlers) {
+        count += (elementHandlers.element != kj::none) + (elementHandlers.comments != kj::none) +
+            (elementHandlers.text != kj::none);
+      }
+      KJ_CASE_ONEOF(documentHandlers, UnregisteredDocumentHandlers) {
+        count += (documentHandlers.doctype != kj::none) +
+            (documentHandlers.comments != kj::none) + (documentHandlers.text != kj::none) +
+            (documentHandlers.end != kj::none);
+      }
+    }
+  }
+  return count;
+}
+
 }  // namespace
 
 // Wrapper around an actual rewriter (streaming parser).
@@ -290,16 +323,17 @@ class Rewriter final: public WritableStreamSink {
     ElementCallbackFunction callback;
   };
 
-  kj::Vector<kj::Own<RegisteredHandler>> registeredHandlers;
-  // TODO(perf): Don't store Owns. We need to pass stable pointers as the userdata parameter to
-  //   lol_html_rewriter_builder_add_*_content_handlers(), but don't have a really easy way to
-  //   know precisely how many handlers we're going to register beforehand, so we need a vector. But
-  //   vectors can grow, moving their objects around, invalidating pointers into their storage.
+  // We pass pointers into this as the userdata parameter to
+  // lol_html_rewriter_builder_add_*_content_handlers(), so it must never move its elements. Its
+  // capacity is counted upfront (see countCallbacks()), so it never has to grow.
+  kj::ArrayBuilder<RegisteredHandler> registeredHandlers;
 
   // This is separate from `registeredHandlers` so we can delete them more eagerly when EndTags are
   // destroyed, and not have to look through all other handlers.
   kj::Vector<kj::Own<RegisteredHandler>> registeredEndTagHandlers;
-  // TODO(perf) Don't store Owns, same as `registeredHandlers` above.
+  // TODO(perf) Don't store Owns. We need to pass stable pointers as the userdata parameter to
+  //   lol_html_element_add_end_tag_handler(), but vectors can grow, moving their objects around,
+  //   invalidating pointers into their storage.
 
   template <typename T, typename CType = typename T::CType>
   static lol_html_rewriter_directive_t thunk(CType* content, void* userdata);
@@ -321,8 +355,8 @@ class Rewriter final: public WritableStreamSink {
   int replacerThunkImpl(lol_html_streaming_sink_t* sink, RegisteredReplacer& registration);
   static void removeRegisteredReplacer(void* userData);
 
-  // Must be constructed AFTER the registered handler vector, since the function which constructs
-  // this (buildRewriter()) modifies that vector.
+  // Must be constructed AFTER the registered handler array, since the function which constructs
+  // this (buildRewriter()) adds to that array.
   kj::Own<lol_html_HtmlRewriter> rewriter;
 
   // Stores data written by lol-html, which will be periodically flushed to inner.
@@ -371,7 +405,7 @@ kj::Own<lol_html_HtmlRewriter> Rewriter::buildRewriter(jsg::Lock& js,
 
   auto registerCallback = [&](ElementCallbackFunction& callback) {
     auto registeredHandler = RegisteredHandler{rewriter, callback.addRef(js)};
-    return rewriter.registeredHandlers.add(kj::heap(kj::mv(registeredHandler))).get();
+    return &rewriter.registeredHandlers.add(kj::mv(registeredHandler));
   };
 
   for (auto& handlers: unregisteredHandlers) {
@@ -429,7 +463,9 @@ Rewriter::Rewriter(jsg::Lock& js,
     kj::ArrayPtr<UnregisteredElementOrDocumentHandlers> unregisteredHandlers,
     kj::ArrayPtr<const char> encoding,
     kj::Own<WritableStreamSink> inner)
-    : rewriter(buildRewriter(js, unregisteredHandlers, encoding, *this)),
+    : registeredHandlers(
+          kj::heapArrayBuilder<RegisteredHandler>(countCallbacks(unregisteredHandlers))),
+      rewriter(buildRewriter(js, unregisteredHandlers, encoding, *this)),
       externalMemoryAdjustment(js.getExternalMemoryAdjustment()),
       inner(kj::mv(inner)),
       ioContext(IoContext::current()),
@@ -809,9 +845,9 @@ Element::Element(CType& element, Rewriter& rewriter) {
   impl.emplace(element, rewriter);
 }
 
-kj::String Element::getTagName() {
+jsg::JsString Element::getTagName(jsg::Lock& js) {
   auto tagName = LolString(lol_html_element_tag_name_get(&checkToken(impl).element));
-  return kj::str(tagName.asChars());
+  return tagName.asInternedJsString(js);
 }
 
 void Element::setTagName(kj::String name) {
@@ -837,15 +873,13 @@ jsg::Ref<Element::AttributesIterator> Element::getAttributes(jsg::Lock& js) {
   return kj::mv(jsIter);
 }
 
-kj::Maybe<kj::String> Element::getAttribute(kj::String name) {
+kj::Maybe<jsg::JsString> Element::getAttribute(jsg::Lock& js, kj::String name) {
   // NOTE: lol_html_element_get_attribute() returns NULL for both nonexistent attributes and for
   //   errors, so we can't use check() here.
   LolString attr(
       lol_html_element_get_attribute(&checkToken(impl).element, name.cStr(), name.size()));
-  // TODO(perf): We could construct a v8::String directly here, saving a copy.
-  kj::Maybe kjAttr = attr.asKjString();
-  if (kjAttr != kj::none) {
-    return kj::mv(kjAttr);
+  if (attr.asChars().begin() != nullptr) {
+    return attr.asJsString(js);
   }
 
   KJ_IF_SOME(exception, tryGetLastError()) {
@@ -946,9 +980,9 @@ void EndTag::htmlContentScopeEnd() {
   impl = kj::none;
 }
 
-kj::String EndTag::getName() {
+jsg::JsString EndTag::getName(jsg::Lock& js) {
   auto text = LolString(lol_html_end_tag_name_get(&checkToken(impl).element));
-  return kj::str(text.asChars());
+  return text.asInternedJsString(js);
 }
 
 void EndTag::setName(kj::String text) {
@@ -992,7 +1026,7 @@ jsg::Ref<Element::AttributesIterator> Element::AttributesIterator::self() {
   return JSG_THIS;
 }
 
-Element::AttributesIterator::Next Element::AttributesIterator::next() {
+Element::AttributesIterator::Next Element::AttributesIterator::next(jsg::Lock& js) {
   // NOTE: lol_html_attribute_t doesn't need to be freed.
   auto* attribute = lol_html_attributes_iterator_next(checkToken(impl));
   if (attribute == nullptr) {
@@ -1005,7 +1039,7 @@ Element::AttributesIterator::Next Element::AttributesIterator::next() {
   auto name = LolString(lol_html_attribute_name_get(attribute));
   auto value = LolString(lol_html_attribute_value_get(attribute));
 
-  return {false, kj::arr(kj::str(name.asChars()), kj::str(value.asChars()))};
+  return {false, js.arr(name.asInternedJsString(js), value.asJsString(js))};
 }
 
 void Element::AttributesIterator::htmlContentScopeEnd() {
@@ -1017,9 +1051,9 @@ void Element::AttributesIterator::htmlContentScopeEnd() {
 
 Comment::Comment(CType& comment, Rewriter&): impl(comment) {}
 
-kj::String Comment::getText() {
+jsg::JsString Comment::getText(jsg::Lock& js) {
   auto text = LolString(lol_html_comment_text_get(&checkToken(impl)));
-  return kj::str(text.asChars());
+  return text.asJsString(js);
 }
 
 void Comment::setText(kj::String text) {
@@ -1078,9 +1112,10 @@ Text::Text(CType& text, Rewriter& rewriter) {
   impl.emplace(text, rewriter);
 }
 
-kj::String Text::getText() {
+jsg::JsString Text::getText(jsg::Lock& js) {
+  // The chunk's content is borrowed from lol-html's parser buffer, so V8 copies it directly.
   auto content = lol_html_text_chunk_content_get(&checkToken(impl).element);
-  return kj::heapString(content.data, content.len);
+  return js.str(kj::ArrayPtr<const char>(content.data, content.len));
 }
 
 bool Text::getLastInTextNode() {
@@ -180,7 +180,7 @@ class Element final: public HTMLRewriter::Token {
 
   explicit Element(CType& element, Rewriter& wrapper);
 
-  kj::String getTagName();
+  jsg::JsString getTagName(jsg::Lock& js);
   void setTagName(kj::String tagName);
 
   class AttributesIterator;
@@ -190,7 +190,7 @@ class Element final: public HTMLRewriter::Token {
 
   kj::StringPtr getNamespaceURI();
 
-  kj::Maybe<kj::String> getAttribute(kj::String name);
+  kj::Maybe<jsg::JsString> getAttribute(jsg::Lock& js, kj::String name);
   bool hasAttribute(kj::String name);
   jsg::Ref<Element> setAttribute(kj::String name, kj::String value);
   jsg::Ref<Element> removeAttribute(kj::String name);
@@ -258,12 +258,15 @@ class Element::AttributesIterator final: public HTMLRewriter::Token {
 
   struct Next {
     bool done;
-    jsg::Optional<kj::Array<kj::String>> value;
+    jsg::Optional<jsg::JsArray> value;
 
     JSG_STRUCT(done, value);
+    JSG_STRUCT_TS_OVERRIDE({
+      value?: string[];
+    });
   };
 
-  Next next();
+  Next next(jsg::Lock& js);
 
   jsg::Ref<AttributesIterator> self();
 
@@ -285,7 +288,7 @@ class EndTag final: public HTMLRewriter::Token {
 
   explicit EndTag(CType& tag, Rewriter& rewriter);
 
-  kj::String getName();
+  jsg::JsString getName(jsg::Lock& js);
   void setName(kj::String);
 
   jsg::Ref<EndTag> before(Content content, jsg::Optional<ContentOptions> options);
@@ -314,7 +317,7 @@ class Comment final: public HTMLRewriter::Token {
 
   explicit Comment(CType& comment, Rewriter&);
 
-  kj::String getText();
+  jsg::JsString getText(jsg::Lock& js);
   void setText(kj::String);
 
   bool getRemoved();
@@ -354,7 +357,7 @@ class Text final: public HTMLRewriter::Token {
 
   explicit Text(CType& text, Rewriter& rewriter);
 
-  kj::String getText();
+  jsg::JsString getText(jsg::Lock& js);
 
   bool getLastInTextNode();
 
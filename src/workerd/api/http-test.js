@@ -361,3 +361,59 @@ export const cacheMode = {
     }
   },
 };
+
+export const headersCopyOnWrite = {
+  test() {
+    // Copies of a Headers object share storage until one of them is modified. Make sure a
+    // modification is never visible through the other copies, or through live iterators.
+    const original = new Headers([
+      ['Content-Type', 'text/plain'],
+      ['X-Custom', 'a'],
+      ['Set-Cookie', 'a=1'],
+      ['Set-Cookie', 'b=2'],
+    ]);
+    const copy = new Headers(original);
+    const request = new Request('http://example.org', { headers: original });
+    const cloned = request.clone();
+
+    copy.set('x-custom', 'b');
+    copy.delete('content-type');
+    original.append('x-other', 'c');
+    assert.strictEqual(original.get('x-custom'), 'a');
+    assert.strictEqual(original.get('content-type'), 'text/plain');
+    assert.strictEqual(copy.get('x-custom'), 'b');
+    assert.strictEqual(copy.has('x-other'), false);
+    assert.strictEqual(request.headers.get('x-custom'), 'a');
+
+    request.headers.set('x-custom', 'd');
+    assert.strictEqual(cloned.headers.get('x-custom'), 'a');
+
+    const entries = original.entries();
+    const keys = original.keys();
+    original.delete('set-cookie');
+    original.set('x-custom', 'e');
+    assert.deepStrictEqual(
+      [...entries],
+      [
+        ['content-type', 'text/plain'],
+        ['set-cookie', 'a=1'],
+        ['set-cookie', 'b=2'],
+        ['x-custom', 'a'],
+        ['x-other', 'c'],
+      ]
+    );
+    assert.deepStrictEqual(
+      [...keys],
+      ['content-type', 'set-cookie', 'set-cookie', 'x-custom', 'x-other']
+    );
+    assert.deepStrictEqual([...original.values()], ['text/plain', 'e', 'c']);
+
+    const seen = [];
+    original.forEach((value, key) => {
+      original.delete(key);
+      seen.push(key);
+    });
+    assert.deepStrictEqual(seen, ['content-type', 'x-custom', 'x-other']);
+    assert.deepStrictEqual([...original], []);
+  },
+};
@@ -92,6 +92,44 @@ class BodyBufferInputStream final: public ReadableStreamSource {
   kj::OneOf<kj::Own<Body::RefcountedBytes>, jsg::Ref<Blob>> ownBytes;
 };
 
+// Feeds a body to a FormData::StreamingParser as it arrives, so that Body::formData() doesn't
+// have to buffer the whole body before parsing it. `limit` bounds the body size just like the
+// buffering limit that applies when the body is read in full.
+class FormDataSink final: public WritableStreamSink {
+ public:
+  FormDataSink(FormData::StreamingParser& parser, uint64_t limit): parser(parser), limit(limit) {}
+
+  kj::Promise<void> write(kj::ArrayPtr<const byte> buffer) override {
+    return kj::evalNow([&]() { feed(buffer); });
+  }
+
+  kj::Promise<void> write(kj::ArrayPtr<const kj::ArrayPtr<const byte>> pieces) override {
+    return kj::evalNow([&]() {
+      for (auto piece: pieces) {
+        feed(piece);
+      }
+    });
+  }
+
+  kj::Promise<void> end() override {
+    // Not every source calls end(), so the parser is finished by whoever started the pump.
+    return kj::READY_NOW;
+  }
+
+  void abort(kj::Exception reason) override {}
+
+ private:
+  FormData::StreamingParser& parser;
+  uint64_t limit;
+  uint64_t written = 0;
+
+  void feed(kj::ArrayPtr<const byte> piece) {
+    written += piece.size();
+    JSG_REQUIRE(written <= limit, TypeError, "Memory limit exceeded before EOF.");
+    parser.write(piece);
+  }
+};
+
 }  // namespace
 
 // Make an array of characters containing random hexadecimal digits.
@@ -315,6 +353,24 @@ jsg::Promise<jsg::Ref<FormData>> Body::formData(jsg::Lock& js) {
     KJ_IF_SOME(i, impl) {
       KJ_ASSERT(!i.stream->isDisturbed());
       auto& context = IoContext::current();
+
+      KJ_IF_SOME(boundary, FormData::tryGetMultipartBoundary(contentType)) {
+        // Parse multipart bodies as they stream in, so that only the parsed entries are held in
+        // memory rather than the raw body as well.
+        auto parser = kj::heap<FormData::StreamingParser>(boundary);
+        auto sink = kj::heap<FormDataSink>(*parser, context.getLimitEnforcer().getBufferingLimit());
+        auto promise = context.waitForDeferredProxy(i.stream->pumpTo(js, kj::mv(sink), true))
+                           .then([&parser = *parser]() { return parser.end(); })
+                           .attach(kj::mv(parser));
+        return context.awaitIo(js, kj::mv(promise),
+            [formData = kj::mv(formData)](
+                jsg::Lock& js, kj::Array<FormData::EntryWithoutLock> entries) mutable {
+          formData->addEntries(
+              js, kj::mv(entries), !FeatureFlags::get(js).getFormDataParserSupportsFiles());
+          return kj::mv(formData);
+        });
+      }
+
       return i.stream->getController()
           .readAllText(js, context.getLimitEnforcer().getBufferingLimit())
           .then(js,
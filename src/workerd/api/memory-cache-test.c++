@@ -0,0 +1,77 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "memory-cache.h"
+
+#include <workerd/io/io-util.h>
+#include <workerd/tests/test-fixture.h>
+
+#include <kj/test.h>
+
+namespace workerd::api {
+namespace {
+
+// Stores a value of the given size under `key`, as a read with a fallback would.
+kj::Promise<void> put(const SharedMemoryCache::Use& use,
+    kj::StringPtr key,
+    size_t size,
+    kj::Maybe<double> expiration) {
+  using Use = SharedMemoryCache::Use;
+  SpanBuilder span(nullptr);
+  auto result = use.getWithFallback(kj::str(key), span);
+  auto& promise = KJ_ASSERT_NONNULL(result.tryGet<kj::Promise<Use::GetWithFallbackOutcome>>());
+  auto outcome = co_await kj::mv(promise);
+  auto& callback = KJ_ASSERT_NONNULL(outcome.tryGet<Use::FallbackDoneCallback>());
+  callback(Use::FallbackResult{
+    .value = kj::atomicRefcounted<CacheValue>(kj::heapArray<kj::byte>(size)),
+    .expiration = expiration,
+  });
+}
+
+KJ_TEST("reading an expired entry removes it from the cache's accounting") {
+  TestFixture fixture;
+
+  // The resize handler is the only view into the cache's accounting. It runs whenever a limit
+  // that isn't already known is suggested or withdrawn.
+  size_t keyCount = 0;
+  size_t totalValueSize = 0;
+  SharedMemoryCache::AdditionalResizeMemoryLimitHandler handler =
+      [&](SharedMemoryCache::ThreadUnsafeData& data) {
+    keyCount = data.cache.size();
+    totalValueSize = data.totalValueSize;
+  };
+  auto cache = SharedMemoryCache::create(
+      kj::none, "test"_kj, handler, kj::systemPreciseMonotonicClock());
+  SharedMemoryCache::Use use(kj::atomicAddRef(*cache),
+      {.maxKeys = 10, .maxValueSize = 100, .maxTotalValueSize = 1000});
+  auto refreshAccounting = [&]() {
+    SharedMemoryCache::Use probe(kj::atomicAddRef(*cache),
+        {.maxKeys = 11, .maxValueSize = 100, .maxTotalValueSize = 1000});
+  };
+
+  double expiration = 0;
+  fixture.runInIoContext([&](const TestFixture::Environment& env) -> kj::Promise<void> {
+    expiration = dateNow() + 5;
+    co_await put(use, "live"_kj, 10, kj::none);
+    co_await put(use, "expiring"_kj, 20, expiration);
+  });
+  refreshAccounting();
+  KJ_EXPECT(keyCount == 2);
+  KJ_EXPECT(totalValueSize == 30);
+
+  fixture.runInIoContext([&](const TestFixture::Environment& env) {
+    while (dateNow() <= expiration) {
+      // Wait for the entry to expire.
+    }
+    SpanBuilder span(nullptr);
+    KJ_EXPECT(use.getWithoutFallback(kj::str("expiring"), span) == kj::none);
+    KJ_EXPECT(use.getWithoutFallback(kj::str("live"), span) != kj::none);
+  });
+  refreshAccounting();
+  KJ_EXPECT(keyCount == 1);
+  KJ_EXPECT(totalValueSize == 10);
+}
+
+}  // namespace
+}  // namespace workerd::api
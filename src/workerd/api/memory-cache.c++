@@ -89,7 +89,7 @@ void SharedMemoryCache::resize(ThreadUnsafeData& data) const {
 
   // First, remove any values that might be too large.
   while (data.cache.size() != 0) {
-    MemoryCacheEntry& largestEntry = *data.cache.ordered<2>().begin();
+    MemoryCacheEntry& largestEntry = *data.cache.ordered<1>().begin();
     if (largestEntry.size() <= data.effectiveLimits.maxValueSize) {
       break;
     }
@@ -104,34 +104,39 @@ void SharedMemoryCache::resize(ThreadUnsafeData& data) const {
   }
 }
 
-kj::Maybe<kj::Own<CacheValue>> SharedMemoryCache::getWhileLocked(
-    ThreadUnsafeData& data, const kj::String& key) const {
+kj::Maybe<kj::Own<const CacheValue>> SharedMemoryCache::getWhileLocked(
+    const ThreadUnsafeData& data, const kj::String& key, bool& foundExpired) const {
   KJ_IF_SOME(existingCacheEntry, data.cache.find(key)) {
     if (hasExpired(existingCacheEntry.expiration)) {
       // The cache entry has an associated expiration time and that time has
       // passed (according to the calling IoContext's timer).
-      data.totalValueSize -= existingCacheEntry.size();
-      data.cache.erase(existingCacheEntry);
+      foundExpired = true;
       return kj::none;
     }
 
-    // Obtain a reference to the cache value before we kj::mv the cache entry.
-    auto cacheValue = kj::atomicAddRef(*existingCacheEntry.value);
-
-    // Update the liveliness.
-    MemoryCacheEntry entry = data.cache.release(existingCacheEntry);
-    entry.liveliness = data.stepLiveliness();
-    data.cache.insert(kj::mv(entry));
-
-    return kj::mv(cacheValue);
+    existingCacheEntry.liveliness.set(data.stepLiveliness());
+    // Adding a reference is atomic, so it is safe under a shared lock.
+    return kj::atomicAddRef(*existingCacheEntry.value);
   } else {
     return kj::none;
   }
 }
 
+kj::Maybe<kj::Own<const CacheValue>> SharedMemoryCache::getWhileLocked(
+    ThreadUnsafeData& data, const kj::String& key) const {
+  bool foundExpired = false;
+  auto result = getWhileLocked(kj::implicitCast<const ThreadUnsafeData&>(data), key, foundExpired);
+  if (foundExpired) {
+    // Expired entries still count against the cache's limits, so don't leave
+    // them for eviction.
+    removeIfExistsWhileLocked(data, key);
+  }
+  return result;
+}
+
 void SharedMemoryCache::putWhileLocked(ThreadUnsafeData& data,
     const kj::String& key,
-    kj::Own<CacheValue>&& value,
+    kj::Own<const CacheValue>&& value,
     kj::Maybe<double> expiration) const {
   size_t valueSize = value->bytes.size();
   if (valueSize > data.effectiveLimits.maxValueSize) {
@@ -159,7 +164,7 @@ void SharedMemoryCache::putWhileLocked(ThreadUnsafeData& data,
       // risk of evicting it.
       evictNextWhileLocked(data);
     }
-    updatedEntry.liveliness = data.stepLiveliness();
+    updatedEntry.liveliness.set(data.stepLiveliness());
     updatedEntry.value = kj::mv(value);
     updatedEntry.expiration = expiration;
     data.cache.insert(kj::mv(updatedEntry));
@@ -175,7 +180,7 @@ void SharedMemoryCache::putWhileLocked(ThreadUnsafeData& data,
     }
     MemoryCacheEntry newEntry = {
       kj::str(key),
-      data.stepLiveliness(),
+      MemoryCacheEntry::Liveliness(data.stepLiveliness()),
       kj::mv(value),
       expiration,
     };
@@ -190,7 +195,7 @@ void SharedMemoryCache::evictNextWhileLocked(
   KJ_REQUIRE(data.cache.size() > 0);
 
   // If there is an entry that has expired already, evict that one.
-  MemoryCacheEntry& maybeExpired = *data.cache.ordered<3>().begin();
+  MemoryCacheEntry& maybeExpired = *data.cache.ordered<2>().begin();
   KJ_ASSERT(data.totalValueSize >= maybeExpired.size());
   if (hasExpired(maybeExpired.expiration, allowOutsideIoContext)) {
     data.totalValueSize -= maybeExpired.size();
@@ -198,8 +203,30 @@ void SharedMemoryCache::evictNextWhileLocked(
     return;
   }
 
-  // Otherwise, if no entry has expired, evict the least recently used entry.
-  MemoryCacheEntry& leastRecentlyUsed = *data.cache.ordered<1>().begin();
+  // Otherwise, if no entry has expired, evict the least recently used entry
+  // among a random sample.
+  MemoryCacheEntry* rows = data.cache.begin();
+  size_t rowCount = data.cache.size();
+  MemoryCacheEntry* candidate = nullptr;
+  auto consider = [&](MemoryCacheEntry& entry) {
+    if (candidate == nullptr || entry.liveliness.get() < candidate->liveliness.get()) {
+      candidate = &entry;
+    }
+  };
+  if (rowCount <= LRU_SAMPLE_SIZE) {
+    for (size_t i = 0; i < rowCount; i++) {
+      consider(rows[i]);
+    }
+  } else {
+    for (size_t i = 0; i < LRU_SAMPLE_SIZE; i++) {
+      uint64_t& x = data.sampleState;
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      consider(rows[x % rowCount]);
+    }
+  }
+  MemoryCacheEntry& leastRecentlyUsed = *candidate;
   KJ_ASSERT(data.totalValueSize >= leastRecentlyUsed.size());
   data.totalValueSize -= leastRecentlyUsed.size();
   data.cache.erase(leastRecentlyUsed);
@@ -242,18 +269,42 @@ SharedMemoryCache::Use::~Use() noexcept(false) {
   }
 }
 
-kj::Maybe<kj::Own<CacheValue>> SharedMemoryCache::Use::getWithoutFallback(
+kj::Maybe<kj::Own<const CacheValue>> SharedMemoryCache::Use::getWithoutFallback(
     const kj::String& key, SpanBuilder& span) const {
-  kj::Locked<ThreadUnsafeData> data = [&] {
-    auto memoryCacheLockRecord =
-        ScopedDurationTagger(span, memoryCachekLockWaitTimeTag, cache->timer);
-    return cache->data.lockExclusive();
-  }();
-  return cache->getWhileLocked(*data, key);
+  bool foundExpired = false;
+  {
+    kj::Locked<const ThreadUnsafeData> data = [&] {
+      auto memoryCacheLockRecord =
+          ScopedDurationTagger(span, memoryCachekLockWaitTimeTag, cache->timer);
+      return cache->data.lockShared();
+    }();
+    KJ_IF_SOME(value, cache->getWhileLocked(*data, key, foundExpired)) {
+      return kj::mv(value);
+    }
+  }
+
+  if (foundExpired) {
+    // Removing the expired entry needs an exclusive lock. Look the key up
+    // again, since it may have been replaced in the meantime.
+    kj::Locked<ThreadUnsafeData> data = [&] {
+      auto memoryCacheLockRecord =
+          ScopedDurationTagger(span, memoryCachekLockWaitTimeTag, cache->timer);
+      return cache->data.lockExclusive();
+    }();
+    return cache->getWhileLocked(*data, key);
+  }
+  return kj::none;
 }
 
-kj::OneOf<kj::Own<CacheValue>, kj::Promise<SharedMemoryCache::Use::GetWithFallbackOutcome>>
+kj::OneOf<kj::Own<const CacheValue>, kj::Promise<SharedMemoryCache::Use::GetWithFallbackOutcome>>
 SharedMemoryCache::Use::getWithFallback(const kj::String& key, SpanBuilder& span) const {
+  // Most reads are hits, which only need a shared lock.
+  KJ_IF_SOME(existingValue, getWithoutFallback(key, span)) {
+    return kj::mv(existingValue);
+  }
+
+  // The value might have been added since we released the shared lock, so
+  // look again now that nobody else can add it.
   kj::Locked<ThreadUnsafeData> data = [&] {
     auto memoryCacheLockRecord =
         ScopedDurationTagger(span, memoryCachekLockWaitTimeTag, cache->timer);
@@ -356,12 +407,12 @@ void SharedMemoryCache::Use::delete_(const kj::String& key) const {
 
 // Attempts to serialize a JavaScript value. If that fails, this function throws
 // a tunneled exception, see jsg::createTunneledException().
-static kj::Own<CacheValue> hackySerialize(jsg::Lock& js, jsg::JsRef<jsg::JsValue>& value) {
-  return js.tryCatch([&]() -> kj::Own<CacheValue> {
+static kj::Own<const CacheValue> hackySerialize(jsg::Lock& js, jsg::JsRef<jsg::JsValue>& value) {
+  return js.tryCatch([&]() -> kj::Own<const CacheValue> {
     jsg::Serializer serializer(js);
     serializer.write(js, value.getHandle(js));
     return kj::atomicRefcounted<CacheValue>(serializer.release().data);
-  }, [&](jsg::Value&& exception) -> kj::Own<CacheValue> {
+  }, [&](jsg::Value&& exception) -> kj::Own<const CacheValue> {
     // We run into big problems with tunneled exceptions here. When
     // the toString() function of the JavaScript error is not marked
     // as side effect free, tunneling the exception fails entirely
@@ -392,7 +443,7 @@ jsg::Promise<jsg::JsRef<jsg::JsValue>> MemoryCache::read(jsg::Lock& js,
 
   KJ_IF_SOME(fallback, optionalFallback) {
     KJ_SWITCH_ONEOF(cacheUse.getWithFallback(key.value, readSpan)) {
-      KJ_CASE_ONEOF(result, kj::Own<CacheValue>) {
+      KJ_CASE_ONEOF(result, kj::Own<const CacheValue>) {
         // Optimization: Don't even release the isolate lock if the value is already in cache.
         jsg::Deserializer deserializer(js, result->bytes.asPtr());
         return js.resolvedPromise(jsg::JsRef(js, deserializer.readValue(js)));
@@ -404,7 +455,7 @@ jsg::Promise<jsg::JsRef<jsg::JsValue>> MemoryCache::read(jsg::Lock& js,
                 jsg::Lock& js, SharedMemoryCache::Use::GetWithFallbackOutcome cacheResult) mutable
             -> jsg::Promise<jsg::JsRef<jsg::JsValue>> {
           KJ_SWITCH_ONEOF(cacheResult) {
-            KJ_CASE_ONEOF(serialized, kj::Own<CacheValue>) {
+            KJ_CASE_ONEOF(serialized, kj::Own<const CacheValue>) {
               jsg::Deserializer deserializer(js, serialized->bytes.asPtr());
               return js.resolvedPromise(jsg::JsRef(js, deserializer.readValue(js)));
             }
@@ -9,6 +9,7 @@
 #include <kj/table.h>
 #include <kj/time.h>
 
+#include <atomic>
 #include <list>
 #include <set>
 
@@ -49,23 +50,38 @@ struct MemoryCacheEntry {
   kj::String key;
 
   // Whenever an entry is created, updated, or retrieved, its liveliness is
-  // set to the value of a monotonically increasing counter.
-  uint64_t liveliness;
-  // TODO(cleanup): The liveliness index accomplishes the same thing as
-  //   kj::InsertionOrderIndex.
-  //
-  // TODO(perf): Updating a cache entry's liveliness requires a re-insertion,
-  //   which means that cache reads require an exclusive lock. This may be
-  //   suboptimal for a read-heavy workload. WorkerSet avoids this by atomically
-  //   updating a `lastUsed` timestamp. The tradeoff is that LRU-eviction
-  //   becomes O(n) instead of O(1), since we can no longer use kj::Table's
-  //   index to find the LRU entry.
+  // set to the value of a monotonically increasing counter. Like WorkerSet's
+  // `lastUsed` timestamps, this is updated atomically so that reads only need
+  // a shared lock on the cache. The tradeoff is that there is no index over
+  // liveliness, so eviction approximates LRU by sampling (see
+  // SharedMemoryCache::evictNextWhileLocked()).
+  class Liveliness {
+   public:
+    explicit Liveliness(uint64_t value): value(value) {}
+    // Entries are only moved while the cache is locked exclusively.
+    Liveliness(Liveliness&& other): value(other.get()) {}
+    Liveliness& operator=(Liveliness&& other) {
+      set(other.get());
+      return *this;
+    }
+
+    inline uint64_t get() const {
+      return value.load(std::memory_order_relaxed);
+    }
+    inline void set(uint64_t newValue) const {
+      value.store(newValue, std::memory_order_relaxed);
+    }
+
+   private:
+    mutable std::atomic<uint64_t> value;
+  };
+  Liveliness liveliness;
 
   // The stored JavaScript value, serialized by V8. It is atomicRefcounted to
   // allow threads to deserialize the value without having to lock the cache,
   // so the value can even be deserialized while the cache entry is being
   // evicted.
-  kj::Own<CacheValue> value;
+  kj::Own<const CacheValue> value;
 
   inline size_t size() const {
     return value->bytes.size();
@@ -183,22 +199,22 @@ class SharedMemoryCache: public kj::AtomicRefcounted {
     // Returns a cached value for the given key if one exists (and has not
     // expired). If no such value exists, nothing is returned, regardless of any
     // in-progress fallbacks trying to produce such a value.
-    kj::Maybe<kj::Own<CacheValue>> getWithoutFallback(
+    kj::Maybe<kj::Own<const CacheValue>> getWithoutFallback(
         const kj::String& key, SpanBuilder& span) const;
 
     struct FallbackResult {
-      kj::Own<CacheValue> value;
+      kj::Own<const CacheValue> value;
       kj::Maybe<double> expiration;
     };
     using FallbackDoneCallback = kj::Function<void(kj::Maybe<FallbackResult>)>;
-    using GetWithFallbackOutcome = kj::OneOf<kj::Own<CacheValue>, FallbackDoneCallback>;
+    using GetWithFallbackOutcome = kj::OneOf<kj::Own<const CacheValue>, FallbackDoneCallback>;
 
     // Returns either:
     // 1. The immediate value, if already in cache.
     // 2. A Promise that will eventually resolve either to the cached value
     //    or to a FallbackDoneCallback. In the latter case, the caller should
     //    invoke the fallback function.
-    kj::OneOf<kj::Own<CacheValue>, kj::Promise<GetWithFallbackOutcome>> getWithFallback(
+    kj::OneOf<kj::Own<const CacheValue>, kj::Promise<GetWithFallbackOutcome>> getWithFallback(
         const kj::String& key, SpanBuilder& span) const;
 
     void delete_(const kj::String& key) const;
@@ -273,24 +289,34 @@ class SharedMemoryCache: public kj::AtomicRefcounted {
   // does not change the cache contents).
   void resize(ThreadUnsafeData& data) const;
 
-  // Returns a cached value while the cache's data is already locked by the
-  // calling thread. If such a cache entry exists, it will be marked as the
-  // most recently used entry.
-  kj::Maybe<kj::Own<CacheValue>> getWhileLocked(
+  // Returns a cached value while the cache's data is already locked
+  // exclusively by the calling thread. If such a cache entry exists, it will be
+  // marked as the most recently used entry. Expired entries are removed.
+  kj::Maybe<kj::Own<const CacheValue>> getWhileLocked(
       ThreadUnsafeData& data, const kj::String& key) const;
 
+  // Like the above, but a shared lock suffices, since the entry is marked as
+  // the most recently used one atomically. An expired entry is treated as
+  // missing and `foundExpired` is set, so that the caller can remove it under
+  // an exclusive lock.
+  kj::Maybe<kj::Own<const CacheValue>> getWhileLocked(
+      const ThreadUnsafeData& data, const kj::String& key, bool& foundExpired) const;
+
   // Stores a value in the cache, with an optional expiration timestamp. It is
   // marked as the most recently used entry.
   void putWhileLocked(ThreadUnsafeData& data,
       const kj::String& key,
-      kj::Own<CacheValue>&& value,
+      kj::Own<const CacheValue>&& value,
       kj::Maybe<double> expiration) const;
 
   // Evicts at least one cache entry. The cache's data must already be locked by
   // the calling thread, and the cache must not be empty. Expiration timestamps
   // are only considered if called from within an I/O context or if
-  // allowOutsideIoContext is true.
+  // allowOutsideIoContext is true. If nothing has expired, this evicts the
+  // least recently used of LRU_SAMPLE_SIZE randomly chosen entries, which is
+  // exact for caches no larger than that.
   void evictNextWhileLocked(ThreadUnsafeData& data, bool allowOutsideIoContext = false) const;
+  static constexpr size_t LRU_SAMPLE_SIZE = 8;
 
   // Removes the cache entry with the given key, if it exists.
   void removeIfExistsWhileLocked(ThreadUnsafeData& data, const kj::String& key) const;
@@ -315,25 +341,6 @@ class SharedMemoryCache: public kj::AtomicRefcounted {
     }
   };
 
-  // Callbacks for a TreeIndex that allow sorting cache entries by their
-  // liveliness. This is used to evict the least recently used entry.
-  class LivelinessCallbacks {
-   public:
-    inline const uint64_t& keyForRow(const MemoryCacheEntry& entry) const {
-      return entry.liveliness;
-    }
-
-    template <typename KeyLike>
-    inline bool matches(const MemoryCacheEntry& e, KeyLike&& key) const {
-      return e.liveliness == key;
-    }
-
-    template <typename KeyLike>
-    inline bool isBefore(const MemoryCacheEntry& e, KeyLike&& key) const {
-      return e.liveliness < key;
-    }
-  };
-
   // Callbacks for a TreeIndex that allow sorting cache entries by the sizes
   // of the serialized values. The entries are sorted in reverse order, i.e.,
   // the first entry contains the largest value. This is used to quickly evict
@@ -410,15 +417,20 @@ class SharedMemoryCache: public kj::AtomicRefcounted {
     Limits effectiveLimits = Limits::min();
 
     // Returns the next liveliness and increments it so that the next call to
-    // this function will return a different value.
-    inline uint64_t stepLiveliness() {
-      return nextLiveliness++;
+    // this function will return a different value. This may be called while
+    // holding only a shared lock.
+    inline uint64_t stepLiveliness() const {
+      return nextLiveliness.fetch_add(1, std::memory_order_relaxed);
     }
 
     // We do not handle integer overflow, but a 64-bit counter should never wrap
     // around, at least not in the foreseeable future. (Even at a billion cache
     // operations per second, it would take almost 600 years.)
-    uint64_t nextLiveliness = 0;
+    mutable std::atomic<uint64_t> nextLiveliness = 0;
+
+    // State of the xorshift generator used to sample eviction candidates. This
+    // needs neither to be unpredictable nor well-distributed, just cheap.
+    uint64_t sampleState = 0x9e3779b97f4a7c15;
 
     // The sum of the sizes of all values that are currently stored in the cache.
     // This is technically redundant information, but more efficient than
@@ -426,11 +438,10 @@ class SharedMemoryCache: public kj::AtomicRefcounted {
     size_t totalValueSize = 0;
 
     // The actual cache contents.
-    kj::Table<MemoryCacheEntry,              // row type
-        kj::HashIndex<KeyCallbacks>,         // index over keys
-        kj::TreeIndex<LivelinessCallbacks>,  // index over liveliness
-        kj::TreeIndex<ValueSizeCallbacks>,   // index over value sizes
-        kj::TreeIndex<ExpirationCallbacks>   // index over expiration
+    kj::Table<MemoryCacheEntry,             // row type
+        kj::HashIndex<KeyCallbacks>,        // index over keys
+        kj::TreeIndex<ValueSizeCallbacks>,  // index over value sizes
+        kj::TreeIndex<ExpirationCallbacks>  // index over expiration
         >
         cache;
 
@@ -444,9 +455,9 @@ class SharedMemoryCache: public kj::AtomicRefcounted {
   };
 
  private:
-  // To ensure thread-safety, all mutable data is guarded by a mutex. Each cache
-  // operation requires an exclusive lock. Even read-only operations need to
-  // update the liveliness of cache entries, which currently requires a lock.
+  // To ensure thread-safety, all mutable data is guarded by a mutex. Reads of
+  // existing entries only take a shared lock, since liveliness is updated
+  // atomically; everything else requires an exclusive lock.
   kj::MutexGuarded<ThreadUnsafeData> data;
 
   // The MemoryCacheProvider instance needs to be guaranteed to outlive the SharedMemoryCache
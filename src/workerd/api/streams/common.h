@@ -200,6 +200,14 @@ class WritableStreamSink {
   virtual kj::Maybe<kj::Promise<DeferredProxy<void>>> tryPumpFrom(
       ReadableStreamSource& input, bool end);
 
+  // The equivalent of kj::AsyncOutputStream::tryPumpFrom(), used when this sink has been wrapped
+  // up as a kj::AsyncOutputStream (e.g. to be sent over RPC) and something pumps a native stream
+  // into it. A sink backed by a native stream should forward this to that stream, so that, in
+  // particular, Cap'n Proto can shorten the path when both ends turn out to be capnp streams.
+  // The default implementation returns kj::none, meaning the pump must read and write().
+  virtual kj::Maybe<kj::Promise<uint64_t>> tryPumpFromNative(
+      kj::AsyncInputStream& input, uint64_t amount);
+
   virtual void abort(kj::Exception reason) = 0;
   // TODO(conform): abort() should return a promise after which closed fulfillers should be
   //   rejected. This may necessitate an "erroring" state.
@@ -237,6 +245,13 @@ class ReadableStreamSource {
   kj::Promise<kj::Array<byte>> readAllBytes(uint64_t limit);
   kj::Promise<kj::String> readAllText(uint64_t limit);
 
+  // Like readAllBytes(), but reads directly into `buffer`, which the caller will typically have
+  // sized using tryGetLength(). Resolves to the number of bytes read if the whole stream fit in
+  // `buffer`. If the stream turns out to be longer than `buffer`, resolves to a new array holding
+  // all of it instead. `buffer` must not be empty.
+  kj::Promise<kj::OneOf<size_t, kj::Array<byte>>> readAllBytesInto(
+      kj::ArrayPtr<byte> buffer, uint64_t limit);
+
   // Hook to inform this ReadableStreamSource that the ReadableStream has been canceled. This only
   // really means anything to TransformStreams, which are supposed to propagate the error to the
   // writable side, and custom ReadableStreams, which we don't implement yet.
@@ -6,6 +6,7 @@
 #include "readable.h"
 #include "writable.h"
 
+#include <workerd/api/system-streams.h>
 #include <workerd/jsg/jsg-test.h>
 #include <workerd/jsg/jsg.h>
 #include <workerd/tests/test-fixture.h>
@@ -201,6 +202,233 @@ KJ_TEST("honest small stream") {
   KJ_ASSERT(stream.maxMaxBytesSeen(), 100);
 }
 
+KJ_TEST("readAllBytesInto") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  // When the stream is as long as it says, everything lands in the caller's buffer.
+  BarStream<10000> stream;
+  auto buffer = kj::heapArray<kj::byte>(10000);
+  auto result = stream.readAllBytesInto(buffer, 10001).wait(waitScope);
+  KJ_ASSERT(KJ_ASSERT_NONNULL(result.tryGet<size_t>()) == 10000);
+  KJ_ASSERT(buffer == stream.buf().first(10000));
+
+  // When it's longer, we get all of it in a new array.
+  FooStream<10000> longStream;
+  result = longStream.readAllBytesInto(buffer.first(10), 10001).wait(waitScope);
+  auto& bytes = KJ_ASSERT_NONNULL(result.tryGet<kj::Array<kj::byte>>());
+  KJ_ASSERT(bytes == longStream.buf().first(10000));
+
+  FooStream<10000> tooLongStream;
+  KJ_EXPECT_THROW_MESSAGE("Memory limit exceeded before EOF.",
+      tooLongStream.readAllBytesInto(buffer.first(10), 5000).wait(waitScope));
+}
+
+KJ_TEST("IdentityTransformStreamImpl waits for minBytes") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  auto stream = kj::refcounted<IdentityTransformStreamImpl>();
+  kj::byte buffer[20]{};
+
+  // A read for at least 10 bytes keeps collecting small writes until it has them.
+  auto read = stream->tryRead(buffer, 10, sizeof(buffer));
+  stream->write("aaaa"_kjb).wait(waitScope);
+  stream->write("bbbb"_kjb).wait(waitScope);
+  KJ_EXPECT(!read.poll(waitScope));
+  stream->write("cccc"_kjb).wait(waitScope);
+  KJ_EXPECT(read.wait(waitScope) == 12);
+  KJ_EXPECT(kj::arrayPtr(buffer, 12) == "aaaabbbbcccc"_kjb);
+
+  // EOF completes a read that has fewer than minBytes.
+  auto write = stream->write("dd"_kjb);
+  KJ_EXPECT(!write.poll(waitScope));
+  read = stream->tryRead(buffer, 5, 5);
+  write.wait(waitScope);
+  stream->end().wait(waitScope);
+  KJ_EXPECT(read.wait(waitScope) == 2);
+  KJ_EXPECT(stream->tryRead(buffer, 1, sizeof(buffer)).wait(waitScope) == 0);
+}
+
+class RecordingSink final: public WritableStreamSink {
+ public:
+  kj::Vector<kj::ArrayPtr<const byte>> writes;
+  bool ended = false;
+
+  kj::Promise<void> write(kj::ArrayPtr<const byte> buffer) override {
+    writes.add(buffer);
+    return kj::READY_NOW;
+  }
+  kj::Promise<void> write(kj::ArrayPtr<const kj::ArrayPtr<const byte>> pieces) override {
+    KJ_UNIMPLEMENTED("not used");
+  }
+  kj::Promise<void> end() override {
+    ended = true;
+    return kj::READY_NOW;
+  }
+  void abort(kj::Exception reason) override {}
+};
+
+KJ_TEST("IdentityTransformStreamImpl pumps writes straight to the output") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  auto stream = kj::refcounted<IdentityTransformStreamImpl>();
+  RecordingSink sink;
+  auto pump = stream->pumpTo(sink, true).then([](DeferredProxy<void> proxy) {
+    return kj::mv(proxy.proxyTask);
+  });
+
+  // Writes of any size reach the output as-is, without being copied or split up.
+  auto data = kj::heapArray<byte>(100000);
+  data.asPtr().fill('x');
+  stream->write(data).wait(waitScope);
+  stream->write("end"_kjb).wait(waitScope);
+  KJ_EXPECT(!sink.ended);
+  stream->end().wait(waitScope);
+  pump.wait(waitScope);
+
+  KJ_ASSERT(sink.writes.size() == 2);
+  KJ_EXPECT(sink.writes[0].begin() == data.begin());
+  KJ_EXPECT(sink.writes[0].size() == data.size());
+  KJ_EXPECT(sink.writes[1] == "end"_kjb);
+  KJ_EXPECT(sink.ended);
+}
+
+KJ_TEST("IdentityTransformStreamImpl enforces a FixedLengthStream's length when pumped") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  {
+    auto stream = kj::refcounted<IdentityTransformStreamImpl>(uint64_t(3));
+    RecordingSink sink;
+    auto pump = stream->pumpTo(sink, true);
+    KJ_EXPECT_THROW_MESSAGE("too many bytes", stream->write("abcd"_kjb).wait(waitScope));
+    KJ_EXPECT_THROW_MESSAGE("too many bytes", pump.wait(waitScope));
+    KJ_EXPECT(sink.writes.size() == 0);
+  }
+
+  {
+    auto stream = kj::refcounted<IdentityTransformStreamImpl>(uint64_t(3));
+    RecordingSink sink;
+    auto pump = stream->pumpTo(sink, true);
+    stream->write("ab"_kjb).wait(waitScope);
+    stream->end().wait(waitScope);
+    KJ_EXPECT_THROW_MESSAGE("did not see all expected bytes", pump.wait(waitScope));
+    KJ_EXPECT(!sink.ended);
+  }
+}
+
+// A kj::AsyncInputStream over a fixed array.
+class ArrayInputStream final: public kj::AsyncInputStream {
+ public:
+  explicit ArrayInputStream(kj::ArrayPtr<const byte> data): data(data) {}
+
+  kj::Promise<size_t> tryRead(void* buffer, size_t minBytes, size_t maxBytes) override {
+    auto amount = kj::min(maxBytes, data.size());
+    memcpy(buffer, data.begin(), amount);
+    data = data.slice(amount);
+    return amount;
+  }
+
+ private:
+  kj::ArrayPtr<const byte> data;
+};
+
+// A kj::AsyncOutputStream that collects what's written to it. If `acceptPumps` is true, it
+// implements pumps itself rather than leaving them to write().
+class CollectingOutputStream final: public kj::AsyncOutputStream {
+ public:
+  explicit CollectingOutputStream(bool acceptPumps): acceptPumps(acceptPumps) {}
+
+  bool acceptPumps;
+  bool pumped = false;
+  uint writes = 0;
+  kj::Vector<byte> data;
+
+  kj::Promise<void> write(kj::ArrayPtr<const byte> buffer) override {
+    ++writes;
+    data.addAll(buffer);
+    return kj::READY_NOW;
+  }
+  kj::Promise<void> write(kj::ArrayPtr<const kj::ArrayPtr<const byte>> pieces) override {
+    ++writes;
+    for (auto piece: pieces) data.addAll(piece);
+    return kj::READY_NOW;
+  }
+  kj::Maybe<kj::Promise<uint64_t>> tryPumpFrom(
+      kj::AsyncInputStream& input, uint64_t amount) override {
+    if (!acceptPumps) return kj::none;
+    pumped = true;
+    return input.readAllBytes(amount).then([this](kj::Array<byte> bytes) -> uint64_t {
+      data.addAll(bytes);
+      return bytes.size();
+    });
+  }
+  kj::Promise<void> whenWriteDisconnected() override {
+    return kj::NEVER_DONE;
+  }
+};
+
+// A WritableStreamSink that collects copies of what's written to it, and has no native stream
+// to pump into.
+class CollectingSink final: public WritableStreamSink {
+ public:
+  kj::Vector<byte> data;
+
+  kj::Promise<void> write(kj::ArrayPtr<const byte> buffer) override {
+    data.addAll(buffer);
+    return kj::READY_NOW;
+  }
+  kj::Promise<void> write(kj::ArrayPtr<const kj::ArrayPtr<const byte>> pieces) override {
+    for (auto piece: pieces) data.addAll(piece);
+    return kj::READY_NOW;
+  }
+  kj::Promise<void> end() override {
+    return kj::READY_NOW;
+  }
+  void abort(kj::Exception reason) override {}
+};
+
+KJ_TEST("native pumps into a system stream sent over RPC reach the inner stream") {
+  TestFixture fixture;
+
+  for (bool acceptPumps: {true, false}) {
+    fixture.runInIoContext([&](const TestFixture::Environment& env) -> kj::Promise<void> {
+      auto inner = kj::heap<CollectingOutputStream>(acceptPumps);
+      auto& collector = *inner;
+      auto adapter = newWritableStreamRpcAdapter(
+          env.context, newSystemStream(kj::mv(inner), StreamEncoding::IDENTITY, env.context));
+
+      // The adapter takes the pump whether or not the inner stream does. If it doesn't, the pump
+      // falls back to writing to the inner stream directly.
+      ArrayInputStream input("hello world"_kjb);
+      auto maybePump = adapter->tryPumpFrom(input, kj::maxValue);
+      auto& pump = KJ_ASSERT_NONNULL(maybePump);
+      KJ_EXPECT(co_await pump == 11);
+      KJ_EXPECT(collector.data.asPtr() == "hello world"_kjb);
+      KJ_EXPECT(collector.pumped == acceptPumps);
+      KJ_EXPECT((collector.writes == 0) == acceptPumps);
+    });
+  }
+}
+
+KJ_TEST("native pumps into a sink sent over RPC fall back to writes") {
+  TestFixture fixture;
+
+  fixture.runInIoContext([&](const TestFixture::Environment& env) -> kj::Promise<void> {
+    auto sink = kj::heap<CollectingSink>();
+    auto& collector = *sink;
+    auto adapter = newWritableStreamRpcAdapter(env.context, kj::mv(sink));
+
+    // The sink has no native stream, so the adapter declines, and the pump writes through it.
+    ArrayInputStream input("hello world"_kjb);
+    KJ_EXPECT(adapter->tryPumpFrom(input, kj::maxValue) == kj::none);
+    KJ_EXPECT(co_await input.pumpTo(*adapter) == 11);
+    KJ_EXPECT(collector.data.asPtr() == "hello world"_kjb);
+  });
+}
+
 KJ_TEST("WritableStreamInternalController queue size assertion") {
 
   capnp::MallocMessageBuilder message;
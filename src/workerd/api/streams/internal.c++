@@ -70,6 +70,39 @@ class AllReader final {
     co_return kj::String(kj::mv(data));
   }
 
+  kj::Promise<kj::OneOf<size_t, kj::Array<kj::byte>>> readAllBytesInto(
+      kj::ArrayPtr<kj::byte> buffer) {
+    KJ_REQUIRE(buffer.size() > 0);
+    auto amount = co_await input.tryRead(buffer.begin(), buffer.size(), buffer.size());
+    if (amount < buffer.size()) {
+      co_return amount;
+    }
+
+    // The buffer is full. Most likely that's everything, but we have to see EOF to be sure.
+    kj::byte probe[1024];
+    auto extra = co_await input.tryRead(probe, sizeof(probe), sizeof(probe));
+    if (extra == 0) {
+      co_return amount;
+    }
+
+    // The stream is longer than the buffer, so collect the rest of it separately and put it all
+    // together at the end.
+    LOG_WARNING_PERIODICALLY(
+        "ReadableStream provided more data than advertised", buffer.size());
+    JSG_REQUIRE(amount + extra < limit, TypeError, "Memory limit exceeded before EOF.");
+    kj::Array<kj::byte> rest = nullptr;
+    if (extra == sizeof(probe)) {
+      limit -= amount + extra;
+      rest = co_await read<kj::byte>();
+    }
+
+    auto out = kj::heapArray<kj::byte>(amount + extra + rest.size());
+    out.first(amount).copyFrom(buffer);
+    out.slice(amount, amount + extra).copyFrom(kj::arrayPtr(probe, extra));
+    out.slice(amount + extra).copyFrom(rest);
+    co_return kj::mv(out);
+  }
+
  private:
   ReadableStreamSource& input;
   uint64_t limit;
@@ -197,7 +230,8 @@ class AllReader final {
         // Realistically runningTotal should never be more than length so we'll emit
         // a warning if it is just so we know. It would be indicative of a bug somewhere
         // in the implementation.
-        KJ_LOG(WARNING, "ReadableStream provided more data than advertised", runningTotal, length);
+        LOG_WARNING_PERIODICALLY(
+            "ReadableStream provided more data than advertised", runningTotal, length);
       }
     }
 
@@ -496,6 +530,12 @@ kj::Promise<kj::String> ReadableStreamSource::readAllText(uint64_t limit) {
   }
 }
 
+kj::Promise<kj::OneOf<size_t, kj::Array<byte>>> ReadableStreamSource::readAllBytesInto(
+    kj::ArrayPtr<byte> buffer, uint64_t limit) {
+  AllReader allReader(*this, limit);
+  co_return co_await allReader.readAllBytesInto(buffer);
+}
+
 void ReadableStreamSource::cancel(kj::Exception reason) {}
 
 kj::Maybe<ReadableStreamSource::Tee> ReadableStreamSource::tryTee(uint64_t limit) {
@@ -507,6 +547,11 @@ kj::Maybe<kj::Promise<DeferredProxy<void>>> WritableStreamSink::tryPumpFrom(
   return kj::none;
 }
 
+kj::Maybe<kj::Promise<uint64_t>> WritableStreamSink::tryPumpFromNative(
+    kj::AsyncInputStream& input, uint64_t amount) {
+  return kj::none;
+}
+
 // =======================================================================================
 
 ReadableStreamInternalController::~ReadableStreamInternalController() noexcept(false) {
@@ -2123,14 +2168,46 @@ jsg::Promise<jsg::BufferSource> ReadableStreamInternalController::readAllBytes(
     KJ_CASE_ONEOF(readable, Readable) {
       auto source = KJ_ASSERT_NONNULL(removeSource(js));
       auto& context = IoContext::current();
-      // TODO(perf): v8 sandboxing will require that backing stores are allocated within
-      // the sandbox. This will require a change to the API of ReadableStreamSource::readAllBytes.
-      // For now, we'll read and allocate into a proper backing store.
+
+      KJ_IF_SOME(length, source->tryGetLength(StreamEncoding::IDENTITY)) {
+        if (length > 0 && length < limit) {
+          // We know how big the result will (almost certainly) be, so read straight into a
+          // backing store allocated in the V8 sandbox, rather than reading into a kj::Array and
+          // copying it over. The I/O side holds its own reference to the backing store so that it
+          // stays alive as long as the read does.
+          auto backing = jsg::BackingStore::alloc<v8::ArrayBuffer>(js, length);
+          auto buffer = backing.asArrayPtr();
+          auto promise = source->readAllBytesInto(buffer, limit)
+                             .attach(kj::mv(source), backing.getTypedView<v8::ArrayBuffer>());
+          return context.awaitIoLegacy(js, kj::mv(promise))
+              .then(js,
+                  [backing = kj::mv(backing)](jsg::Lock& js,
+                      kj::OneOf<size_t, kj::Array<kj::byte>> result) mutable -> jsg::BufferSource {
+            KJ_SWITCH_ONEOF(result) {
+              KJ_CASE_ONEOF(amount, size_t) {
+                if (amount == backing.size()) {
+                  return jsg::BufferSource(js, kj::mv(backing));
+                }
+                // The stream was shorter than it said it would be.
+                auto trimmed = jsg::BackingStore::alloc<v8::ArrayBuffer>(js, amount);
+                trimmed.asArrayPtr().copyFrom(backing.asArrayPtr().first(amount));
+                return jsg::BufferSource(js, kj::mv(trimmed));
+              }
+              KJ_CASE_ONEOF(bytes, kj::Array<kj::byte>) {
+                return jsg::BufferSource(
+                    js, jsg::BackingStore::from<v8::ArrayBuffer>(js, kj::mv(bytes)));
+              }
+            }
+            KJ_UNREACHABLE;
+          });
+        }
+      }
+
+      // Otherwise, we have to read into kj::Arrays first. BackingStore::from() adopts the result
+      // without copying it if it happens to be inside the sandbox.
       return context.awaitIoLegacy(js, source->readAllBytes(limit).attach(kj::mv(source)))
           .then(js, [](jsg::Lock& js, kj::Array<kj::byte> bytes) -> jsg::BufferSource {
-        auto backing = jsg::BackingStore::alloc<v8::ArrayBuffer>(js, bytes.size());
-        backing.asArrayPtr().copyFrom(bytes);
-        return jsg::BufferSource(js, kj::mv(backing));
+        return jsg::BufferSource(js, jsg::BackingStore::from<v8::ArrayBuffer>(js, kj::mv(bytes)));
       });
     }
   }
@@ -2242,49 +2319,34 @@ StreamEncoding ReadableStreamInternalController::getPreferredEncoding() {
 
 kj::Promise<size_t> IdentityTransformStreamImpl::tryRead(
     void* buffer, size_t minBytes, size_t maxBytes) {
-  size_t total = 0;
-  while (total < minBytes) {
-    // TODO(perf): tryReadInternal was written assuming minBytes would always be 1 but we've now
-    // introduced an API for user to specify a larger minBytes. For now, this is implemented as a
-    // naive loop dispatching to the 1 byte version but would be better to bake it deeper into
-    // the implementation where it can be more efficient.
-    auto amount = co_await tryReadInternal(buffer, maxBytes);
-    KJ_ASSERT(amount <= maxBytes);
-    if (amount == 0) {
-      // EOF.
-      break;
-    }
+  auto promise = readHelper(kj::arrayPtr(static_cast<kj::byte*>(buffer), maxBytes),
+      kj::min(kj::max(minBytes, size_t(1)), maxBytes));
 
-    total += amount;
-    buffer = reinterpret_cast<char*>(buffer) + amount;
-    maxBytes -= amount;
+  if (limit == kj::none) {
+    return promise;
   }
 
-  co_return total;
+  return promise.then([this](size_t amount) {
+    countBytes(amount);
+    return amount;
+  });
 }
 
-kj::Promise<size_t> IdentityTransformStreamImpl::tryReadInternal(void* buffer, size_t maxBytes) {
-  auto promise = readHelper(kj::arrayPtr(static_cast<kj::byte*>(buffer), maxBytes));
-
+void IdentityTransformStreamImpl::countBytes(size_t amount) {
   KJ_IF_SOME(l, limit) {
-    promise = promise.then([this, &l = l](size_t amount) -> kj::Promise<size_t> {
-      if (amount > l) {
-        auto exception = JSG_KJ_EXCEPTION(
-            FAILED, TypeError, "Attempt to write too many bytes through a FixedLengthStream.");
-        cancel(exception);
-        return kj::mv(exception);
-      } else if (amount == 0 && l != 0) {
-        auto exception = JSG_KJ_EXCEPTION(
-            FAILED, TypeError, "FixedLengthStream did not see all expected bytes before close().");
-        cancel(exception);
-        return kj::mv(exception);
-      }
-      l -= amount;
-      return amount;
-    });
+    if (amount > l) {
+      auto exception = JSG_KJ_EXCEPTION(
+          FAILED, TypeError, "Attempt to write too many bytes through a FixedLengthStream.");
+      cancel(exception);
+      kj::throwFatalException(kj::mv(exception));
+    } else if (amount == 0 && l != 0) {
+      auto exception = JSG_KJ_EXCEPTION(
+          FAILED, TypeError, "FixedLengthStream did not see all expected bytes before close().");
+      cancel(exception);
+      kj::throwFatalException(kj::mv(exception));
+    }
+    l -= amount;
   }
-
-  return promise;
 }
 
 kj::Promise<DeferredProxy<void>> IdentityTransformStreamImpl::pumpTo(
@@ -2299,7 +2361,52 @@ kj::Promise<DeferredProxy<void>> IdentityTransformStreamImpl::pumpTo(
   JSG_REQUIRE(kj::dynamicDowncastIfAvailable<IdentityTransformStreamImpl>(output) == kj::none,
       TypeError, "Inter-TransformStream ReadableStream.pipeTo() is not implemented.");
 
-  return ReadableStreamSource::pumpTo(output, end);
+  // Rather than reading into an intermediate buffer and writing that out, as the default
+  // implementation does, hand each write straight to `output`. The writer is on the other end of
+  // the pipe, so the IoContext must stay live: there is nothing to do in the deferred part.
+  return addNoopDeferredProxy(pumpHelper(output, end));
+}
+
+kj::Promise<void> IdentityTransformStreamImpl::pumpHelper(WritableStreamSink& output, bool end) {
+  for (;;) {
+    if (state.is<Idle>()) {
+      auto paf = kj::newPromiseAndFulfiller<void>();
+      state = PumpRequest{kj::mv(paf.fulfiller)};
+      co_await paf.promise;
+    } else KJ_IF_SOME(request, state.tryGet<WriteRequest>()) {
+      auto bytes = request.bytes;
+      countBytes(bytes.size());
+
+      // The writer's promise, which keeps `bytes` alive, resolves only once `output` is done with
+      // them. If the pump is canceled in the meantime, fail the writer rather than leave it
+      // waiting for a reader that is gone.
+      bool settled = false;
+      KJ_DEFER(if (!settled) cancel(KJ_EXCEPTION(DISCONNECTED, "reader canceled")));
+      try {
+        co_await output.write(bytes);
+      } catch (...) {
+        settled = true;
+        cancel(kj::getCaughtExceptionAsKj());
+        throw;
+      }
+      settled = true;
+
+      KJ_IF_SOME(request, state.tryGet<WriteRequest>()) {
+        request.fulfiller->fulfill();
+        state = Idle();
+      }
+    } else KJ_IF_SOME(exception, state.tryGet<kj::Exception>()) {
+      kj::throwFatalException(kj::cp(exception));
+    } else if (state.is<StreamStates::Closed>()) {
+      countBytes(0);
+      if (end) {
+        co_await output.end();
+      }
+      co_return;
+    } else {
+      KJ_FAIL_ASSERT("read operation already in flight");
+    }
+  }
 }
 
 kj::Maybe<uint64_t> IdentityTransformStreamImpl::tryGetLength(StreamEncoding encoding) {
@@ -2316,11 +2423,15 @@ void IdentityTransformStreamImpl::cancel(kj::Exception reason) {
       // This is fine.
     }
     KJ_CASE_ONEOF(request, ReadRequest) {
-      request.fulfiller->fulfill(size_t(0));
+      request.fulfiller->fulfill(kj::cp(request.filled));
     }
     KJ_CASE_ONEOF(request, WriteRequest) {
       request.fulfiller->reject(kj::cp(reason));
     }
+    KJ_CASE_ONEOF(request, PumpRequest) {
+      // The pump will find the stream errored when it wakes up.
+      request.fulfiller->fulfill();
+    }
     KJ_CASE_ONEOF(exception, kj::Exception) {
       // Already errored.
       return;
@@ -2365,6 +2476,9 @@ void IdentityTransformStreamImpl::abort(kj::Exception reason) {
     KJ_CASE_ONEOF(request, ReadRequest) {
       request.fulfiller->reject(kj::cp(reason));
     }
+    KJ_CASE_ONEOF(request, PumpRequest) {
+      request.fulfiller->reject(kj::cp(reason));
+    }
     KJ_CASE_ONEOF(request, WriteRequest) {
       // IF the fulfiller is not waiting, the write promise was already
       // canceled and no one is waiting on it.
@@ -2386,35 +2500,45 @@ void IdentityTransformStreamImpl::abort(kj::Exception reason) {
   // TODO(conform): Proactively put ReadableStream into Errored state.
 }
 
-kj::Promise<size_t> IdentityTransformStreamImpl::readHelper(kj::ArrayPtr<kj::byte> bytes) {
+kj::Promise<size_t> IdentityTransformStreamImpl::readHelper(
+    kj::ArrayPtr<kj::byte> bytes, size_t minBytes) {
   KJ_SWITCH_ONEOF(state) {
     KJ_CASE_ONEOF(idle, Idle) {
       // No outstanding write request, switch to ReadRequest state.
 
       auto paf = kj::newPromiseAndFulfiller<size_t>();
-      state = ReadRequest{bytes, kj::mv(paf.fulfiller)};
+      state = ReadRequest{bytes, minBytes, 0, kj::mv(paf.fulfiller)};
       return kj::mv(paf.promise);
     }
     KJ_CASE_ONEOF(request, ReadRequest) {
       KJ_FAIL_ASSERT("read operation already in flight");
     }
+    KJ_CASE_ONEOF(request, PumpRequest) {
+      KJ_FAIL_ASSERT("read operation already in flight");
+    }
     KJ_CASE_ONEOF(request, WriteRequest) {
-      if (bytes.size() >= request.bytes.size()) {
-        // The write buffer will entirely fit into our read buffer; fulfill both requests.
-        memcpy(bytes.begin(), request.bytes.begin(), request.bytes.size());
-        auto result = request.bytes.size();
-        request.fulfiller->fulfill();
+      auto amount = kj::min(bytes.size(), request.bytes.size());
+      memcpy(bytes.begin(), request.bytes.begin(), amount);
 
-        // Switch to idle state.
+      if (amount == request.bytes.size()) {
+        // The write buffer entirely fit into our read buffer; fulfill the write request.
+        request.fulfiller->fulfill();
         state = Idle();
+      } else {
+        // The write buffer didn't quite fit into our read buffer; the rest waits for the next read.
+        request.bytes = request.bytes.slice(amount, request.bytes.size());
+      }
 
-        return result;
+      if (amount >= minBytes) {
+        return amount;
       }
 
-      // The write buffer won't quite fit into our read buffer; fulfill only the read request.
-      memcpy(bytes.begin(), request.bytes.begin(), bytes.size());
-      request.bytes = request.bytes.slice(bytes.size(), request.bytes.size());
-      return bytes.size();
+      // The writer has nothing more for us yet, but the reader asked for more. Wait for further
+      // writes to fill in the rest of the buffer.
+      auto paf = kj::newPromiseAndFulfiller<size_t>();
+      state = ReadRequest{
+        bytes.slice(amount, bytes.size()), minBytes, amount, kj::mv(paf.fulfiller)};
+      return kj::mv(paf.promise);
     }
     KJ_CASE_ONEOF(exception, kj::Exception) {
       return kj::cp(exception);
@@ -2456,31 +2580,61 @@ kj::Promise<void> IdentityTransformStreamImpl::writeHelper(kj::ArrayPtr<const kj
       }
 
       if (bytes.size() == 0) {
-        // This is a close operation.
-        request.fulfiller->fulfill(size_t(0));
+        // This is a close operation. The reader gets whatever it has so far, even if that is
+        // less than it asked for.
+        request.fulfiller->fulfill(kj::cp(request.filled));
         state = StreamStates::Closed();
         return kj::READY_NOW;
       }
 
       KJ_ASSERT(request.bytes.size() > 0);
 
-      if (request.bytes.size() >= bytes.size()) {
-        // Our write buffer will entirely fit into the read buffer; fulfill both requests.
-        memcpy(request.bytes.begin(), bytes.begin(), bytes.size());
-        request.fulfiller->fulfill(bytes.size());
-        state = Idle();
+      auto amount = kj::min(request.bytes.size(), bytes.size());
+      memcpy(request.bytes.begin(), bytes.begin(), amount);
+      request.filled += amount;
+      request.bytes = request.bytes.slice(amount, request.bytes.size());
+      bytes = bytes.slice(amount, bytes.size());
+
+      if (request.filled < request.minBytes) {
+        // Our write buffer fit entirely into the read buffer, but the reader wants more. Keep
+        // waiting for further writes.
         return kj::READY_NOW;
       }
 
-      // Our write buffer won't quite fit into the read buffer; fulfill only the read request.
-      memcpy(request.bytes.begin(), bytes.begin(), request.bytes.size());
-      bytes = bytes.slice(request.bytes.size(), bytes.size());
-      request.fulfiller->fulfill(request.bytes.size());
+      request.fulfiller->fulfill(kj::cp(request.filled));
+      state = Idle();
+
+      if (bytes.size() == 0) {
+        // Our write buffer fit entirely into the read buffer; both requests are fulfilled.
+        return kj::READY_NOW;
+      }
 
+      // Our write buffer didn't quite fit into the read buffer; the rest waits for the next read.
       auto paf = kj::newPromiseAndFulfiller<void>();
       state = WriteRequest{bytes, kj::mv(paf.fulfiller)};
       return kj::mv(paf.promise);
     }
+    KJ_CASE_ONEOF(request, PumpRequest) {
+      if (!request.fulfiller->isWaiting()) {
+        // The pump was canceled. As with a canceled read, above, propagate that to the writer.
+        state = KJ_EXCEPTION(DISCONNECTED, "reader canceled");
+        return writeHelper(bytes);
+      }
+
+      auto pumpFulfiller = kj::mv(request.fulfiller);
+      kj::Promise<void> promise = kj::READY_NOW;
+      if (bytes.size() == 0) {
+        // This is a close operation.
+        state = StreamStates::Closed();
+      } else {
+        // The pump will forward our buffer to its output and fulfill us once that's done.
+        auto paf = kj::newPromiseAndFulfiller<void>();
+        state = WriteRequest{bytes, kj::mv(paf.fulfiller)};
+        promise = kj::mv(paf.promise);
+      }
+      pumpFulfiller->fulfill();
+      return promise;
+    }
     KJ_CASE_ONEOF(request, WriteRequest) {
       KJ_FAIL_ASSERT("write operation already in flight");
     }
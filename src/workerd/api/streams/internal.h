@@ -372,15 +372,14 @@ class WritableStreamInternalController: public WritableStreamController {
 };
 
 // An implementation of ReadableStreamSource and WritableStreamSink which communicates read and
-// write requests via a OneOf.
+// write requests via a OneOf. Data is never buffered: each write is handed straight to the pending
+// read, or, when the readable side is being pumped, straight to the pump's output.
 //
 // This class is also used as the implementation of FixedLengthStream, in which case `limit` is
 // non-nullptr.
 class IdentityTransformStreamImpl: public kj::Refcounted,
                                    public ReadableStreamSource,
                                    public WritableStreamSink {
-  // TODO(soon): Reimplement this in terms of kj::OneWayPipe, so we can optimize pumpTo().
-
  public:
   explicit IdentityTransformStreamImpl(kj::Maybe<uint64_t> limit = kj::none): limit(limit) {}
 
@@ -398,8 +397,6 @@ class IdentityTransformStreamImpl: public kj::Refcounted,
 
   kj::Promise<size_t> tryRead(void* buffer, size_t minBytes, size_t maxBytes) override;
 
-  kj::Promise<size_t> tryReadInternal(void* buffer, size_t maxBytes);
-
   kj::Promise<DeferredProxy<void>> pumpTo(WritableStreamSink& output, bool end) override;
 
   kj::Maybe<uint64_t> tryGetLength(StreamEncoding encoding) override;
@@ -417,17 +414,29 @@ class IdentityTransformStreamImpl: public kj::Refcounted,
   void abort(kj::Exception reason) override;
 
  private:
-  kj::Promise<size_t> readHelper(kj::ArrayPtr<kj::byte> bytes);
+  kj::Promise<size_t> readHelper(kj::ArrayPtr<kj::byte> bytes, size_t minBytes);
 
   kj::Promise<void> writeHelper(kj::ArrayPtr<const kj::byte> bytes);
 
+  // Forwards each write directly to `output` until the writable side is closed.
+  kj::Promise<void> pumpHelper(WritableStreamSink& output, bool end);
+
+  // Counts `amount` bytes against a FixedLengthStream's limit, where 0 means EOF. Throws (after
+  // canceling the stream) if the writer wrote too much or too little.
+  void countBytes(size_t amount);
+
   kj::Maybe<uint64_t> limit;
 
   struct ReadRequest {
+    // The part of the read buffer not yet filled.
     kj::ArrayPtr<kj::byte> bytes;
     // WARNING: `bytes` may be invalid if fulfiller->isWaiting() returns false! (This indicates the
     //   read was canceled.)
 
+    // The read completes once `filled` reaches `minBytes`, or at EOF.
+    size_t minBytes;
+    size_t filled;
+
     kj::Own<kj::PromiseFulfiller<size_t>> fulfiller;
   };
 
@@ -436,9 +445,15 @@ class IdentityTransformStreamImpl: public kj::Refcounted,
     kj::Own<kj::PromiseFulfiller<void>> fulfiller;
   };
 
+  // pumpHelper() is waiting for the next write (or for the close).
+  struct PumpRequest {
+    kj::Own<kj::PromiseFulfiller<void>> fulfiller;
+  };
+
   struct Idle {};
 
-  kj::OneOf<Idle, ReadRequest, WriteRequest, kj::Exception, StreamStates::Closed> state = Idle();
+  kj::OneOf<Idle, ReadRequest, WriteRequest, PumpRequest, kj::Exception, StreamStates::Closed>
+      state = Idle();
 };
 
 }  // namespace workerd::api
@@ -336,10 +336,14 @@ class WritableStreamRpcAdapter final: public capnp::ExplicitEndOutputStream {
     return canceler.wrap(getInner().write(pieces));
   }
 
-  // TODO(perf): We can't properly implement tryPumpFrom(), which means that Cap'n Proto will
-  //   be unable to perform path shortening if the underlying stream turns out to be another capnp
-  //   stream. This isn't a huge deal, but might be nice to enable someday. It may require
-  //   significant refactoring of streams.
+  kj::Maybe<kj::Promise<uint64_t>> tryPumpFrom(
+      kj::AsyncInputStream& input, uint64_t amount) override {
+    // If the sink is a native stream, this lets Cap'n Proto perform path shortening when that
+    // stream turns out to be another capnp stream.
+    return getInner().tryPumpFromNative(input, amount).map([this](kj::Promise<uint64_t> promise) {
+      return canceler.wrap(kj::mv(promise));
+    });
+  }
 
   kj::Promise<void> whenWriteDisconnected() override {
     // TODO(someday): WritableStreamSink doesn't give us a way to implement this.
@@ -485,10 +489,8 @@ class WritableStreamJsRpcAdapter final: public capnp::ExplicitEndOutputStream {
     }));
   }
 
-  // TODO(perf): We can't properly implement tryPumpFrom(), which means that Cap'n Proto will
-  //   be unable to perform path shortening if the underlying stream turns out to be another capnp
-  //   stream. This isn't a huge deal, but might be nice to enable someday. It may require
-  //   significant refactoring of streams.
+  // There is no tryPumpFrom() here: a JavaScript-backed stream has to see every chunk, so pumps
+  // into it necessarily go through write().
 
   kj::Promise<void> whenWriteDisconnected() override {
     // TODO(soon): We might be able to support this by following the writer.closed promise,
@@ -543,6 +545,17 @@ class WritableStreamJsRpcAdapter final: public capnp::ExplicitEndOutputStream {
 
 }  // namespace
 
+kj::Own<capnp::ExplicitEndOutputStream> newWritableStreamRpcAdapter(
+    IoContext& ioContext, kj::Own<WritableStreamSink> sink) {
+  auto wrapper = kj::heap<WritableStreamRpcAdapter>(kj::mv(sink));
+
+  // Make sure this stream will be revoked if the IoContext ends.
+  ioContext.addTask(
+      wrapper->waitForCompletionOrRevoke().attach(ioContext.registerPendingEvent()));
+
+  return wrapper;
+}
+
 void WritableStream::serialize(jsg::Lock& js, jsg::Serializer& serializer) {
   // Serialize by effectively creating a `JsRpcStub` around this object and serializing that.
   // Except we don't actually want to do _exactly_ that, because we do not want to actually create
@@ -564,11 +577,7 @@ void WritableStream::serialize(jsg::Lock& js, jsg::Serializer& serializer) {
     // NOTE: We're counting on `removeSink()`, to check that the stream is not locked and other
     //   common checks. It's important we don't modify the WritableStream before this call.
     auto encoding = sink->disownEncodingResponsibility();
-    auto wrapper = kj::heap<WritableStreamRpcAdapter>(kj::mv(sink));
-
-    // Make sure this stream will be revoked if the IoContext ends.
-    ioctx.addTask(wrapper->waitForCompletionOrRevoke().attach(ioctx.registerPendingEvent()));
-
+    auto wrapper = newWritableStreamRpcAdapter(ioctx, kj::mv(sink));
     auto capnpStream = ioctx.getByteStreamFactory().kjToCapnp(kj::mv(wrapper));
 
     externalHandler->write([capnpStream = kj::mv(capnpStream), encoding](
@@ -8,6 +8,8 @@
 
 #include <workerd/util/weak-refs.h>
 
+#include <capnp/compat/byte-stream.h>
+
 namespace workerd::api {
 
 class WritableStreamDefaultWriter: public jsg::Object, public WritableStreamController::Writer {
@@ -188,4 +190,9 @@ class WritableStream: public jsg::Object {
   friend class WritableImpl;
 };
 
+// Wraps a WritableStreamSink up as an output stream suitable for handing off to capnp RPC.
+// The stream is revoked if `ioContext` ends before it is dropped.
+kj::Own<capnp::ExplicitEndOutputStream> newWritableStreamRpcAdapter(
+    IoContext& ioContext, kj::Own<WritableStreamSink> sink);
+
 }  // namespace workerd::api
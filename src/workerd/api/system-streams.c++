@@ -157,6 +157,9 @@ class EncodedAsyncOutputStream final: public WritableStreamSink {
   kj::Maybe<kj::Promise<DeferredProxy<void>>> tryPumpFrom(
       ReadableStreamSource& input, bool end) override;
 
+  kj::Maybe<kj::Promise<uint64_t>> tryPumpFromNative(
+      kj::AsyncInputStream& input, uint64_t amount) override;
+
   kj::Promise<void> end() override;
 
   void abort(kj::Exception reason) override;
@@ -267,6 +270,17 @@ kj::Maybe<kj::Promise<DeferredProxy<void>>> EncodedAsyncOutputStream::tryPumpFro
   return kj::none;
 }
 
+kj::Maybe<kj::Promise<uint64_t>> EncodedAsyncOutputStream::tryPumpFromNative(
+    kj::AsyncInputStream& input, uint64_t amount) {
+  if (inner.is<Ended>()) return kj::none;
+
+  ensureIdentityEncoding();
+
+  // Pump straight into the inner stream, which gets the chance to optimize the pump itself (e.g.
+  // capnp path shortening) and otherwise skips our write() and its per-write pending events.
+  return input.pumpTo(getInner(), amount).attach(ioContext.registerPendingEvent());
+}
+
 StreamEncoding EncodedAsyncOutputStream::disownEncodingResponsibility() {
   StreamEncoding result = encoding;
   encoding = StreamEncoding::IDENTITY;
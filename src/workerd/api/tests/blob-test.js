@@ -2,7 +2,7 @@
 // Licensed under the Apache 2.0 license found in the LICENSE file or at:
 //     https://opensource.org/licenses/Apache-2.0
 
-import { strictEqual, throws } from 'node:assert';
+import { deepStrictEqual, strictEqual, throws } from 'node:assert';
 import { inspect } from 'node:util';
 
 export const test1 = {
@@ -92,6 +92,49 @@ export const test1 = {
   },
 };
 
+export const ropes = {
+  async test() {
+    // Blobs built from other Blobs share their bytes rather than copying them. Make sure slicing
+    // and reading work across the seams between parts, however the blob is nested.
+    const left = new Blob(['abc', 'def']);
+    const right = new Blob(['ghi']);
+    const rope = new Blob([left, 'xy', right, new Uint8Array([0x7a])]);
+    strictEqual(rope.size, 12);
+    strictEqual(await rope.text(), 'abcdefxyghiz');
+    deepStrictEqual(
+      new Uint8Array(await rope.arrayBuffer()),
+      new TextEncoder().encode('abcdefxyghiz')
+    );
+
+    strictEqual(await rope.slice(4, 10).text(), 'efxygh');
+    strictEqual(await rope.slice(6, 8).text(), 'xy');
+    strictEqual(await rope.slice(-4).text(), 'ghiz');
+    strictEqual(await rope.slice(12).text(), '');
+    strictEqual(await rope.slice(4, 10).slice(1, -1).text(), 'fxyg');
+
+    const nested = new Blob([rope, rope.slice(0, 3), left]);
+    strictEqual(await nested.text(), 'abcdefxyghizabcabcdef');
+    strictEqual(await nested.slice(10, 16).text(), 'izabca');
+
+    const chunks = [];
+    for await (const chunk of nested.stream()) {
+      chunks.push(...chunk);
+    }
+    strictEqual(
+      new TextDecoder().decode(new Uint8Array(chunks)),
+      await nested.text()
+    );
+
+    strictEqual(await new Response(nested.slice(2, 9)).text(), 'cdefxyg');
+
+    const file = new File([left, right], 'rope.txt', { type: 'text/plain' });
+    strictEqual(file.size, 9);
+    strictEqual(file.name, 'rope.txt');
+    strictEqual(await file.text(), 'abcdefghi');
+    strictEqual(await file.slice(2, 7).text(), 'cdefg');
+  },
+};
+
 export const test2 = {
   async test(ctrl, env, ctx) {
     // This test verifies that a Blob created from a request/response properly reflects
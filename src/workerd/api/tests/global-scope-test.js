@@ -91,6 +91,38 @@ export const intervalVarargs = {
   },
 };
 
+export const timeoutsDueTogether = {
+  async test() {
+    // Timeouts scheduled for the same time are released together, but must still run one at a
+    // time, in order, with microtasks drained in between and cancellation respected.
+    const order = [];
+    const times = new Set();
+    let resolve;
+    const done = new Promise((r) => (resolve = r));
+    const ids = [];
+    for (let i = 0; i < 100; i++) {
+      ids.push(
+        setTimeout(() => {
+          order.push(i);
+          times.add(Date.now());
+          Promise.resolve().then(() => order.push(`${i}m`));
+          if (i === 10) clearTimeout(ids[11]);
+          if (i === 99) resolve();
+        }, 10)
+      );
+    }
+    await done;
+
+    const expected = [];
+    for (let i = 0; i < 100; i++) {
+      if (i === 11) continue;
+      expected.push(i, `${i}m`);
+    }
+    deepStrictEqual(order, expected);
+    strictEqual(times.size, 1);
+  },
+};
+
 export const mutableGlobals = {
   async test() {
     {
@@ -1015,3 +1015,42 @@ export const hugeNumberOfHandlersForAnElement = {
     }
   },
 };
+
+export const reusedRewriter = {
+  async test() {
+    // One HTMLRewriter can transform several responses at once. Each transform must see its own
+    // elements, even while another transform's handlers are suspended.
+    const seen = [];
+    const rewriter = new HTMLRewriter().on('p', {
+      async element(e) {
+        const id = e.getAttribute('id');
+        await scheduler.wait(id === 'a' ? 10 : 0);
+        seen.push(id);
+        e.setInnerContent(id.toUpperCase());
+      },
+    });
+
+    const first = rewriter.transform(new Response('<p id="a"></p>'));
+    const second = rewriter.transform(new Response('<p id="b"></p>'));
+    const [firstText, secondText] = await Promise.all([
+      first.text(),
+      second.text(),
+    ]);
+    strictEqual(firstText, '<p id="a">A</p>');
+    strictEqual(secondText, '<p id="b">B</p>');
+    deepStrictEqual(seen.sort(), ['a', 'b']);
+
+    // Handlers added after a transform apply to later transforms only.
+    rewriter.on('span', {
+      element(e) {
+        e.remove();
+      },
+    });
+    strictEqual(
+      await rewriter
+        .transform(new Response('<p id="c"></p><span></span>'))
+        .text(),
+      '<p id="c">C</p>'
+    );
+  },
+};
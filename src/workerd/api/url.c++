@@ -107,6 +107,24 @@ kj::ArrayPtr<const char> split(kj::StringPtr& text, const kj::parse::CharGroup_&
   return result;
 }
 
+// Validates and lower-cases a scheme in place. A scheme is an ASCII letter followed by letters,
+// digits, '+', '-', or '.' -- the same rule kj::Url::parse() applies.
+bool tryNormalizeScheme(kj::ArrayPtr<char> scheme) {
+  constexpr auto SCHEME_CHARS = kj::parse::alphaNumeric.orAny("+-.");
+  if (scheme.size() == 0 || !kj::parse::alpha.contains(scheme[0])) {
+    return false;
+  }
+  for (auto& c: scheme) {
+    if (!SCHEME_CHARS.contains(c)) {
+      return false;
+    }
+    if ('A' <= c && c <= 'Z') {
+      c += 'a' - 'A';
+    }
+  }
+  return true;
+}
+
 kj::String percentDecode(kj::ArrayPtr<const char> text, bool& hadErrors) {
   // TODO(cleanup): Code duplication with kj/compat/url.c++.
 
@@ -161,6 +179,23 @@ kj::String kjUrlToString(const kj::Url& url) {
   return kj::mv(result);
 }
 
+// Applies `update`, which sets the username or password, to the URL. These are stored decoded and
+// percent-encoded on output, so when the URL has a host, any value round-trips and we can update
+// the URL in place. Without a host, whether userinfo is allowed at all is up to kj::Url's parser,
+// so we update a copy and keep it only if it still parses, as these setters always have.
+template <typename Func>
+void updateUserInfo(kj::Url& url, Func&& update) {
+  if (url.host.size() > 0) {
+    update(url);
+  } else {
+    auto copy = url.clone();
+    update(copy);
+    KJ_IF_SOME(u, kj::Url::tryParse(kjUrlToString(copy))) {
+      url = kj::mv(u);
+    }
+  }
+}
+
 }  // namespace
 
 // =======================================================================================
@@ -186,26 +221,15 @@ URL::URL(kj::Url&& u): url(kj::refcounted<RefcountedUrl>(kj::mv(u))) {
 // When possible, getters just pull out the corresponding attribute from kj::Url and return it.
 // Sometimes we need to modify the output a bit, e.g. to get the hostname and port separately.
 //
-// Setters need to set and validate new input. To accomplish this without reimplementing validation
-// code that ought to live in kj::Url, I have implemented setters using the following general
-// strategy:
-//
-// 1. Pre-process the input, if necessary. E.g., we drop anything after a ':' when setting protocol.
-// 2. Clone the kj::Url object.
-// 3. Replace the cloned component in question with the new value.
-// 4. Stringify and parse the clone. If this succeeds, the clone is the new kj::Url object.
+// Setters need to set and validate new input. Each setter parses only the component it replaces,
+// in the spirit of the WHATWG URL spec's state overrides, and modifies the kj::Url in place. The
+// validation applied to each component matches what kj::Url's parser would apply to it, so a URL
+// modified by setters always stringifies to something that parses back to the same kj::Url. The
+// one exception is userinfo on a URL with no host, which is still checked by stringifying and
+// reparsing the whole URL (see updateUserInfo()).
 //
-// Notably, we do little to no validation in this wrapper class. As validation checks are added to
-// kj::Url's parser, more and more unit tests for this wrapper class should start passing without
-// modification.
-//
-// TODO(perf): Pre-processing input, cloning, stringifying, and parsing the cloned URL is an awfully
-//   heavyweight operation when all we want to do is validly replace a URL component. A couple
-//   attributes, pathname and search, are able to take advantage of the kj::Url parser's context
-//   argument: we can parse a pathname using the HTTP_REQUEST context, for instance. The WHATWG URL
-//   spec defines a parser state machine allowing for the state to be overridden to parse only
-//   specific components of a URL. This is more or less a generalization of kj::Url's parser
-//   context, and offers an obvious path forward to both conformance and performance.
+// Notably, we do little validation beyond that in this wrapper class. The standard URL
+// implementation (url-standard.c++) is the conformant one.
 
 kj::String URL::getHref() {
   return toString();
@@ -242,14 +266,10 @@ void URL::setProtocol(kj::String value) {
     value = kj::str(value.first(colon));
   }
 
-  auto copy = url->clone();
-  copy.scheme = kj::mv(value);
-
-  KJ_IF_SOME(u, kj::Url::tryParse(kjUrlToString(copy))) {
-    url->kj::Url::operator=(kj::mv(u));
+  if (tryNormalizeScheme(value)) {
+    url->scheme = kj::mv(value);
+    normalizePort(*url);
   }
-
-  normalizePort(*url);
 }
 
 kj::String URL::getUsername() {
@@ -259,16 +279,13 @@ kj::String URL::getUsername() {
   return {};
 }
 void URL::setUsername(kj::String value) {
-  auto copy = url->clone();
-  KJ_IF_SOME(ui, copy.userInfo) {
-    ui.username = kj::mv(value);
-  } else {
-    copy.userInfo = kj::Url::UserInfo{.username = kj::mv(value)};
-  }
-
-  KJ_IF_SOME(u, kj::Url::tryParse(kjUrlToString(copy))) {
-    url->kj::Url::operator=(kj::mv(u));
-  }
+  updateUserInfo(*url, [&](kj::Url& u) {
+    KJ_IF_SOME(ui, u.userInfo) {
+      ui.username = kj::mv(value);
+    } else {
+      u.userInfo = kj::Url::UserInfo{.username = kj::mv(value)};
+    }
+  });
 }
 
 kj::String URL::getPassword() {
@@ -280,22 +297,19 @@ kj::String URL::getPassword() {
   return {};
 }
 void URL::setPassword(kj::String value) {
-  auto copy = url->clone();
-  KJ_IF_SOME(ui, copy.userInfo) {
-    // We already have userInfo. Set the password if we were given a non-empty string, otherwise
-    // reset the password Maybe.
-    if (value.size() > 0) {
-      ui.password = kj::mv(value);
-    } else {
-      ui.password = kj::none;
+  updateUserInfo(*url, [&](kj::Url& u) {
+    KJ_IF_SOME(ui, u.userInfo) {
+      // We already have userInfo. Set the password if we were given a non-empty string, otherwise
+      // reset the password Maybe.
+      if (value.size() > 0) {
+        ui.password = kj::mv(value);
+      } else {
+        ui.password = kj::none;
+      }
+    } else if (value.size() > 0) {
+      u.userInfo = kj::Url::UserInfo{.password = kj::mv(value)};
     }
-  } else if (value.size() > 0) {
-    copy.userInfo = kj::Url::UserInfo{.password = kj::mv(value)};
-  }
-
-  KJ_IF_SOME(u, kj::Url::tryParse(kjUrlToString(copy))) {
-    url->kj::Url::operator=(kj::mv(u));
-  }
+  });
 }
 
 kj::String URL::getHost() {
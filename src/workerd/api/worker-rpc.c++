@@ -159,6 +159,21 @@ void RpcDeserializerExternalHandler::setLastStream(capnp::Capability::Client str
 
 namespace {
 
+// Error thrown when a value exceeds MAX_JS_RPC_MESSAGE_SIZE. `size` is only known if
+// serialization got to finish; otherwise it was abandoned as soon as the limit was crossed.
+kj::Exception rpcSizeLimitError(kj::Maybe<size_t> size) {
+  KJ_IF_SOME(s, size) {
+    return JSG_KJ_EXCEPTION(FAILED, Error,
+        "Serialized RPC arguments or return values are limited to 32MiB, but the size of this "
+        "value was: ",
+        s, " bytes.");
+  } else {
+    return JSG_KJ_EXCEPTION(FAILED, Error,
+        "Serialized RPC arguments or return values are limited to 32MiB, but the size of this "
+        "value was larger than that.");
+  }
+}
+
 // Call to construct an `rpc::JsValue` from a JS value.
 //
 // `makeBuilder` is a function which takes a capnp::MessageSize hint and returns the
@@ -174,13 +189,11 @@ void serializeJsValue(jsg::Lock& js,
         .omitHeader = false,
         .treatClassInstancesAsPlainObjects = false,
         .externalHandler = externalHandler,
+        .maxSize = MAX_JS_RPC_MESSAGE_SIZE,
+        .maxSizeError = kj::Function<kj::Exception(kj::Maybe<size_t>)>(rpcSizeLimitError),
       });
   serializer.write(js, value);
   kj::Array<const byte> data = serializer.release().data;
-  JSG_ASSERT(data.size() <= MAX_JS_RPC_MESSAGE_SIZE, Error,
-      "Serialized RPC arguments or return values are limited to 32MiB, but the size of this value "
-      "was: ",
-      data.size(), " bytes.");
 
   capnp::MessageSize hint{0, 0};
   hint.wordCount += (data.size() + sizeof(capnp::word) - 1) / sizeof(capnp::word);
@@ -191,8 +204,9 @@ void serializeJsValue(jsg::Lock& js,
   rpc::JsValue::Builder builder = makeBuilder(hint);
 
   // TODO(perf): It would be nice if we could serialize directly into the capnp message to avoid
-  // a redundant copy of the bytes here. Maybe we could even cancel serialization early if it
-  // goes over the size limit.
+  // a redundant copy of the bytes here. However, capnp can only grow a Data blob in place when it
+  // happens to be last in its segment; otherwise it moves it and leaves the old copy behind as
+  // zeroed padding that would then go out on the wire.
   builder.setV8Serialized(data);
 
   if (externalHandler.size() > 0) {
@@ -453,28 +467,48 @@ JsRpcPromiseAndPipeline callImpl(jsg::Lock& js,
         client = lock.then([client = kj::mv(client)]() mutable { return kj::mv(client); });
       }
 
-      auto builder = client.callRequest();
-
-      // This code here is slightly overcomplicated in order to avoid pushing anything to the
-      // kj::Vector in the common case that the parent path is empty. I'm probably trying too hard
-      // but oh well.
-      if (path.empty()) {
-        KJ_IF_SOME(n, name) {
-          builder.setMethodName(n);
-        } else {
-          // No name and no path, must be directly calling a stub.
-          builder.initMethodPath(0);
-        }
-      } else {
-        auto pathBuilder = builder.initMethodPath(path.size() + (name != kj::none));
-        for (auto i: kj::indices(path)) {
-          pathBuilder.set(i, path[i]);
+      // Creates the request and fills in the method path, with room for `hint` more on top.
+      auto newCall = [&](capnp::MessageSize hint) {
+        hint.wordCount += capnp::sizeInWords<rpc::JsRpcTarget::CallParams>();
+        hint.capCount += 1;  // for resultsStreamSink
+        auto textWords = [](kj::StringPtr text) {
+          return (text.size() + sizeof(capnp::word)) / sizeof(capnp::word);
+        };
+        hint.wordCount += path.size() + 1;  // the method path's elements
+        for (auto& part: path) {
+          hint.wordCount += textWords(part);
         }
         KJ_IF_SOME(n, name) {
-          pathBuilder.set(path.size(), n);
+          hint.wordCount += textWords(n);
         }
-      }
 
+        auto builder = client.callRequest(hint);
+
+        // This code here is slightly overcomplicated in order to avoid pushing anything to the
+        // kj::Vector in the common case that the parent path is empty. I'm probably trying too
+        // hard but oh well.
+        if (path.empty()) {
+          KJ_IF_SOME(n, name) {
+            builder.setMethodName(n);
+          } else {
+            // No name and no path, must be directly calling a stub.
+            builder.initMethodPath(0);
+          }
+        } else {
+          auto pathBuilder = builder.initMethodPath(path.size() + (name != kj::none));
+          for (auto i: kj::indices(path)) {
+            pathBuilder.set(i, path[i]);
+          }
+          KJ_IF_SOME(n, name) {
+            pathBuilder.set(path.size(), n);
+          }
+        }
+        return builder;
+      };
+
+      // The request isn't created until we know how big the serialized arguments are.
+      kj::Maybe<capnp::Request<rpc::JsRpcTarget::CallParams, rpc::JsRpcTarget::CallResults>>
+          maybeBuilder;
       kj::Maybe<StreamSinkFulfiller> paramsStreamSinkFulfiller;
 
       KJ_IF_SOME(args, maybeArgs) {
@@ -499,15 +533,20 @@ JsRpcPromiseAndPipeline callImpl(jsg::Lock& js,
             return kj::mv(paf.promise);
           });
           serializeJsValue(js, jsg::JsValue(arr), externalHandler, [&](capnp::MessageSize hint) {
-            // TODO(perf): Actually use the size hint.
-            return builder.getOperation().initCallWithArgs();
+            return maybeBuilder.emplace(newCall(hint)).getOperation().initCallWithArgs();
           });
         }
-      } else {
-        // This is a property access.
-        builder.getOperation().setGetProperty();
       }
 
+      if (maybeBuilder == kj::none) {
+        auto& builder = maybeBuilder.emplace(newCall(capnp::MessageSize{0, 0}));
+        if (maybeArgs == kj::none) {
+          // This is a property access.
+          builder.getOperation().setGetProperty();
+        }
+      }
+      auto& builder = KJ_ASSERT_NONNULL(maybeBuilder);
+
       // Unfortunately, we always have to send a `resultsStreamSink` because we don't know until
       // after the call completes whether or not it will return any streams. If it's unused,
       // though, it should only be a couple allocations.
@@ -210,6 +210,8 @@ struct ActorCacheTestOptions {
   size_t maxKeysPerRpc = 128;
   bool noCache = false;
   bool neverFlush = false;
+  uint maxFlushesInFlight = 1;
+  uint maxBatchesInFlight = 0;
 };
 
 struct ActorCacheTest: public ActorCacheConvenienceWrappers {
@@ -234,7 +236,8 @@ struct ActorCacheTest: public ActorCacheConvenienceWrappers {
         ws(loop),
         mockStorage(kj::mv(mockPair.mock)),
         lru({options.softLimit, options.hardLimit, options.staleTimeout, options.dirtyListByteLimit,
-          options.maxKeysPerRpc, options.noCache, options.neverFlush}),
+          options.maxKeysPerRpc, options.noCache, options.neverFlush, options.maxFlushesInFlight,
+          options.maxBatchesInFlight}),
         cache(kj::mv(mockPair.client), lru, gate),
         gateBrokenPromise(options.monitorOutputGate ? eagerlyReportExceptions(gate.onBroken())
                                                     : kj::Promise<void>(kj::READY_NOW)) {}
@@ -1273,6 +1276,180 @@ KJ_TEST("ActorCache output gate blocked during flush") {
   gatePromise.wait(ws);
 }
 
+KJ_TEST("ActorCache pipelined flushes") {
+  ActorCacheTest test({.maxFlushesInFlight = 2});
+  auto& ws = test.ws;
+  auto& mockStorage = test.mockStorage;
+
+  test.put("foo", "123");
+
+  auto mockTxn1 = mockStorage->expectCall("txn", ws).returnMock("transaction");
+  mockTxn1->expectCall("put", ws)
+      .withParams(CAPNP(entries = [(key = "foo", value = "123")]))
+      .thenReturn(CAPNP());
+  auto commit1 = mockTxn1->expectCall("commit", ws);
+
+  // A second flush sends its writes while the first is still committing. It only carries what
+  // changed since the first one started.
+  test.put({{"foo", "456"}, {"bar", "789"}});
+  auto gatePromise = test.gate.wait();
+
+  auto mockTxn2 = mockStorage->expectCall("txn", ws).returnMock("transaction");
+  mockTxn2->expectCall("put", ws)
+      .withParams(CAPNP(entries = [ (key = "foo", value = "456"), (key = "bar", value = "789") ]))
+      .thenReturn(CAPNP());
+
+  // But it doesn't commit until the first one has completed, and a third flush must wait for the
+  // first to complete before starting at all.
+  test.put("baz", "000");
+  mockTxn2->expectNoActivity(ws);
+  mockStorage->expectNoActivity(ws);
+
+  kj::mv(commit1).thenReturn(CAPNP());
+  mockTxn1->expectDropped(ws);
+  auto commit2 = mockTxn2->expectCall("commit", ws);
+
+  auto mockTxn3 = mockStorage->expectCall("txn", ws).returnMock("transaction");
+  mockTxn3->expectCall("put", ws)
+      .withParams(CAPNP(entries = [(key = "baz", value = "000")]))
+      .thenReturn(CAPNP());
+  mockTxn3->expectNoActivity(ws);
+
+  KJ_ASSERT(!gatePromise.poll(ws));
+  kj::mv(commit2).thenReturn(CAPNP());
+  mockTxn2->expectDropped(ws);
+  gatePromise.wait(ws);
+
+  mockTxn3->expectCall("commit", ws).thenReturn(CAPNP());
+  mockTxn3->expectDropped(ws);
+  test.gate.wait().wait(ws);
+
+  KJ_ASSERT(KJ_ASSERT_NONNULL(expectCached(test.get("foo"))) == "456");
+  KJ_ASSERT(KJ_ASSERT_NONNULL(expectCached(test.get("bar"))) == "789");
+  KJ_ASSERT(KJ_ASSERT_NONNULL(expectCached(test.get("baz"))) == "000");
+}
+
+KJ_TEST("ActorCache pipelined flushes retry after disconnect") {
+  ActorCacheTest test({.maxFlushesInFlight = 2});
+  auto& ws = test.ws;
+  auto& mockStorage = test.mockStorage;
+
+  test.put("foo", "123");
+
+  auto mockTxn1 = mockStorage->expectCall("txn", ws).returnMock("transaction");
+  mockTxn1->expectCall("put", ws)
+      .withParams(CAPNP(entries = [(key = "foo", value = "123")]))
+      .thenReturn(CAPNP());
+  auto commit1 = mockTxn1->expectCall("commit", ws);
+
+  test.put("bar", "456");
+  auto gatePromise = test.gate.wait();
+
+  auto mockTxn2 = mockStorage->expectCall("txn", ws).returnMock("transaction");
+  mockTxn2->expectCall("put", ws)
+      .withParams(CAPNP(entries = [(key = "bar", value = "456")]))
+      .thenReturn(CAPNP());
+
+  // The first flush fails and is retried with the same contents, while the second keeps waiting to
+  // commit.
+  kj::mv(commit1).thenThrow(KJ_EXCEPTION(DISCONNECTED, "flush failed"));
+  mockTxn1->expectDropped(ws);
+  {
+    auto mockTxn = mockStorage->expectCall("txn", ws).returnMock("transaction");
+    mockTxn->expectCall("put", ws)
+        .withParams(CAPNP(entries = [(key = "foo", value = "123")]))
+        .thenReturn(CAPNP());
+    mockTxn2->expectNoActivity(ws);
+    mockTxn->expectCall("commit", ws).thenReturn(CAPNP());
+    mockTxn->expectDropped(ws);
+  }
+
+  // Now the second flush commits, fails, and is retried on its own.
+  mockTxn2->expectCall("commit", ws).thenThrow(KJ_EXCEPTION(DISCONNECTED, "flush failed"));
+  mockTxn2->expectDropped(ws);
+  KJ_ASSERT(!gatePromise.poll(ws));
+  {
+    auto mockTxn = mockStorage->expectCall("txn", ws).returnMock("transaction");
+    mockTxn->expectCall("put", ws)
+        .withParams(CAPNP(entries = [(key = "bar", value = "456")]))
+        .thenReturn(CAPNP());
+    mockTxn->expectCall("commit", ws).thenReturn(CAPNP());
+    mockTxn->expectDropped(ws);
+  }
+
+  gatePromise.wait(ws);
+
+  KJ_ASSERT(KJ_ASSERT_NONNULL(expectCached(test.get("foo"))) == "123");
+  KJ_ASSERT(KJ_ASSERT_NONNULL(expectCached(test.get("bar"))) == "456");
+}
+
+KJ_TEST("ActorCache pipelined flush isn't resent when an earlier flush fails") {
+  ActorCacheTest test({.maxFlushesInFlight = 2});
+  auto& ws = test.ws;
+  auto& mockStorage = test.mockStorage;
+
+  test.put("foo", "123");
+
+  auto mockTxn1 = mockStorage->expectCall("txn", ws).returnMock("transaction");
+  mockTxn1->expectCall("put", ws)
+      .withParams(CAPNP(entries = [(key = "foo", value = "123")]))
+      .thenReturn(CAPNP());
+  auto commit1 = mockTxn1->expectCall("commit", ws);
+
+  test.put("bar", "456");
+  auto gatePromise = test.gate.wait();
+
+  auto mockTxn2 = mockStorage->expectCall("txn", ws).returnMock("transaction");
+  mockTxn2->expectCall("put", ws)
+      .withParams(CAPNP(entries = [(key = "bar", value = "456")]))
+      .thenReturn(CAPNP());
+
+  // The first flush keeps disconnecting until it runs out of retries.
+  kj::mv(commit1).thenThrow(KJ_EXCEPTION(DISCONNECTED, "jsg.Error: flush failed"));
+  mockTxn1->expectDropped(ws);
+  for (auto i KJ_UNUSED: kj::zeroTo(4)) {
+    auto mockTxn = mockStorage->expectCall("txn", ws).returnMock("transaction");
+    mockTxn->expectCall("put", ws)
+        .withParams(CAPNP(entries = [(key = "foo", value = "123")]))
+        .thenReturn(CAPNP());
+    mockTxn->expectCall("commit", ws)
+        .thenThrow(KJ_EXCEPTION(DISCONNECTED, "jsg.Error: flush failed"));
+    mockTxn->expectDropped(ws);
+  }
+
+  // The second flush fails along with it, without committing or being sent again.
+  mockTxn2->expectDropped(ws);
+  mockStorage->expectNoActivity(ws);
+  KJ_EXPECT_THROW_MESSAGE("flush failed", gatePromise.wait(ws));
+}
+
+KJ_TEST("ActorCache paces flush batches") {
+  ActorCacheTest test({.maxKeysPerRpc = 1, .maxBatchesInFlight = 2});
+  auto& ws = test.ws;
+  auto& mockStorage = test.mockStorage;
+
+  test.put({{"a", "1"}, {"b", "2"}, {"c", "3"}});
+
+  auto mockTxn = mockStorage->expectCall("txn", ws).returnMock("transaction");
+  auto putA =
+      mockTxn->expectCall("put", ws).withParams(CAPNP(entries = [(key = "a", value = "1")]));
+  auto putB =
+      mockTxn->expectCall("put", ws).withParams(CAPNP(entries = [(key = "b", value = "2")]));
+
+  // The third batch isn't sent until the first is acknowledged.
+  mockTxn->expectNoActivity(ws);
+  kj::mv(putA).thenReturn(CAPNP());
+
+  mockTxn->expectCall("put", ws)
+      .withParams(CAPNP(entries = [(key = "c", value = "3")]))
+      .thenReturn(CAPNP());
+  kj::mv(putB).thenReturn(CAPNP());
+  mockTxn->expectCall("commit", ws).thenReturn(CAPNP());
+  mockTxn->expectDropped(ws);
+
+  test.gate.wait().wait(ws);
+}
+
 KJ_TEST("ActorCache output gate bypass") {
   ActorCacheTest test({.monitorOutputGate = false});
   auto& ws = test.ws;
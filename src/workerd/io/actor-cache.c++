@@ -25,6 +25,9 @@ namespace workerd {
 // hit this limit, so this is just a sanity check.
 static constexpr size_t MAX_ACTOR_STORAGE_RPC_WORDS = (16u << 20) / sizeof(capnp::word);
 
+// Number of times a flush is retried after a disconnect before giving up.
+static constexpr size_t MAX_FLUSH_RETRIES = 4;
+
 const ActorCache::Hooks ActorCache::Hooks::DEFAULT;
 
 namespace {
@@ -2190,17 +2193,22 @@ void ActorCache::ensureFlushScheduled(const WriteOptions& options) {
 
   if (!flushScheduled) {
     flushScheduled = true;
-    auto flushPromise = lastFlush.addBranch()
-                            .attach(kj::defer([this]() {
-      flushScheduled = false;
-      flushScheduledWithOutputGate = false;
-    })).then([this]() {
-      ++flushesEnqueued;
-      return kj::evalNow([this]() {
-        // `flushImpl()` can throw, so we need to wrap it in `evalNow()` to observe all pathways.
-        return flushImpl();
-      }).attach(kj::defer([this]() { --flushesEnqueued; }));
-    });
+    kj::Promise<void> flushPromise = nullptr;
+    if (lru.options.maxFlushesInFlight > 1) {
+      flushPromise = schedulePipelinedFlush();
+    } else {
+      flushPromise = lastFlush.addBranch()
+                         .attach(kj::defer([this]() {
+        flushScheduled = false;
+        flushScheduledWithOutputGate = false;
+      })).then([this]() {
+        ++flushesEnqueued;
+        return kj::evalNow([this]() {
+          // `flushImpl()` can throw, so we need to wrap it in `evalNow()` to observe all pathways.
+          return flushImpl();
+        }).attach(kj::defer([this]() { --flushesEnqueued; }));
+      });
+    }
 
     if (options.allowUnconfirmed) {
       // Don't apply output gate. But, if an exception is thrown, we still want to break the gate,
@@ -2213,6 +2221,11 @@ void ActorCache::ensureFlushScheduled(const WriteOptions& options) {
     }
 
     lastFlush = flushPromise.fork();
+
+    if (lru.options.maxFlushesInFlight > 1) {
+      pipelinedFlushSlots[flushesScheduled++ % pipelinedFlushSlots.size()] =
+          lastFlush.addBranch().fork();
+    }
   } else if (!flushScheduledWithOutputGate && !options.allowUnconfirmed) {
     // The flush has already been scheduled without the output gate, but we want to upgrade it to
     // use the output gate now.
@@ -2293,6 +2306,135 @@ using RpcDeleteRequest = capnp::Request<rpc::ActorStorage::Operations::DeletePar
     rpc::ActorStorage::Operations::DeleteResults>;
 }  // namespace
 
+void ActorCache::addToFlushBatch(kj::Vector<FlushBatch>& batches, size_t words) {
+  KJ_ASSERT(words < MAX_ACTOR_STORAGE_RPC_WORDS);
+
+  if (batches.empty()) {
+    // This is the first one, let's just set up a current batch.
+    batches.add(FlushBatch{});
+  } else if (auto& tailBatch = batches.back(); tailBatch.pairCount >= lru.options.maxKeysPerRpc ||
+             ((tailBatch.wordCount + words) > MAX_ACTOR_STORAGE_RPC_WORDS)) {
+    // We've filled this batch, add a new one.
+    batches.add(FlushBatch{});
+  }
+
+  auto& batch = batches.back();
+  ++batch.pairCount;
+  batch.wordCount += words;
+}
+
+void ActorCache::addToFlush(Entry& entry, PutFlush& putFlush, MutedDeleteFlush& mutedDeleteFlush) {
+  // Counts up the number of operations and RPC message sizes we'll need to cover this entry.
+
+  if (entry.isCountedDelete) {
+    // We should have already put this entry into a batch, so just skip it.
+    KJ_ASSERT(entry.flushStarted);
+    return;
+  }
+
+  entry.flushStarted = true;
+
+  auto keySizeInWords = bytesToWordsRoundUp(entry.key.size());
+
+  KJ_IF_SOME(v, entry.getValuePtr()) {
+    auto words = keySizeInWords + bytesToWordsRoundUp(v.size()) +
+        capnp::sizeInWords<rpc::ActorStorage::KeyValue>();
+    addToFlushBatch(putFlush.batches, words);
+    putFlush.entries.add(kj::atomicAddRef(entry));
+  } else {
+    auto words = keySizeInWords + 1;
+    addToFlushBatch(mutedDeleteFlush.batches, words);
+    mutedDeleteFlush.entries.add(kj::atomicAddRef(entry));
+  }
+}
+
+ActorCache::MaybeAlarmChange ActorCache::startAlarmFlush() {
+  KJ_SWITCH_ONEOF(currentAlarmTime) {
+    KJ_CASE_ONEOF(knownAlarmTime, ActorCache::KnownAlarmTime) {
+      if (knownAlarmTime.status == KnownAlarmTime::Status::DIRTY ||
+          knownAlarmTime.status == KnownAlarmTime::Status::FLUSHING) {
+        knownAlarmTime.status = KnownAlarmTime::Status::FLUSHING;
+        return DirtyAlarm{knownAlarmTime.time};
+      }
+    }
+    KJ_CASE_ONEOF(deferredDelete, ActorCache::DeferredAlarmDelete) {
+      if (deferredDelete.status == DeferredAlarmDelete::Status::READY ||
+          deferredDelete.status == DeferredAlarmDelete::Status::FLUSHING) {
+        deferredDelete.status = DeferredAlarmDelete::Status::FLUSHING;
+        return DirtyAlarm{kj::none};
+      }
+    }
+    KJ_CASE_ONEOF(_, UnknownAlarmTime) {}
+  }
+  return CleanAlarm{};
+}
+
+void ActorCache::finishAlarmFlush() {
+  KJ_SWITCH_ONEOF(currentAlarmTime) {
+    KJ_CASE_ONEOF(knownAlarmTime, ActorCache::KnownAlarmTime) {
+      if (knownAlarmTime.status == KnownAlarmTime::Status::FLUSHING) {
+        if (knownAlarmTime.noCache) {
+          currentAlarmTime = UnknownAlarmTime{};
+        } else {
+          knownAlarmTime.status = KnownAlarmTime::Status::CLEAN;
+        }
+      }
+    }
+    KJ_CASE_ONEOF(deferredDelete, ActorCache::DeferredAlarmDelete) {
+      if (deferredDelete.status == DeferredAlarmDelete::Status::FLUSHING) {
+        bool wasDeleted = KJ_ASSERT_NONNULL(deferredDelete.wasDeleted);
+        if (deferredDelete.noCache || !wasDeleted) {
+          currentAlarmTime = UnknownAlarmTime{};
+        } else {
+          currentAlarmTime = KnownAlarmTime{.status = KnownAlarmTime::Status::CLEAN,
+            .time = kj::none,
+            .noCache = deferredDelete.noCache};
+        }
+      }
+    }
+    KJ_CASE_ONEOF(_, ActorCache::UnknownAlarmTime) {}
+  }
+}
+
+void ActorCache::finishEntryFlush(Lock& lock, Entry& entry) {
+  KJ_ASSERT(entry.flushStarted);
+
+  // We know all `countedDelete` operations were satisfied so we can remove this if it's
+  // present. The `CountedDeleteWaiters` will resolve once the flush is finished, and will
+  // remove the `CountedDelete`s from `countedDeletes`. Even if it doesn't happen by the
+  // next flush, each `CountedDelete` should have `isFinished` set so even if we encounter it
+  // next flush we won't attempt to delete again.
+  entry.isCountedDelete = false;
+
+  dirtyList.remove(entry);
+  if (entry.noCache) {
+    entry.setNotInCache();
+    evictEntry(lock, entry);
+  } else {
+    if (entry.gapIsKnownEmpty && entry.getValueStatus() == EntryValueStatus::ABSENT) {
+      // This is a negative entry, and is followed by a known-empty gap. If the previous entry
+      // also has `gapIsKnownEmpty`, then this entry is entirely redundant.
+      auto& map = currentValues.get(lock);
+      auto entryIter = map.seek(entry.key);
+      KJ_ASSERT(entryIter->get() == &entry);
+
+      if (entryIter != map.ordered().begin()) {
+        auto prevIter = entryIter;
+        --prevIter;
+        if (prevIter->get()->gapIsKnownEmpty) {
+          // Yep!
+          entry.setNotInCache();
+          map.erase(*entryIter);
+          // WARNING: We might have just deleted `entry`.
+          return;
+        }
+      }
+    }
+
+    addToCleanList(lock, entry);
+  }
+}
+
 kj::Promise<void> ActorCache::startFlushTransaction() {
   // Whenever we flush, we MUST write ALL dirty entries in a single transaction. This is necessary
   // because our cache design doesn't necessarily remember the order in which writes were
@@ -2326,32 +2468,12 @@ kj::Promise<void> ActorCache::startFlushTransaction() {
   // muted deletes, we go ahead and construct batches of no more than 128 keys. They all end up
   // being part of the same transaction in the end, though.
   //
-  // TODO(perf): Currently we send all the batches at the same time. If the batches are large,
-  //   it could be worth spacing them out a bit so we don't saturate the connection. However, we
-  //   still need to make sure that the whole transaction represents a consistent snapshot in time,
-  //   so getting this right, without making a copy of everything upfront, could get complicated.
-  //   Punting for now.
+  // The request messages for all batches are built upfront, so the transaction is a consistent
+  // snapshot even if `maxBatchesInFlight` spaces out sending them.
 
   PutFlush putFlush;
   MutedDeleteFlush mutedDeleteFlush;
 
-  auto includeInCurrentBatch = [this](kj::Vector<FlushBatch>& batches, size_t words) {
-    KJ_ASSERT(words < MAX_ACTOR_STORAGE_RPC_WORDS);
-
-    if (batches.empty()) {
-      // This is the first one, let's just set up a current batch.
-      batches.add(FlushBatch{});
-    } else if (auto& tailBatch = batches.back(); tailBatch.pairCount >= lru.options.maxKeysPerRpc ||
-               ((tailBatch.wordCount + words) > MAX_ACTOR_STORAGE_RPC_WORDS)) {
-      // We've filled this batch, add a new one.
-      batches.add(FlushBatch{});
-    }
-
-    auto& batch = batches.back();
-    ++batch.pairCount;
-    batch.wordCount += words;
-  };
-
   kj::Vector<CountedDeleteFlush> countedDeleteFlushes(countedDeletes.size());
   for (auto countedDelete: countedDeletes) {
     if (countedDelete->isFinished) {
@@ -2407,53 +2529,11 @@ kj::Promise<void> ActorCache::startFlushTransaction() {
 
       auto keySizeInWords = bytesToWordsRoundUp(entry->key.size());
       auto words = keySizeInWords + 1;
-      includeInCurrentBatch(countedDeleteFlush.batches, words);
+      addToFlushBatch(countedDeleteFlush.batches, words);
     }
   }
 
-  auto countEntry = [&](Entry& entry) {
-    // Counts up the number of operations and RPC message sizes we'll need to cover this entry.
-
-    if (entry.isCountedDelete) {
-      // We should have already put this entry into a batch, so just skip it.
-      KJ_ASSERT(entry.flushStarted);
-      return;
-    }
-
-    entry.flushStarted = true;
-
-    auto keySizeInWords = bytesToWordsRoundUp(entry.key.size());
-
-    KJ_IF_SOME(v, entry.getValuePtr()) {
-      auto words = keySizeInWords + bytesToWordsRoundUp(v.size()) +
-          capnp::sizeInWords<rpc::ActorStorage::KeyValue>();
-      includeInCurrentBatch(putFlush.batches, words);
-      putFlush.entries.add(kj::atomicAddRef(entry));
-    } else {
-      auto words = keySizeInWords + 1;
-      includeInCurrentBatch(mutedDeleteFlush.batches, words);
-      mutedDeleteFlush.entries.add(kj::atomicAddRef(entry));
-    }
-  };
-
-  MaybeAlarmChange maybeAlarmChange = CleanAlarm{};
-  KJ_SWITCH_ONEOF(currentAlarmTime) {
-    KJ_CASE_ONEOF(knownAlarmTime, ActorCache::KnownAlarmTime) {
-      if (knownAlarmTime.status == KnownAlarmTime::Status::DIRTY ||
-          knownAlarmTime.status == KnownAlarmTime::Status::FLUSHING) {
-        knownAlarmTime.status = KnownAlarmTime::Status::FLUSHING;
-        maybeAlarmChange = DirtyAlarm{knownAlarmTime.time};
-      }
-    }
-    KJ_CASE_ONEOF(deferredDelete, ActorCache::DeferredAlarmDelete) {
-      if (deferredDelete.status == DeferredAlarmDelete::Status::READY ||
-          deferredDelete.status == DeferredAlarmDelete::Status::FLUSHING) {
-        deferredDelete.status = DeferredAlarmDelete::Status::FLUSHING;
-        maybeAlarmChange = DirtyAlarm{kj::none};
-      }
-    }
-    KJ_CASE_ONEOF(_, UnknownAlarmTime) {}
-  }
+  MaybeAlarmChange maybeAlarmChange = startAlarmFlush();
 
   // We have to remember _before_ waiting for the flush whether or not it was a pre-deleteAll()
   // flush. Otherwise, if it wasn't, but someone calls deleteAll() while we're flushing, then
@@ -2461,11 +2541,11 @@ kj::Promise<void> ActorCache::startFlushTransaction() {
   // ready to issue the delete-all.
   KJ_IF_SOME(r, requestedDeleteAll) {
     for (auto& entry: r.deletedDirty) {
-      countEntry(*entry);
+      addToFlush(*entry, putFlush, mutedDeleteFlush);
     }
   } else {
     for (auto& entry: dirtyList) {
-      countEntry(entry);
+      addToFlush(entry, putFlush, mutedDeleteFlush);
     }
   }
 
@@ -2547,30 +2627,7 @@ kj::Promise<void> ActorCache::flushImpl(uint retryCount) {
     // we did not our alarm state can't know if it need to flush a new time or not after the delete
     // all. This might be another reason why delete all should not be considered truly deleting the
     // durable object: alarms are not cleared by a delete all.
-    KJ_SWITCH_ONEOF(currentAlarmTime) {
-      KJ_CASE_ONEOF(knownAlarmTime, ActorCache::KnownAlarmTime) {
-        if (knownAlarmTime.status == KnownAlarmTime::Status::FLUSHING) {
-          if (knownAlarmTime.noCache) {
-            currentAlarmTime = UnknownAlarmTime{};
-          } else {
-            knownAlarmTime.status = KnownAlarmTime::Status::CLEAN;
-          }
-        }
-      }
-      KJ_CASE_ONEOF(deferredDelete, ActorCache::DeferredAlarmDelete) {
-        if (deferredDelete.status == DeferredAlarmDelete::Status::FLUSHING) {
-          bool wasDeleted = KJ_ASSERT_NONNULL(deferredDelete.wasDeleted);
-          if (deferredDelete.noCache || !wasDeleted) {
-            currentAlarmTime = UnknownAlarmTime{};
-          } else {
-            currentAlarmTime = KnownAlarmTime{.status = KnownAlarmTime::Status::CLEAN,
-              .time = kj::none,
-              .noCache = deferredDelete.noCache};
-          }
-        }
-      }
-      KJ_CASE_ONEOF(_, ActorCache::UnknownAlarmTime) {}
-    }
+    finishAlarmFlush();
     if (flushingBeforeDeleteAll) {
       // The writes we flushed were writes that had occurred before a deleteAll. Now that they are
       // written, we must perform the deleteAll() itself.
@@ -2601,42 +2658,8 @@ kj::Promise<void> ActorCache::flushImpl(uint retryCount) {
           break;
         }
 
-        KJ_ASSERT(entry.flushStarted);
-
-        // We know all `countedDelete` operations were satisfied so we can remove this if it's
-        // present. The `CountedDeleteWaiters` will resolve once the flush is finished, and will
-        // remove the `CountedDelete`s from `countedDeletes`. Even if it doesn't happen by the
-        // next flush, each `CountedDelete` should have `isFinished` set so even if we encounter it
-        // next flush we won't attempt to delete again.
-        entry.isCountedDelete = false;
-
-        dirtyList.remove(entry);
-        if (entry.noCache) {
-          entry.setNotInCache();
-          evictEntry(lock, entry);
-        } else {
-          if (entry.gapIsKnownEmpty && entry.getValueStatus() == EntryValueStatus::ABSENT) {
-            // This is a negative entry, and is followed by a known-empty gap. If the previous entry
-            // also has `gapIsKnownEmpty`, then this entry is entirely redundant.
-            auto& map = currentValues.get(lock);
-            auto entryIter = map.seek(entry.key);
-            KJ_ASSERT(entryIter->get() == &entry);
-
-            if (entryIter != map.ordered().begin()) {
-              auto prevIter = entryIter;
-              --prevIter;
-              if (prevIter->get()->gapIsKnownEmpty) {
-                // Yep!
-                entry.setNotInCache();
-                map.erase(*entryIter);
-                // WARNING: We might have just deleted `entry`.
-                continue;
-              }
-            }
-          }
-
-          addToCleanList(lock, entry);
-        }
+        // WARNING: This might delete `entry`.
+        finishEntryFlush(lock, entry);
       }
     }
 
@@ -2644,30 +2667,189 @@ kj::Promise<void> ActorCache::flushImpl(uint retryCount) {
 
     return kj::READY_NOW;
   }, [this, retryCount](kj::Exception&& e) -> kj::Promise<void> {
-    static const size_t MAX_RETRIES = 4;
-    if (e.getType() == kj::Exception::Type::DISCONNECTED && retryCount < MAX_RETRIES) {
+    if (e.getType() == kj::Exception::Type::DISCONNECTED && retryCount < MAX_FLUSH_RETRIES) {
       return flushImpl(retryCount + 1);
-    } else if (jsg::isTunneledException(e.getDescription()) ||
-        jsg::isDoNotLogException(e.getDescription())) {
-      // Before passing along the exception, give it the proper brokenness reason.
-      // We were overriding any exception that came through here by ioGateBroken (now outputGateBroken).
-      // without checking for previous brokenness reasons we would be unable to throw
-      // exceededConcurrentStorageOps at all.
-      auto msg = jsg::stripRemoteExceptionPrefix(e.getDescription());
-      if (!(msg.startsWith("broken."))) {
-        e.setDescription(kj::str("broken.outputGateBroken; ", msg));
-      }
-      return kj::mv(e);
     } else {
-      if (isInterestingException(e)) {
-        LOG_EXCEPTION("actorCacheFlush", e);
-      } else {
-        LOG_NOSENTRY(ERROR, "actor cache flush failed", e);
+      return makeFlushException(kj::mv(e));
+    }
+  });
+}
+
+kj::Exception ActorCache::makeFlushException(kj::Exception&& e) {
+  if (jsg::isTunneledException(e.getDescription()) ||
+      jsg::isDoNotLogException(e.getDescription())) {
+    // Before passing along the exception, give it the proper brokenness reason.
+    // We were overriding any exception that came through here by ioGateBroken (now
+    // outputGateBroken). without checking for previous brokenness reasons we would be unable to
+    // throw exceededConcurrentStorageOps at all.
+    auto msg = jsg::stripRemoteExceptionPrefix(e.getDescription());
+    if (!(msg.startsWith("broken."))) {
+      e.setDescription(kj::str("broken.outputGateBroken; ", msg));
+    }
+    return kj::mv(e);
+  } else {
+    if (isInterestingException(e)) {
+      LOG_EXCEPTION("actorCacheFlush", e);
+    } else {
+      LOG_NOSENTRY(ERROR, "actor cache flush failed", e);
+    }
+    // Pass through exception type to convey appropriate retry behavior.
+    return kj::Exception(e.getType(), __FILE__, __LINE__,
+        kj::str("broken.outputGateBroken; jsg.Error: Internal error in Durable "
+                "Object storage write caused object to be reset."));
+  }
+}
+
+kj::Promise<void> ActorCache::schedulePipelinedFlush() {
+  if (pipelinedFlushSlots.size() == 0) {
+    pipelinedFlushSlots =
+        kj::heapArray<kj::Maybe<kj::ForkedPromise<void>>>(lru.options.maxFlushesInFlight);
+  }
+
+  // Wait for the flush scheduled `maxFlushesInFlight` flushes ago. Since flushes complete in
+  // order, this leaves at most `maxFlushesInFlight - 1` earlier flushes in flight.
+  kj::Promise<void> slotAvailable = kj::READY_NOW;
+  KJ_IF_SOME(earlier, pipelinedFlushSlots[flushesScheduled % pipelinedFlushSlots.size()]) {
+    slotAvailable = earlier.addBranch();
+  }
+
+  return slotAvailable
+      .attach(kj::defer([this]() {
+    flushScheduled = false;
+    flushScheduledWithOutputGate = false;
+  })).then([this, previous = lastFlush.addBranch()]() mutable {
+    ++flushesEnqueued;
+    return kj::evalNow([&]() {
+      // `flushImplPipelined()` can throw, so we need to wrap it in `evalNow()` to observe all
+      // pathways.
+      return flushImplPipelined(kj::mv(previous));
+    }).attach(kj::defer([this]() { --flushesEnqueued; }));
+  });
+}
+
+kj::Promise<void> ActorCache::flushImplPipelined(kj::Promise<void> previous) {
+  KJ_IF_SOME(e, maybeTerminalException) {
+    kj::throwFatalException(kj::cp(e));
+  }
+
+  // Counted deletes, deleteAll() and deferred alarm deletions report results (counts, whether the
+  // alarm was deleted) that must reflect every earlier write, but a pipelined flush sends its
+  // writes before earlier flushes have committed. So they fall back to flushing one at a time:
+  // after every earlier flush has completed, and before any later one starts.
+  bool needsSerialization =
+      requestedDeleteAll != kj::none || currentAlarmTime.is<DeferredAlarmDelete>();
+  for (auto countedDelete: countedDeletes) {
+    if (!countedDelete->isFinished) {
+      needsSerialization = true;
+    }
+  }
+
+  if (needsSerialization) {
+    ++serializedFlushesInFlight;
+    KJ_DEFER(--serializedFlushesInFlight);
+    co_await previous;
+    co_return co_await flushImpl();
+  }
+
+  if (serializedFlushesInFlight > 0) {
+    // A serialized flush only takes its snapshot once it starts, and may need to flush entries
+    // before a deleteAll(). Let it finish rather than racing it for the same entries.
+    co_await previous;
+    previous = kj::READY_NOW;
+  }
+
+  auto previousFork = previous.fork();
+
+  // Take a snapshot of everything that isn't already being written by an earlier flush. We only
+  // commit after earlier flushes have completed, so storage applies newer values last.
+  auto flush = kj::heap<PipelinedFlush>();
+  for (auto& entry: dirtyList) {
+    if (!entry.flushStarted) {
+      addToFlush(entry, flush->putFlush, flush->mutedDeleteFlush);
+    }
+  }
+  flush->maybeAlarmChange = startAlarmFlush();
+
+  bool hasWrites = flush->putFlush.batches.size() > 0 ||
+      flush->mutedDeleteFlush.batches.size() > 0 || flush->maybeAlarmChange.is<DirtyAlarm>();
+  if (hasWrites) {
+    flush->sequence = nextFlushSequence++;
+  }
+  if (flush->maybeAlarmChange.is<DirtyAlarm>()) {
+    // An earlier flush may be carrying the same alarm change. If it completes first, it must not
+    // mark the alarm clean while we still have it in flight.
+    alarmFlushSequence = flush->sequence;
+  }
+
+  // See startFlushTransaction() for why writes wait for past reads.
+  co_await waitForPastReads();
+
+  if (hasWrites) {
+    co_await sendPipelinedFlush(*flush, previousFork);
+  }
+
+  // Even with nothing to write, we only complete once all earlier flushes have, so that
+  // completion of the latest flush (which the output gate waits on) implies completion of all of
+  // them.
+  co_await previousFork.addBranch();
+
+  if (flush->maybeAlarmChange.is<DirtyAlarm>() && alarmFlushSequence == flush->sequence) {
+    finishAlarmFlush();
+  }
+
+  auto lock = lru.cleanList.lockExclusive();
+  auto finish = [&](kj::Vector<kj::Own<Entry>>& entries) {
+    for (auto& entry: entries) {
+      // Entries that were overwritten or dropped by deleteAll() since the snapshot are no longer
+      // in the dirty list, and are not ours to clean.
+      if (entry->getSyncStatus() == EntrySyncStatus::DIRTY) {
+        finishEntryFlush(lock, *entry);
       }
-      // Pass through exception type to convey appropriate retry behavior.
-      return kj::Exception(e.getType(), __FILE__, __LINE__,
-          kj::str("broken.outputGateBroken; jsg.Error: Internal error in Durable "
-                  "Object storage write caused object to be reset."));
+    }
+  };
+  finish(flush->putFlush.entries);
+  finish(flush->mutedDeleteFlush.entries);
+
+  evictOrOomIfNeeded(lock);
+}
+
+kj::Promise<void> ActorCache::sendPipelinedFlush(
+    PipelinedFlush& flush, kj::ForkedPromise<void>& previous, uint retryCount) {
+  KJ_IF_SOME(e, maybeTerminalException) {
+    kj::throwFatalException(kj::cp(e));
+  }
+
+  // flushImplUsingTxn() consumes its inputs, but a retry must resend the same transaction.
+  auto copyFlush = [](auto& from) {
+    kj::Decay<decltype(from)> to;
+    for (auto& entry: from.entries) {
+      to.entries.add(kj::atomicAddRef(*entry));
+    }
+    to.batches.addAll(from.batches);
+    return to;
+  };
+
+  // An earlier flush failing also fails this one, but that's not ours to retry: resending would
+  // just fail on it again.
+  auto earlierFailed = kj::heap<bool>(false);
+  auto commitAfter = previous.addBranch().catch_(
+      [&earlierFailed = *earlierFailed](kj::Exception&& e) -> kj::Promise<void> {
+    earlierFailed = true;
+    return kj::mv(e);
+  });
+
+  auto promise = flushImplUsingTxn(copyFlush(flush.putFlush), copyFlush(flush.mutedDeleteFlush),
+      nullptr, kj::cp(flush.maybeAlarmChange), kj::mv(commitAfter));
+  return oomCanceler.wrap(kj::mv(promise))
+      .catch_([this, &flush, &previous, retryCount, earlierFailed = kj::mv(earlierFailed)](
+                  kj::Exception&& e) -> kj::Promise<void> {
+    if (!*earlierFailed && e.getType() == kj::Exception::Type::DISCONNECTED &&
+        retryCount < MAX_FLUSH_RETRIES) {
+      // As with flushImpl(), resending is safe even if the first attempt actually committed:
+      // no later flush has committed since, so we just write the same values again.
+      return sendPipelinedFlush(flush, previous, retryCount + 1);
+    } else {
+      return makeFlushException(kj::mv(e));
     }
   });
 }
@@ -2799,7 +2981,8 @@ kj::Promise<void> ActorCache::flushImplAlarmOnly(DirtyAlarm dirty) {
 kj::Promise<void> ActorCache::flushImplUsingTxn(PutFlush putFlush,
     MutedDeleteFlush mutedDeleteFlush,
     CountedDeleteFlushes countedDeleteFlushes,
-    MaybeAlarmChange maybeAlarmChange) {
+    MaybeAlarmChange maybeAlarmChange,
+    kj::Maybe<kj::Promise<void>> commitAfter) {
   auto txnProm = storage.txnRequest(capnp::MessageSize{4, 0}).send();
   auto txn = txnProm.getTransaction();
 
@@ -2884,9 +3067,15 @@ kj::Promise<void> ActorCache::flushImplUsingTxn(PutFlush putFlush,
   // The constant extra 2 promises are those added outside of the rpc batches, currently one
   // to work around a bug in capnp::autoreconnect, and one to actually commit the flush txn
   // A 3rd promise may be added to write the alarm time if necessary.
-  auto promises = kj::heapArrayBuilder<kj::Promise<void>>(rpcPuts.size() + rpcMutedDeletes.size() +
+  kj::Vector<kj::Promise<void>> promises(rpcPuts.size() + rpcMutedDeletes.size() +
       rpcCountedDeletes.size() + 2 + !maybeAlarmChange.is<CleanAlarm>());
 
+  // If `maxBatchesInFlight` is set, then before sending another batch while that many are still
+  // awaiting a response, we wait for the oldest one. Requests are still sent in order, and their
+  // messages were all built above, so the transaction remains a consistent snapshot.
+  auto maxBatchesInFlight = lru.options.maxBatchesInFlight;
+  size_t batchesAcknowledged = 0;
+
   auto joinCountedDelete = [](RpcCountedDelete& rpcCountedDelete) -> kj::Promise<void> {
     auto promises = KJ_MAP(request, rpcCountedDelete.rpcDeletes) {
       return request.send().then(
@@ -2913,14 +3102,23 @@ kj::Promise<void> ActorCache::flushImplUsingTxn(PutFlush putFlush,
   };
 
   for (auto& rpcCountedDelete: rpcCountedDeletes) {
+    if (maxBatchesInFlight > 0 && promises.size() - batchesAcknowledged >= maxBatchesInFlight) {
+      co_await promises[batchesAcknowledged++];
+    }
     promises.add(joinCountedDelete(rpcCountedDelete));
   }
 
   for (auto& request: rpcMutedDeletes) {
+    if (maxBatchesInFlight > 0 && promises.size() - batchesAcknowledged >= maxBatchesInFlight) {
+      co_await promises[batchesAcknowledged++];
+    }
     promises.add(request.sendIgnoringResult());
   }
 
   for (auto& request: rpcPuts) {
+    if (maxBatchesInFlight > 0 && promises.size() - batchesAcknowledged >= maxBatchesInFlight) {
+      co_await promises[batchesAcknowledged++];
+    }
     promises.add(request.sendIgnoringResult());
   }
 
@@ -2969,13 +3167,23 @@ kj::Promise<void> ActorCache::flushImplUsingTxn(PutFlush putFlush,
   // if the promise is dropped but the pipeline stays alive.
   promises.add(txnProm.ignoreResult());
 
+  KJ_IF_SOME(promise, commitAfter) {
+    // A pipelined flush sends its writes early, but must not commit before the earlier flushes
+    // that overlap it, or storage could apply older values last.
+    co_await promise;
+  }
+
   {
     auto writeObserver = recordStorageWrite(hooks, clock);
     util::DurationExceededLogger logger(clock, 1 * kj::SECONDS,
         "storage operation took longer than expected: commit flush transaction");
     promises.add(txn.commitRequest(capnp::MessageSize{4, 0}).sendIgnoringResult());
 
-    co_await kj::joinPromises(promises.finish());
+    auto remaining = kj::heapArrayBuilder<kj::Promise<void>>(promises.size() - batchesAcknowledged);
+    for (auto& promise: promises.slice(batchesAcknowledged, promises.size())) {
+      remaining.add(kj::mv(promise));
+    }
+    co_await kj::joinPromises(remaining.finish());
     for (auto& rpcCountedDelete: rpcCountedDeletes) {
       // Now that the transaction has successfully completed, we can mark all our CountedDeletes
       // as having completed as well.
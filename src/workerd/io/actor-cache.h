@@ -9,6 +9,7 @@
 
 #include <kj/async.h>
 #include <kj/debug.h>
+#include <kj/function.h>
 #include <kj/list.h>
 #include <kj/map.h>
 #include <kj/mutex.h>
@@ -132,6 +133,34 @@ class ActorCacheOps {
   virtual kj::OneOf<GetResultList, kj::Promise<GetResultList>> listReverse(
       Key begin, kj::Maybe<Key> end, kj::Maybe<uint> limit, ReadOptions options) = 0;
 
+  // Receives one row from tryGetBorrowed() or tryListBorrowed(). `key` and `value` point into
+  // the implementation's own buffers and are only valid for the duration of the call.
+  using BorrowedRowCallback = kj::FunctionParam<void(KeyPtr key, ValuePtr value)>;
+
+  // Variants of get() and list() for implementations that can answer reads synchronously straight
+  // out of the storage engine's buffers. This lets the caller parse each value in place instead of
+  // receiving an owned copy of every key and value.
+  //
+  // tryGetBorrowed() calls `callback` for each of `keys` that is present, in key order.
+  // tryListBorrowed() calls `callback` for each row in the range, in reverse order if `reverse` is
+  // true, with the same range semantics as list() and listReverse().
+  //
+  // Returns false without calling `callback` if the implementation does not support borrowed
+  // reads, in which case the caller should use get() or list() instead. The default
+  // implementation always returns false.
+  virtual bool tryGetBorrowed(
+      kj::ArrayPtr<const Key> keys, ReadOptions options, BorrowedRowCallback callback) {
+    return false;
+  }
+  virtual bool tryListBorrowed(KeyPtr begin,
+      kj::Maybe<KeyPtr> end,
+      kj::Maybe<uint> limit,
+      bool reverse,
+      ReadOptions options,
+      BorrowedRowCallback callback) {
+    return false;
+  }
+
   using WriteOptions = ActorCacheWriteOptions;
 
   // Writes a key/value into cache and schedules it to be flushed to disk later.
@@ -727,12 +756,33 @@ class ActorCache final: public ActorCacheInterface {
 
   kj::Maybe<DeleteAllState> requestedDeleteAll;
 
-  // Promise for the completion of the previous flush. We can only execute one flushImpl() at a time
-  // because we can't allow out-of-order writes.
+  // Promise for the completion of the previous flush. Flushes always complete in the order they
+  // were scheduled, so this is also a watermark for all earlier flushes.
+  //
+  // By default we only execute one flushImpl() at a time because we can't allow out-of-order
+  // writes, and ActorStorage has automatic reconnect behavior at the supervisor layer which
+  // violates e-order. If `maxFlushesInFlight` allows, flushes are instead pipelined: a flush may
+  // open its transaction and send its writes while earlier ones are in flight, but still only
+  // commits once they have completed; see flushImplPipelined().
   kj::ForkedPromise<void> lastFlush = kj::Promise<void>(kj::READY_NOW).fork();
-  // TODO(perf): If we could rely on e-order on the ActorStorage API, we could pipeline additional
-  //   writes and not have to worry about this. However, at present, ActorStorage has automatic
-  //   reconnect behavior at the supervisor layer which violates e-order.
+
+  // When pipelining, completion of the flush scheduled `maxFlushesInFlight` flushes ago, indexed
+  // by the number of flushes scheduled modulo `maxFlushesInFlight`. A new flush may start once
+  // that one has completed.
+  kj::Array<kj::Maybe<kj::ForkedPromise<void>>> pipelinedFlushSlots;
+  uint64_t flushesScheduled = 0;
+
+  // Sequence number for the next pipelined flush that writes anything. Only used within this
+  // ActorCache, to tell which flush last carried the alarm.
+  uint64_t nextFlushSequence = 1;
+
+  // Sequence number of the latest pipelined flush that carried the alarm. The alarm is only
+  // clean once that flush completes.
+  uint64_t alarmFlushSequence = 0;
+
+  // Number of flushes running one-at-a-time while pipelining is enabled. Pipelined flushes must
+  // not overlap with these.
+  uint serializedFlushesInFlight = 0;
 
   // Did we hit a problem that makes the ActorCache unusable? If so this is the exception that
   // describes the problem.
@@ -820,6 +870,9 @@ class ActorCache final: public ActorCacheInterface {
   kj::Promise<void> flushImpl(uint retryCount = 0);
   kj::Promise<void> flushImplDeleteAll(uint retryCount = 0);
 
+  // Converts a non-retryable flush failure into the exception that breaks the output gate.
+  kj::Exception makeFlushException(kj::Exception&& e);
+
   struct FlushBatch {
     size_t pairCount = 0;
     size_t wordCount = 0;
@@ -837,6 +890,37 @@ class ActorCache final: public ActorCacheInterface {
     kj::Vector<FlushBatch> batches;
   };
   using CountedDeleteFlushes = kj::Array<CountedDeleteFlush>;
+
+  // Accounts for an RPC element of the given size, starting a new batch if the last is full.
+  void addToFlushBatch(kj::Vector<FlushBatch>& batches, size_t words);
+
+  // Marks the entry as flushing and adds it to the put or muted delete flush.
+  void addToFlush(Entry& entry, PutFlush& putFlush, MutedDeleteFlush& mutedDeleteFlush);
+
+  // Marks a dirty alarm as flushing and returns the change to write, if any.
+  MaybeAlarmChange startAlarmFlush();
+
+  // After a successful flush, updates the alarm state for the change that was written.
+  void finishAlarmFlush();
+
+  // After a successful flush, moves a flushed entry to the clean list (or evicts it).
+  void finishEntryFlush(Lock& lock, Entry& entry);
+
+  // The contents of a pipelined flush. These are kept until the flush completes so that a retry
+  // resends exactly the same transaction.
+  struct PipelinedFlush {
+    uint64_t sequence = 0;
+    PutFlush putFlush;
+    MutedDeleteFlush mutedDeleteFlush;
+    MaybeAlarmChange maybeAlarmChange = CleanAlarm{};
+  };
+
+  // Schedules a flush to start once fewer than `maxFlushesInFlight` flushes are in flight.
+  kj::Promise<void> schedulePipelinedFlush();
+  kj::Promise<void> flushImplPipelined(kj::Promise<void> previous);
+  kj::Promise<void> sendPipelinedFlush(
+      PipelinedFlush& flush, kj::ForkedPromise<void>& previous, uint retryCount = 0);
+
   kj::Promise<void> startFlushTransaction();
   kj::Promise<void> flushImplUsingSinglePut(PutFlush putFlush);
   kj::Promise<void> flushImplUsingSingleMutedDelete(MutedDeleteFlush mutedFlush);
@@ -845,7 +929,8 @@ class ActorCache final: public ActorCacheInterface {
   kj::Promise<void> flushImplUsingTxn(PutFlush putFlush,
       MutedDeleteFlush mutedDeleteFlush,
       CountedDeleteFlushes countedDeleteFlushes,
-      MaybeAlarmChange maybeAlarmChange);
+      MaybeAlarmChange maybeAlarmChange,
+      kj::Maybe<kj::Promise<void>> commitAfter = kj::none);
 
   // Carefully remove a clean entry from `currentValues`, making sure to update gaps.
   void evictEntry(Lock& lock, Entry& entry);
@@ -972,6 +1057,17 @@ struct ActorCacheSharedLruOptions {
   // If true, don't actually flush anything. This is used in preview sessions, since they keep
   // state strictly in memory.
   bool neverFlush = false;
+
+  // Maximum number of flushes that may be in flight at once. With the default of 1, each flush
+  // waits for the previous one to complete. Larger values let a flush open its transaction and
+  // send its writes while earlier ones are still awaiting a response. Commits are still sent one
+  // at a time, in order, so storage sees no difference other than overlapping transactions.
+  uint maxFlushesInFlight = 1;
+
+  // Maximum number of batch RPCs of a single flush transaction that may be awaiting a response at
+  // once. Large transactions are then sent at the rate storage acknowledges them, rather than all
+  // at once. Zero means no limit.
+  uint maxBatchesInFlight = 0;
 };
 
 class ActorCache::SharedLru {
@@ -1287,6 +1287,40 @@ KJ_TEST("rolling back nested transaction leaves deferred alarm deletion in expec
   KJ_ASSERT(expectSync(test.getAlarm()) == kj::none);
 }
 
+KJ_TEST("borrowed reads see the same rows as copying reads") {
+  ActorSqliteTest test;
+
+  test.put("bar", "1");
+  test.put("baz", "22");
+  test.put("foo", "333");
+  test.pollAndExpectCalls({"commit"})[0]->fulfill();
+
+  kj::Vector<kj::String> rows;
+  auto collect = [&](kj::StringPtr key, kj::ArrayPtr<const kj::byte> value) {
+    rows.add(kj::str(key, "=", value.asChars()));
+  };
+
+  auto keys = kj::arr(kj::str("bar"), kj::str("foo"), kj::str("qux"));
+  KJ_ASSERT(test.actor.tryGetBorrowed(keys, {}, collect));
+  KJ_EXPECT(kj::strArray(rows, ",") == "bar=1,foo=333");
+
+  rows.clear();
+  KJ_ASSERT(test.actor.tryListBorrowed("baz", kj::none, kj::none, false, {}, collect));
+  KJ_EXPECT(kj::strArray(rows, ",") == "baz=22,foo=333");
+
+  rows.clear();
+  KJ_ASSERT(test.actor.tryListBorrowed("", "foo"_kj, 1, true, {}, collect));
+  KJ_EXPECT(kj::strArray(rows, ",") == "baz=22");
+
+  // Transactions read through to the same database.
+  auto txn = test.actor.startTransaction();
+  txn->put(kj::str("qux"), kj::heapArray(kj::StringPtr("4444").asBytes()), {});
+  rows.clear();
+  KJ_ASSERT(txn->tryGetBorrowed(keys, {}, collect));
+  KJ_EXPECT(kj::strArray(rows, ",") == "bar=1,foo=333,qux=4444");
+  txn->rollback().wait(test.ws);
+}
+
 KJ_TEST("database write operations check for brokenness") {
   ActorSqliteTest test({.monitorOutputGate = false});
 
@@ -411,12 +411,14 @@ kj::OneOf<ActorCacheOps::GetResultList, kj::Promise<ActorCacheOps::GetResultList
     kj::Array<Key> keys, ReadOptions options) {
   requireNotBroken();
 
-  kj::Vector<KeyValuePair> results;
-  for (auto& key: keys) {
-    kv.get(
-        key, [&](ValuePtr value) { results.add(KeyValuePair{kj::mv(key), kj::heapArray(value)}); });
-  }
-  std::sort(results.begin(), results.end(), [](auto& a, auto& b) { return a.key < b.key; });
+  // Sorting the keys makes SqliteKv report results in key order.
+  auto keyPtrs = KJ_MAP(key, keys) -> KeyPtr { return key; };
+  std::sort(keyPtrs.begin(), keyPtrs.end());
+
+  kj::Vector<KeyValuePair> results(keys.size());
+  kv.get(keyPtrs, [&](KeyPtr key, ValuePtr value) {
+    results.add(KeyValuePair{kj::str(key), kj::heapArray(value)});
+  });
   return GetResultList(kj::mv(results));
 }
 
@@ -465,6 +467,33 @@ kj::OneOf<ActorCacheOps::GetResultList, kj::Promise<ActorCacheOps::GetResultList
   return GetResultList(kj::mv(results));
 }
 
+bool ActorSqlite::tryGetBorrowed(
+    kj::ArrayPtr<const Key> keys, ReadOptions options, BorrowedRowCallback callback) {
+  requireNotBroken();
+
+  auto keyPtrs = KJ_MAP(key, keys) -> KeyPtr { return key; };
+  std::sort(keyPtrs.begin(), keyPtrs.end());
+  kv.get(keyPtrs, [&](KeyPtr key, ValuePtr value) { callback(key, value); });
+  return true;
+}
+
+bool ActorSqlite::tryListBorrowed(KeyPtr begin,
+    kj::Maybe<KeyPtr> end,
+    kj::Maybe<uint> limit,
+    bool reverse,
+    ReadOptions options,
+    BorrowedRowCallback callback) {
+  requireNotBroken();
+
+  auto forward = [&](KeyPtr key, ValuePtr value) { callback(key, value); };
+  if (reverse) {
+    kv.list(begin, end, limit, SqliteKv::REVERSE, forward);
+  } else {
+    kv.list(begin, end, limit, SqliteKv::FORWARD, forward);
+  }
+  return true;
+}
+
 kj::Maybe<kj::Promise<void>> ActorSqlite::put(Key key, Value value, WriteOptions options) {
   requireNotBroken();
   kv.put(key, value);
@@ -474,9 +503,10 @@ kj::Maybe<kj::Promise<void>> ActorSqlite::put(Key key, Value value, WriteOptions
 kj::Maybe<kj::Promise<void>> ActorSqlite::put(kj::Array<KeyValuePair> pairs, WriteOptions options) {
   requireNotBroken();
 
-  for (auto& pair: pairs) {
-    kv.put(pair.key, pair.value);
-  }
+  auto pairPtrs = KJ_MAP(pair, pairs) -> SqliteKv::KeyValuePtrPair {
+    return {pair.key, pair.value};
+  };
+  kv.put(pairPtrs);
   return kj::none;
 }
 
@@ -489,11 +519,8 @@ kj::OneOf<bool, kj::Promise<bool>> ActorSqlite::delete_(Key key, WriteOptions op
 kj::OneOf<uint, kj::Promise<uint>> ActorSqlite::delete_(kj::Array<Key> keys, WriteOptions options) {
   requireNotBroken();
 
-  uint count = 0;
-  for (auto& key: keys) {
-    count += kv.delete_(key);
-  }
-  return count;
+  auto keyPtrs = KJ_MAP(key, keys) -> KeyPtr { return key; };
+  return kv.delete_(keyPtrs);
 }
 
 kj::Maybe<kj::Promise<void>> ActorSqlite::setAlarm(
@@ -792,6 +819,18 @@ kj::OneOf<ActorCacheOps::GetResultList, kj::Promise<ActorCacheOps::GetResultList
         Key begin, kj::Maybe<Key> end, kj::Maybe<uint> limit, ReadOptions options) {
   return actorSqlite.listReverse(kj::mv(begin), kj::mv(end), limit, options);
 }
+bool ActorSqlite::ExplicitTxn::tryGetBorrowed(
+    kj::ArrayPtr<const Key> keys, ReadOptions options, BorrowedRowCallback callback) {
+  return actorSqlite.tryGetBorrowed(keys, options, callback);
+}
+bool ActorSqlite::ExplicitTxn::tryListBorrowed(KeyPtr begin,
+    kj::Maybe<KeyPtr> end,
+    kj::Maybe<uint> limit,
+    bool reverse,
+    ReadOptions options,
+    BorrowedRowCallback callback) {
+  return actorSqlite.tryListBorrowed(begin, end, limit, reverse, options, callback);
+}
 kj::Maybe<kj::Promise<void>> ActorSqlite::ExplicitTxn::put(
     Key key, Value value, WriteOptions options) {
   return actorSqlite.put(kj::mv(key), kj::mv(value), options);
@@ -12,13 +12,12 @@
 namespace workerd {
 
 // An implementation of ActorCacheOps that is backed by SqliteKv.
+//
+// Reads are always answered synchronously, so besides the copying get() and list() this implements
+// tryGetBorrowed() and tryListBorrowed(), which hand out pointers straight into the blobs of the
+// SQLite statement being stepped. `DurableObjectStorageOperations` uses these to parse
+// V8-serialized values without copying them first.
 class ActorSqlite final: public ActorCacheInterface, private kj::TaskSet::ErrorHandler {
-  // TODO(perf): This interface is not designed ideally for wrapping SqliteKv. In particular, we
-  //   end up allocating extra copies of all the results. It would be nicer if we could actually
-  //   parse the V8-serialized values directly from the blob pointers that SQLite spits out.
-  //   However, that probably requires rewriting `DurableObjectStorageOperations`. For now, hooking
-  //   here is easier and not too costly.
-
  public:
   // Hooks to configure ActorSqlite behavior, right now only used to allow plugging in a backend
   // for alarm operations.
@@ -68,6 +67,14 @@ class ActorSqlite final: public ActorCacheInterface, private kj::TaskSet::ErrorH
       Key begin, kj::Maybe<Key> end, kj::Maybe<uint> limit, ReadOptions options) override;
   kj::OneOf<GetResultList, kj::Promise<GetResultList>> listReverse(
       Key begin, kj::Maybe<Key> end, kj::Maybe<uint> limit, ReadOptions options) override;
+  bool tryGetBorrowed(
+      kj::ArrayPtr<const Key> keys, ReadOptions options, BorrowedRowCallback callback) override;
+  bool tryListBorrowed(KeyPtr begin,
+      kj::Maybe<KeyPtr> end,
+      kj::Maybe<uint> limit,
+      bool reverse,
+      ReadOptions options,
+      BorrowedRowCallback callback) override;
   kj::Maybe<kj::Promise<void>> put(Key key, Value value, WriteOptions options) override;
   kj::Maybe<kj::Promise<void>> put(kj::Array<KeyValuePair> pairs, WriteOptions options) override;
   kj::OneOf<bool, kj::Promise<bool>> delete_(Key key, WriteOptions options) override;
@@ -149,6 +156,14 @@ class ActorSqlite final: public ActorCacheInterface, private kj::TaskSet::ErrorH
         Key begin, kj::Maybe<Key> end, kj::Maybe<uint> limit, ReadOptions options) override;
     kj::OneOf<GetResultList, kj::Promise<GetResultList>> listReverse(
         Key begin, kj::Maybe<Key> end, kj::Maybe<uint> limit, ReadOptions options) override;
+    bool tryGetBorrowed(
+        kj::ArrayPtr<const Key> keys, ReadOptions options, BorrowedRowCallback callback) override;
+    bool tryListBorrowed(KeyPtr begin,
+        kj::Maybe<KeyPtr> end,
+        kj::Maybe<uint> limit,
+        bool reverse,
+        ReadOptions options,
+        BorrowedRowCallback callback) override;
     kj::Maybe<kj::Promise<void>> put(Key key, Value value, WriteOptions options) override;
     kj::Maybe<kj::Promise<void>> put(kj::Array<KeyValuePair> pairs, WriteOptions options) override;
     kj::OneOf<bool, kj::Promise<bool>> delete_(Key key, WriteOptions options) override;
@@ -15,7 +15,6 @@
 #include <kj/debug.h>
 
 #include <cmath>
-#include <map>
 
 namespace workerd {
 
@@ -38,16 +37,15 @@ static void* getThreadId() {
 class IoContext::TimeoutManagerImpl final: public TimeoutManager {
  public:
   class TimeoutState;
-  using Map = std::map<TimeoutId, TimeoutState>;
-  using Iterator = Map::iterator;
 
   TimeoutManagerImpl() = default;
   KJ_DISALLOW_COPY_AND_MOVE(TimeoutManagerImpl);
 
   TimeoutId setTimeout(
       IoContext& context, TimeoutId::Generator& generator, TimeoutParameters params) override {
-    auto [id, it] = addState(generator, kj::mv(params));
-    setTimeoutImpl(context, it);
+    auto [id, state] = addState(context, generator, kj::mv(params));
+    KJ_ON_SCOPE_FAILURE(removeTimeout(context, id));
+    setTimeoutImpl(context, id, state);
     return id;
   }
 
@@ -69,21 +67,27 @@ class IoContext::TimeoutManagerImpl final: public TimeoutManager {
     timerTask = nullptr;
     timeouts.clear();
     timeoutTimes.clear();
+    keepAlive = kj::none;
   }
 
  private:
-  struct IdAndIterator {
+  struct IdAndState {
     TimeoutId id;
-    Iterator it;
+    TimeoutState& state;
   };
-  IdAndIterator addState(TimeoutId::Generator& generator, TimeoutParameters params);
+  IdAndState addState(
+      IoContext& context, TimeoutId::Generator& generator, TimeoutParameters params);
 
-  void setTimeoutImpl(IoContext& context, Iterator it);
+  void setTimeoutImpl(IoContext& context, TimeoutId id, TimeoutState& state);
+
+  // Forgets a timeout that won't run again. Its entry in `timeoutTimes`, if any, is left behind to
+  // be skipped over, so this doesn't have to search for it.
+  void removeTimeout(IoContext& context, TimeoutId id);
 
   // A pair of a Date and a numeric ID, used as entry in timeoutTimes set, below.
   struct TimeoutTime {
     kj::Date when;
-    uint tiebreaker;  // Unique number, in case two timeouts target same time.
+    uint64_t tiebreaker;  // Unique number, in case two timeouts target same time.
 
     inline bool operator<(const TimeoutTime& other) const {
       if (when < other.when) return true;
@@ -97,27 +101,46 @@ class IoContext::TimeoutManagerImpl final: public TimeoutManager {
 
   // Tracks registered timeouts sorted by the next time the timeout is expected to fire.
   //
-  // The associated fulfiller should be fulfilled when the time has been reached AND all previous
-  // timeouts have completed.
-  kj::TreeMap<TimeoutTime, kj::Own<kj::PromiseFulfiller<void>>> timeoutTimes;
-  uint timeoutTimesTiebreakerCounter = 0;
+  // An entry is stale if its timeout was cleared or has since been rescheduled, i.e. if the
+  // timeout's `scheduledAt` no longer names it. Stale entries are dropped as soon as they reach
+  // the front, so the front is always the next timeout to run, and the rest are swept out in bulk
+  // once they outnumber the live ones.
+  kj::TreeMap<TimeoutTime, TimeoutId> timeoutTimes;
+  uint64_t timeoutTimesTiebreakerCounter = 0;
+
+  bool isLive(const TimeoutTime& key, TimeoutId id) const;
+
+  // Drops stale entries from the front of `timeoutTimes`. Returns true if any were dropped.
+  bool dropStaleFront();
 
   uint timeoutsStarted = 0;
   uint timeoutsFinished = 0;
-  Map timeouts;
+  kj::HashMap<TimeoutId, kj::Own<TimeoutState>> timeouts;
 
-  // Promise that is waiting for the closest timeout, and will fulfill its fulfiller. We only ever
-  // actually wait on the next timeout in `timeoutTasks`, so that we can't fulfill timer callbacks
-  // out-of-order. This task gets replaced each time the lead timeout changes.
+  // Held while any timeouts are set, to keep the IoContext around until they've run.
+  kj::Maybe<kj::Own<void>> keepAlive;
+  kj::Own<void> makeKeepAlive(IoContext& context);
+
+  // Loop that waits for the next timeout to come due, then runs it along with everything else due
+  // by then. This task is replaced each time the lead timeout changes, except while callbacks are
+  // running, as the loop checks the front again once they return anyway.
   kj::Promise<void> timerTask = nullptr;
+  bool isRunningCallbacks = false;
+
+  kj::Promise<void> runTimerLoop(IoContext& context);
+  void runDueTimeouts(
+      IoContext& context, Worker::Lock& lock, kj::Date dueBy, uint64_t tiebreakerLimit);
+  void runTimeout(IoContext& context, Worker::Lock& lock, TimeoutId id, TimeoutState& state);
 
   // Must be called any time timeoutTimes.begin() changes.
-  void resetTimerTask(TimerChannel& timerChannel);
+  void resetTimerTask(IoContext& context);
 };
 
 class IoContext::TimeoutManagerImpl::TimeoutState {
  public:
-  TimeoutState(TimeoutManagerImpl& manager, TimeoutParameters params);
+  TimeoutState(TimeoutManagerImpl& manager,
+      TimeoutParameters params,
+      kj::Maybe<kj::Own<InputGate::CriticalSection>> criticalSection);
   ~TimeoutState();
 
   void trigger(Worker::Lock& lock);
@@ -126,10 +149,14 @@ class IoContext::TimeoutManagerImpl::TimeoutState {
   TimeoutManagerImpl& manager;
   TimeoutParameters params;
 
+  // The critical section the timeout was set in, if any. Its callback runs in it too.
+  kj::Maybe<kj::Own<InputGate::CriticalSection>> criticalSection;
+
   bool isCanceled = false;
   bool isRunning = false;
 
-  kj::Maybe<kj::Promise<void>> maybePromise;
+  // The timeout's current entry in `timeoutTimes`, if it's waiting to run.
+  kj::Maybe<TimeoutTime> scheduledAt;
 };
 
 IoContext::IoContext(ThreadContext& thread,
@@ -594,10 +621,12 @@ kj::Own<void> IoContext::registerPendingEvent() {
   }
 }
 
-IoContext::TimeoutManagerImpl::TimeoutState::TimeoutState(
-    TimeoutManagerImpl& manager, TimeoutParameters params)
+IoContext::TimeoutManagerImpl::TimeoutState::TimeoutState(TimeoutManagerImpl& manager,
+    TimeoutParameters params,
+    kj::Maybe<kj::Own<InputGate::CriticalSection>> criticalSection)
     : manager(manager),
-      params(kj::mv(params)) {
+      params(kj::mv(params)),
+      criticalSection(kj::mv(criticalSection)) {
   ++manager.timeoutsStarted;
 }
 
@@ -623,182 +652,248 @@ void IoContext::TimeoutManagerImpl::TimeoutState::cancel() {
     return;
   }
 
-  auto wasCanceled = isCanceled;
   isCanceled = true;
-
-  if (!isRunning && !wasCanceled) {
-    params.function = kj::none;
-    maybePromise = kj::none;
-  }
-
   ++manager.timeoutsFinished;
 }
 
-auto IoContext::TimeoutManagerImpl::addState(
-    TimeoutId::Generator& generator, TimeoutParameters params) -> IdAndIterator {
+auto IoContext::TimeoutManagerImpl::addState(IoContext& context,
+    TimeoutId::Generator& generator,
+    TimeoutParameters params) -> IdAndState {
   JSG_REQUIRE(getTimeoutCount() < MAX_TIMEOUTS, DOMQuotaExceededError,
       "You have exceeded the number of active timeouts you may set.",
       " max active timeouts: ", MAX_TIMEOUTS, ", current active timeouts: ", getTimeoutCount(),
       ", finished timeouts: ", timeoutsFinished);
 
   auto id = generator.getNext();
-  auto [it, wasEmplaced] = timeouts.try_emplace(id, *this, kj::mv(params));
-  if (!wasEmplaced) {
+  KJ_IF_SOME(existing, timeouts.find(id)) {
     // We shouldn't have reached here because the `TimeoutId::Generator` throws if it reaches
     // Number.MAX_SAFE_INTEGER, much less wraps around the uint64_t number space. Let's throw with
     // as many details as possible.
-    auto& state = it->second;
-    auto delay = state.params.msDelay;
-    auto repeat = state.params.repeat;
+    auto delay = existing->params.msDelay;
+    auto repeat = existing->params.repeat;
     KJ_FAIL_ASSERT("Saw a timeout id collision", getTimeoutCount(), timeoutsStarted, id.toNumber(),
         delay, repeat);
   }
 
-  return {id, it};
+  auto& state = timeouts.insert(id,
+      kj::heap<TimeoutState>(*this, kj::mv(params), context.getCriticalSection()));
+  return {id, *state.value};
 }
 
-void IoContext::TimeoutManagerImpl::setTimeoutImpl(IoContext& context, Iterator it) {
-  auto& state = it->second;
-
-  auto stateGuard = kj::defer([&]() {
-    if (state.maybePromise == kj::none) {
-      // Something threw, erase the state.
-      timeouts.erase(it);
-    }
-  });
-
-  auto paf = kj::newPromiseAndFulfiller<void>();
+void IoContext::TimeoutManagerImpl::setTimeoutImpl(
+    IoContext& context, TimeoutId id, TimeoutState& state) {
+  if (keepAlive == kj::none) {
+    keepAlive = makeKeepAlive(context);
+  }
 
   // Always schedule the timeout relative to what Date.now() currently returns, so that the delay
   // appear exact. Otherwise, the delay could reveal non-determinism containing side channels.
   auto when = context.now() + state.params.msDelay * kj::MILLISECONDS;
-  // TODO(cleanup): The manual use of run() here (including carrying over the critical section) is
-  //   kind of ugly, but using awaitIo() doesn't work here because we need the ability to cancel
-  //   the timer, so we don't want to addTask() it, which awaitIo() does implicitly.
-  auto promise =
-      paf.promise.then([this, &context, it, cs = context.getCriticalSection()]() mutable {
-    return context.run([this, &context, it](Worker::Lock& lock) mutable {
-      auto& state = it->second;
-
-      auto stateGuard = kj::defer([&] {
-        if (state.maybePromise == kj::none) {
-          // At the end of this block, there was no new timeout, so we should remove the state.
-          // Note that this can happen from cancelTimeout or a non-repeating timeout.
-          timeouts.erase(it);
-        }
-      });
+  TimeoutTime key{when, timeoutTimesTiebreakerCounter++};
+  timeoutTimes.insert(key, id);
+  state.scheduledAt = key;
 
-      if (state.isCanceled) {
-        // We've been canceled before running. Nothing more to do.
-        KJ_ASSERT(state.maybePromise == kj::none);
-        return;
-      }
+  if (timeoutTimes.begin()->key == key) {
+    resetTimerTask(context);
+  }
+}
 
-      KJ_IF_SOME(promise, state.maybePromise) {
-        // We could KJ_ASSERT_NONNULL(iter->second) instead if we are sure clearTimeout() couldn't
-        // race us. However, I'm not sure about that.
-
-        // First, move our timeout promise to the task set so it's safe to call clearInterval()
-        // inside the user's callback. We don't yet null out the Maybe<Promise>, because we need to
-        // be able to detect whether the user does call clearInterval(). We leave the actual map
-        // entry in place because this aids in reporting cross-request-context timeout cancellation
-        // errors to the user.
-        context.addTask(kj::mv(promise));
-
-        // Because Promise has an underspecified move ctor, we need to explicitly nullify the Maybe
-        // to indicate that we've consumed the promise.
-        state.maybePromise = kj::none;
-
-        // The user's callback might throw, but we need to at least attempt to reschedule interval
-        // callbacks even if they throw. This deferred action takes care of that. Note that we don't
-        // run the user's callback directly in this->run(), because that function throws a fatal
-        // exception if a JS exception is thrown, which complicates our logic here.
-        //
-        // TODO(perf): If we can guarantee that `timeout->second = nullptr` will never throw, it
-        //   might be worthwhile having an early-out path for non-interval timeouts.
-        kj::UnwindDetector unwindDetector;
-        KJ_DEFER(unwindDetector.catchExceptionsIfUnwinding([&] {
-          if (state.isCanceled) {
-            // The user's callback has called clearInterval(), nothing more to do.
-            KJ_ASSERT(state.maybePromise == kj::none);
-            return;
-          }
+kj::Own<void> IoContext::TimeoutManagerImpl::makeKeepAlive(IoContext& context) {
+  auto pendingEvent = context.registerPendingEvent();
+  if (context.actor == kj::none) {
+    return pendingEvent;
+  }
 
-          // If this is an interval task and the script has CPU time left, reschedule the task;
-          // otherwise leave the dead map entry in place.
-          if (state.params.repeat && context.limitEnforcer->getLimitsExceeded() == kj::none) {
-            setTimeoutImpl(context, it);
-          }
-        }););
+  // Add a wait-until task which resolves once no timeouts are left. This ensures that
+  // `IncomingRequest::drain()` waits until all timers finish.
+  auto paf = kj::newPromiseAndFulfiller<void>();
+  context.addWaitUntil(kj::mv(paf.promise));
+  return kj::heap(kj::defer([fulfiller = kj::mv(paf.fulfiller)]() mutable {
+    fulfiller->fulfill();
+  })).attach(kj::mv(pendingEvent));
+}
 
-        state.trigger(lock);
-      }
-    }, kj::mv(cs));
-  }, [](kj::Exception&&) {});
-
-  promise = promise.attach(context.registerPendingEvent());
-
-  // Add an entry to the timeoutTimes map, to track when the nearest timeout is. Arrange for it
-  // to be removed when the promise completes.
-  TimeoutTime timeoutTimesKey{when, timeoutTimesTiebreakerCounter++};
-  timeoutTimes.insert(timeoutTimesKey, kj::mv(paf.fulfiller));
-  auto deferredTimeoutTimeRemoval = kj::defer([this, &context, timeoutTimesKey]() {
-    // If the promise is being destroyed due to IoContext teardown then IoChannelFactory may
-    // no longer be available, but we can just skip starting a new timer in that case as it'd be
-    // canceled anyway. Similarly we should skip rescheduling if the context has been aborted since
-    // there's no way the events can run anyway (and we'll cause trouble if `cancelAll()` is being
-    // called in ~IoContext_IncomingRequest).
-    if (context.selfRef->isValid() && context.abortException == kj::none) {
-      bool isNext = timeoutTimes.begin()->key == timeoutTimesKey;
-      timeoutTimes.erase(timeoutTimesKey);
-      if (isNext) resetTimerTask(context.getIoChannelFactory().getTimer());
-    }
-  });
+void IoContext::TimeoutManagerImpl::removeTimeout(IoContext& context, TimeoutId id) {
+  timeouts.erase(id);
 
-  if (timeoutTimes.begin()->key == timeoutTimesKey) {
-    resetTimerTask(context.getIoChannelFactory().getTimer());
+  if (timeouts.size() == 0) {
+    // Nothing left to wait for.
+    timeoutTimes.clear();
+    keepAlive = kj::none;
+    resetTimerTask(context);
+  } else if (dropStaleFront()) {
+    resetTimerTask(context);
+  } else if (timeoutTimes.size() > 2 * timeouts.size()) {
+    timeoutTimes.eraseAll(
+        [this](const TimeoutTime& key, TimeoutId id) { return !isLive(key, id); });
   }
-  promise = promise.attach(kj::mv(deferredTimeoutTimeRemoval));
+}
 
-  if (context.actor != kj::none) {
-    // Add a wait-until task which resolves when this timer completes. This ensures that
-    // `IncomingRequest::drain()` waits until all timers finish.
-    auto paf = kj::newPromiseAndFulfiller<void>();
-    promise = promise.attach(
-        kj::defer([fulfiller = kj::mv(paf.fulfiller)]() mutable { fulfiller->fulfill(); }));
-    context.addWaitUntil(kj::mv(paf.promise));
+bool IoContext::TimeoutManagerImpl::isLive(const TimeoutTime& key, TimeoutId id) const {
+  KJ_IF_SOME(state, timeouts.find(id)) {
+    KJ_IF_SOME(scheduledAt, state->scheduledAt) {
+      return scheduledAt == key;
+    }
   }
+  return false;
+}
 
-  state.maybePromise = promise.eagerlyEvaluate(nullptr);
+bool IoContext::TimeoutManagerImpl::dropStaleFront() {
+  bool dropped = false;
+  while (timeoutTimes.size() > 0) {
+    auto key = timeoutTimes.begin()->key;
+    if (isLive(key, timeoutTimes.begin()->value)) break;
+    timeoutTimes.erase(key);
+    dropped = true;
+  }
+  return dropped;
 }
 
-void IoContext::TimeoutManagerImpl::resetTimerTask(TimerChannel& timerChannel) {
+void IoContext::TimeoutManagerImpl::resetTimerTask(IoContext& context) {
+  if (isRunningCallbacks) {
+    // runTimerLoop() picks up the new front once the callbacks return.
+    return;
+  }
+
   if (timeoutTimes.size() == 0) {
     // Not waiting for any timer, clear the existing timer task.
     timerTask = nullptr;
   } else {
-    // Wait for the first timer.
-    auto& entry = *timeoutTimes.begin();
-    timerTask = timerChannel.atTime(entry.key.when)
-                    .then([this, key = entry.key]() {
-      auto& newEntry = *timeoutTimes.begin();
-      KJ_ASSERT(newEntry.key == key,
-          "front of timeoutTimes changed without calling resetTimerTask(), we probably missed "
-          "a timeout!");
-      newEntry.value->fulfill();
-    }).eagerlyEvaluate([](kj::Exception&& e) { KJ_LOG(ERROR, e); });
+    timerTask =
+        runTimerLoop(context).eagerlyEvaluate([](kj::Exception&& e) { KJ_LOG(ERROR, e); });
   }
 }
 
+kj::Promise<void> IoContext::TimeoutManagerImpl::runTimerLoop(IoContext& context) {
+  while (timeoutTimes.size() > 0) {
+    auto when = timeoutTimes.begin()->key.when;
+    co_await context.getIoChannelFactory().getTimer().atTime(when);
+
+    // Run everything that has come due by now in one go, rather than taking the lock and running
+    // the microtask queue once per timeout. Timeouts set by the callbacks themselves wait for the
+    // next round even if they're already due, so that a callback which keeps setting zero-delay
+    // timeouts can't hold the lock forever.
+    auto dueBy = kj::max(when, context.getIoChannelFactory().getTimer().now());
+    auto tiebreakerLimit = timeoutTimesTiebreakerCounter;
+
+    auto& next = *KJ_ASSERT_NONNULL(timeouts.find(timeoutTimes.begin()->value));
+    auto cs = next.criticalSection.map(
+        [](kj::Own<InputGate::CriticalSection>& cs) { return kj::addRef(*cs); });
+
+    try {
+      co_await context.run([this, &context, dueBy, tiebreakerLimit](Worker::Lock& lock) {
+        runDueTimeouts(context, lock, dueBy, tiebreakerLimit);
+      }, kj::mv(cs));
+    } catch (...) {
+      // The script can't run anymore, e.g. because it exceeded its limits, so none of the other
+      // callbacks will get to run either.
+      timeouts.clear();
+      timeoutTimes.clear();
+      keepAlive = kj::none;
+      co_return;
+    }
+  }
+}
+
+void IoContext::TimeoutManagerImpl::runDueTimeouts(
+    IoContext& context, Worker::Lock& lock, kj::Date dueBy, uint64_t tiebreakerLimit) {
+  jsg::Lock& js = lock;
+  isRunningCallbacks = true;
+  KJ_DEFER(isRunningCallbacks = false);
+
+  bool isFirst = true;
+  InputGate::CriticalSection* criticalSection = nullptr;
+
+  while (timeoutTimes.size() > 0) {
+    auto key = timeoutTimes.begin()->key;
+    auto id = timeoutTimes.begin()->value;
+    if (key.when > dueBy || key.tiebreaker >= tiebreakerLimit) break;
+
+    auto& state = *KJ_ASSERT_NONNULL(timeouts.find(id));
+    InputGate::CriticalSection* stateCs = nullptr;
+    KJ_IF_SOME(cs, state.criticalSection) {
+      stateCs = cs.get();
+    }
+
+    if (isFirst) {
+      criticalSection = stateCs;
+      isFirst = false;
+    } else {
+      // A timeout set in some other critical section has to run in that one, so it gets a run()
+      // of its own.
+      if (stateCs != criticalSection) break;
+
+      // Let the previous callback's promise reactions run before the next callback, as they
+      // would have if each callback had a run() of its own.
+      {
+        v8::TryCatch tryCatch(lock.getIsolate());
+        js.runMicrotasks();
+        if (tryCatch.HasCaught()) {
+          // Only termination can get here. Leave it to run() to deal with.
+          tryCatch.ReThrow();
+          throw jsg::JsExceptionThrown();
+        }
+      }
+
+      if (context.limitEnforcer->getLimitsExceeded() != kj::none) break;
+    }
+
+    v8::TryCatch tryCatch(lock.getIsolate());
+    try {
+      runTimeout(context, lock, id, state);
+    } catch (const jsg::JsExceptionThrown&) {
+      if (!tryCatch.CanContinue() || !tryCatch.HasCaught() || tryCatch.Message().IsEmpty()) {
+        // The script was terminated. Leave it to run() to deal with.
+        tryCatch.ReThrow();
+        throw;
+      }
+
+      // Report the exception as run() would have, then carry on with the other callbacks.
+      lock.logUncaughtException(UncaughtExceptionSource::INTERNAL,
+          jsg::JsValue(tryCatch.Exception()), jsg::JsMessage(tryCatch.Message()));
+    }
+  }
+}
+
+void IoContext::TimeoutManagerImpl::runTimeout(
+    IoContext& context, Worker::Lock& lock, TimeoutId id, TimeoutState& state) {
+  auto key = KJ_ASSERT_NONNULL(state.scheduledAt);
+
+  // The user's callback might throw, but we need to at least attempt to reschedule interval
+  // callbacks even if they throw. This deferred action takes care of that. The timeout's entry
+  // stays at the front of `timeoutTimes` until then, so that Date.now() returns the time it was
+  // scheduled for, both in the callback and when the next interval is scheduled.
+  kj::UnwindDetector unwindDetector;
+  KJ_DEFER(unwindDetector.catchExceptionsIfUnwinding([&] {
+    if (!state.isCanceled && state.params.repeat &&
+        context.limitEnforcer->getLimitsExceeded() == kj::none) {
+      // This is an interval task and the script has CPU time left, so reschedule the task.
+      setTimeoutImpl(context, id, state);
+      timeoutTimes.erase(key);
+      dropStaleFront();
+    } else {
+      // The timeout is done, either because it ran once or because the user's callback has called
+      // clearInterval().
+      state.scheduledAt = kj::none;
+      timeoutTimes.erase(key);
+      removeTimeout(context, id);
+    }
+  }););
+
+  state.trigger(lock);
+}
+
 void IoContext::TimeoutManagerImpl::clearTimeout(IoContext& context, TimeoutId timeoutId) {
-  auto timeout = timeouts.find(timeoutId);
-  if (timeout == timeouts.end()) {
-    // We can't find this timeout, thus we act as if it was already canceled.
-    return;
+  KJ_IF_SOME(state, timeouts.find(timeoutId)) {
+    state->cancel();
+
+    // If the timeout is clearing itself from its own callback, it's removed once that returns.
+    if (!state->isRunning) {
+      removeTimeout(context, timeoutId);
+    }
   }
 
-  // Cancel the timeout.
-  timeout->second.cancel();
+  // If we can't find this timeout, we act as if it was already canceled.
 }
 
 TimeoutId IoContext::setTimeoutImpl(
@@ -2,6 +2,8 @@
 
 #include <workerd/jsg/jsg.h>
 
+#include <kj/hash.h>
+
 namespace workerd {
 
 class IoContext;
@@ -42,6 +44,12 @@ class TimeoutId {
   inline bool operator<(TimeoutId id) const {
     return value < id.value;
   }
+  inline bool operator==(TimeoutId id) const {
+    return value == id.value;
+  }
+  inline uint hashCode() const {
+    return kj::hashCode(value);
+  }
 
  private:
   constexpr explicit TimeoutId(ValueType value): value(value) {}
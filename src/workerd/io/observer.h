@@ -194,6 +194,11 @@ class IsolateObserver: public kj::AtomicRefcounted {
     // TODO(cleanup): Should be able to get this data at `tryCreateLockTiming()` time. It'd be
     //   easier if IsolateObserver were an AOP class, and thus had access to the real isolate.
 
+    // Called when an async lock attempt acquires the lock, with the total time it spent queued
+    // (including any time spent blocked behind a different isolate lock on the same thread).
+    // Useful for building histograms of async lock wait times.
+    virtual void asyncLockAcquired(kj::Duration waitTime) {}
+
     virtual void start() {}
     virtual void stop() {}
 
@@ -29,6 +29,10 @@ struct WorkerSource {
   // module types.
   struct EsModule {
     kj::StringPtr body;
+
+    // Optional V8 code cache for `body`, generated ahead of time. V8 ignores it if it doesn't
+    // match the running V8 version and flags.
+    kj::ArrayPtr<const byte> compileCache = nullptr;
   };
   struct CommonJsModule {
     kj::StringPtr body;
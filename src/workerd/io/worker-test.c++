@@ -0,0 +1,166 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "worker.h"
+
+#include <workerd/tests/test-fixture.h>
+
+#include <kj/test.h>
+
+namespace workerd {
+namespace {
+
+// Records what each async lock attempt reports about the locks it waited behind.
+class LockRecorder final: public IsolateObserver {
+ public:
+  kj::Maybe<kj::Own<LockTiming>> tryCreateLockTiming(
+      kj::OneOf<SpanParent, kj::Maybe<RequestObserver&>> parentOrRequest) const override {
+    return kj::Own<LockTiming>(kj::heap<Timing>(differentLockCounts));
+  }
+
+  mutable kj::Vector<uint> differentLockCounts;
+
+ private:
+  class Timing final: public LockTiming {
+   public:
+    Timing(kj::Vector<uint>& differentLockCounts): differentLockCounts(differentLockCounts) {}
+
+    void reportAsyncInfo(uint currentLoad,
+        bool threadWaitingSameLock,
+        uint threadWaitingDifferentLockCount) override {
+      differentLockCounts.add(threadWaitingDifferentLockCount);
+    }
+
+   private:
+    kj::Vector<uint>& differentLockCounts;
+  };
+};
+
+// Several workers, each with its own isolate, all driven from this thread's event loop.
+struct AsyncLockTest {
+  kj::AsyncIoContext io = kj::setupAsyncIo();
+  kj::Own<LockRecorder> recorder = kj::atomicRefcounted<LockRecorder>();
+  TestFixture a{{.waitScope = io.waitScope, .isolateObserver = observer()}};
+  TestFixture b{{.waitScope = io.waitScope, .isolateObserver = observer()}};
+  TestFixture c{{.waitScope = io.waitScope, .isolateObserver = observer()}};
+
+  kj::Own<IsolateObserver> observer() {
+    return kj::atomicAddRef(*recorder);
+  }
+
+  kj::Promise<Worker::AsyncLock> lock(TestFixture& fixture) {
+    return fixture.getWorker().takeAsyncLockWithoutRequest(nullptr);
+  }
+
+  bool ready(kj::Promise<Worker::AsyncLock>& promise) {
+    return promise.poll(io.waitScope);
+  }
+
+  // Number of lock attempts on the fixture's isolate that have a waiter of their own.
+  uint load(TestFixture& fixture) {
+    return fixture.getWorker().getIsolate().getCurrentLoad();
+  }
+};
+
+KJ_TEST("async lock attempts blocked on another isolate wake when it is released") {
+  AsyncLockTest test;
+
+  kj::Maybe<Worker::AsyncLock> lockA = test.lock(test.a).wait(test.io.waitScope);
+
+  auto promiseB = test.lock(test.b);
+  KJ_EXPECT(!test.ready(promiseB));
+  KJ_EXPECT(test.load(test.b) == 0);
+
+  // Taking A's lock again coalesces with the lock the thread already holds, rather than blocking.
+  auto promiseA = test.lock(test.a);
+  KJ_EXPECT(test.ready(promiseA));
+  KJ_EXPECT(test.load(test.a) == 1);
+  promiseA.wait(test.io.waitScope);
+  KJ_EXPECT(!test.ready(promiseB));
+
+  lockA = kj::none;
+  KJ_EXPECT(test.ready(promiseB));
+  KJ_EXPECT(test.load(test.a) == 0);
+  KJ_EXPECT(test.load(test.b) == 1);
+  promiseB.wait(test.io.waitScope);
+}
+
+KJ_TEST("async lock attempts for the same isolate share the handed-off waiter") {
+  AsyncLockTest test;
+
+  kj::Maybe<Worker::AsyncLock> lockA = test.lock(test.a).wait(test.io.waitScope);
+  auto promiseB1 = test.lock(test.b);
+  auto promiseC = test.lock(test.c);
+  auto promiseB2 = test.lock(test.b);
+
+  // B was asked for first, so both of its attempts are woken together. C has to wait for B.
+  lockA = kj::none;
+  KJ_EXPECT(test.ready(promiseB1));
+  KJ_EXPECT(test.ready(promiseB2));
+  KJ_EXPECT(!test.ready(promiseC));
+  KJ_EXPECT(test.load(test.b) == 1);
+  KJ_EXPECT(test.load(test.c) == 0);
+
+  kj::Maybe<Worker::AsyncLock> lockB1 = promiseB1.wait(test.io.waitScope);
+  kj::Maybe<Worker::AsyncLock> lockB2 = promiseB2.wait(test.io.waitScope);
+  lockB1 = kj::none;
+  KJ_EXPECT(!test.ready(promiseC));
+  lockB2 = kj::none;
+  KJ_EXPECT(test.ready(promiseC));
+  KJ_EXPECT(test.load(test.b) == 0);
+  KJ_EXPECT(test.load(test.c) == 1);
+  promiseC.wait(test.io.waitScope);
+}
+
+KJ_TEST("canceled blocked async lock attempts are skipped") {
+  AsyncLockTest test;
+
+  kj::Maybe<Worker::AsyncLock> lockA = test.lock(test.a).wait(test.io.waitScope);
+  kj::Maybe<kj::Promise<Worker::AsyncLock>> promiseB = test.lock(test.b);
+  auto promiseC = test.lock(test.c);
+
+  promiseB = kj::none;
+  lockA = kj::none;
+  KJ_EXPECT(test.ready(promiseC));
+  KJ_EXPECT(test.load(test.b) == 0);
+  KJ_EXPECT(test.load(test.c) == 1);
+  promiseC.wait(test.io.waitScope);
+}
+
+KJ_TEST("async lock handed off to an attempt that is then canceled passes on") {
+  AsyncLockTest test;
+
+  kj::Maybe<Worker::AsyncLock> lockA = test.lock(test.a).wait(test.io.waitScope);
+  kj::Maybe<kj::Promise<Worker::AsyncLock>> promiseB = test.lock(test.b);
+  auto promiseC = test.lock(test.c);
+
+  // B's attempt is handed a waiter, but is dropped before it gets to run.
+  lockA = kj::none;
+  KJ_EXPECT(test.load(test.b) == 1);
+  promiseB = kj::none;
+
+  KJ_EXPECT(test.load(test.b) == 0);
+  KJ_EXPECT(test.ready(promiseC));
+  KJ_EXPECT(test.load(test.c) == 1);
+  promiseC.wait(test.io.waitScope);
+}
+
+KJ_TEST("async lock attempts report every isolate lock they waited behind") {
+  AsyncLockTest test;
+
+  kj::Maybe<Worker::AsyncLock> lockA = test.lock(test.a).wait(test.io.waitScope);
+  auto promiseB = test.lock(test.b);
+  auto promiseC = test.lock(test.c);
+
+  // C is skipped over when A's lock is handed off to B, so it ends up waiting behind both.
+  lockA = kj::none;
+  kj::Maybe<Worker::AsyncLock> lockB = promiseB.wait(test.io.waitScope);
+  lockB = kj::none;
+  promiseC.wait(test.io.waitScope);
+
+  KJ_EXPECT(test.recorder->differentLockCounts.asPtr() == kj::arr(0u, 1u, 2u).asPtr());
+}
+
+}  // namespace
+}  // namespace workerd
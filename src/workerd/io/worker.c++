@@ -25,6 +25,7 @@
 #include <workerd/util/batch-queue.h>
 #include <workerd/util/color-util.h>
 #include <workerd/util/mimetype.h>
+#include <workerd/util/stdio-log-sink.h>
 #include <workerd/util/stream-utils.h>
 #include <workerd/util/thread-scopes.h>
 #include <workerd/util/uuid.h>
@@ -39,6 +40,7 @@
 #include <kj/compat/gzip.h>
 #include <kj/encoding.h>
 #include <kj/filesystem.h>
+#include <kj/list.h>
 #include <kj/map.h>
 
 #include <cstdint>
@@ -396,6 +398,31 @@ class Worker::AsyncWaiter: public kj::Refcounted {
 
   static const kj::EventLoopLocal<AsyncWaiter*> threadCurrentWaiter;
 
+  // A lock attempt that is blocked because its thread is already waiting for or holding a lock on
+  // a different isolate. Lives in the frame of `takeAsyncLockImpl()`.
+  struct BlockedAttempt {
+    const Isolate& isolate;
+    kj::Own<kj::PromiseFulfiller<kj::Own<AsyncWaiter>>> fulfiller;
+
+    // Set if the waiter handed to this attempt was shared with an earlier attempt.
+    bool sameLock = false;
+
+    // Number of other isolates' locks this attempt has waited behind: the one the thread was on
+    // when the attempt was made, plus one for each hand-off that skipped over it.
+    uint differentLockCount = 1;
+
+    kj::ListLink<BlockedAttempt> link;
+  };
+  using BlockedAttemptList = kj::List<BlockedAttempt, &BlockedAttempt::link>;
+
+  // Blocked attempts on this thread, in the order they were made.
+  static const kj::EventLoopLocal<BlockedAttemptList> threadBlockedAttempts;
+
+  // Called once the thread's current waiter is gone. Creates a waiter for the isolate of the
+  // oldest blocked attempt and hands it directly to every blocked attempt for that isolate. The
+  // rest stay blocked on the new waiter, so only attempts that can make progress are woken.
+  static void handOffToBlockedAttempts();
+
   friend class Worker::Isolate;
   friend class Worker::AsyncLock;
 };
@@ -1970,8 +1997,13 @@ void Worker::handleLog(jsg::Lock& js,
     args[length + 2] = jsg::v8StrIntern(js.v8Isolate, levelStr);
     auto formatted = js.toString(
         jsg::check(formatLog->Call(context, js.v8Undefined(), length + 3, args.data())));
-    fprintf(fd, "%s\n", formatted.cStr());
-    fflush(fd);
+    KJ_IF_SOME(sink, StdioLogSink::current()) {
+      // Don't make the isolate wait on whoever is reading our output.
+      sink.write(fd, kj::str(formatted, '\n'));
+    } else {
+      fprintf(fd, "%s\n", formatted.cStr());
+      fflush(fd);
+    }
   }
 }
 
@@ -2359,6 +2391,8 @@ void Worker::Lock::validateHandlers(ValidationErrorReporter& errorReporter) {
 // AsyncLock implementation
 
 const kj::EventLoopLocal<Worker::AsyncWaiter*> Worker::AsyncWaiter::threadCurrentWaiter;
+const kj::EventLoopLocal<Worker::AsyncWaiter::BlockedAttemptList>
+    Worker::AsyncWaiter::threadBlockedAttempts;
 
 Worker::Isolate::AsyncWaiterList::~AsyncWaiterList() noexcept {
   // It should be impossible for this list to be non-empty since each member of the list holds a
@@ -2382,43 +2416,57 @@ kj::Promise<Worker::AsyncLock> Worker::Isolate::takeAsyncLock(RequestObserver& r
 kj::Promise<Worker::AsyncLock> Worker::Isolate::takeAsyncLockImpl(
     kj::Maybe<kj::Own<IsolateObserver::LockTiming>> lockTiming) const {
   kj::Maybe<uint> currentLoad;
+  kj::TimePoint startTime = kj::origin<kj::TimePoint>();
   if (lockTiming != kj::none) {
     currentLoad = getCurrentLoad();
+    startTime = kj::systemPreciseMonotonicClock().now();
   }
 
-  for (uint threadWaitingDifferentLockCount = 0;; ++threadWaitingDifferentLockCount) {
-    AsyncWaiter* waiter = *AsyncWaiter::threadCurrentWaiter;
-
-    if (waiter == nullptr) {
-      // Thread is not currently waiting on a lock.
-      KJ_IF_SOME(lt, lockTiming) {
-        lt.get()->reportAsyncInfo(KJ_ASSERT_NONNULL(currentLoad), false /* threadWaitingSameLock */,
-            threadWaitingDifferentLockCount);
-      }
-      auto newWaiter = kj::refcounted<AsyncWaiter>(kj::atomicAddRef(*this));
-      co_await newWaiter->readyPromise;
-      co_return AsyncLock(kj::mv(newWaiter), kj::mv(lockTiming));
-    } else if (waiter->isolate == this) {
-      // Thread is waiting on a lock already, and it's for the same isolate. We can coalesce the
-      // locks.
-      KJ_IF_SOME(lt, lockTiming) {
-        lt.get()->reportAsyncInfo(KJ_ASSERT_NONNULL(currentLoad), true /* threadWaitingSameLock */,
-            threadWaitingDifferentLockCount);
-      }
-      auto newWaiterRef = kj::addRef(*waiter);
-      co_await newWaiterRef->readyPromise;
-      co_return AsyncLock(kj::mv(newWaiterRef), kj::mv(lockTiming));
-    } else {
-      // Thread is already waiting for or holding a different isolate lock. Wait for that one to
-      // be released before we try to lock a different isolate.
-      // TODO(perf): Use of ForkedPromise leads to thundering herd here. Should be minor in practice,
-      //   but we could consider creating another linked list instead...
-      KJ_IF_SOME(lt, lockTiming) {
-        lt.get()->waitingForOtherIsolate(waiter->isolate->getId());
-      }
-      co_await waiter->releasePromise;
+  kj::Own<AsyncWaiter> waiter;
+  bool threadWaitingSameLock = false;
+  uint threadWaitingDifferentLockCount = 0;
+
+  AsyncWaiter* currentWaiter = *AsyncWaiter::threadCurrentWaiter;
+  if (currentWaiter == nullptr) {
+    // Thread is not currently waiting on a lock.
+    waiter = kj::refcounted<AsyncWaiter>(kj::atomicAddRef(*this));
+  } else if (currentWaiter->isolate == this) {
+    // Thread is waiting on a lock already, and it's for the same isolate. We can coalesce the
+    // locks.
+    waiter = kj::addRef(*currentWaiter);
+    threadWaitingSameLock = true;
+  } else {
+    // Thread is already waiting for or holding a different isolate lock. Queue up behind it; once
+    // it's released we'll be handed a waiter for this isolate (see handOffToBlockedAttempts()).
+    KJ_IF_SOME(lt, lockTiming) {
+      lt.get()->waitingForOtherIsolate(currentWaiter->isolate->getId());
     }
+    auto paf = kj::newPromiseAndFulfiller<kj::Own<AsyncWaiter>>();
+    AsyncWaiter::BlockedAttempt attempt{.isolate = *this, .fulfiller = kj::mv(paf.fulfiller)};
+    auto& blockedAttempts = *AsyncWaiter::threadBlockedAttempts;
+    blockedAttempts.add(attempt);
+    KJ_DEFER({
+      if (attempt.link.isLinked()) {
+        blockedAttempts.remove(attempt);
+      }
+    });
+
+    waiter = co_await paf.promise;
+    threadWaitingSameLock = attempt.sameLock;
+    threadWaitingDifferentLockCount = attempt.differentLockCount;
+  }
+
+  KJ_IF_SOME(lt, lockTiming) {
+    lt.get()->reportAsyncInfo(
+        KJ_ASSERT_NONNULL(currentLoad), threadWaitingSameLock, threadWaitingDifferentLockCount);
   }
+
+  co_await waiter->readyPromise;
+
+  KJ_IF_SOME(lt, lockTiming) {
+    lt.get()->asyncLockAcquired(kj::systemPreciseMonotonicClock().now() - startTime);
+  }
+  co_return AsyncLock(kj::mv(waiter), kj::mv(lockTiming));
 }
 
 kj::Promise<Worker::AsyncLock> Worker::takeAsyncLockWithoutRequest(SpanParent parentSpan) const {
@@ -2468,29 +2516,58 @@ Worker::AsyncWaiter::~AsyncWaiter() noexcept {
 
   __atomic_sub_fetch(&isolate->impl->lockAttemptGauge, 1, __ATOMIC_RELAXED);
 
-  auto lock = isolate->asyncWaiters.lockExclusive();
-
-  releaseFulfiller->fulfill();
+  {
+    auto lock = isolate->asyncWaiters.lockExclusive();
 
-  // Remove ourselves from the list.
-  *prev = next;
-  KJ_IF_SOME(n, next) {
-    n.prev = prev;
-  } else {
-    lock->tail = prev;
-  }
+    releaseFulfiller->fulfill();
 
-  if (prev == &lock->head) {
-    // We held the lock before now. Alert the next waiter that they are now at the front of the
-    // line.
+    // Remove ourselves from the list.
+    *prev = next;
     KJ_IF_SOME(n, next) {
-      n.readyFulfiller->fulfill();
+      n.prev = prev;
+    } else {
+      lock->tail = prev;
+    }
+
+    if (prev == &lock->head) {
+      // We held the lock before now. Alert the next waiter that they are now at the front of the
+      // line.
+      KJ_IF_SOME(n, next) {
+        n.readyFulfiller->fulfill();
+      }
     }
   }
 
   auto& w = *threadCurrentWaiter;
   KJ_ASSERT(w == this);
   w = nullptr;
+
+  handOffToBlockedAttempts();
+}
+
+void Worker::AsyncWaiter::handOffToBlockedAttempts() {
+  auto& blockedAttempts = *threadBlockedAttempts;
+  if (blockedAttempts.empty()) {
+    return;
+  }
+
+  const Isolate& nextIsolate = blockedAttempts.front().isolate;
+  auto waiter = kj::refcounted<AsyncWaiter>(kj::atomicAddRef(nextIsolate));
+
+  bool first = true;
+  for (auto iter = blockedAttempts.begin(); iter != blockedAttempts.end();) {
+    auto& attempt = *iter;
+    ++iter;
+    if (&attempt.isolate != &nextIsolate) {
+      ++attempt.differentLockCount;
+      continue;
+    }
+
+    blockedAttempts.remove(attempt);
+    attempt.sameLock = !first;
+    attempt.fulfiller->fulfill(kj::addRef(*waiter));
+    first = false;
+  }
 }
 
 kj::Promise<void> Worker::AsyncLock::whenThreadIdle() {
@@ -3219,6 +3296,8 @@ void Worker::Isolate::logWarning(kj::StringPtr description, Lock& lock) {
   if (consoleMode == ConsoleMode::INSPECTOR_ONLY) {
     // Run with --verbose to log JS exceptions to stderr. Useful when running tests.
     KJ_LOG(INFO, "console warning", description);
+  } else KJ_IF_SOME(sink, StdioLogSink::current()) {
+    sink.write(stderr, kj::str(description, '\n'));
   } else {
     fprintf(stderr, "%s\n", description.cStr());
     fflush(stderr);
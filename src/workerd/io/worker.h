@@ -498,8 +498,9 @@ class Worker::Isolate: public kj::AtomicRefcounted {
   // protects the `AsyncWaiterList` as well as the next/prev pointers in each `AsyncWaiter` that
   // is currently in the list.
   kj::MutexGuarded<AsyncWaiterList> asyncWaiters;
-  // TODO(perf): Use a lock-free list? Tricky to get right. `asyncWaiters` should only be locked
-  //   briefly so there's probably not that much to gain.
+  // TODO(perf): Use a lock-free list? Tricky to get right, since a waiter whose lock attempt is
+  //   canceled must be able to unlink itself from the middle of the list. `asyncWaiters` is only
+  //   ever locked for a constant-time splice, so there's probably not that much to gain.
 
   friend class Worker::AsyncLock;
 
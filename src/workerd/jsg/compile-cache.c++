@@ -3,6 +3,13 @@
 //     https://opensource.org/licenses/Apache-2.0
 #include "compile-cache.h"
 
+#include <openssl/sha.h>
+
+#include <kj/debug.h>
+#include <kj/encoding.h>
+
+#include <algorithm>
+
 namespace workerd::jsg {
 
 // CompileCache::Data
@@ -28,4 +35,264 @@ kj::Maybe<CompileCache::Data&> CompileCache::find(kj::StringPtr key) const {
   return kj::none;
 }
 
+// PersistentCompileCache
+
+namespace {
+
+// Prefixed to every file in the cache directory. The version tag and source size are redundant
+// with the file name, but guard against truncated files and hash collisions across V8 versions.
+struct PersistentEntryHeader {
+  static constexpr uint32_t MAGIC = 0x77646363;  // "wdcc"
+
+  uint32_t magic;
+  uint32_t versionTag;
+  uint64_t sourceSize;
+};
+
+kj::String persistentEntryName(
+    kj::ArrayPtr<const char> specifier, kj::ArrayPtr<const char> source) {
+  uint32_t versionTag = v8::ScriptCompiler::CachedDataVersionTag();
+  uint64_t specifierSize = specifier.size();
+  kj::byte hash[SHA256_DIGEST_LENGTH];
+  SHA256_CTX ctx;
+  SHA256_Init(&ctx);
+  SHA256_Update(&ctx, &versionTag, sizeof(versionTag));
+  // The specifier's length is hashed too, so that no specifier/source split is ambiguous.
+  SHA256_Update(&ctx, &specifierSize, sizeof(specifierSize));
+  SHA256_Update(&ctx, specifier.begin(), specifier.size());
+  SHA256_Update(&ctx, source.begin(), source.size());
+  SHA256_Final(hash, &ctx);
+  return kj::encodeHex(kj::arrayPtr(hash));
+}
+
+kj::Own<PersistentCompileCache>* persistentCompileCacheInstance = nullptr;
+
+}  // namespace
+
+PersistentCompileCache::PersistentCompileCache(
+    kj::Own<const kj::Directory> dirParam, uint64_t maxSize)
+    : dir(kj::mv(dirParam)),
+      maxSize(maxSize) {
+  // Index whatever a previous run left behind, treating older files as less recently used. The
+  // contents are loaded later, by the background thread.
+  struct Existing {
+    kj::String name;
+    uint64_t size;
+    kj::Date lastModified;
+  };
+  kj::Vector<Existing> existing;
+  for (auto& entry: dir->listEntries()) {
+    if (entry.type != kj::FsNode::Type::FILE) continue;
+    KJ_IF_SOME(meta, dir->tryLstat(kj::Path(kj::str(entry.name)))) {
+      existing.add(Existing{kj::mv(entry.name), meta.size, meta.lastModified});
+    }
+  }
+  std::sort(existing.begin(), existing.end(),
+      [](const Existing& a, const Existing& b) { return a.lastModified < b.lastModified; });
+
+  {
+    auto lock = state.lockExclusive();
+    for (auto& e: existing) {
+      lock->totalSize += e.size;
+      lock->entries.insert(kj::mv(e.name), Entry{.size = e.size, .lastUsed = ++lock->clock});
+    }
+  }
+
+  thread.emplace([this]() { run(); });
+}
+
+PersistentCompileCache::~PersistentCompileCache() noexcept(false) {
+  queue.lockExclusive()->shutdown = true;
+  // Joins the background thread, which first writes out anything still queued.
+  thread = kj::none;
+}
+
+kj::Maybe<kj::Array<kj::byte>> PersistentCompileCache::find(
+    kj::ArrayPtr<const char> specifier, kj::ArrayPtr<const char> source) const {
+  auto name = persistentEntryName(specifier, source);
+  auto lock = state.lockExclusive();
+  KJ_IF_SOME(entry, lock->entries.find(name)) {
+    KJ_IF_SOME(data, entry.data) {
+      if (entry.sourceSize == source.size()) {
+        entry.lastUsed = ++lock->clock;
+        return kj::heapArray<kj::byte>(data);
+      }
+    }
+  }
+  return kj::none;
+}
+
+void PersistentCompileCache::add(kj::ArrayPtr<const char> specifier,
+    kj::ArrayPtr<const char> source,
+    kj::ArrayPtr<const kj::byte> data) const {
+  PersistentEntryHeader header{
+    .magic = PersistentEntryHeader::MAGIC,
+    .versionTag = v8::ScriptCompiler::CachedDataVersionTag(),
+    .sourceSize = source.size(),
+  };
+  if (sizeof(header) + data.size() > maxSize) return;
+
+  auto content = kj::heapArray<kj::byte>(sizeof(header) + data.size());
+  memcpy(content.begin(), &header, sizeof(header));
+  content.slice(sizeof(header)).copyFrom(data);
+
+  auto name = persistentEntryName(specifier, source);
+  auto lock = state.lockExclusive();
+  auto& entry = lock->entries.upsert(kj::str(name), Entry{}, [](Entry&, Entry&&) {});
+  lock->totalSize = lock->totalSize - entry.value.size + content.size();
+  entry.value = Entry{
+    .size = content.size(),
+    .lastUsed = ++lock->clock,
+    .sourceSize = source.size(),
+    .data = kj::heapArray<kj::byte>(data),
+  };
+
+  // Evict the least recently used entries until we're back under the limit. The cache holds at
+  // most a few thousand modules, so a linear scan is cheaper than maintaining an ordered index.
+  // The entry just added is the most recently used and fits on its own, so it's never evicted.
+  kj::Vector<kj::String> evicted;
+  while (lock->totalSize > maxSize) {
+    kj::Maybe<kj::HashMap<kj::String, Entry>::Entry&> oldest;
+    for (auto& e: lock->entries) {
+      KJ_IF_SOME(o, oldest) {
+        if (e.value.lastUsed >= o.value.lastUsed) continue;
+      }
+      oldest = e;
+    }
+    auto& victim = KJ_ASSERT_NONNULL(oldest);
+    lock->totalSize -= victim.value.size;
+    evicted.add(kj::str(victim.key));
+    lock->entries.erase(victim);
+  }
+
+  auto queueLock = queue.lockExclusive();
+  if (queueLock->shutdown) return;
+  queueLock->ops.add(PendingOp{kj::mv(name), kj::mv(content)});
+  for (auto& victim: evicted) {
+    queueLock->ops.add(PendingOp{kj::mv(victim), kj::none});
+  }
+}
+
+void PersistentCompileCache::flush() const {
+  queue.lockExclusive().wait([](const Queue& q) { return q.ops.empty() && !q.busy; });
+}
+
+void PersistentCompileCache::waitUntilLoaded() const {
+  queue.lockExclusive().wait([](const Queue& q) { return !q.loading; });
+}
+
+void PersistentCompileCache::run() const {
+  loadExisting();
+  queue.lockExclusive()->loading = false;
+
+  for (;;) {
+    queue.lockExclusive().wait([](const Queue& q) { return !q.ops.empty() || q.shutdown; });
+    if (applyQueued()) return;
+  }
+}
+
+bool PersistentCompileCache::applyQueued() const {
+  kj::Vector<PendingOp> ops;
+  bool shutdown;
+  {
+    auto lock = queue.lockExclusive();
+    ops = kj::mv(lock->ops);
+    shutdown = lock->shutdown;
+    lock->busy = true;
+  }
+
+  for (auto& op: ops) {
+    KJ_IF_SOME(exception, kj::runCatchingExceptions([&]() { apply(op); })) {
+      KJ_LOG(WARNING, "failed to update compile cache entry", op.name, exception);
+    }
+  }
+
+  queue.lockExclusive()->busy = false;
+  return shutdown;
+}
+
+void PersistentCompileCache::loadExisting() const {
+  struct ToLoad {
+    kj::String name;
+    uint64_t lastUsed;
+  };
+  kj::Vector<ToLoad> toLoad;
+  {
+    auto lock = state.lockShared();
+    for (auto& entry: lock->entries) {
+      toLoad.add(ToLoad{kj::str(entry.key), entry.value.lastUsed});
+    }
+  }
+  std::sort(toLoad.begin(), toLoad.end(),
+      [](const ToLoad& a, const ToLoad& b) { return a.lastUsed > b.lastUsed; });
+
+  for (auto& item: toLoad) {
+    // Write out anything queued in the meantime first, so that flush() only ever waits for a
+    // single file to be read, not for the whole load.
+    if (applyQueued()) return;
+
+    kj::Array<kj::byte> bytes;
+    KJ_IF_SOME(exception, kj::runCatchingExceptions([&]() {
+      KJ_IF_SOME(file, dir->tryOpenFile(kj::Path(kj::str(item.name)))) {
+        bytes = file->readAllBytes();
+      }
+    })) {
+      KJ_LOG(WARNING, "failed to read compile cache entry", item.name, exception);
+    }
+
+    PersistentEntryHeader header;
+    bool valid = false;
+    if (bytes.size() > sizeof(header)) {
+      memcpy(&header, bytes.begin(), sizeof(header));
+      valid = header.magic == PersistentEntryHeader::MAGIC &&
+          header.versionTag == v8::ScriptCompiler::CachedDataVersionTag();
+    }
+
+    bool remove = false;
+    {
+      auto lock = state.lockExclusive();
+      KJ_IF_SOME(entry, lock->entries.findEntry(item.name)) {
+        // Skip entries that were replaced by add() while we were reading.
+        if (entry.value.data != kj::none) continue;
+
+        if (valid) {
+          entry.value.sourceSize = header.sourceSize;
+          entry.value.data = kj::heapArray<kj::byte>(bytes.slice(sizeof(header)));
+        } else {
+          // The file has gone missing or is corrupt. Forget about it, so that it's regenerated.
+          lock->totalSize -= entry.value.size;
+          lock->entries.erase(entry);
+          remove = true;
+        }
+      }
+    }
+    if (remove) {
+      dir->tryRemove(kj::Path(kj::mv(item.name)));
+    }
+  }
+}
+
+void PersistentCompileCache::apply(PendingOp& op) const {
+  KJ_IF_SOME(content, op.content) {
+    auto replacer =
+        dir->replaceFile(kj::Path(kj::str(op.name)), kj::WriteMode::CREATE | kj::WriteMode::MODIFY);
+    replacer->get().writeAll(content);
+    replacer->commit();
+  } else {
+    dir->tryRemove(kj::Path(kj::mv(op.name)));
+  }
+}
+
+void PersistentCompileCache::install(kj::Own<PersistentCompileCache> instance) {
+  KJ_REQUIRE(persistentCompileCacheInstance == nullptr, "compile cache already installed");
+  // Intentionally leaked: it must outlive every isolate, some of which may still be compiling on
+  // other threads during shutdown. Call flush() before exiting to write out anything queued.
+  persistentCompileCacheInstance = new kj::Own<PersistentCompileCache>(kj::mv(instance));
+}
+
+kj::Maybe<const PersistentCompileCache&> PersistentCompileCache::get() {
+  if (persistentCompileCacheInstance == nullptr) return kj::none;
+  return **persistentCompileCacheInstance;
+}
+
 }  // namespace workerd::jsg
@@ -5,9 +5,12 @@
 
 #include <v8-script.h>
 
+#include <kj/filesystem.h>
 #include <kj/map.h>
 #include <kj/mutex.h>
 #include <kj/string.h>
+#include <kj/thread.h>
+#include <kj/vector.h>
 
 namespace workerd::jsg {
 
@@ -54,4 +57,99 @@ class CompileCache {
   kj::MutexGuarded<kj::HashMap<kj::String, Data>> cache;
 };
 
+// The PersistentCompileCache holds V8 code cache data for user (bundle) modules across process
+// restarts. Entries are stored as files in a directory, named by a SHA-256 hash of the module
+// specifier and source combined with V8's cached data version tag, which covers both the V8
+// version and the flags in effect. Data generated by a different V8 version or flag set is
+// therefore never found, and V8 will still reject anything else that doesn't check out.
+//
+// The directory is mirrored in memory, so that lookups, which happen while compiling under the
+// isolate lock, never wait on disk I/O. A background thread loads the entries left by a previous
+// run, most recently used first, and writes out new entries. Until an entry has been loaded,
+// lookups for it miss. The total size of the directory, and therefore of the mirror, is bounded;
+// the least recently used entries are removed when a new entry would exceed the limit.
+//
+// Unlike CompileCache, entries may be evicted at any time, so find() returns a copy.
+class PersistentCompileCache {
+ public:
+  PersistentCompileCache(kj::Own<const kj::Directory> dir, uint64_t maxSize);
+  ~PersistentCompileCache() noexcept(false);
+  KJ_DISALLOW_COPY_AND_MOVE(PersistentCompileCache);
+
+  // Returns the cached data for the module with the given specifier and source, if any.
+  kj::Maybe<kj::Array<kj::byte>> find(
+      kj::ArrayPtr<const char> specifier, kj::ArrayPtr<const char> source) const;
+
+  // Adds the cached data for the module with the given specifier and source, and queues it to be
+  // written to disk. The data is copied, so the caller may release it as soon as this returns.
+  void add(kj::ArrayPtr<const char> specifier,
+      kj::ArrayPtr<const char> source,
+      kj::ArrayPtr<const kj::byte> data) const;
+
+  // Blocks until everything queued so far has been written to disk. Doesn't wait for the entries
+  // left by a previous run to finish loading: queued writes are interleaved with the load.
+  void flush() const;
+
+  // Blocks until the entries left by a previous run have been loaded.
+  void waitUntilLoaded() const;
+
+  // Installs the process-wide instance consulted when compiling bundle modules. Must be called
+  // at most once, before any isolates are created.
+  static void install(kj::Own<PersistentCompileCache> instance);
+  static kj::Maybe<const PersistentCompileCache&> get();
+
+ private:
+  struct Entry {
+    // Size of the file, including its header.
+    uint64_t size;
+    uint64_t lastUsed;
+    uint64_t sourceSize = 0;
+
+    // The cached data, once it has been loaded from disk or added.
+    kj::Maybe<kj::Array<kj::byte>> data;
+  };
+
+  struct State {
+    kj::HashMap<kj::String, Entry> entries;
+    uint64_t totalSize = 0;
+    uint64_t clock = 0;
+  };
+
+  // Writes the file `name`, or removes it if `content` is none.
+  struct PendingOp {
+    kj::String name;
+    kj::Maybe<kj::Array<kj::byte>> content;
+  };
+
+  struct Queue {
+    kj::Vector<PendingOp> ops;
+
+    // True while the background thread is applying ops it took from `ops`.
+    bool busy = false;
+
+    // True until the background thread is done loading the entries left by a previous run.
+    bool loading = true;
+    bool shutdown = false;
+  };
+
+  kj::Own<const kj::Directory> dir;
+  uint64_t maxSize;
+
+  // When both are locked, `state` is locked first, so that ops are queued in the same order as
+  // the changes to `state` that they reflect.
+  kj::MutexGuarded<State> state;
+  kj::MutexGuarded<Queue> queue;
+
+  // Declared last so that it is joined before the members it uses are destroyed.
+  kj::Maybe<kj::Thread> thread;
+
+  void run() const;
+  void loadExisting() const;
+
+  // Applies the ops queued so far, if any. Returns true if `shutdown` was set, in which case no
+  // more ops will be queued.
+  bool applyQueued() const;
+  void apply(PendingOp& op) const;
+};
+
 }  // namespace workerd::jsg
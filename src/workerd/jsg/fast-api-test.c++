@@ -104,6 +104,19 @@ class FastMethodContext: public jsg::Object, public jsg::ContextGlobal {
     return source.size();
   }
 
+  int32_t unwrapBytes(jsg::Lock& js, kj::Array<kj::byte> bytes) {
+    return bytes.size();
+  }
+
+  // Returns the ByteString warning, which must match what the slow path would have reported.
+  int32_t unwrapByteString(jsg::Lock& js, jsg::ByteString str) {
+    return static_cast<int32_t>(str.warning);
+  }
+
+  int32_t unwrapRef(jsg::Lock& js, jsg::Ref<StaticMethodContainer> container) {
+    return container->getValue();
+  }
+
   int32_t unwrapMaybe(jsg::Lock& js, kj::Maybe<kj::String> str) {
     KJ_IF_SOME(s, str) {
       return s.size();
@@ -147,6 +160,9 @@ class FastMethodContext: public jsg::Object, public jsg::ContextGlobal {
     JSG_METHOD(unwrapUint);
     JSG_METHOD(unwrapString);
     JSG_METHOD(unwrapBufferSource);
+    JSG_METHOD(unwrapBytes);
+    JSG_METHOD(unwrapByteString);
+    JSG_METHOD(unwrapRef);
     JSG_METHOD(unwrapMaybe);
     JSG_METHOD(unwrapOptional);
     JSG_METHOD(unwrapLenientOptional);
@@ -211,6 +227,10 @@ KJ_TEST("type unwrapping arguments") {
   KJ_ASSERT(runTest({"unwrapString('0123')"_kjc, "number"_kjc, "4"_kjc}) == CallCounter(2, 1));
   KJ_ASSERT(runTest({"unwrapBufferSource(new Uint8Array(256))"_kjc, "number"_kjc, "256"_kjc}) ==
       CallCounter(2, 1));
+  KJ_ASSERT(runTest({"unwrapBytes(new Uint8Array([1, 2, 3]))"_kjc, "number"_kjc, "3"_kjc}) ==
+      CallCounter(2, 1));
+  KJ_ASSERT(runTest({"unwrapRef(newContainer())"_kjc, "number"_kjc, "42"_kjc, ""_kjc, 2}) ==
+      CallCounter(5, 1));
   KJ_ASSERT(runTest({"unwrapMaybe(undefined)"_kjc, "number"_kjc, "-1"_kjc}) == CallCounter(2, 1));
   KJ_ASSERT(runTest({"unwrapMaybe('foo')"_kjc, "number"_kjc, "3"_kjc}) == CallCounter(2, 1));
   KJ_ASSERT(
@@ -225,6 +245,16 @@ KJ_TEST("type unwrapping arguments") {
       CallCounter(2, 1));
 }
 
+KJ_TEST("one-byte strings in fast method calls") {
+  // V8 passes sequential one-byte strings directly to the fast path as Latin-1, so conversions
+  // must report the same thing the slow path does.
+  KJ_ASSERT(
+      runTest({"unwrapString('caf\\u00e9')"_kjc, "number"_kjc, "5"_kjc}) == CallCounter(2, 1));
+  KJ_ASSERT(runTest({"unwrapByteString('abc')"_kjc, "number"_kjc, "0"_kjc}) == CallCounter(2, 1));
+  KJ_ASSERT(runTest({"unwrapByteString('caf\\u00e9')"_kjc, "number"_kjc, "1"_kjc}) ==
+      CallCounter(2, 1));
+}
+
 KJ_TEST("Fast methods should work with getters/setters") {
   KJ_ASSERT(
       runTest({"value"_kjc, "number"_kjc, "42"_kjc, "newContainer()"_kjc, 2}) == CallCounter(5, 1));
@@ -362,6 +392,12 @@ KJ_TEST("isFastApiCompatible Detection") {
   static_assert(isFastApiCompatible<StaticMethodContainerMethod>, "This should be compatible");
   static_assert(!isFastApiCompatible<KjPromiseMethod>, "kj::Promise is not compatible");
   static_assert(!isFastApiCompatible<JsgPromiseMethod>, "jsg::Promise is not compatible");
+
+  // Strings, typed arrays and resource types are unwrapped as parameters.
+  static_assert(isFastApiCompatible<int32_t (FastMethodContext::*)(jsg::ByteString)>);
+  static_assert(
+      isFastApiCompatible<int32_t (FastMethodContext::*)(jsg::Lock&, kj::Array<kj::byte>)>);
+  static_assert(isFastApiCompatible<int32_t (FastMethodContext::*)(Ref<StaticMethodContainer>)>);
 }
 
 }  // namespace
@@ -2,11 +2,13 @@
 // Licensed under the Apache 2.0 license found in the LICENSE file or at:
 //     https://opensource.org/licenses/Apache-2.0
 
+#include "compile-cache.h"
 #include "observer.h"
 #include "type-wrapper.h"
 #include "url.h"
 
 #include <workerd/jsg/modules-new.h>
+#include <workerd/jsg/modules.h>
 #include <workerd/jsg/modules.capnp.h>
 #include <workerd/jsg/setup.h>
 
@@ -815,6 +817,142 @@ KJ_TEST("Attaching a module registry works") {
 
 // ======================================================================================
 
+KJ_TEST("ESM modules consume a compile cache generated ahead of time") {
+  struct CountingObserver: public CompilationObserver {
+    mutable uint found = 0;
+    mutable uint rejected = 0;
+    void onCompileCacheFound(v8::Isolate*) const override {
+      ++found;
+    }
+    void onCompileCacheRejected(v8::Isolate*) const override {
+      ++rejected;
+    }
+  };
+
+  PREAMBLE(([&](Lock& js) {
+    ResolveObserver resolveObserver;
+    CountingObserver compilationObserver;
+    ModuleRegistry::Builder registryBuilder(resolveObserver, BASE);
+
+    auto source = kj::str("export default 123;");
+    auto cache =
+        KJ_ASSERT_NONNULL(generateEsmCompileCache(js, "file:///main", source.asArray()));
+    KJ_ASSERT(cache.size() > 0);
+
+    ModuleBundle::BundleBuilder bundleBuilder(BASE);
+    bundleBuilder.addEsmModule("main", source, Module::Flags::MAIN, cache);
+    registryBuilder.add(bundleBuilder.finish());
+
+    auto registry = registryBuilder.finish();
+    auto attached = registry->attachToIsolate(js, compilationObserver);
+
+    js.tryCatch([&] {
+      auto val = ModuleRegistry::resolve(js, "file:///main");
+      KJ_ASSERT(val.isNumber());
+    }, [&](Value exception) { js.throwException(kj::mv(exception)); });
+
+    KJ_EXPECT(compilationObserver.found == 1);
+    KJ_EXPECT(compilationObserver.rejected == 0);
+  }));
+}
+
+KJ_TEST("Invalid compile cache data is ignored") {
+  PREAMBLE(([&](Lock& js) {
+    ResolveObserver resolveObserver;
+    CompilationObserver compilationObserver;
+    ModuleRegistry::Builder registryBuilder(resolveObserver, BASE);
+
+    auto source = kj::str("export default 123;");
+    auto garbage = kj::heapArray<kj::byte>(64);
+    garbage.asPtr().fill(0xab);
+
+    ModuleBundle::BundleBuilder bundleBuilder(BASE);
+    bundleBuilder.addEsmModule("main", source, Module::Flags::MAIN, garbage);
+    registryBuilder.add(bundleBuilder.finish());
+
+    auto registry = registryBuilder.finish();
+    auto attached = registry->attachToIsolate(js, compilationObserver);
+
+    js.tryCatch([&] {
+      auto val = ModuleRegistry::resolve(js, "file:///main");
+      KJ_ASSERT(val.isNumber());
+    }, [&](Value exception) { js.throwException(kj::mv(exception)); });
+  }));
+}
+
+KJ_TEST("Persistent compile cache survives restarts") {
+  auto dir = kj::newInMemoryDirectory(kj::nullClock());
+  auto source = kj::str("export default 123;");
+  auto data = kj::heapArray<kj::byte>({1, 2, 3, 4});
+
+  {
+    PersistentCompileCache cache(dir->clone(), 1 << 20);
+    cache.waitUntilLoaded();
+    KJ_EXPECT(cache.find("file:///main"_kj, source) == kj::none);
+    cache.add("file:///main"_kj, source, data);
+    KJ_EXPECT(KJ_ASSERT_NONNULL(cache.find("file:///main"_kj, source)).asPtr() == data.asPtr());
+    // Destroying the cache flushes pending writes.
+  }
+
+  PersistentCompileCache cache(dir->clone(), 1 << 20);
+  cache.waitUntilLoaded();
+  auto found = KJ_ASSERT_NONNULL(cache.find("file:///main"_kj, source));
+  KJ_EXPECT(found.asPtr() == data.asPtr());
+  KJ_EXPECT(cache.find("file:///main"_kj, "export default 456;"_kj) == kj::none);
+}
+
+KJ_TEST("Persistent compile cache is keyed on the specifier as well as the source") {
+  auto dir = kj::newInMemoryDirectory(kj::nullClock());
+  auto source = kj::str("export default 123;");
+  auto dataA = kj::heapArray<kj::byte>({1, 2, 3, 4});
+  auto dataB = kj::heapArray<kj::byte>({5, 6, 7, 8});
+
+  PersistentCompileCache cache(dir->clone(), 1 << 20);
+  cache.waitUntilLoaded();
+  cache.add("file:///a"_kj, source, dataA);
+  KJ_EXPECT(cache.find("file:///b"_kj, source) == kj::none);
+  cache.add("file:///b"_kj, source, dataB);
+  KJ_EXPECT(KJ_ASSERT_NONNULL(cache.find("file:///a"_kj, source)).asPtr() == dataA.asPtr());
+  KJ_EXPECT(KJ_ASSERT_NONNULL(cache.find("file:///b"_kj, source)).asPtr() == dataB.asPtr());
+
+  // flush() writes entries out without waiting for the cache to be destroyed.
+  cache.flush();
+  KJ_EXPECT(dir->listNames().size() == 2);
+}
+
+KJ_TEST("Persistent compile cache evicts least recently used entries") {
+  auto dir = kj::newInMemoryDirectory(kj::nullClock());
+  auto a = kj::str("export default 'a';");
+  auto b = kj::str("export default 'b';");
+  auto c = kj::str("export default 'c';");
+  auto data = kj::heapArray<kj::byte>({1, 2, 3, 4});
+
+  {
+    PersistentCompileCache cache(dir->clone(), 1 << 20);
+    cache.add("file:///a"_kj, a, data);
+    cache.add("file:///b"_kj, b, data);
+  }
+
+  // From here on, leave room for only two entries.
+  auto entrySize = KJ_ASSERT_NONNULL(dir->tryLstat(kj::Path(kj::str(dir->listNames()[0])))).size;
+
+  {
+    PersistentCompileCache cache(dir->clone(), entrySize * 2);
+    cache.waitUntilLoaded();
+    KJ_EXPECT(cache.find("file:///a"_kj, a) != kj::none);
+    cache.add("file:///c"_kj, c, data);
+  }
+
+  PersistentCompileCache cache(dir->clone(), entrySize * 2);
+  cache.waitUntilLoaded();
+  KJ_EXPECT(cache.find("file:///a"_kj, a) != kj::none);
+  KJ_EXPECT(cache.find("file:///b"_kj, b) == kj::none);
+  KJ_EXPECT(cache.find("file:///c"_kj, c) != kj::none);
+  KJ_EXPECT(dir->listNames().size() == 2);
+}
+
+// ======================================================================================
+
 KJ_TEST("Basic types of modules work (text, data, json, wasm)") {
   PREAMBLE(([&](Lock& js) {
     ResolveObserver resolveObserver;
@@ -5,6 +5,7 @@
 #include "modules-new.h"
 
 #include "buffersource.h"
+#include "compile-cache.h"
 
 #include <workerd/jsg/function.h>
 #include <workerd/jsg/jsg.h>
@@ -67,11 +68,21 @@ constexpr ModuleBundle::Type toModuleBuilderType(ModuleBundle::BuiltinBuilder::T
 // The implementation of Module for ESM.
 class EsModule final: public Module {
  public:
-  explicit EsModule(Url specifier, Type type, Flags flags, kj::ArrayPtr<const char> source)
+  explicit EsModule(Url specifier,
+      Type type,
+      Flags flags,
+      kj::ArrayPtr<const char> source,
+      kj::ArrayPtr<const kj::byte> compileCache = nullptr)
       : Module(kj::mv(specifier), type, flags | Flags::ESM | Flags::EVAL),
         source(source),
         cachedData(kj::none) {
     KJ_DASSERT(isEsm());
+    if (compileCache.size() > 0) {
+      // Seed the cache with code cache data generated ahead of time. Like `source`, the buffer
+      // is not owned and must outlive this module.
+      *cachedData.lockExclusive() = kj::heap<v8::ScriptCompiler::CachedData>(compileCache.begin(),
+          compileCache.size(), v8::ScriptCompiler::CachedData::BufferPolicy::BufferNotOwned);
+    }
   }
   // This variation does not take ownership of the source buffer.
   KJ_DISALLOW_COPY_AND_MOVE(EsModule);
@@ -93,7 +104,29 @@ class EsModule final: public Module {
 
     auto options = v8::ScriptCompiler::CompileOptions::kNoCompileOptions;
 
+    // Bundle modules without cached data of their own may find some left by a previous run. The
+    // lookup only happens until this module has cached data, whichever way it got it.
+    kj::Maybe<const PersistentCompileCache&> persistentCache;
+    if (type() == Type::BUNDLE) {
+      persistentCache = PersistentCompileCache::get();
+      KJ_IF_SOME(cache, persistentCache) {
+        if (*cachedData.lockShared() == kj::none) {
+          KJ_IF_SOME(data, cache.find(specifier().getHref(), this->source)) {
+            auto lock = cachedData.lockExclusive();
+            if (*lock == kj::none) {
+              auto cached = kj::heap<v8::ScriptCompiler::CachedData>(data.begin(), data.size(),
+                  v8::ScriptCompiler::CachedData::BufferPolicy::BufferNotOwned);
+              *lock = kj::mv(cached).attach(kj::mv(data));
+            }
+          }
+        }
+      }
+    }
+
     v8::Local<v8::Module> module;
+    // Set if we had cached data but V8 couldn't use it, e.g. because it was generated ahead of
+    // time by a different V8 version. In that case we replace it below.
+    bool cachedDataUnusable = false;
     {
       v8::ScriptCompiler::CachedData* data = nullptr;
 
@@ -112,6 +145,8 @@ class EsModule final: public Module {
           // The cached data is not compatible with the current isolate. Let's
           // not try using it.
           delete data;
+          data = nullptr;
+          cachedDataUnusable = true;
         } else {
           observer.onCompileCacheFound(js.v8Isolate);
         }
@@ -134,6 +169,7 @@ class EsModule final: public Module {
           // investigation but is not critical.
           LOG_WARNING_ONCE("NOSENTRY Cached data for an ESM module was rejected");
           observer.onCompileCacheRejected(js.v8Isolate);
+          cachedDataUnusable = true;
         }
       }
 
@@ -154,10 +190,14 @@ class EsModule final: public Module {
     // generation.
     if (options == v8::ScriptCompiler::CompileOptions::kNoCompileOptions) {
       auto lock = cachedData.lockExclusive();
-      if (*lock == kj::none) {
+      if (*lock == kj::none || cachedDataUnusable) {
         if (auto ptr = v8::ScriptCompiler::CreateCodeCache(module->GetUnboundModuleScript())) {
           kj::Own<v8::ScriptCompiler::CachedData> cached(
               ptr, kj::_::HeapDisposer<v8::ScriptCompiler::CachedData>::instance);
+          KJ_IF_SOME(cache, persistentCache) {
+            cache.add(
+                specifier().getHref(), this->source, kj::arrayPtr(cached->data, cached->length));
+          }
           *lock = kj::mv(cached);
           observer.onCompileCacheGenerated(js.v8Isolate);
         } else {
@@ -1081,15 +1121,18 @@ ModuleBundle::BundleBuilder& ModuleBundle::BundleBuilder::addSyntheticModule(
   return *this;
 }
 
-ModuleBundle::BundleBuilder& ModuleBundle::BundleBuilder::addEsmModule(
-    kj::StringPtr specifier, kj::ArrayPtr<const char> source, Module::Flags flags) {
+ModuleBundle::BundleBuilder& ModuleBundle::BundleBuilder::addEsmModule(kj::StringPtr specifier,
+    kj::ArrayPtr<const char> source,
+    Module::Flags flags,
+    kj::ArrayPtr<const kj::byte> compileCache) {
   auto url = KJ_ASSERT_NONNULL(bundleBase.tryResolve(specifier));
   // Make sure that percent-encoding in the path is normalized so we can match correctly.
   url = url.clone(Url::EquivalenceOption::NORMALIZE_PATH);
   add(url,
-      [url = url.clone(), source, flags, type = type()](const ResolveContext& context) mutable
+      [url = url.clone(), source, flags, compileCache, type = type()](
+          const ResolveContext& context) mutable
       -> kj::Maybe<kj::OneOf<kj::String, kj::Own<Module>>> {
-    kj::Own<Module> mod = kj::heap<EsModule>(kj::mv(url), type, flags, source);
+    kj::Own<Module> mod = kj::heap<EsModule>(kj::mv(url), type, flags, source, compileCache);
     return kj::Maybe<kj::OneOf<kj::String, kj::Own<Module>>>(kj::mv(mod));
   });
   return *this;
@@ -478,9 +478,12 @@ class ModuleBundle {
         EvaluateCallback callback,
         kj::Array<kj::String> namedExports = nullptr) KJ_LIFETIMEBOUND;
 
+    // `compileCache`, if non-empty, is V8 code cache data for `code` generated ahead of time.
+    // Like `code`, it is not copied and must outlive the registry.
     BundleBuilder& addEsmModule(kj::StringPtr specifier,
         kj::ArrayPtr<const char> code,
-        Module::Flags flags = Module::Flags::ESM) KJ_LIFETIMEBOUND;
+        Module::Flags flags = Module::Flags::ESM,
+        kj::ArrayPtr<const kj::byte> compileCache = nullptr) KJ_LIFETIMEBOUND;
 
     BundleBuilder& alias(kj::StringPtr alias, kj::StringPtr specifier) KJ_LIFETIMEBOUND;
 
@@ -2,6 +2,7 @@
 // Licensed under the Apache 2.0 license found in the LICENSE file or at:
 //     https://opensource.org/licenses/Apache-2.0
 
+#include "compile-cache.h"
 #include "jsg.h"
 #include "setup.h"
 
@@ -346,16 +347,55 @@ v8::Local<v8::Module> compileEsmModule(jsg::Lock& js,
     contentStr = jsg::v8Str(js.v8Isolate, content);
   }
 
+  // Bundle modules without a cache of their own may find one left by a previous run.
+  kj::Maybe<const PersistentCompileCache&> persistentCache;
+  kj::Array<kj::byte> persistedData;
+  if (option == ModuleInfoCompileOption::BUNDLE && compileCache.size() == 0) {
+    persistentCache = PersistentCompileCache::get();
+    KJ_IF_SOME(cache, persistentCache) {
+      KJ_IF_SOME(data, cache.find(name, content)) {
+        persistedData = kj::mv(data);
+        compileCache = persistedData;
+      }
+    }
+  }
+
+  v8::Local<v8::Module> module;
+  bool needsPersisting = persistentCache != kj::none;
   if (compileCache.size() > 0 && compileCache.begin() != nullptr) {
     auto cached =
         std::make_unique<v8::ScriptCompiler::CachedData>(compileCache.begin(), compileCache.size());
     v8::ScriptCompiler::Source source(contentStr, origin, cached.release());
-    return jsg::check(v8::ScriptCompiler::CompileModule(
+    module = jsg::check(v8::ScriptCompiler::CompileModule(
         js.v8Isolate, &source, v8::ScriptCompiler::kConsumeCodeCache));
+    // A rejected cache (e.g. generated by a different V8 version) is not an error; V8 has simply
+    // compiled from source instead.
+    if (source.GetCachedData()->rejected) {
+      observer.onCompileCacheRejected(js.v8Isolate);
+    } else {
+      observer.onCompileCacheFound(js.v8Isolate);
+      needsPersisting = false;
+    }
+  } else {
+    v8::ScriptCompiler::Source source(contentStr, origin);
+    module = jsg::check(v8::ScriptCompiler::CompileModule(js.v8Isolate, &source));
+  }
+
+  if (needsPersisting) {
+    // Serializing the code cache is cheap relative to compilation; the disk write itself happens
+    // on the cache's background thread.
+    std::unique_ptr<v8::ScriptCompiler::CachedData> cached(
+        v8::ScriptCompiler::CreateCodeCache(module->GetUnboundModuleScript()));
+    if (cached != nullptr) {
+      KJ_ASSERT_NONNULL(persistentCache).add(
+          name, content, kj::arrayPtr(cached->data, cached->length));
+      observer.onCompileCacheGenerated(js.v8Isolate);
+    } else {
+      observer.onCompileCacheGenerationFailed(js.v8Isolate);
+    }
   }
 
-  v8::ScriptCompiler::Source source(contentStr, origin);
-  return jsg::check(v8::ScriptCompiler::CompileModule(js.v8Isolate, &source));
+  return module;
 }
 
 v8::Local<v8::Module> createSyntheticModule(
@@ -415,6 +455,25 @@ v8::Local<v8::WasmModuleObject> compileWasmModule(
       js.v8Isolate, v8::MemorySpan<const uint8_t>(code.begin(), code.size())));
 }
 
+kj::Maybe<kj::Array<kj::byte>> generateEsmCompileCache(
+    jsg::Lock& js, kj::StringPtr name, kj::ArrayPtr<const char> content) {
+  v8::TryCatch tryCatch(js.v8Isolate);
+  v8::Local<v8::Module> module;
+  try {
+    module = compileEsmModule(js, name, content, nullptr, ModuleInfoCompileOption::BUNDLE,
+        IsolateBase::from(js.v8Isolate).getObserver());
+  } catch (JsExceptionThrown&) {
+    return kj::none;
+  }
+
+  std::unique_ptr<v8::ScriptCompiler::CachedData> cached(
+      v8::ScriptCompiler::CreateCodeCache(module->GetUnboundModuleScript()));
+  if (cached == nullptr) {
+    return kj::none;
+  }
+  return kj::heapArray<kj::byte>(cached->data, cached->length);
+}
+
 // ======================================================================================
 
 kj::Maybe<kj::OneOf<kj::String, ModuleRegistry::ModuleInfo>> tryResolveFromFallbackService(Lock& js,
@@ -45,6 +45,17 @@ enum class ModuleInfoCompileOption {
 v8::Local<v8::WasmModuleObject> compileWasmModule(
     jsg::Lock& js, kj::ArrayPtr<const uint8_t> code, const CompilationObserver& observer);
 
+// Compiles `content` as an ES module named `name` and returns V8 code cache data for it, suitable
+// for passing later as the `compileCache` of that same module. This is used to generate code
+// caches ahead of time (e.g. by `workerd compile --code-cache`). The cache is only accepted by
+// the same V8 version running with the same V8 flags; otherwise V8 rejects it and compiles from
+// source as usual.
+//
+// Returns none if the module fails to compile. The error isn't reported here since it will be
+// reported again when the module is actually loaded.
+kj::Maybe<kj::Array<kj::byte>> generateEsmCompileCache(
+    jsg::Lock& js, kj::StringPtr name, kj::ArrayPtr<const char> content);
+
 // The ModuleRegistry maintains the collection of modules known to a script that can be
 // required or imported.
 class ModuleRegistry {
@@ -180,6 +180,32 @@ struct SerTestContext: public ContextGlobalObject {
     return val;
   }
 
+  double serializedSizeWithLimit(Lock& js, JsValue value, double maxSize) {
+    Serializer ser(js,
+        Serializer::Options{
+          .maxSize = static_cast<size_t>(maxSize),
+        });
+    ser.write(js, value);
+    return ser.release().data.size();
+  }
+
+  double serializedSizeWithLimitAndError(Lock& js, JsValue value, double maxSize) {
+    Serializer ser(js,
+        Serializer::Options{
+          .maxSize = static_cast<size_t>(maxSize),
+          .maxSizeError = kj::Function<kj::Exception(kj::Maybe<size_t>)>(
+              [](kj::Maybe<size_t> size) {
+      KJ_IF_SOME(s, size) {
+        return JSG_KJ_EXCEPTION(FAILED, TypeError, "too big: ", s);
+      } else {
+        return JSG_KJ_EXCEPTION(FAILED, TypeError, "too big");
+      }
+    }),
+        });
+    ser.write(js, value);
+    return ser.release().data.size();
+  }
+
   JSG_RESOURCE_TYPE(SerTestContext) {
     JSG_NESTED_TYPE(Foo);
     JSG_NESTED_TYPE(Bar);
@@ -187,6 +213,8 @@ struct SerTestContext: public ContextGlobalObject {
     JSG_NESTED_TYPE(Qux);
     JSG_METHOD(roundTrip);
     JSG_METHOD(roundTripError);
+    JSG_METHOD(serializedSizeWithLimit);
+    JSG_METHOD(serializedSizeWithLimitAndError);
   }
 };
 JSG_DECLARE_ISOLATE_TYPE(SerTestIsolate,
@@ -356,5 +384,41 @@ KJ_TEST("serialization of errors") {
       "boolean", "true");
 }
 
+KJ_TEST("serialization size limit") {
+  Evaluator<SerTestContext, SerTestIsolate> e(v8System);
+
+  // Small values are unaffected.
+  e.expectEval("serializedSizeWithLimit('abc', 1024) < 1024", "boolean", "true");
+
+  // A value exactly at the limit is accepted, even though V8 grows its buffer well past that.
+  e.expectEval("let n = serializedSizeWithLimit('x'.repeat(100000), 1000000);\n"
+               "serializedSizeWithLimit('x'.repeat(100000), n) == n",
+      "boolean", "true");
+
+  e.expectEval("serializedSizeWithLimit('x'.repeat(100000), 99999)", "throws",
+      "RangeError: Serialized data exceeds the maximum size of 99999 bytes.");
+
+  // Serialization is abandoned as soon as the limit is crossed, rather than walking the whole
+  // object graph.
+  e.expectEval("let visited = 0;\n"
+               "let big = [];\n"
+               "for (let i = 0; i < 1000; i++) {\n"
+               "  big.push({get x() { ++visited; return 'x'.repeat(1000); }});\n"
+               "}\n"
+               "try { serializedSizeWithLimit(big, 10000); } catch {}\n"
+               "visited < 100",
+      "boolean", "true");
+
+  // Callers can substitute their own error. It gets the size when serialization got to finish.
+  e.expectEval("let n = serializedSizeWithLimit('x'.repeat(100000), 1000000);\n"
+               "try { serializedSizeWithLimitAndError('x'.repeat(100000), n - 1); }\n"
+               "catch (e) { e instanceof TypeError && e.message == `too big: ${n}` }",
+      "boolean", "true");
+  e.expectEval("let big = [];\n"
+               "for (let i = 0; i < 1000; i++) big.push('x'.repeat(1000));\n"
+               "serializedSizeWithLimitAndError(big, 10000)",
+      "throws", "TypeError: too big");
+}
+
 }  // namespace
 }  // namespace workerd::jsg::test
@@ -134,6 +134,8 @@ void Serializer::ExternalHandler::serializeProxy(
 
 Serializer::Serializer(Lock& js, Options options)
     : externalHandler(options.externalHandler),
+      maxSize(options.maxSize),
+      maxSizeError(kj::mv(options.maxSizeError)),
       treatClassInstancesAsPlainObjects(options.treatClassInstancesAsPlainObjects),
       treatErrorsAsHostObjects(options.treatErrorsAsHostObjects),
       preserveStackInErrors(options.preserveStackInErrors),
@@ -173,6 +175,31 @@ v8::Maybe<uint32_t> Serializer::GetSharedArrayBufferId(
   return v8::Just(n);
 }
 
+void* Serializer::ReallocateBufferMemory(void* oldBuffer, size_t size, size_t* actualSize) {
+  KJ_IF_SOME(limit, maxSize) {
+    // V8 only asks for a bigger buffer once the data no longer fits in the current one, so if the
+    // current capacity already reaches the limit, the output is known to exceed it. Failing the
+    // allocation makes V8 abandon serialization immediately. (We can't simply cap the allocation
+    // at the limit, as V8 assumes it gets at least what it asked for.)
+    if (bufferCapacity >= limit) {
+      sizeLimitExceeded = true;
+      return nullptr;
+    }
+  }
+
+  // Must match the allocator used by SerializedBufferDisposer and V8's default implementation.
+  void* result = realloc(oldBuffer, size);
+  if (result != nullptr) {
+    bufferCapacity = size;
+    *actualSize = size;
+  }
+  return result;
+}
+
+void Serializer::FreeBufferMemory(void* buffer) {
+  free(buffer);
+}
+
 void Serializer::throwDataCloneErrorForObject(jsg::Lock& js, v8::Local<v8::Object> obj) {
   // The default error that V8 would generate is "#<TypeName> could not be cloned." -- for some
   // reason, it surrounds the type name in "#<>", which seems bizarre? Let's generate a better
@@ -184,9 +211,22 @@ void Serializer::throwDataCloneErrorForObject(jsg::Lock& js, v8::Local<v8::Objec
   js.throwException(jsg::JsValue(KJ_ASSERT_NONNULL(exception.tryGetHandle(js))));
 }
 
+void Serializer::throwSizeLimitExceeded(jsg::Lock& js, kj::Maybe<size_t> size) {
+  KJ_IF_SOME(makeError, maxSizeError) {
+    js.throwException(makeError(size));
+  }
+  js.throwException(js.rangeError(kj::str("Serialized data exceeds the maximum size of ",
+      KJ_ASSERT_NONNULL(maxSize), " bytes.")));
+}
+
 void Serializer::ThrowDataCloneError(v8::Local<v8::String> message) {
   auto& js = jsg::Lock::current();
   try {
+    if (sizeLimitExceeded) {
+      // V8 reports a failed buffer allocation as an out-of-memory DataCloneError, but the real
+      // reason is that we refused to grow the buffer past `maxSize`.
+      throwSizeLimitExceeded(js);
+    }
     auto exception = js.domException(kj::str("DataCloneError"), kj::str(message));
     js.v8Isolate->ThrowException(KJ_ASSERT_NONNULL(exception.tryGetHandle(js)));
   } catch (JsExceptionThrown&) {
@@ -330,10 +370,20 @@ v8::Maybe<bool> Serializer::WriteHostObject(v8::Isolate* isolate, v8::Local<v8::
 
 Serializer::Released Serializer::release() {
   KJ_ASSERT(!released, "The data has already been released.");
+  auto& js = jsg::Lock::current();
+  // Raw writes (e.g. from an ExternalHandler) can't report failure, so the limit may have been
+  // hit without write() throwing.
+  if (sizeLimitExceeded) throwSizeLimitExceeded(js);
   released = true;
   sharedArrayBuffers.clear();
   arrayBuffers.clear();
   auto pair = ser.Release();
+  KJ_IF_SOME(limit, maxSize) {
+    if (pair.second > limit) {
+      free(pair.first);
+      throwSizeLimitExceeded(js, pair.second);
+    }
+  }
   return Released{
     .data = kj::Array(pair.first, pair.second, jsg::SERIALIZED_BUFFER_DISPOSER),
     .sharedArrayBuffers = sharedBackingStores.releaseAsArray(),
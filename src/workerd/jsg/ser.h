@@ -127,6 +127,16 @@ class Serializer final: v8::ValueSerializer::Delegate {
     // ExternalHandler, if any. Typically this would be allocated on the stack just before the
     // Serializer.
     kj::Maybe<ExternalHandler&> externalHandler;
+
+    // When set, serialization fails with a RangeError if the serialized data would exceed this
+    // many bytes. The check happens as the output buffer grows, so an oversized value is rejected
+    // as soon as the limit is crossed, rather than after the whole object graph has been walked.
+    kj::Maybe<size_t> maxSize;
+
+    // Builds the exception thrown when `maxSize` is exceeded, in place of the default RangeError.
+    // It is passed the size of the serialized data when that is known. When serialization was cut
+    // short, it is passed kj::none, and all that is known is that the size is over `maxSize`.
+    kj::Maybe<kj::Function<kj::Exception(kj::Maybe<size_t> size)>> maxSizeError;
   };
 
   struct Released {
@@ -201,8 +211,20 @@ class Serializer final: v8::ValueSerializer::Delegate {
 
   v8::Maybe<uint32_t> GetSharedArrayBufferId(
       v8::Isolate* isolate, v8::Local<v8::SharedArrayBuffer> sab) override;
+  void* ReallocateBufferMemory(void* oldBuffer, size_t size, size_t* actualSize) override;
+  void FreeBufferMemory(void* buffer) override;
+
+  [[noreturn]] void throwSizeLimitExceeded(jsg::Lock& js, kj::Maybe<size_t> size = kj::none);
 
   kj::Maybe<ExternalHandler&> externalHandler;
+  kj::Maybe<size_t> maxSize;
+  kj::Maybe<kj::Function<kj::Exception(kj::Maybe<size_t> size)>> maxSizeError;
+
+  // Capacity of the buffer V8 is currently serializing into.
+  size_t bufferCapacity = 0;
+
+  // Set when ReallocateBufferMemory() refused to grow the buffer past `maxSize`.
+  bool sizeLimitExceeded = false;
 
   kj::Vector<JsValue> sharedArrayBuffers;
   kj::Vector<JsValue> arrayBuffers;
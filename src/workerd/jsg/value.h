@@ -529,7 +529,13 @@ class StringWrapper {
     if constexpr (kj::isSameType<kj::String, T>()) {
       return js.accountedKjString(kj::mv(buf));
     } else if constexpr (kj::isSameType<ByteString, T>()) {
-      return jsg::ByteString(kj::mv(buf));
+      auto result = jsg::ByteString(kj::mv(buf));
+      if (utf8_length != handle.length) {
+        // Same as JsString::toByteString(): a one-byte string that isn't pure ASCII must contain
+        // extended ASCII characters.
+        result.warning = ByteString::Warning::CONTAINS_EXTENDED_ASCII;
+      }
+      return kj::mv(result);
     } else if constexpr (kj::isSameType<USVString, T>()) {
       return js.accountedUSVString(kj::mv(buf));
     } else if constexpr (kj::isSameType<DOMString, T>()) {
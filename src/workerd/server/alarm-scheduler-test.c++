@@ -0,0 +1,195 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "alarm-scheduler.h"
+
+#include <kj/filesystem.h>
+#include <kj/test.h>
+
+namespace workerd::server {
+namespace {
+
+class FakeClock final: public kj::Clock {
+ public:
+  kj::Date now() const override {
+    return time;
+  }
+
+  kj::Date time = kj::UNIX_EPOCH + 1'000'000 * kj::SECONDS;
+};
+
+// Records the alarms it is asked to run, and reports them as having succeeded.
+class AlarmRecorder final: public WorkerInterface {
+ public:
+  AlarmRecorder(kj::Vector<kj::String>& ran, kj::String actorId)
+      : ran(ran),
+        actorId(kj::mv(actorId)) {}
+
+  kj::Promise<void> request(kj::HttpMethod method,
+      kj::StringPtr url,
+      const kj::HttpHeaders& headers,
+      kj::AsyncInputStream& requestBody,
+      kj::HttpService::Response& response) override {
+    KJ_UNIMPLEMENTED("not used by the alarm scheduler");
+  }
+  kj::Promise<void> connect(kj::StringPtr host,
+      const kj::HttpHeaders& headers,
+      kj::AsyncIoStream& connection,
+      ConnectResponse& response,
+      kj::HttpConnectSettings settings) override {
+    KJ_UNIMPLEMENTED("not used by the alarm scheduler");
+  }
+  kj::Promise<void> prewarm(kj::StringPtr url) override {
+    KJ_UNIMPLEMENTED("not used by the alarm scheduler");
+  }
+  kj::Promise<ScheduledResult> runScheduled(kj::Date scheduledTime, kj::StringPtr cron) override {
+    KJ_UNIMPLEMENTED("not used by the alarm scheduler");
+  }
+  kj::Promise<CustomEvent::Result> customEvent(kj::Own<CustomEvent> event) override {
+    KJ_UNIMPLEMENTED("not used by the alarm scheduler");
+  }
+
+  kj::Promise<AlarmResult> runAlarm(kj::Date scheduledTime, uint32_t retryCount) override {
+    ran.add(kj::mv(actorId));
+    return AlarmResult{.retry = false, .outcome = EventOutcome::OK};
+  }
+
+ private:
+  kj::Vector<kj::String>& ran;
+  kj::String actorId;
+};
+
+const kj::Path DB_PATH({"alarms.sqlite"});
+
+struct AlarmSchedulerTest {
+  kj::EventLoop loop;
+  kj::WaitScope ws{loop};
+  FakeClock clock;
+  kj::TimerImpl timer{kj::origin<kj::TimePoint>()};
+  kj::Own<const kj::Directory> dir = kj::newInMemoryDirectory(kj::nullClock());
+  SqliteDatabase::Vfs vfs{*dir};
+  kj::Vector<kj::String> ran;
+
+  kj::Own<AlarmScheduler> makeScheduler() {
+    auto scheduler = kj::heap<AlarmScheduler>(clock, timer, vfs, DB_PATH);
+    scheduler->registerNamespace("ns"_kj,
+        [this](kj::String actorId) { return kj::heap<AlarmRecorder>(ran, kj::mv(actorId)); });
+    return scheduler;
+  }
+
+  // Moves both the clock and the timer forward, one minute at a time, running whatever comes due.
+  void advance(kj::Duration duration) {
+    while (duration > 0 * kj::SECONDS) {
+      auto step = kj::min(duration, 1 * kj::MINUTES);
+      clock.time += step;
+      timer.advanceTo(timer.now() + step);
+      ws.poll();
+      duration -= step;
+    }
+  }
+};
+
+ActorKey actor(kj::StringPtr actorId) {
+  return {.uniqueKey = "ns"_kj, .actorId = actorId};
+}
+
+KJ_TEST("AlarmScheduler loads alarms from the database as their window comes up") {
+  AlarmSchedulerTest test;
+  auto start = test.clock.now();
+  auto window = AlarmScheduler::IN_MEMORY_WINDOW;
+  {
+    // Alarms left behind by a previous run. Only the first is ever in memory.
+    auto previous = test.makeScheduler();
+    previous->setAlarm(actor("soon"), start + 1 * kj::MINUTES);
+    previous->setAlarm(actor("later"), start + window + 2 * kj::MINUTES);
+    previous->setAlarm(actor("much-later"), start + 3 * window);
+  }
+
+  auto scheduler = test.makeScheduler();
+
+  test.advance(2 * kj::MINUTES);
+  KJ_ASSERT(test.ran.size() == 1);
+  KJ_EXPECT(test.ran[0] == "soon");
+
+  // Still waiting in the database until the window reaches it.
+  KJ_EXPECT(scheduler->getAlarm(actor("later")) == start + window + 2 * kj::MINUTES);
+
+  test.advance(window);
+  KJ_ASSERT(test.ran.size() == 2);
+  KJ_EXPECT(test.ran[1] == "later");
+  KJ_EXPECT(scheduler->getAlarm(actor("later")) == kj::none);
+
+  test.advance(2 * window);
+  KJ_ASSERT(test.ran.size() == 3);
+  KJ_EXPECT(test.ran[2] == "much-later");
+}
+
+KJ_TEST("AlarmScheduler keeps far-future alarms in the database only") {
+  AlarmSchedulerTest test;
+  auto start = test.clock.now();
+  auto window = AlarmScheduler::IN_MEMORY_WINDOW;
+  auto scheduler = test.makeScheduler();
+
+  // Set, read back, move, and delete an alarm that never enters the window.
+  KJ_EXPECT(scheduler->setAlarm(actor("a"), start + 5 * window));
+  KJ_EXPECT(scheduler->getAlarm(actor("a")) == start + 5 * window);
+  KJ_EXPECT(scheduler->setAlarm(actor("a"), start + 6 * window));
+  KJ_EXPECT(scheduler->getAlarm(actor("a")) == start + 6 * window);
+  KJ_EXPECT(scheduler->deleteAlarm(actor("a")));
+  KJ_EXPECT(scheduler->getAlarm(actor("a")) == kj::none);
+  KJ_EXPECT(!scheduler->deleteAlarm(actor("a")));
+
+  // Moving an alarm out of the window takes it out of memory, so it doesn't fire early.
+  KJ_EXPECT(scheduler->setAlarm(actor("b"), start + 1 * kj::MINUTES));
+  KJ_EXPECT(scheduler->setAlarm(actor("b"), start + 2 * window));
+  test.advance(window);
+  KJ_EXPECT(test.ran.size() == 0);
+  KJ_EXPECT(scheduler->getAlarm(actor("b")) == start + 2 * window);
+
+  test.advance(window + 1 * kj::MINUTES);
+  KJ_ASSERT(test.ran.size() == 1);
+  KJ_EXPECT(test.ran[0] == "b");
+  KJ_EXPECT(scheduler->getAlarm(actor("b")) == kj::none);
+}
+
+KJ_TEST("AlarmScheduler retries a failed load") {
+  AlarmSchedulerTest test;
+  auto start = test.clock.now();
+  auto window = AlarmScheduler::IN_MEMORY_WINDOW;
+  auto scheduler = test.makeScheduler();
+
+  // Pull the table out from under the scheduler, so that its loads fail.
+  SqliteDatabase db(test.vfs, DB_PATH, kj::WriteMode::MODIFY);
+  db.run("DROP TABLE _cf_ALARM");
+  {
+    KJ_EXPECT_LOG(ERROR, "Failed to load upcoming alarms, will retry");
+    test.advance(window / 2);
+  }
+
+  // The retry comes seconds later, rather than at the next regular load.
+  {
+    KJ_EXPECT_LOG(ERROR, "Failed to load upcoming alarms, will retry");
+    test.advance(1 * kj::MINUTES);
+  }
+
+  // Put the table back. The next retry succeeds, and covers the part of the window that the
+  // failed loads missed.
+  db.run(R"(
+    CREATE TABLE _cf_ALARM (
+      actor_unique_key TEXT,
+      actor_id TEXT,
+      scheduled_time INTEGER,
+      PRIMARY KEY (actor_unique_key, actor_id)
+    ) WITHOUT ROWID;
+  )");
+  db.run("INSERT INTO _cf_ALARM VALUES(?, ?, ?)", "ns"_kj, "a"_kj,
+      (start + window + 2 * kj::MINUTES - kj::UNIX_EPOCH) / kj::NANOSECONDS);
+
+  test.advance(window);
+  KJ_ASSERT(test.ran.size() == 1);
+  KJ_EXPECT(test.ran[0] == "a");
+}
+
+}  // namespace
+}  // namespace workerd::server
@@ -38,7 +38,8 @@ AlarmScheduler::AlarmScheduler(
         return kj::mv(db);
       }()),
       tasks(*this) {
-  loadAlarmsFromDb();
+  loadAlarmsFromDb(clock.now() + IN_MEMORY_WINDOW);
+  tasks.add(loadUpcomingAlarms());
 }
 
 void AlarmScheduler::ensureInitialized(SqliteDatabase& db) {
@@ -53,18 +54,27 @@ void AlarmScheduler::ensureInitialized(SqliteDatabase& db) {
       PRIMARY KEY (actor_unique_key, actor_id)
     ) WITHOUT ROWID;
   )");
+
+  // Lets us load only the alarms that are coming up soon.
+  db.run(R"(
+    CREATE INDEX IF NOT EXISTS _cf_ALARM_scheduled_time ON _cf_ALARM (scheduled_time);
+  )");
 }
 
-void AlarmScheduler::loadAlarmsFromDb() {
+void AlarmScheduler::loadAlarmsFromDb(kj::Date until) {
   auto now = clock.now();
 
-  // TODO(someday): don't maintain the entire alarm set in memory -- right now for the usecase of
-  // local development, doing so is sufficient.
-  auto query = db->run(R"(
-    SELECT actor_unique_key, actor_id, scheduled_time FROM _cf_ALARM;
-  )");
+  int64_t untilNs = (until - kj::UNIX_EPOCH) / kj::NANOSECONDS;
+  auto query = stmtLoadAlarms.run(loadedUntil, untilNs);
 
   while (!query.isDone()) {
+    ActorKey key{.uniqueKey = query.getText(0), .actorId = query.getText(1)};
+    if (alarms.find(key) != kj::none) {
+      // Already in memory, e.g. because it was queued behind a running alarm.
+      query.nextRow();
+      continue;
+    }
+
     auto date = kj::UNIX_EPOCH + (kj::NANOSECONDS * query.getInt64(2));
 
     auto ownUniqueKey = kj::str(query.getText(0));
@@ -76,6 +86,34 @@ void AlarmScheduler::loadAlarmsFromDb() {
 
     query.nextRow();
   }
+
+  // Only advance once everything has been loaded, so that a failed load is picked up again by the
+  // next one. Alarms which did make it into memory are skipped then.
+  loadedUntil = untilNs;
+}
+
+kj::Promise<void> AlarmScheduler::loadUpcomingAlarms() {
+  // Counts consecutive failed loads.
+  uint32_t backoff = 0;
+
+  for (;;) {
+    auto delay = IN_MEMORY_WINDOW / 2;
+    if (backoff > 0) {
+      // Retry sooner than usual, while the alarms loaded last time are still covering for us.
+      auto shift = kj::min(AlarmScheduler::RETRY_BACKOFF_MAX, backoff - 1);
+      delay = kj::min(delay, (AlarmScheduler::RETRY_START_SECONDS << shift) * kj::SECONDS);
+    }
+    co_await timer.afterDelay(delay);
+
+    try {
+      loadAlarmsFromDb(clock.now() + IN_MEMORY_WINDOW);
+      backoff = 0;
+    } catch (...) {
+      auto exception = kj::getCaughtExceptionAsKj();
+      KJ_LOG(ERROR, "Failed to load upcoming alarms, will retry", exception);
+      ++backoff;
+    }
+  }
 }
 
 void AlarmScheduler::registerNamespace(kj::StringPtr uniqueKey, GetActorFn getActor) {
@@ -94,8 +132,12 @@ kj::Maybe<kj::Date> AlarmScheduler::getAlarm(ActorKey actor) {
       return alarm.scheduledTime;
     }
   } else {
-    // We currently retain the entire set of queued alarms in memory, no need to hit sqlite
-    return kj::none;
+    // Not due soon enough to be in memory, but it may still be in the database.
+    auto query = stmtGetAlarm.run(actor.uniqueKey, actor.actorId);
+    if (query.isDone()) {
+      return kj::none;
+    }
+    return kj::UNIX_EPOCH + (kj::NANOSECONDS * query.getInt64(0));
   }
 }
 
@@ -103,6 +145,19 @@ bool AlarmScheduler::setAlarm(ActorKey actor, kj::Date scheduledTime) {
   int64_t scheduledTimeNs = (scheduledTime - kj::UNIX_EPOCH) / kj::NANOSECONDS;
   auto query = stmtSetAlarm.run(actor.uniqueKey, actor.actorId, scheduledTimeNs);
 
+  if (scheduledTimeNs >= loadedUntil) {
+    // Too far out to keep in memory; loadUpcomingAlarms() will pick it up from the database. An
+    // alarm which is running or retrying still needs its entry, so queue behind it as usual.
+    KJ_IF_SOME(entry, alarms.findEntry(actor)) {
+      if (entry.value.status == AlarmStatus::WAITING) {
+        alarms.erase(entry);
+      } else {
+        entry.value.queuedAlarm = scheduledTime;
+      }
+    }
+    return query.changeCount() > 0;
+  }
+
   bool existing = true;
   auto& entry = alarms.findOrCreate(actor, [&]() {
     existing = false;
@@ -58,6 +58,11 @@ class AlarmScheduler final: kj::TaskSet::ErrorHandler {
   // some common dependency between a set of failed alarms
   static constexpr auto RETRY_JITTER_FACTOR = 0.25;
 
+  // Only alarms due within this window are held in memory, each with its own timer. Alarms
+  // further out live only in the database and are loaded as the window advances over them, which
+  // happens every half window.
+  static constexpr auto IN_MEMORY_WINDOW = 10 * kj::MINUTES;
+
   using GetActorFn = kj::Function<kj::Own<WorkerInterface>(kj::String)>;
 
   AlarmScheduler(
@@ -103,8 +108,13 @@ class AlarmScheduler final: kj::TaskSet::ErrorHandler {
     uint32_t countedRetry = 0;
   };
 
+  // Alarms scheduled before `loadedUntil`, plus any alarm which has started running (including
+  // retries and an alarm queued behind it). Every other alarm is only in the database.
   kj::HashMap<ActorKey, ScheduledAlarm> alarms;
 
+  // Nanoseconds since the Unix epoch up to which alarms have been loaded from the database.
+  int64_t loadedUntil = kj::minValue;
+
   struct RetryInfo {
     bool retry;
     bool retryCountsAgainstLimit;
@@ -128,13 +138,26 @@ class AlarmScheduler final: kj::TaskSet::ErrorHandler {
   SqliteDatabase::Statement stmtDeleteAlarm = db->prepare(R"(
     DELETE FROM _cf_ALARM WHERE actor_unique_key = ? AND actor_id = ?
   )");
+  SqliteDatabase::Statement stmtGetAlarm = db->prepare(R"(
+    SELECT scheduled_time FROM _cf_ALARM WHERE actor_unique_key = ? AND actor_id = ?
+  )");
+  SqliteDatabase::Statement stmtLoadAlarms = db->prepare(R"(
+    SELECT actor_unique_key, actor_id, scheduled_time FROM _cf_ALARM
+      WHERE scheduled_time >= ? AND scheduled_time < ?
+  )");
 
   void taskFailed(kj::Exception&& exception) override;
 
   int maxJitterMsForDelay(kj::Duration delay);
 
   static void ensureInitialized(SqliteDatabase& db);
-  void loadAlarmsFromDb();
+
+  // Loads all alarms scheduled before `until` which aren't already in memory.
+  void loadAlarmsFromDb(kj::Date until);
+
+  // Periodically advances the in-memory window. A failed load is logged and retried with
+  // exponential backoff.
+  kj::Promise<void> loadUpcomingAlarms();
 };
 
 }  // namespace workerd::server
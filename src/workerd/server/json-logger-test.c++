@@ -6,6 +6,7 @@
 #include "json-logger.h"
 
 #include <workerd/server/log-schema.capnp.h>
+#include <workerd/util/stdio-log-sink.h>
 
 #include <fcntl.h>
 #include <unistd.h>
@@ -83,6 +84,38 @@ KJ_TEST("JsonLogger stdout validation") {
   auto source = logEntry.getSource();
   KJ_EXPECT(kj::StringPtr(source.begin(), source.size()).endsWith("json-logger-test.c++:49"));
 }
+
+KJ_TEST("JsonLogger writes through the StdioLogSink if there is one") {
+  auto interceptorPipe = makePipeFds();
+  int originalStdout = dup(STDOUT_FILENO);
+  KJ_SYSCALL(dup2(interceptorPipe.input.get(), STDOUT_FILENO));
+  interceptorPipe.input = nullptr;
+  KJ_DEFER({
+    // Restore stdout
+    KJ_SYSCALL(dup2(originalStdout, STDOUT_FILENO));
+    close(originalStdout);
+  });
+
+  {
+    StdioLogSink sink;
+    JsonLogger logger;
+
+    // The log entry lands between lines written to the sink before and after it.
+    sink.write(stdout, kj::str("before\n"));
+    KJ_LOG(ERROR, "Test JSON message");
+    sink.write(stdout, kj::str("after\n"));
+  }
+
+  char buffer[4096];
+  ssize_t n;
+  KJ_SYSCALL(n = read(interceptorPipe.output.get(), buffer, sizeof(buffer) - 1));
+  buffer[n] = '\0';
+  kj::StringPtr output(buffer, n);
+
+  KJ_EXPECT(output.startsWith("before\n{"), output);
+  KJ_EXPECT(output.contains(R"("message":"Test JSON message")"), output);
+  KJ_EXPECT(output.endsWith("}\nafter\n"), output);
+}
 #endif  // __linux__
 
 KJ_TEST("Blank test because KJ fails when 0 tests are enabled") {}
@@ -5,6 +5,7 @@
 #include "json-logger.h"
 
 #include <workerd/server/log-schema.capnp.h>
+#include <workerd/util/stdio-log-sink.h>
 
 #include <capnp/compat/json.h>
 #include <capnp/message.h>
@@ -66,7 +67,12 @@ void JsonLogger::logMessage(
 
   auto json = buildJsonLogMessage(severity, file, line, contextDepth, text);
 
-  puts(json.cStr());
+  KJ_IF_SOME(sink, StdioLogSink::current()) {
+    // Keep log entries in order with console output, which also goes through the sink.
+    sink.write(stdout, kj::str(json, '\n'));
+  } else {
+    puts(json.cStr());
+  }
 }
 
 kj::Function<void(kj::Function<void()>)> JsonLogger::getThreadInitializer() {
@@ -0,0 +1,298 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "local-cache.h"
+
+#include <kj/test.h>
+
+#if !_WIN32
+#include <stdlib.h>
+#include <sys/file.h>
+#endif
+
+namespace workerd::server {
+namespace {
+
+class FakeClock final: public kj::Clock {
+ public:
+  kj::Date now() const override {
+    return time;
+  }
+
+  kj::Date time = kj::UNIX_EPOCH + 1'000'000 * kj::SECONDS;
+};
+
+// Counts the body files in all of the cache subdirectories of `dir`.
+size_t countBodyFiles(const kj::Directory& dir) {
+  size_t count = 0;
+  for (auto& name: dir.listNames()) {
+    if (name.endsWith(".bodies")) {
+      count += dir.openSubdir(kj::Path(kj::mv(name)))->listNames().size();
+    }
+  }
+  return count;
+}
+
+struct CacheTest {
+  kj::EventLoop loop;
+  kj::WaitScope ws{loop};
+  FakeClock clock;
+  kj::HttpHeaderTable::Builder builder;
+  kj::HttpHeaderId hAcceptEncoding = builder.add("Accept-Encoding");
+  kj::HttpHeaderId cfCacheStatus = builder.add("CF-Cache-Status");
+  kj::HttpHeaderId cfCacheNamespace = builder.add("CF-Cache-Namespace");
+  LocalCache cache;
+  kj::Own<kj::HttpHeaderTable> table = builder.build();
+  kj::Own<kj::HttpClient> client = kj::newHttpClient(*table, cache);
+
+  explicit CacheTest(kj::Maybe<kj::Own<const kj::Directory>> dir = kj::none,
+      LocalCache::Options options = {})
+      : cache(builder, clock, kj::mv(dir), options) {}
+
+  struct Result {
+    uint statusCode;
+    kj::Maybe<kj::String> cacheStatus;
+    kj::Maybe<kj::String> contentRange;
+    kj::String body;
+  };
+
+  uint put(kj::StringPtr url,
+      kj::StringPtr serialized,
+      kj::Maybe<kj::StringPtr> acceptEncoding = kj::none) {
+    kj::HttpHeaders headers(*table);
+    KJ_IF_SOME(value, acceptEncoding) {
+      headers.set(hAcceptEncoding, value);
+    }
+    auto req = client->request(kj::HttpMethod::PUT, url, headers, serialized.size());
+    req.body->write(serialized.asBytes()).wait(ws);
+    req.body = nullptr;
+    auto response = req.response.wait(ws);
+    response.body->readAllBytes().wait(ws);
+    return response.statusCode;
+  }
+
+  Result request(kj::HttpMethod method,
+      kj::StringPtr url,
+      kj::Maybe<kj::StringPtr> acceptEncoding = kj::none,
+      kj::Maybe<kj::StringPtr> range = kj::none,
+      kj::Maybe<kj::StringPtr> ns = kj::none) {
+    kj::HttpHeaders headers(*table);
+    KJ_IF_SOME(value, acceptEncoding) {
+      headers.set(hAcceptEncoding, value);
+    }
+    KJ_IF_SOME(value, range) {
+      headers.set(kj::HttpHeaderId::RANGE, value);
+    }
+    KJ_IF_SOME(value, ns) {
+      headers.set(cfCacheNamespace, value);
+    }
+    auto response = client->request(method, url, headers).response.wait(ws);
+    auto body = response.body->readAllText().wait(ws);
+    return {
+      .statusCode = response.statusCode,
+      .cacheStatus = response.headers->get(cfCacheStatus).map([](kj::StringPtr s) {
+        return kj::str(s);
+      }),
+      .contentRange = response.headers->get(kj::HttpHeaderId::CONTENT_RANGE).map(
+          [](kj::StringPtr s) { return kj::str(s); }),
+      .body = kj::mv(body),
+    };
+  }
+
+  Result get(kj::StringPtr url,
+      kj::Maybe<kj::StringPtr> acceptEncoding = kj::none,
+      kj::Maybe<kj::StringPtr> range = kj::none) {
+    return request(kj::HttpMethod::GET, url, acceptEncoding, range);
+  }
+};
+
+KJ_TEST("LocalCache stores responses until they expire") {
+  CacheTest test;
+
+  auto miss = test.get("https://example.com/a");
+  KJ_EXPECT(miss.statusCode == 504);
+  KJ_EXPECT(KJ_ASSERT_NONNULL(miss.cacheStatus) == "MISS");
+
+  KJ_EXPECT(test.put("https://example.com/a",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\nContent-Length: 5\r\n\r\nhello") ==
+      204);
+
+  auto hit = test.get("https://example.com/a");
+  KJ_EXPECT(hit.statusCode == 200);
+  KJ_EXPECT(KJ_ASSERT_NONNULL(hit.cacheStatus) == "HIT");
+  KJ_EXPECT(hit.body == "hello");
+
+  // Other namespaces don't see it.
+  KJ_EXPECT(test.request(kj::HttpMethod::GET, "https://example.com/a", kj::none, kj::none, "ns"_kj)
+                .statusCode == 504);
+
+  test.clock.time += 61 * kj::SECONDS;
+  KJ_EXPECT(test.get("https://example.com/a").statusCode == 504);
+
+  // Expires is measured against the response's own Date header.
+  KJ_EXPECT(test.put("https://example.com/b",
+                "HTTP/1.1 200 OK\r\n"
+                "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+                "Expires: Sun, 06 Nov 1994 08:50:37 GMT\r\n"
+                "\r\nworld") == 204);
+  KJ_EXPECT(test.get("https://example.com/b").body == "world");
+  test.clock.time += 59 * kj::SECONDS;
+  KJ_EXPECT(test.get("https://example.com/b").statusCode == 200);
+  test.clock.time += 2 * kj::SECONDS;
+  KJ_EXPECT(test.get("https://example.com/b").statusCode == 504);
+}
+
+KJ_TEST("LocalCache honors no-store and Vary") {
+  CacheTest test;
+
+  KJ_EXPECT(test.put("https://example.com/a",
+                "HTTP/1.1 200 OK\r\nCache-Control: no-store\r\n\r\nhello") == 204);
+  KJ_EXPECT(test.get("https://example.com/a").statusCode == 504);
+
+  KJ_EXPECT(test.put("https://example.com/v",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\nVary: Accept-Encoding\r\n\r\ngz",
+                "gzip"_kj) == 204);
+  KJ_EXPECT(test.put("https://example.com/v",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\nVary: Accept-Encoding\r\n\r\nbr",
+                "br"_kj) == 204);
+
+  KJ_EXPECT(test.get("https://example.com/v", "gzip"_kj).body == "gz");
+  KJ_EXPECT(test.get("https://example.com/v", "br"_kj).body == "br");
+  KJ_EXPECT(test.get("https://example.com/v", "identity"_kj).statusCode == 504);
+  KJ_EXPECT(test.get("https://example.com/v").statusCode == 504);
+}
+
+KJ_TEST("LocalCache serves ranges and purges") {
+  CacheTest test;
+
+  KJ_EXPECT(test.put("https://example.com/a",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\n\r\nhello") == 204);
+
+  auto partial = test.get("https://example.com/a", kj::none, "bytes=1-3"_kj);
+  KJ_EXPECT(partial.statusCode == 206);
+  KJ_EXPECT(partial.body == "ell");
+  KJ_EXPECT(KJ_ASSERT_NONNULL(partial.contentRange) == "bytes 1-3/5");
+
+  auto unsatisfiable = test.get("https://example.com/a", kj::none, "bytes=10-20"_kj);
+  KJ_EXPECT(unsatisfiable.statusCode == 416);
+  KJ_EXPECT(KJ_ASSERT_NONNULL(unsatisfiable.contentRange) == "bytes */5");
+
+  KJ_EXPECT(test.request(kj::HttpMethod::PURGE, "https://example.com/a").statusCode == 200);
+  KJ_EXPECT(test.get("https://example.com/a").statusCode == 504);
+  KJ_EXPECT(test.request(kj::HttpMethod::PURGE, "https://example.com/a").statusCode == 404);
+}
+
+KJ_TEST("LocalCache spills large bodies to disk and evicts them") {
+  auto dir = kj::newInMemoryDirectory(kj::nullClock());
+  dir->openFile(kj::Path("stale.body"), kj::WriteMode::CREATE)->writeAll("left over");
+  dir->openFile(kj::Path({"dead.bodies", "0.body"}), kj::WriteMode::CREATE_PARENT)
+      ->writeAll("left over");
+  dir->openFile(kj::Path("unrelated"), kj::WriteMode::CREATE)->writeAll("keep me");
+
+  CacheTest test(dir->clone(),
+      {
+        .maxMemory = 16,
+        .maxDisk = 16,
+        .maxObjectSize = 16,
+        .maxInMemoryBodySize = 4,
+      });
+
+  // Files from a previous run are cleaned up, leaving only our own subdirectory and what isn't
+  // ours to remove.
+  KJ_EXPECT(dir->listNames().size() == 2);
+  KJ_EXPECT(dir->exists(kj::Path("unrelated")));
+  KJ_EXPECT(countBodyFiles(*dir) == 0);
+
+  KJ_EXPECT(test.put("https://example.com/small",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\n\r\nabc") == 204);
+  KJ_EXPECT(countBodyFiles(*dir) == 0);
+
+  KJ_EXPECT(test.put("https://example.com/big",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\n\r\n0123456789") == 204);
+  KJ_EXPECT(countBodyFiles(*dir) == 1);
+  KJ_EXPECT(test.get("https://example.com/big").body == "0123456789");
+  KJ_EXPECT(test.get("https://example.com/big", kj::none, "bytes=-3"_kj).body == "789");
+
+  // Too big to store at all.
+  KJ_EXPECT(test.put("https://example.com/huge",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\n\r\n0123456789abcdefg") == 413);
+
+  // Pushes the first large body out of the disk tier, but leaves the memory tier alone.
+  KJ_EXPECT(test.put("https://example.com/big2",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\n\r\nabcdefghij") == 204);
+  KJ_EXPECT(countBodyFiles(*dir) == 1);
+  KJ_EXPECT(test.get("https://example.com/big").statusCode == 504);
+  KJ_EXPECT(test.get("https://example.com/big2").body == "abcdefghij");
+  KJ_EXPECT(test.get("https://example.com/small").body == "abc");
+}
+
+KJ_TEST("LocalCache instances sharing a directory keep their files apart") {
+  auto dir = kj::newInMemoryDirectory(kj::nullClock());
+  LocalCache::Options options{.maxInMemoryBodySize = 0};
+
+  auto first = kj::heap<CacheTest>(dir->clone(), options);
+  KJ_EXPECT(first->put("https://example.com/a",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\n\r\nfirst") == 204);
+
+  // Starting another instance, as another thread would, doesn't sweep away the first one's files.
+  auto second = kj::heap<CacheTest>(dir->clone(), options);
+  KJ_EXPECT(second->put("https://example.com/a",
+                "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\n\r\nsecond") == 204);
+  KJ_EXPECT(dir->listNames().size() == 2);
+  KJ_EXPECT(countBodyFiles(*dir) == 2);
+  KJ_EXPECT(first->get("https://example.com/a").body == "first");
+  KJ_EXPECT(second->get("https://example.com/a").body == "second");
+
+  // Each instance removes its own files when it goes away.
+  first = nullptr;
+  KJ_EXPECT(dir->listNames().size() == 1);
+  KJ_EXPECT(second->get("https://example.com/a").body == "second");
+  second = nullptr;
+  KJ_EXPECT(dir->listNames().size() == 0);
+}
+
+#if !_WIN32
+KJ_TEST("LocalCache leaves other processes' files alone") {
+  auto disk = kj::newDiskFilesystem();
+  const char* tmpDir = getenv("TEST_TMPDIR");
+  auto pathStr =
+      kj::str(tmpDir != nullptr ? tmpDir : "/var/tmp", "/workerd-local-cache-test.XXXXXX");
+  KJ_ASSERT(mkdtemp(pathStr.begin()) != nullptr);
+  auto path = disk->getCurrentPath().eval(pathStr);
+  auto dir = disk->getRoot().openSubdir(path, kj::WriteMode::MODIFY);
+  KJ_DEFER(disk->getRoot().remove(path));
+
+  // Another process's cache holds the lock on its subdirectory. (flock() locks belong to the open
+  // file, so holding one here excludes the cache just as well.)
+  auto other = dir->openSubdir(kj::Path("1-other.bodies"), kj::WriteMode::CREATE);
+  other->openFile(kj::Path("0.body"), kj::WriteMode::CREATE)->writeAll("in use");
+  KJ_SYSCALL(flock(KJ_ASSERT_NONNULL(other->getFd()), LOCK_EX | LOCK_NB));
+
+  // A process that has exited left its subdirectory unlocked.
+  dir->openFile(kj::Path({"2-dead.bodies", "0.body"}), kj::WriteMode::CREATE_PARENT)
+      ->writeAll("left over");
+
+  {
+    CacheTest test(dir->clone());
+    KJ_EXPECT(dir->exists(kj::Path("1-other.bodies")));
+    KJ_EXPECT(!dir->exists(kj::Path("2-dead.bodies")));
+    KJ_EXPECT(dir->listNames().size() == 2);
+
+    // Our own subdirectory is locked too.
+    for (auto& name: dir->listNames()) {
+      if (name == "1-other.bodies") continue;
+      auto ours = dir->openSubdir(kj::Path(kj::mv(name)));
+      int result;
+      KJ_NONBLOCKING_SYSCALL(
+          result = flock(KJ_ASSERT_NONNULL(ours->getFd()), LOCK_EX | LOCK_NB));
+      KJ_EXPECT(result < 0);
+    }
+  }
+
+  KJ_EXPECT(dir->listNames().size() == 1);
+}
+#endif
+
+}  // namespace
+}  // namespace workerd::server
@@ -0,0 +1,721 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "local-cache.h"
+
+#include <kj/debug.h>
+#include <kj/mutex.h>
+
+#include <random>
+
+#if _WIN32
+#include <process.h>
+#else
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace workerd::server {
+
+namespace {
+
+// Largest serialized response header block we accept in a PUT.
+constexpr size_t MAX_HEADER_SIZE = 128 * 1024;
+
+// Size of reads when the length of a body isn't known in advance.
+constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+// Suffix of the per-instance subdirectories holding file bodies.
+constexpr kj::StringPtr BODY_DIR_SUFFIX = ".bodies"_kj;
+
+// Names of the body subdirectories of every live LocalCache in the process. Instances that share
+// a directory must not sweep each other's files away at startup.
+kj::MutexGuarded<kj::HashSet<kj::String>>& liveBodyDirs() {
+  static kj::MutexGuarded<kj::HashSet<kj::String>> result;
+  return result;
+}
+
+// Returns a name for a new body subdirectory which no other instance, in this process or any
+// other, is using.
+kj::String newBodyDirName() {
+#if _WIN32
+  auto pid = _getpid();
+#else
+  auto pid = getpid();
+#endif
+  std::random_device random;
+  uint64_t suffix = (uint64_t(random()) << 32) | random();
+  return kj::str(pid, '-', kj::hex(suffix), BODY_DIR_SUFFIX);
+}
+
+// Takes the lock that marks a body subdirectory as in use, for as long as `dir` stays open.
+// Returns false if some other instance, in this process or another, holds it. Directories that
+// aren't on disk can't be shared with other processes, so they have no lock; liveBodyDirs()
+// covers those.
+bool tryLockBodyDir(const kj::Directory& dir) {
+#if !_WIN32
+  KJ_IF_SOME(fd, dir.getFd()) {
+    int result;
+    KJ_NONBLOCKING_SYSCALL(result = flock(fd, LOCK_EX | LOCK_NB));
+    return result == 0;
+  }
+#endif
+  return true;
+}
+
+// Returns true, and takes its lock, if the body subdirectory `dir` belongs to no live instance.
+bool lockIfAbandoned(const kj::Directory& dir) {
+#if _WIN32
+  // TODO(someday): Lock with LockFileEx(). Until then, subdirectories on disk may be in use by
+  //   another process, so they're left alone.
+  if (dir.getWin32Handle() != kj::none) return false;
+#endif
+  return tryLockBodyDir(dir);
+}
+
+kj::String toLower(kj::ArrayPtr<const char> text) {
+  auto result = kj::heapString(text);
+  for (char& c: result) {
+    if ('A' <= c && c <= 'Z') c = c - 'A' + 'a';
+  }
+  return result;
+}
+
+kj::ArrayPtr<const char> trim(kj::ArrayPtr<const char> text) {
+  while (text.size() > 0 && (text.front() == ' ' || text.front() == '\t')) text = text.slice(1);
+  while (text.size() > 0 && (text.back() == ' ' || text.back() == '\t')) {
+    text = text.first(text.size() - 1);
+  }
+  return text;
+}
+
+// Calls `func` with each trimmed, non-empty element of a comma-separated header value.
+template <typename Func>
+void forEachListElement(kj::StringPtr value, Func&& func) {
+  kj::ArrayPtr<const char> rest = value;
+  while (rest.size() > 0) {
+    size_t end = 0;
+    while (end < rest.size() && rest[end] != ',') ++end;
+    auto element = trim(rest.first(end));
+    if (element.size() > 0) func(element);
+    rest = rest.slice(kj::min(end + 1, rest.size()));
+  }
+}
+
+struct CacheControl {
+  bool noStore = false;
+  bool noCache = false;
+  bool isPrivate = false;
+  kj::Maybe<int64_t> maxAge;
+  kj::Maybe<int64_t> sMaxAge;
+};
+
+CacheControl parseCacheControl(kj::Maybe<kj::StringPtr> header) {
+  CacheControl result;
+  KJ_IF_SOME(value, header) {
+    forEachListElement(value, [&](kj::ArrayPtr<const char> directive) {
+      kj::ArrayPtr<const char> name = directive;
+      kj::Maybe<kj::ArrayPtr<const char>> argument;
+      KJ_IF_SOME(eq, directive.findFirst('=')) {
+        name = trim(directive.first(eq));
+        auto arg = trim(directive.slice(eq + 1));
+        if (arg.size() >= 2 && arg.front() == '"' && arg.back() == '"') {
+          arg = arg.slice(1, arg.size() - 1);
+        }
+        argument = arg;
+      }
+
+      auto lower = toLower(name);
+      auto seconds = [&]() -> kj::Maybe<int64_t> {
+        KJ_IF_SOME(arg, argument) {
+          return kj::str(arg).tryParseAs<int64_t>();
+        }
+        return kj::none;
+      };
+      if (lower == "no-store") {
+        result.noStore = true;
+      } else if (lower == "no-cache") {
+        result.noCache = true;
+      } else if (lower == "private") {
+        result.isPrivate = true;
+      } else if (lower == "max-age") {
+        result.maxAge = seconds();
+      } else if (lower == "s-maxage") {
+        result.sMaxAge = seconds();
+      }
+    });
+  }
+  return result;
+}
+
+int64_t daysFromCivil(int64_t y, int m, int d) {
+  // Howard Hinnant's algorithm, counting days since 1970-01-01 in the proleptic Gregorian calendar.
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// Parses an IMF-fixdate such as "Sun, 06 Nov 1994 08:49:37 GMT", the only date format HTTP
+// senders are allowed to generate.
+kj::Maybe<kj::Date> parseHttpDate(kj::StringPtr text) {
+  static constexpr kj::StringPtr MONTHS[] = {
+    "Jan"_kj, "Feb"_kj, "Mar"_kj, "Apr"_kj, "May"_kj, "Jun"_kj,
+    "Jul"_kj, "Aug"_kj, "Sep"_kj, "Oct"_kj, "Nov"_kj, "Dec"_kj,
+  };
+
+  if (text.size() != 29 || text[3] != ',' || text[4] != ' ' || text[7] != ' ' ||
+      text[11] != ' ' || text[16] != ' ' || text[19] != ':' || text[22] != ':' ||
+      !text.slice(25).startsWith(" GMT")) {
+    return kj::none;
+  }
+
+  auto number = [&](size_t start, size_t length) -> kj::Maybe<int64_t> {
+    int64_t result = 0;
+    for (char c: text.slice(start, start + length)) {
+      if (c < '0' || c > '9') return kj::none;
+      result = result * 10 + (c - '0');
+    }
+    return result;
+  };
+
+  int month = 0;
+  for (auto i: kj::indices(MONTHS)) {
+    if (MONTHS[i].asArray() == text.slice(8, 11)) month = i + 1;
+  }
+  if (month == 0) return kj::none;
+
+  auto day = KJ_UNWRAP_OR_RETURN(number(5, 2), kj::none);
+  auto year = KJ_UNWRAP_OR_RETURN(number(12, 4), kj::none);
+  auto hour = KJ_UNWRAP_OR_RETURN(number(17, 2), kj::none);
+  auto minute = KJ_UNWRAP_OR_RETURN(number(20, 2), kj::none);
+  auto second = KJ_UNWRAP_OR_RETURN(number(23, 2), kj::none);
+  if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) return kj::none;
+
+  int64_t seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+  return kj::UNIX_EPOCH + seconds * kj::SECONDS;
+}
+
+// Returns the value of the named header, which need not be registered in the header table.
+// Repeated headers are combined as a comma-separated list.
+kj::Maybe<kj::String> getHeaderByName(const kj::HttpHeaders& headers, kj::StringPtr lowerName) {
+  kj::Maybe<kj::String> result;
+  headers.forEach([&](kj::StringPtr name, kj::StringPtr value) {
+    if (toLower(name) == lowerName) {
+      KJ_IF_SOME(previous, result) {
+        result = kj::str(previous, ", ", value);
+      } else {
+        result = kj::str(value);
+      }
+    }
+  });
+  return result;
+}
+
+bool sameVariant(
+    kj::ArrayPtr<const kj::Maybe<kj::String>> a, kj::ArrayPtr<const kj::Maybe<kj::String>> b) {
+  if (a.size() != b.size()) return false;
+  for (auto i: kj::indices(a)) {
+    KJ_IF_SOME(x, a[i]) {
+      KJ_IF_SOME(y, b[i]) {
+        if (x != y) return false;
+      } else {
+        return false;
+      }
+    } else if (b[i] != kj::none) {
+      return false;
+    }
+  }
+  return true;
+}
+
+kj::Promise<void> discard(kj::AsyncInputStream& in) {
+  auto buffer = kj::heapArray<kj::byte>(READ_CHUNK_SIZE);
+  while (co_await in.tryRead(buffer.begin(), 1, buffer.size()) > 0) {
+  }
+}
+
+}  // namespace
+
+LocalCache::LocalCache(kj::HttpHeaderTable::Builder& headerTableBuilder,
+    const kj::Clock& clock,
+    kj::Maybe<kj::Own<const kj::Directory>> dirParam,
+    Options options)
+    : headerTable(headerTableBuilder.getFutureTable()),
+      cacheControl(headerTableBuilder.add("Cache-Control")),
+      expires(headerTableBuilder.add("Expires")),
+      date(headerTableBuilder.add("Date")),
+      vary(headerTableBuilder.add("Vary")),
+      age(headerTableBuilder.add("Age")),
+      cfCacheStatus(headerTableBuilder.add("CF-Cache-Status")),
+      cfCacheNamespace(headerTableBuilder.add("CF-Cache-Namespace")),
+      clock(clock),
+      parentDir(kj::mv(dirParam)),
+      options(options) {
+  KJ_IF_SOME(parent, parentDir) {
+    bodyDirName = newBodyDirName();
+
+    // Holding the lock while sweeping keeps other instances in this process from creating their
+    // subdirectories until we're done.
+    auto live = liveBodyDirs().lockExclusive();
+    for (auto& name: parent->listNames()) {
+      // Entries don't survive restarts, so anything that isn't in use is garbage from a previous
+      // run. Loose `.body` files come from versions that didn't use subdirectories. A subdirectory
+      // is only in use while its owner, possibly in another process, holds its lock.
+      if (name.endsWith(".body")) {
+        parent->tryRemove(kj::Path(kj::mv(name)));
+      } else if (name.endsWith(BODY_DIR_SUFFIX) && !live->contains(name)) {
+        KJ_IF_SOME(abandoned, parent->tryOpenSubdir(kj::Path(kj::str(name)))) {
+          if (lockIfAbandoned(*abandoned)) {
+            parent->tryRemove(kj::Path(kj::mv(name)));
+          }
+        }
+      }
+    }
+
+    // Lock our subdirectory before giving it its final name, so that no one ever sees it unlocked.
+    auto tmpName = kj::str(bodyDirName, ".tmp");
+    auto ownDir = parent->openSubdir(kj::Path(kj::str(tmpName)), kj::WriteMode::CREATE);
+    KJ_ASSERT(tryLockBodyDir(*ownDir));
+    parent->transfer(kj::Path(kj::str(bodyDirName)), kj::WriteMode::CREATE,
+        kj::Path(kj::mv(tmpName)), kj::TransferMode::MOVE);
+    dir = kj::mv(ownDir);
+    live->insert(kj::str(bodyDirName));
+  }
+}
+
+LocalCache::~LocalCache() noexcept(false) {
+  // Entries must be unlinked before they're destroyed. Their files go with the subdirectory.
+  while (!lru.empty()) {
+    lru.remove(lru.front());
+  }
+
+  KJ_IF_SOME(parent, parentDir) {
+    // Remove the subdirectory before closing it, which releases its lock.
+    auto live = liveBodyDirs().lockExclusive();
+    parent->tryRemove(kj::Path(kj::str(bodyDirName)));
+    dir = kj::none;
+    live->erase(bodyDirName);
+  }
+}
+
+kj::Promise<void> LocalCache::request(kj::HttpMethod method,
+    kj::StringPtr url,
+    const kj::HttpHeaders& headers,
+    kj::AsyncInputStream& requestBody,
+    Response& response) {
+  // The namespace is URI-encoded and the URL can't contain spaces, so this is unambiguous.
+  auto key = kj::str(headers.get(cfCacheNamespace).orDefault(""_kj), ' ', url);
+
+  switch (method) {
+    case kj::HttpMethod::GET:
+      return match(key, headers, response);
+    case kj::HttpMethod::PUT:
+      return put(kj::mv(key), headers, requestBody, response);
+    case kj::HttpMethod::PURGE:
+      return purge(key, response);
+    default:
+      return response.sendError(501, "Not Implemented", headerTable);
+  }
+}
+
+kj::Promise<void> LocalCache::put(kj::String key,
+    const kj::HttpHeaders& requestHeaders,
+    kj::AsyncInputStream& requestBody,
+    Response& response) {
+  auto totalLength = requestBody.tryGetLength();
+
+  // Read up to the end of the serialized response's header block.
+  auto buffer = kj::heapArray<char>(8192);
+  size_t filled = 0;
+  size_t headerSize = 0;
+  for (;;) {
+    if (filled == buffer.size()) {
+      if (buffer.size() >= MAX_HEADER_SIZE) {
+        co_await discard(requestBody);
+        co_return co_await response.sendError(413, "Payload Too Large", headerTable);
+      }
+      auto bigger = kj::heapArray<char>(buffer.size() * 2);
+      bigger.first(filled).copyFrom(buffer.first(filled));
+      buffer = kj::mv(bigger);
+    }
+
+    size_t n = co_await requestBody.tryRead(buffer.begin() + filled, 1, buffer.size() - filled);
+    if (n == 0) {
+      co_return co_await response.sendError(400, "Bad Request", headerTable);
+    }
+    size_t searchFrom = filled < 3 ? 0 : filled - 3;
+    filled += n;
+
+    auto end = buffer.first(filled).slice(searchFrom);
+    for (size_t i = 0; i + 4 <= end.size(); i++) {
+      if (end.slice(i, i + 4) == "\r\n\r\n"_kj.asArray()) {
+        headerSize = searchFrom + i + 4;
+        break;
+      }
+    }
+    if (headerSize > 0) break;
+  }
+
+  kj::HttpHeaders parsedHeaders(headerTable);
+  uint statusCode = 0;
+  kj::String statusText;
+  KJ_SWITCH_ONEOF(parsedHeaders.tryParseResponse(buffer.first(headerSize))) {
+    KJ_CASE_ONEOF(parsed, kj::HttpHeaders::Response) {
+      statusCode = parsed.statusCode;
+      statusText = kj::str(parsed.statusText);
+    }
+    KJ_CASE_ONEOF(error, kj::HttpHeaders::ProtocolError) {}
+  }
+  if (statusCode == 0) {
+    co_await discard(requestBody);
+    co_return co_await response.sendError(400, "Bad Request", headerTable);
+  }
+
+  // The parsed headers point into `buffer`, so take a copy we can keep. The framing headers
+  // describe the serialized payload, not the stored body.
+  auto responseHeaders = parsedHeaders.clone();
+  responseHeaders.unset(kj::HttpHeaderId::CONTENT_LENGTH);
+  responseHeaders.unset(kj::HttpHeaderId::TRANSFER_ENCODING);
+  auto leftover = buffer.slice(headerSize, filled).asBytes();
+
+  // Figure out how long the response stays fresh, if it may be stored at all.
+  auto now = clock.now();
+  auto cc = parseCacheControl(responseHeaders.get(cacheControl));
+  bool cacheable = !cc.noStore && !cc.noCache && !cc.isPrivate;
+  kj::Maybe<kj::Date> expiresAt;
+  KJ_IF_SOME(ttl, cc.sMaxAge.orDefault(cc.maxAge)) {
+    if (ttl > 0) {
+      expiresAt = now + ttl * kj::SECONDS;
+    } else {
+      cacheable = false;
+    }
+  } else KJ_IF_SOME(value, responseHeaders.get(expires)) {
+    // Per RFC 9111, an invalid Expires value means the response is already stale. We measure the
+    // lifetime against the response's own Date header, so clock skew doesn't matter.
+    KJ_IF_SOME(e, parseHttpDate(value)) {
+      kj::Date base = now;
+      KJ_IF_SOME(d, responseHeaders.get(date)) {
+        base = parseHttpDate(d).orDefault(now);
+      }
+      if (e > base) {
+        expiresAt = now + (e - base);
+      } else {
+        cacheable = false;
+      }
+    } else {
+      cacheable = false;
+    }
+  }
+
+  kj::Vector<kj::String> varyNames;
+  KJ_IF_SOME(value, responseHeaders.get(vary)) {
+    forEachListElement(value, [&](kj::ArrayPtr<const char> name) {
+      if (name == "*"_kj.asArray()) cacheable = false;
+      varyNames.add(toLower(name));
+    });
+  }
+
+  if (!cacheable) {
+    // Don't let an older response shadow the one that was just declined.
+    KJ_IF_SOME(existing, findVariant(key, requestHeaders)) {
+      remove(existing);
+    }
+    co_await discard(requestBody);
+    kj::HttpHeaders headers(headerTable);
+    response.send(204, "No Content", headers);
+    co_return;
+  }
+
+  kj::Maybe<uint64_t> bodySize;
+  KJ_IF_SOME(length, totalLength) {
+    if (length < filled) {
+      co_return co_await response.sendError(400, "Bad Request", headerTable);
+    }
+    bodySize = length - headerSize;
+  }
+  bool toDisk = false;
+  if (dir != kj::none) {
+    toDisk = bodySize.map([&](uint64_t size) {
+      return size > options.maxInMemoryBodySize;
+    }).orDefault(true);
+  }
+  uint64_t limit = kj::min(options.maxObjectSize, toDisk ? options.maxDisk : options.maxMemory);
+
+  auto entry =
+      kj::heap<Entry>(statusCode, kj::mv(statusText), kj::mv(responseHeaders), now, expiresAt);
+  entry->varyValues = KJ_MAP(name, varyNames) { return getHeaderByName(requestHeaders, name); };
+
+  bool tooLarge = bodySize.map([&](uint64_t size) { return size > limit; }).orDefault(false);
+  if (!tooLarge && toDisk) {
+    auto& d = KJ_ASSERT_NONNULL(dir);
+    auto name = kj::str(nextFileId++, ".body");
+    auto replacer = d->replaceFile(kj::Path(kj::str(name)), kj::WriteMode::CREATE);
+    auto& file = replacer->get();
+    file.write(0, leftover);
+    uint64_t offset = leftover.size();
+    auto chunk = kj::heapArray<kj::byte>(READ_CHUNK_SIZE);
+    for (;;) {
+      size_t n = co_await requestBody.tryRead(chunk.begin(), 1, chunk.size());
+      if (n == 0) break;
+      if (offset + n > limit) {
+        tooLarge = true;
+        break;
+      }
+      file.write(offset, chunk.first(n));
+      offset += n;
+    }
+    if (!tooLarge) {
+      replacer->commit();
+      entry->body = kj::mv(name);
+      entry->bodySize = offset;
+    }
+  } else if (!tooLarge) {
+    kj::Array<kj::byte> bytes;
+    KJ_IF_SOME(size, bodySize) {
+      // Known length: read straight into the final buffer.
+      bytes = kj::heapArray<kj::byte>(size);
+      bytes.first(leftover.size()).copyFrom(leftover);
+      co_await requestBody.read(bytes.begin() + leftover.size(), size - leftover.size());
+    } else {
+      kj::Vector<kj::byte> accumulated;
+      accumulated.addAll(leftover);
+      auto chunk = kj::heapArray<kj::byte>(READ_CHUNK_SIZE);
+      for (;;) {
+        size_t n = co_await requestBody.tryRead(chunk.begin(), 1, chunk.size());
+        if (n == 0) break;
+        if (accumulated.size() + n > limit) {
+          tooLarge = true;
+          break;
+        }
+        accumulated.addAll(chunk.first(n));
+      }
+      bytes = accumulated.releaseAsArray();
+    }
+    if (!tooLarge) {
+      entry->bodySize = bytes.size();
+      entry->body = kj::refcounted<MemoryBody>(kj::mv(bytes));
+    }
+  }
+
+  if (tooLarge) {
+    co_await discard(requestBody);
+    co_return co_await response.sendError(413, "Payload Too Large", headerTable);
+  }
+
+  insert(kj::mv(key), varyNames.releaseAsArray(), kj::mv(entry));
+  kj::HttpHeaders headers(headerTable);
+  response.send(204, "No Content", headers);
+}
+
+kj::Promise<void> LocalCache::match(
+    kj::StringPtr key, const kj::HttpHeaders& requestHeaders, Response& response) {
+  auto miss = [&]() {
+    kj::HttpHeaders headers(headerTable);
+    headers.set(cfCacheStatus, "MISS");
+    return response.sendError(504, "Gateway Timeout", headers);
+  };
+
+  auto& entry = KJ_UNWRAP_OR(findVariant(key, requestHeaders), return miss());
+
+  auto now = clock.now();
+  KJ_IF_SOME(e, entry.expiresAt) {
+    if (e <= now) {
+      remove(entry);
+      return miss();
+    }
+  }
+
+  // Grab what we need to stream the body before anything can evict the entry.
+  kj::OneOf<kj::Own<MemoryBody>, kj::Own<const kj::File>> source;
+  KJ_SWITCH_ONEOF(entry.body) {
+    KJ_CASE_ONEOF(memory, kj::Own<MemoryBody>) {
+      source = kj::addRef(*memory);
+    }
+    KJ_CASE_ONEOF(name, kj::String) {
+      KJ_IF_SOME(file, KJ_ASSERT_NONNULL(dir)->tryOpenFile(kj::Path(kj::str(name)))) {
+        source = kj::mv(file);
+      } else {
+        // Someone else removed the file out from under us.
+        remove(entry);
+        return miss();
+      }
+    }
+  }
+
+  lru.remove(entry);
+  lru.add(entry);
+
+  auto headers = entry.headers.clone();
+  headers.set(cfCacheStatus, "HIT");
+  headers.set(age, kj::str((now - entry.storedAt) / kj::SECONDS));
+  headers.set(kj::HttpHeaderId::CONTENT_LENGTH, kj::str(entry.bodySize));
+
+  uint statusCode = entry.statusCode;
+  kj::StringPtr statusText = entry.statusText;
+  uint64_t start = 0;
+  uint64_t size = entry.bodySize;
+  if (statusCode == 200) {
+    KJ_IF_SOME(header, requestHeaders.get(kj::HttpHeaderId::RANGE)) {
+      KJ_SWITCH_ONEOF(kj::tryParseHttpRangeHeader(header.asArray(), entry.bodySize)) {
+        KJ_CASE_ONEOF(ranges, kj::Array<kj::HttpByteRange>) {
+          // TODO(someday): consider supporting multiple ranges with multipart/byteranges
+          if (ranges.size() == 1) {
+            auto& r = ranges[0];
+            start = r.start;
+            size = r.end - r.start + 1;
+            statusCode = 206;
+            statusText = "Partial Content";
+            headers.set(kj::HttpHeaderId::CONTENT_LENGTH, kj::str(size));
+            headers.set(kj::HttpHeaderId::CONTENT_RANGE,
+                kj::str("bytes ", r.start, "-", r.end, "/", entry.bodySize));
+          }
+        }
+        KJ_CASE_ONEOF(_, kj::HttpEverythingRange) {}
+        KJ_CASE_ONEOF(_, kj::HttpUnsatisfiableRange) {
+          headers.set(kj::HttpHeaderId::CONTENT_RANGE, kj::str("bytes */", entry.bodySize));
+          return response.sendError(416, "Range Not Satisfiable", headers);
+        }
+      }
+    }
+  }
+
+  auto out = response.send(statusCode, statusText, headers, size);
+  KJ_SWITCH_ONEOF(source) {
+    KJ_CASE_ONEOF(memory, kj::Own<MemoryBody>) {
+      auto promise = out->write(memory->bytes.slice(start, start + size));
+      return promise.attach(kj::mv(out), kj::mv(memory));
+    }
+    KJ_CASE_ONEOF(file, kj::Own<const kj::File>) {
+      auto in = kj::heap<kj::FileInputStream>(*file, start);
+      auto promise = in->pumpTo(*out, size).ignoreResult();
+      return promise.attach(kj::mv(in), kj::mv(out), kj::mv(file));
+    }
+  }
+  KJ_UNREACHABLE;
+}
+
+kj::Promise<void> LocalCache::purge(kj::StringPtr key, Response& response) {
+  kj::HttpHeaders headers(headerTable);
+  KJ_IF_SOME(variants, entries.find(key)) {
+    removeAll(*variants);
+    response.send(200, "OK", headers, uint64_t(0));
+    return kj::READY_NOW;
+  } else {
+    return response.sendError(404, "Not Found", headers);
+  }
+}
+
+kj::Maybe<LocalCache::Entry&> LocalCache::findVariant(
+    kj::StringPtr key, const kj::HttpHeaders& requestHeaders) {
+  auto& variants = *KJ_UNWRAP_OR_RETURN(entries.find(key), kj::none);
+  auto values =
+      KJ_MAP(name, variants.varyNames) { return getHeaderByName(requestHeaders, name); };
+  for (auto& entry: variants.entries) {
+    if (sameVariant(entry->varyValues, values)) {
+      return *entry;
+    }
+  }
+  return kj::none;
+}
+
+void LocalCache::insert(kj::String key, kj::Array<kj::String> varyNames, kj::Own<Entry> entry) {
+  Variants* variantsPtr;
+  KJ_IF_SOME(existing, entries.find(key)) {
+    variantsPtr = existing;
+  } else {
+    auto created = kj::heap<Variants>();
+    created->key = kj::mv(key);
+    variantsPtr = created;
+    entries.insert(created->key, kj::mv(created));
+  }
+  auto& variants = *variantsPtr;
+
+  // The most recent response's Vary header governs how variants are selected, so variants stored
+  // under a different one can no longer be matched.
+  if (variants.varyNames.asPtr() != varyNames.asPtr()) {
+    for (auto& e: variants.entries) {
+      release(*e);
+    }
+    variants.entries.clear();
+    variants.varyNames = kj::mv(varyNames);
+  }
+
+  for (auto i: kj::indices(variants.entries)) {
+    if (sameVariant(variants.entries[i]->varyValues, entry->varyValues)) {
+      release(*variants.entries[i]);
+      if (i != variants.entries.size() - 1) {
+        variants.entries[i] = kj::mv(variants.entries.back());
+      }
+      variants.entries.removeLast();
+      break;
+    }
+  }
+
+  entry->variants = &variants;
+  if (entry->body.is<kj::Own<MemoryBody>>()) {
+    memoryUsed += entry->bodySize;
+  } else {
+    diskUsed += entry->bodySize;
+  }
+  lru.add(*entry);
+  variants.entries.add(kj::mv(entry));
+
+  evict();
+}
+
+void LocalCache::release(Entry& entry) {
+  lru.remove(entry);
+  KJ_SWITCH_ONEOF(entry.body) {
+    KJ_CASE_ONEOF(memory, kj::Own<MemoryBody>) {
+      memoryUsed -= entry.bodySize;
+    }
+    KJ_CASE_ONEOF(name, kj::String) {
+      diskUsed -= entry.bodySize;
+      // Readers that already opened the file keep streaming from it.
+      KJ_ASSERT_NONNULL(dir)->tryRemove(kj::Path(kj::str(name)));
+    }
+  }
+}
+
+void LocalCache::remove(Entry& entry) {
+  release(entry);
+  auto& variants = *entry.variants;
+  for (auto i: kj::indices(variants.entries)) {
+    if (variants.entries[i].get() == &entry) {
+      if (i != variants.entries.size() - 1) {
+        variants.entries[i] = kj::mv(variants.entries.back());
+      }
+      variants.entries.removeLast();
+      break;
+    }
+  }
+  if (variants.entries.empty()) {
+    // Erasing destroys `variants`, including the key, so look it up by a copy.
+    entries.erase(kj::str(variants.key));
+  }
+}
+
+void LocalCache::removeAll(Variants& variants) {
+  for (auto& e: variants.entries) {
+    release(*e);
+  }
+  entries.erase(kj::str(variants.key));
+}
+
+void LocalCache::evict() {
+  while (memoryUsed > options.maxMemory || diskUsed > options.maxDisk) {
+    bool wantMemory = memoryUsed > options.maxMemory;
+    for (auto& entry: lru) {
+      if (entry.body.is<kj::Own<MemoryBody>>() == wantMemory) {
+        remove(entry);
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace workerd::server
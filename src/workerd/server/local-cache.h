@@ -0,0 +1,175 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#pragma once
+
+#include <kj/compat/http.h>
+#include <kj/filesystem.h>
+#include <kj/list.h>
+#include <kj/map.h>
+#include <kj/one-of.h>
+#include <kj/time.h>
+#include <kj/vector.h>
+
+namespace workerd::server {
+
+using kj::uint;
+
+// An in-process backend for the Cache API (`caches.default` and `caches.open()`), speaking the
+// same HTTP protocol that api/cache.c++ speaks to an external cache:
+//
+// * `PUT <url>` stores the serialized HTTP response carried in the request body. The request's
+//   own headers are those of the original request, which are needed to honor `Vary`. Responds
+//   204 on success (including when the response is simply not cacheable) or 413 if it is too big.
+// * `GET <url>` responds with the stored response and `CF-Cache-Status: HIT`, or with a 504 and
+//   `CF-Cache-Status: MISS`. A single-range `Range` header produces a 206 from the stored body.
+// * `PURGE <url>` removes all stored variants, responding 200 if there were any, 404 otherwise.
+//
+// The `CF-Cache-Namespace` header, set by `caches.open()`, selects a separate namespace.
+//
+// Freshness is computed when storing from the response's `Cache-Control` (`s-maxage`, then
+// `max-age`) or `Expires` header. Responses marked `no-store`, `no-cache` or `private`, already
+// stale, or carrying `Vary: *` are not stored. Responses with no freshness information are kept
+// until evicted.
+//
+// Bodies are held in memory unless a directory is given, in which case bodies larger than
+// `maxInMemoryBodySize` (or of unknown length) are spilled to files there. Both tiers are bounded,
+// evicting the least recently used entries first. Bodies are streamed to the client straight from
+// the stored buffer or file, without copying them into an intermediate buffer first.
+//
+// The cache itself is not persistent. Each instance keeps its files in its own subdirectory of
+// the given directory, so that several instances (e.g. one per thread, or several processes) can
+// share it, and removes that subdirectory when destroyed. While in use, the subdirectory is
+// locked with flock(). At startup, subdirectories whose lock isn't held are left over from a
+// previous run, and are removed. (On Windows there's no lock yet, so only those left behind
+// within the same process are removed.)
+//
+// File bodies are written and removed with synchronous filesystem calls on the event loop thread.
+// That is fine for local development, which is what this is for, but it means a slow disk stalls
+// every request served by the same thread.
+class LocalCache final: public kj::HttpService {
+ public:
+  struct Options {
+    uint64_t maxMemory = 64ull << 20;
+    uint64_t maxDisk = 1ull << 30;
+    uint64_t maxObjectSize = 512ull << 20;
+    uint64_t maxInMemoryBodySize = 1ull << 20;
+  };
+
+  LocalCache(kj::HttpHeaderTable::Builder& headerTableBuilder,
+      const kj::Clock& clock,
+      kj::Maybe<kj::Own<const kj::Directory>> dir,
+      Options options);
+  ~LocalCache() noexcept(false);
+  KJ_DISALLOW_COPY_AND_MOVE(LocalCache);
+
+  kj::Promise<void> request(kj::HttpMethod method,
+      kj::StringPtr url,
+      const kj::HttpHeaders& headers,
+      kj::AsyncInputStream& requestBody,
+      Response& response) override;
+
+ private:
+  struct MemoryBody: public kj::Refcounted {
+    explicit MemoryBody(kj::Array<kj::byte> bytes): bytes(kj::mv(bytes)) {}
+    kj::Array<kj::byte> bytes;
+  };
+
+  struct Variants;
+
+  struct Entry {
+    Entry(uint statusCode,
+        kj::String statusText,
+        kj::HttpHeaders headers,
+        kj::Date storedAt,
+        kj::Maybe<kj::Date> expiresAt)
+        : statusCode(statusCode),
+          statusText(kj::mv(statusText)),
+          headers(kj::mv(headers)),
+          storedAt(storedAt),
+          expiresAt(expiresAt) {}
+
+    // Set by insert().
+    Variants* variants = nullptr;
+
+    // Values of the request headers listed in `variants.varyNames`, in the same order.
+    kj::Array<kj::Maybe<kj::String>> varyValues;
+
+    uint statusCode;
+    kj::String statusText;
+    kj::HttpHeaders headers;
+
+    // The body is either in memory or in a file in `dir` with the given name.
+    kj::OneOf<kj::Own<MemoryBody>, kj::String> body;
+    uint64_t bodySize = 0;
+
+    kj::Date storedAt;
+    kj::Maybe<kj::Date> expiresAt;
+
+    kj::ListLink<Entry> lruLink;
+  };
+
+  // All variants stored under a single namespace and URL.
+  struct Variants {
+    kj::String key;
+
+    // Lower-cased names of the request headers listed in the stored responses' `Vary` header.
+    kj::Array<kj::String> varyNames;
+
+    kj::Vector<kj::Own<Entry>> entries;
+  };
+
+  kj::HttpHeaderTable& headerTable;
+  kj::HttpHeaderId cacheControl;
+  kj::HttpHeaderId expires;
+  kj::HttpHeaderId date;
+  kj::HttpHeaderId vary;
+  kj::HttpHeaderId age;
+  kj::HttpHeaderId cfCacheStatus;
+  kj::HttpHeaderId cfCacheNamespace;
+
+  const kj::Clock& clock;
+
+  // The directory given at construction, and this instance's subdirectory of it, named
+  // `bodyDirName`, which holds the files.
+  kj::Maybe<kj::Own<const kj::Directory>> parentDir;
+  kj::String bodyDirName;
+  kj::Maybe<kj::Own<const kj::Directory>> dir;
+  Options options;
+
+  kj::HashMap<kj::StringPtr, kj::Own<Variants>> entries;
+
+  // Least recently used first.
+  kj::List<Entry, &Entry::lruLink> lru;
+
+  uint64_t memoryUsed = 0;
+  uint64_t diskUsed = 0;
+  uint64_t nextFileId = 0;
+
+  kj::Promise<void> put(kj::String key,
+      const kj::HttpHeaders& requestHeaders,
+      kj::AsyncInputStream& requestBody,
+      Response& response);
+  kj::Promise<void> match(
+      kj::StringPtr key, const kj::HttpHeaders& requestHeaders, Response& response);
+  kj::Promise<void> purge(kj::StringPtr key, Response& response);
+
+  kj::Maybe<Entry&> findVariant(kj::StringPtr key, const kj::HttpHeaders& requestHeaders);
+
+  // Links a new entry into the cache, replacing any existing entry for the same variant, then
+  // evicts entries as needed to stay within limits.
+  void insert(kj::String key, kj::Array<kj::String> varyNames, kj::Own<Entry> entry);
+
+  // Unlinks the entry from the LRU list and frees its body, without removing it from its
+  // Variants.
+  void release(Entry& entry);
+
+  // Releases and destroys the entry, and its Variants if it was the last one.
+  void remove(Entry& entry);
+  void removeAll(Variants& variants);
+
+  void evict();
+};
+
+}  // namespace workerd::server
@@ -3345,6 +3345,56 @@ KJ_TEST("Server: external server") {
   conn.recvHttp200("OK");
 }
 
+KJ_TEST("Server: external server connection limit") {
+  TestServer test(R"((
+    services = [
+      (name = "hello", external = (
+        address = "ext-addr",
+        http = (),
+        connectionPool = (maxConnections = 1)
+      ))
+    ],
+    sockets = [
+      (name = "main", address = "test-addr", service = "hello")
+    ]
+  ))"_kj);
+
+  test.start();
+
+  auto conn1 = test.connect("test-addr");
+  auto conn2 = test.connect("test-addr");
+  conn1.sendHttpGet("/a");
+  conn2.sendHttpGet("/b");
+
+  // Both requests arrive on a single connection, the second only once the first has finished.
+  auto subreq = test.receiveSubrequest("ext-addr");
+  subreq.recv(R"(
+    GET /a HTTP/1.1
+    Host: foo
+
+  )"_blockquote);
+  subreq.send(R"(
+    HTTP/1.1 200 OK
+    Content-Length: 1
+    Content-Type: text/plain;charset=UTF-8
+
+    a)"_blockquote);
+  conn1.recvHttp200("a");
+
+  subreq.recv(R"(
+    GET /b HTTP/1.1
+    Host: foo
+
+  )"_blockquote);
+  subreq.send(R"(
+    HTTP/1.1 200 OK
+    Content-Length: 1
+    Content-Type: text/plain;charset=UTF-8
+
+    b)"_blockquote);
+  conn2.recvHttp200("b");
+}
+
 KJ_TEST("Server: external server proxy style") {
   TestServer test(R"((
     services = [
@@ -5,6 +5,7 @@
 #include "server.h"
 
 #include "container-client.h"
+#include "local-cache.h"
 #include "pyodide.h"
 #include "workerd-api.h"
 
@@ -667,26 +668,43 @@ class Server::ExternalTcpService final: public Service, private WorkerInterface
 // Service used when the service is configured as external HTTP service.
 class Server::ExternalHttpService final: public Service {
  public:
+  // Connection reuse settings; see `ExternalServer.ConnectionPool` in workerd.capnp.
+  struct PoolOptions {
+    kj::Duration idleTimeout = 5 * kj::SECONDS;
+    kj::Maybe<uint> maxConnections;
+    kj::Maybe<kj::Duration> capnpIdleTimeout;
+  };
+
   ExternalHttpService(kj::Own<kj::NetworkAddress> addrParam,
       kj::Own<HttpRewriter> rewriter,
       kj::HttpHeaderTable& headerTable,
       kj::Timer& timer,
       kj::EntropySource& entropySource,
       capnp::ByteStreamFactory& byteStreamFactory,
-      capnp::HttpOverCapnpFactory& httpOverCapnpFactory)
+      capnp::HttpOverCapnpFactory& httpOverCapnpFactory,
+      PoolOptions poolOptions)
       : addr(kj::mv(addrParam)),
         webSocketErrorHandler(kj::heap<JsgifyWebSocketErrors>()),
         inner(kj::newHttpClient(timer,
             headerTable,
             *addr,
-            {.entropySource = entropySource,
+            {.idleTimeout = poolOptions.idleTimeout,
+              .entropySource = entropySource,
               .webSocketCompressionMode = kj::HttpClientSettings::MANUAL_COMPRESSION,
               .webSocketErrorHandler = *webSocketErrorHandler})),
-        serviceAdapter(kj::newHttpService(*inner)),
+        limitedInner(poolOptions.maxConnections.map([&](uint max) {
+          return kj::newConcurrencyLimitingHttpClient(*inner, max, [](uint running, uint pending) {
+            TRACE_COUNTER("workerd", "ExternalHttpService running requests", running);
+            TRACE_COUNTER("workerd", "ExternalHttpService pending requests", pending);
+          });
+        })),
+        serviceAdapter(kj::newHttpService(getHttpClient())),
         rewriter(kj::mv(rewriter)),
         headerTable(headerTable),
+        timer(timer),
         byteStreamFactory(byteStreamFactory),
-        httpOverCapnpFactory(httpOverCapnpFactory) {}
+        httpOverCapnpFactory(httpOverCapnpFactory),
+        capnpIdleTimeout(poolOptions.capnpIdleTimeout) {}
 
   kj::Own<WorkerInterface> startRequest(IoChannelFactory::SubrequestMetadata metadata) override {
     return kj::heap<WorkerInterfaceImpl>(*this, kj::mv(metadata));
@@ -700,15 +718,30 @@ class Server::ExternalHttpService final: public Service {
   kj::Own<kj::NetworkAddress> addr;
 
   kj::Own<JsgifyWebSocketErrors> webSocketErrorHandler;
+
+  // Pools connections to `addr`, closing them after the idle timeout.
   kj::Own<kj::HttpClient> inner;
+
+  // Wraps `inner` when `maxConnections` is set, queueing requests beyond the limit.
+  kj::Maybe<kj::Own<kj::HttpClient>> limitedInner;
+
   kj::Own<kj::HttpService> serviceAdapter;
 
   kj::Own<HttpRewriter> rewriter;
 
   kj::HttpHeaderTable& headerTable;
+  kj::Timer& timer;
   capnp::ByteStreamFactory& byteStreamFactory;
   capnp::HttpOverCapnpFactory& httpOverCapnpFactory;
 
+  kj::HttpClient& getHttpClient() {
+    KJ_IF_SOME(l, limitedInner) {
+      return *l;
+    } else {
+      return *inner;
+    }
+  }
+
   struct CapnpClient {
     kj::Own<kj::AsyncIoStream> connection;
     capnp::TwoPartyClient rpcSystem;
@@ -724,6 +757,15 @@ class Server::ExternalHttpService final: public Service {
   // This task nulls out `capnpClient` when the connection is lost.
   kj::Promise<void> clearCapnpClientTask = nullptr;
 
+  // If set, `capnpClient` is dropped once no events have used it for this long.
+  kj::Maybe<kj::Duration> capnpIdleTimeout;
+
+  // Number of events currently being delivered over `capnpClient`.
+  uint capnpEventsInFlight = 0;
+
+  // Runs while `capnpClient` is idle; drops it when the idle timeout expires.
+  kj::Promise<void> capnpIdleTask = nullptr;
+
   // Get an WorkerdBootstrap representing the service on the other end of an HTTP connection. May
   // reuse an existing connection, or form a new one over `client`.
   rpc::WorkerdBootstrap::Client getOutgoingCapnp(kj::HttpClient& client) {
@@ -739,9 +781,8 @@ class Server::ExternalHttpService final: public Service {
     auto& c = capnpClient.emplace(kj::mv(req.connection));
 
     // Arrange that when the connection is lost, we'll null out `capnpClient`. This ensures that
-    // on the next event, we'll attempt to reconnect.
-    //
-    // TODO(perf): Time out idle connections?
+    // on the next event, we'll attempt to reconnect. Idle connections are closed separately, by
+    // `capnpIdleTask`.
     clearCapnpClientTask =
         c.rpcSystem.onDisconnect().attach(kj::defer([this]() {
       capnpClient = kj::none;
@@ -750,6 +791,23 @@ class Server::ExternalHttpService final: public Service {
     return c.rpcSystem.bootstrap().castAs<rpc::WorkerdBootstrap>();
   }
 
+  // Marks an event as using `capnpClient` until the returned object is dropped, so that the
+  // connection isn't closed as idle underneath it.
+  kj::Own<void> trackCapnpEvent() {
+    ++capnpEventsInFlight;
+    capnpIdleTask = nullptr;
+    return kj::heap(kj::defer([this]() {
+      if (--capnpEventsInFlight > 0) return;
+      KJ_IF_SOME(timeout, capnpIdleTimeout) {
+        capnpIdleTask = timer.afterDelay(timeout).then([this]() {
+          // Stop watching for disconnect before destroying the client being watched.
+          clearCapnpClientTask = nullptr;
+          capnpClient = kj::none;
+        }).eagerlyEvaluate(nullptr);
+      }
+    }));
+  }
+
   class WorkerInterfaceImpl final: public WorkerInterface, private kj::HttpService::Response {
    public:
     WorkerInterfaceImpl(ExternalHttpService& parent, IoChannelFactory::SubrequestMetadata metadata)
@@ -793,13 +851,15 @@ class Server::ExternalHttpService final: public Service {
     }
 
     kj::Promise<CustomEvent::Result> customEvent(kj::Own<CustomEvent> event) override {
-      // We'll use capnp RPC for custom events.
+      // We'll use capnp RPC for custom events. The RPC connection is formed over the pool
+      // directly rather than through the concurrency limit, since it is long-lived and carries
+      // any number of events at once.
       auto bootstrap = parent->getOutgoingCapnp(*parent->inner);
       auto dispatcher =
           bootstrap.startEventRequest(capnp::MessageSize{4, 0}).send().getDispatcher();
       return event
           ->sendRpc(parent->httpOverCapnpFactory, parent->byteStreamFactory, kj::mv(dispatcher))
-          .attach(kj::mv(event));
+          .attach(kj::mv(event), parent->trackCapnpEvent());
     }
 
    private:
@@ -859,6 +919,17 @@ kj::Own<Server::Service> Server::makeExternalService(kj::StringPtr name,
     return makeInvalidConfigService();
   }
 
+  auto poolConf = conf.getConnectionPool();
+  ExternalHttpService::PoolOptions poolOptions{
+    .idleTimeout = poolConf.getIdleTimeoutMs() * kj::MILLISECONDS,
+  };
+  if (poolConf.getMaxConnections() > 0) {
+    poolOptions.maxConnections = poolConf.getMaxConnections();
+  }
+  if (poolConf.getCapnpIdleTimeoutMs() > 0) {
+    poolOptions.capnpIdleTimeout = poolConf.getCapnpIdleTimeoutMs() * kj::MILLISECONDS;
+  }
+
   switch (conf.which()) {
     case config::ExternalServer::HTTP: {
       // We have to construct the rewriter upfront before waiting on any promises, since the
@@ -867,7 +938,7 @@ kj::Own<Server::Service> Server::makeExternalService(kj::StringPtr name,
       auto addr = kj::heap<PromisedNetworkAddress>(network.parseAddress(addrStr, 80));
       return kj::refcounted<ExternalHttpService>(kj::mv(addr), kj::mv(rewriter),
           headerTableBuilder.getFutureTable(), timer, entropySource,
-          globalContext->byteStreamFactory, globalContext->httpOverCapnpFactory);
+          globalContext->byteStreamFactory, globalContext->httpOverCapnpFactory, poolOptions);
     }
     case config::ExternalServer::HTTPS: {
       auto httpsConf = conf.getHttps();
@@ -880,7 +951,7 @@ kj::Own<Server::Service> Server::makeExternalService(kj::StringPtr name,
           makeTlsNetworkAddress(httpsConf.getTlsOptions(), addrStr, certificateHost, 443));
       return kj::refcounted<ExternalHttpService>(kj::mv(addr), kj::mv(rewriter),
           headerTableBuilder.getFutureTable(), timer, entropySource,
-          globalContext->byteStreamFactory, globalContext->httpOverCapnpFactory);
+          globalContext->byteStreamFactory, globalContext->httpOverCapnpFactory, poolOptions);
     }
     case config::ExternalServer::TCP: {
       auto tcpConf = conf.getTcp();
@@ -1297,6 +1368,87 @@ kj::Own<Server::Service> Server::makeDiskDirectoryService(kj::StringPtr name,
 
 // =======================================================================================
 
+// Service used when the service is configured as a local cache.
+class Server::LocalCacheService final: public Service, private WorkerInterface {
+ public:
+  LocalCacheService(kj::Maybe<kj::Own<const kj::Directory>> dir,
+      LocalCache::Options options,
+      kj::HttpHeaderTable::Builder& headerTableBuilder)
+      : cache(headerTableBuilder, kj::systemCoarseCalendarClock(), kj::mv(dir), options) {}
+
+  kj::Own<WorkerInterface> startRequest(IoChannelFactory::SubrequestMetadata metadata) override {
+    return {this, kj::NullDisposer::instance};
+  }
+
+  bool hasHandler(kj::StringPtr handlerName) override {
+    return handlerName == "fetch"_kj;
+  }
+
+ private:
+  LocalCache cache;
+
+  kj::Promise<void> request(kj::HttpMethod method,
+      kj::StringPtr url,
+      const kj::HttpHeaders& headers,
+      kj::AsyncInputStream& requestBody,
+      kj::HttpService::Response& response) override {
+    TRACE_EVENT("workerd", "LocalCacheService::request()", "url", url.cStr());
+    return cache.request(method, url, headers, requestBody, response);
+  }
+
+  kj::Promise<void> connect(kj::StringPtr host,
+      const kj::HttpHeaders& headers,
+      kj::AsyncIoStream& connection,
+      kj::HttpService::ConnectResponse& response,
+      kj::HttpConnectSettings settings) override {
+    throwUnsupported();
+  }
+  kj::Promise<void> prewarm(kj::StringPtr url) override {
+    return kj::READY_NOW;
+  }
+  kj::Promise<ScheduledResult> runScheduled(kj::Date scheduledTime, kj::StringPtr cron) override {
+    throwUnsupported();
+  }
+  kj::Promise<AlarmResult> runAlarm(kj::Date scheduledTime, uint32_t retryCount) override {
+    throwUnsupported();
+  }
+  kj::Promise<CustomEvent::Result> customEvent(kj::Own<CustomEvent> event) override {
+    return event->notSupported();
+  }
+
+  [[noreturn]] void throwUnsupported() {
+    JSG_FAIL_REQUIRE(Error, "Local cache services don't support this event type.");
+  }
+};
+
+kj::Own<Server::Service> Server::makeLocalCacheService(kj::StringPtr name,
+    config::LocalCache::Reader conf,
+    kj::HttpHeaderTable::Builder& headerTableBuilder) {
+  TRACE_EVENT("workerd", "Server::makeLocalCacheService()");
+
+  LocalCache::Options options{
+    .maxMemory = conf.getMaxMemory(),
+    .maxDisk = conf.getMaxDisk(),
+    .maxObjectSize = conf.getMaxObjectSize(),
+    .maxInMemoryBodySize = conf.getMaxInMemoryBodySize(),
+  };
+
+  kj::Maybe<kj::Own<const kj::Directory>> dir;
+  if (conf.hasPath()) {
+    auto pathStr = conf.getPath();
+    auto path = fs.getCurrentPath().evalNative(pathStr);
+    auto mode = kj::WriteMode::CREATE | kj::WriteMode::MODIFY | kj::WriteMode::CREATE_PARENT;
+    dir = KJ_UNWRAP_OR(fs.getRoot().tryOpenSubdir(kj::mv(path), mode), {
+      reportConfigError(kj::str("Local cache \"", name, "\" couldn't open directory: ", pathStr));
+      return makeInvalidConfigService();
+    });
+  }
+
+  return kj::refcounted<LocalCacheService>(kj::mv(dir), options, headerTableBuilder);
+}
+
+// =======================================================================================
+
 // This class exists to update the InspectorService's table of isolates when a config
 // has multiple services. The InspectorService exists on the stack of its own thread and
 // initializes state that is bound to the thread, e.g. a http server and an event loop.
@@ -4345,6 +4497,9 @@ kj::Promise<kj::Own<Server::Service>> Server::makeService(config::Service::Reade
 
     case config::Service::DISK:
       co_return makeDiskDirectoryService(name, conf.getDisk(), headerTableBuilder);
+
+    case config::Service::LOCAL_CACHE:
+      co_return makeLocalCacheService(name, conf.getLocalCache(), headerTableBuilder);
   }
 
   reportConfigError(kj::str("Service named \"", name,
@@ -221,6 +221,9 @@ class Server final: private kj::TaskSet::ErrorHandler {
   kj::Own<Service> makeDiskDirectoryService(kj::StringPtr name,
       config::DiskDirectory::Reader conf,
       kj::HttpHeaderTable::Builder& headerTableBuilder);
+  kj::Own<Service> makeLocalCacheService(kj::StringPtr name,
+      config::LocalCache::Reader conf,
+      kj::HttpHeaderTable::Builder& headerTableBuilder);
   kj::Promise<kj::Own<Service>> makeWorker(kj::StringPtr name,
       config::Worker::Reader conf,
       capnp::List<config::Extension>::Reader extensions);
@@ -253,6 +256,7 @@ class Server final: private kj::TaskSet::ErrorHandler {
   class ExternalTcpService;
   class NetworkService;
   class DiskDirectoryService;
+  class LocalCacheService;
   class WorkerService;
   class WorkerEntrypointService;
   class HttpListener;
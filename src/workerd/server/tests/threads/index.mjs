@@ -0,0 +1,10 @@
+// Each serving thread has its own isolate, and so its own copy of this module. Random values
+// can't be generated at global scope, so the ID is picked on the first request.
+let isolateId = null;
+
+export default {
+  async fetch(request, env, ctx) {
+    isolateId ??= crypto.randomUUID();
+    return new Response(isolateId);
+  },
+};
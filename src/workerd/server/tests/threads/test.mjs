@@ -0,0 +1,73 @@
+/*
+This is a node.js script which runs `workerd serve` with `threads` greater than 1. It checks that
+connections accepted by the main thread are spread across the serving threads, and that the
+process still shuts down cleanly on SIGTERM.
+*/
+
+import { env } from 'node:process';
+import { request } from 'node:http';
+import { test } from 'node:test';
+import assert from 'node:assert';
+import { WorkerdServerHarness } from '../server-harness.mjs';
+
+assert.notStrictEqual(
+  env.WORKERD_BINARY,
+  undefined,
+  'You must set the WORKERD_BINARY environment variable.'
+);
+assert.notStrictEqual(
+  env.WORKERD_CONFIG,
+  undefined,
+  'You must set the WORKERD_CONFIG environment variable.'
+);
+
+// Must match `threads` in the config.
+const THREAD_COUNT = 4;
+
+// Makes a GET request over a fresh connection and returns the response body.
+function get(port) {
+  return new Promise((resolve, reject) => {
+    const req = request({ host: 'localhost', port, agent: false }, (res) => {
+      let body = '';
+      res.setEncoding('utf8');
+      res.on('data', (chunk) => (body += chunk));
+      res.on('end', () => {
+        assert.strictEqual(res.statusCode, 200);
+        resolve(body);
+      });
+      res.on('error', reject);
+    });
+    req.on('error', reject);
+    req.end();
+  });
+}
+
+test('connections are served by every thread', async () => {
+  const workerd = new WorkerdServerHarness({
+    workerdBinary: env.WORKERD_BINARY,
+    workerdConfig: env.WORKERD_CONFIG,
+
+    // Hard-coded to match a socket name expected in the `workerdConfig` file.
+    listenPortNames: ['http'],
+  });
+
+  await workerd.start();
+  const httpPort = await workerd.getListenPort('http');
+
+  // Connections are handed off round-robin, so consecutive connections each land on a different
+  // thread, and thus a different isolate.
+  const ids = new Set();
+  for (let i = 0; i < THREAD_COUNT; ++i) {
+    ids.add(await get(httpPort));
+  }
+  assert.strictEqual(ids.size, THREAD_COUNT);
+
+  // The next round reuses the same isolates.
+  for (let i = 0; i < THREAD_COUNT; ++i) {
+    assert(ids.has(await get(httpPort)));
+  }
+
+  const [code, signal] = await workerd.stop();
+  assert(code === 0 || signal === 'SIGTERM', `code=${code}, signal=${signal}`);
+});
+
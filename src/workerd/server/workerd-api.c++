@@ -627,9 +627,8 @@ kj::Maybe<jsg::ModuleRegistry::ModuleInfo> WorkerdApi::tryCompileModule(jsg::Loc
           jsg::ModuleRegistry::JsonModuleInfo(lock, Impl::compileJsonGlobal(lock, content.body)));
     }
     KJ_CASE_ONEOF(content, Worker::Script::EsModule) {
-      // TODO(soon): Make sure passing nullptr to compile cache is desired.
       return jsg::ModuleRegistry::ModuleInfo(lock, module.name, content.body,
-          nullptr /* compile cache */, jsg::ModuleInfoCompileOption::BUNDLE, observer);
+          content.compileCache, jsg::ModuleInfoCompileOption::BUNDLE, observer);
     }
     KJ_CASE_ONEOF(content, Worker::Script::CommonJsModule) {
       return jsg::ModuleRegistry::ModuleInfo(lock, module.name, content.namedExports,
@@ -665,7 +664,8 @@ Worker::Script::Module WorkerdApi::readModuleConf(config::Worker::Module::Reader
       case config::Worker::Module::JSON:
         return Worker::Script::JsonModule{conf.getJson()};
       case config::Worker::Module::ES_MODULE:
-        return Worker::Script::EsModule{conf.getEsModule()};
+        return Worker::Script::EsModule{
+          .body = conf.getEsModule(), .compileCache = conf.getCompileCache()};
       case config::Worker::Module::COMMON_JS_MODULE: {
         Worker::Script::CommonJsModule result{.body = conf.getCommonJsModule()};
         if (conf.hasNamedExports()) {
@@ -1112,7 +1112,7 @@ kj::Own<jsg::modules::ModuleRegistry> WorkerdApi::initializeBundleModuleRegistry
           // module registry. We can safely pass a reference to the module handler.
           // It will not be copied into a JS string until the module is actually
           // evaluated.
-          bundleBuilder.addEsmModule(def.name, content.body, flags);
+          bundleBuilder.addEsmModule(def.name, content.body, flags, content.compileCache);
           break;
         }
         KJ_CASE_ONEOF(content, Worker::Script::TextModule) {
@@ -8,6 +8,9 @@
 #include <workerd/io/compatibility-date.capnp.h>
 #include <workerd/io/compatibility-date.h>
 #include <workerd/io/supported-compatibility-date.capnp.h>
+#include <workerd/jsg/compile-cache.h>
+#include <workerd/jsg/jsg.h>
+#include <workerd/jsg/modules.h>
 #include <workerd/jsg/setup.h>
 #include <workerd/rust/cxx-integration/lib.rs.h>
 #include <workerd/server/json-logger.h>
@@ -15,6 +18,7 @@
 #include <workerd/server/workerd-meta.capnp.h>
 #include <workerd/server/workerd.capnp.h>
 #include <workerd/util/autogate.h>
+#include <workerd/util/stdio-log-sink.h>
 
 #include <fcntl.h>
 #include <openssl/rand.h>
@@ -29,6 +33,8 @@
 #include <kj/filesystem.h>
 #include <kj/main.h>
 #include <kj/map.h>
+#include <kj/mutex.h>
+#include <kj/thread.h>
 
 #if _WIN32
 #include <windows.h>
@@ -523,6 +529,18 @@ kj::Maybe<kj::Own<capnp::SchemaFile>> tryImportBulitin(kj::StringPtr name) {
 
 // =======================================================================================
 
+// A bare global scope for generating code caches with `workerd compile --code-cache`. Compiling a
+// module (as opposed to evaluating it) doesn't depend on anything in the global scope, so no APIs
+// are needed here.
+class CodeCacheGlobalScope: public jsg::Object, public jsg::ContextGlobal {
+ public:
+  JSG_RESOURCE_TYPE(CodeCacheGlobalScope) {}
+};
+
+JSG_DECLARE_ISOLATE_TYPE(CodeCacheIsolate, CodeCacheGlobalScope);
+
+// =======================================================================================
+
 // A kj::Network implementation which wraps some other network and optionally (if enabled)
 // implements "loopback:" network addresses, which are expected to be serviced within the same
 // process. Loopback addresses are enabled only when running `workerd test`. The purpose is to
@@ -646,6 +664,262 @@ class NetworkWithLoopback final: public kj::Network {
 
 // =======================================================================================
 
+// Server options given on the command line which must also be applied to each additional server
+// started for `Config.threads`. Options with process-wide side effects (the inspector, the control
+// FD, Python snapshot creation) intentionally only apply to the main thread's server.
+struct ReplicatedServerOptions {
+  struct NamedOverride {
+    kj::String name;
+    kj::String value;
+  };
+
+  bool experimental = false;
+  kj::Vector<NamedOverride> directoryOverrides;
+  kj::Vector<NamedOverride> externalOverrides;
+
+  void applyTo(Server& server) const {
+    if (experimental) {
+      server.allowExperimental();
+    }
+    for (auto& override: directoryOverrides) {
+      server.overrideDirectory(kj::str(override.name), kj::str(override.value));
+    }
+    for (auto& override: externalOverrides) {
+      server.overrideExternal(kj::str(override.name), kj::str(override.value));
+    }
+  }
+};
+
+#if !_WIN32
+
+// Implements `Config.threads`: runs additional copies of the server, each on its own thread with
+// its own event loop, ThreadContext, and isolates.
+//
+// Sockets are bound only once, on the main thread. The main thread's accept loop (see
+// `DistributingReceiver`) hands accepted connections off round-robin to the serving threads,
+// including itself. This preserves all of KJ's address semantics (wildcards, names resolving to
+// multiple addresses, Unix sockets, inherited FDs). The downside is that new connections are only
+// accepted while the main thread's event loop is responsive; connections that were already handed
+// off are unaffected.
+class ServeThreadPool {
+ public:
+  ServeThreadPool(uint threadCount,
+      jsg::V8System& v8System,
+      config::Config::Reader config,
+      const ReplicatedServerOptions& options)
+      : states(kj::heapArray<ThreadState>(threadCount)),
+        ready(0) {
+    auto donePromises = kj::heapArrayBuilder<kj::Promise<void>>(threadCount);
+    for (auto i: kj::zeroTo(threadCount)) {
+      auto paf = kj::newPromiseAndCrossThreadFulfiller<void>();
+      donePromises.add(kj::mv(paf.promise));
+      threads.add(kj::heap<kj::Thread>(
+          [this, &state = states[i], &v8System, config, &options,
+              doneFulfiller = kj::mv(paf.fulfiller)]() mutable noexcept {
+        KJ_IF_SOME(exception,
+            kj::runCatchingExceptions([&]() { runThread(state, v8System, config, options); })) {
+          if (!state.published) {
+            // We failed before publishing our state. Count ourselves as ready anyway so that the
+            // constructor doesn't wait forever; `handoff()` skips us.
+            *ready.lockExclusive() += 1;
+          }
+          doneFulfiller->reject(kj::mv(exception));
+        } else {
+          doneFulfiller->fulfill();
+        }
+      }));
+    }
+    allDone = kj::joinPromisesFailFast(donePromises.finish());
+
+    // Wait until every thread has published its executor and connection queues, so that
+    // `handoff()` can be called from here on.
+    ready.when([threadCount](const uint& count) { return count == threadCount; }, [](uint) {});
+  }
+
+  // Drains the threads, if that hasn't happened yet, and then joins them. Draining here matters
+  // when the main thread's server fails: otherwise the other threads would keep serving and
+  // joining them would hang the process rather than letting it exit with the error.
+  ~ServeThreadPool() noexcept(false) {
+    drain();
+  }
+
+  KJ_DISALLOW_COPY_AND_MOVE(ServeThreadPool);
+
+  // Number of threads serving connections, including the main thread.
+  uint size() const {
+    return states.size() + 1;
+  }
+
+  // Passes a connection accepted on the main thread to thread `index` (1-based; index 0 is the
+  // main thread itself), as if it had been accepted by that thread's socket named `socketName`.
+  void handoff(uint index, kj::StringPtr socketName, kj::OwnFd fd) {
+    auto& state = states[index - 1];
+    if (!state.published) {
+      // The thread failed to start. The failure is reported through `onAllDone()`, and the
+      // connection is dropped.
+      return;
+    }
+    auto& queue = *KJ_ASSERT_NONNULL(state.queues.find(socketName));
+    tasks.add(state.executor->executeAsync([&state, &queue, fd = kj::mv(fd)]() mutable {
+      queue.push(state.lowLevelProvider->wrapSocketFd(
+          fd.release(), kj::LowLevelAsyncIoProvider::TAKE_OWNERSHIP));
+    }));
+  }
+
+  // Tells all threads to stop accepting connections and drain. Must be called on the main thread.
+  void drain() {
+    if (drained) return;
+    drained = true;
+    for (auto& state: states) {
+      state.drainFulfiller->fulfill();
+    }
+  }
+
+  // Resolves when every thread's server has shut down. Rejects as soon as any thread's server
+  // fails.
+  kj::Promise<void> onAllDone() {
+    return kj::mv(allDone);
+  }
+
+ private:
+  using ConnectionQueue = kj::ProducerConsumerQueue<kj::Own<kj::AsyncIoStream>>;
+
+  // Receives the connections handed off to one thread for a single socket.
+  class HandoffReceiver final: public kj::ConnectionReceiver {
+   public:
+    HandoffReceiver(ConnectionQueue& queue): queue(queue) {}
+
+    kj::Promise<kj::Own<kj::AsyncIoStream>> accept() override {
+      return queue.pop();
+    }
+
+    uint getPort() override {
+      // Only used to report the port on `--control-fd`, which is handled by the main thread.
+      return 0;
+    }
+
+   private:
+    ConnectionQueue& queue;
+  };
+
+  struct ThreadState {
+    // Everything here is written by the thread itself before it bumps `ready`, and is immutable
+    // afterwards, so the main thread may read it without further locking.
+    kj::Own<const kj::Executor> executor;
+    kj::LowLevelAsyncIoProvider* lowLevelProvider = nullptr;
+    kj::HashMap<kj::String, kj::Own<ConnectionQueue>> queues;
+    kj::Own<kj::CrossThreadPromiseFulfiller<void>> drainFulfiller;
+
+    // False if the thread failed before it could fill in the above.
+    bool published = false;
+  };
+
+  class TaskErrorHandler final: public kj::TaskSet::ErrorHandler {
+   public:
+    void taskFailed(kj::Exception&& exception) override {
+      // Most likely the target thread has already shut down, in which case the connection is
+      // simply dropped.
+      KJ_LOG(INFO, "failed to hand off connection to serving thread", exception);
+    }
+  };
+
+  void runThread(ThreadState& state,
+      jsg::V8System& v8System,
+      config::Config::Reader config,
+      const ReplicatedServerOptions& options) {
+    kj::AsyncIoContext io = kj::setupAsyncIo();
+    auto fs = kj::newDiskFilesystem();
+    NetworkWithLoopback network{io.provider->getNetwork(), *io.provider};
+    EntropySourceImpl entropySource;
+
+    auto drainPaf = kj::newPromiseAndCrossThreadFulfiller<void>();
+    state.executor = kj::getCurrentThreadExecutor().addRef();
+    state.lowLevelProvider = io.lowLevelProvider.get();
+    state.drainFulfiller = kj::mv(drainPaf.fulfiller);
+    for (auto sock: config.getSockets()) {
+      state.queues.insert(kj::str(sock.getName()), kj::heap<ConnectionQueue>());
+    }
+    state.published = true;
+    *ready.lockExclusive() += 1;
+
+    Server server(*fs, io.provider->getTimer(), network, entropySource,
+        Worker::ConsoleMode::STDOUT, [](kj::String error) {
+      // The main thread's server loads the exact same config and reports the same errors, so
+      // there's no need to report them a second time.
+    });
+    options.applyTo(server);
+    for (auto& entry: state.queues) {
+      server.overrideSocket(kj::str(entry.key), kj::heap<HandoffReceiver>(*entry.value));
+    }
+
+    server.run(v8System, config, kj::mv(drainPaf.promise)).wait(io.waitScope);
+  }
+
+  kj::Array<ThreadState> states;
+  kj::MutexGuarded<uint> ready;
+  kj::Promise<void> allDone = nullptr;
+  bool drained = false;
+
+  TaskErrorHandler taskErrorHandler;
+  kj::TaskSet tasks{taskErrorHandler};
+
+  // Declared last so that threads are joined before the state they reference is destroyed.
+  kj::Vector<kj::Own<kj::Thread>> threads;
+};
+
+// Wraps a listening socket on the main thread so that each accepted connection is either served
+// locally or handed off to another thread in the ServeThreadPool, round-robin.
+class DistributingReceiver final: public kj::ConnectionReceiver {
+ public:
+  DistributingReceiver(
+      kj::Own<kj::ConnectionReceiver> inner, ServeThreadPool& pool, kj::StringPtr socketName)
+      : inner(kj::mv(inner)),
+        pool(pool),
+        socketName(kj::str(socketName)) {}
+
+  kj::Promise<kj::Own<kj::AsyncIoStream>> accept() override {
+    for (;;) {
+      auto stream = co_await inner->accept();
+      uint target = next++ % pool.size();
+      if (target != 0) {
+        KJ_IF_SOME(fd, stream->getFd()) {
+          // Duplicate the descriptor so that it survives destroying `stream`, which otherwise
+          // belongs to this thread's event loop.
+          int dupFd;
+          KJ_SYSCALL(dupFd = fcntl(fd, F_DUPFD_CLOEXEC, 0));
+          pool.handoff(target, socketName, kj::OwnFd(dupFd));
+          continue;
+        }
+      }
+      co_return kj::mv(stream);
+    }
+  }
+
+  uint getPort() override {
+    return inner->getPort();
+  }
+
+  void getsockopt(int level, int option, void* value, uint* length) override {
+    inner->getsockopt(level, option, value, length);
+  }
+  void setsockopt(int level, int option, const void* value, uint length) override {
+    inner->setsockopt(level, option, value, length);
+  }
+  void getsockname(struct sockaddr* addr, uint* length) override {
+    inner->getsockname(addr, length);
+  }
+
+ private:
+  kj::Own<kj::ConnectionReceiver> inner;
+  ServeThreadPool& pool;
+  kj::String socketName;
+  uint next = 0;
+};
+
+#endif  // !_WIN32
+
+// =======================================================================================
+
 class CliMain final: public SchemaFileImpl::ErrorReporter {
  public:
   CliMain(kj::ProcessContext& context, char** argv)
@@ -662,6 +936,7 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
                 //   additional errors. The tricky part is we don't currently have any signal of when
                 //   the server has completely finished loading, and also we probably don't want to
                 //   accept any connections on any of the sockets if the server is partially broken.
+                flushBeforeExit();
                 context.exitError(error);
               } else {
                 // In --watch mode, we don't want to exit from errors, we want to wait until things
@@ -776,6 +1051,7 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
         .addOption({"experimental"},
             [this]() {
       server->allowExperimental();
+      replicatedOptions.experimental = true;
       return true;
     },
             "Permit the use of experimental features which may break backwards "
@@ -786,6 +1062,23 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
         .addOptionWithArg({"pyodide-bundle-disk-cache-dir"}, CLI_METHOD(setPyodideDiskCacheDir),
             "<path>",
             "Use <path> as a disk cache to avoid repeatedly fetching Pyodide bundles from the internet. ")
+        .addOptionWithArg({"compile-cache-dir"}, CLI_METHOD(setCompileCacheDir), "<path>",
+            "Persist V8 code caches for the configured modules to <path>, creating it if "
+            "necessary, so that later runs can skip recompiling unchanged modules.")
+        .addOptionWithArg({"compile-cache-max-size"}, CLI_METHOD(setCompileCacheMaxSize),
+            "<bytes>",
+            "Limit the total size of --compile-cache-dir to <bytes>, evicting the least recently "
+            "used entries. Defaults to 256 MiB.")
+        .addOptionWithArg({"log-buffer-size"}, CLI_METHOD(setLogBufferSize), "<bytes>",
+            "Queue up to <bytes> of log output waiting to be written to stdout and stderr. Once "
+            "the queue is full, workers wait for it to drain. Defaults to 1 MiB.")
+        .addOption({"drop-logs-when-full"},
+            [this]() {
+      stdioLogSinkOptions.overflowPolicy = StdioLogSink::OverflowPolicy::DROP;
+      return true;
+    },
+            "When the log output queue is full, drop log lines, noting how many were dropped, "
+            "rather than making workers wait.")
         .addOption({"python-save-snapshot"},
             [this]() {
       server->setPythonCreateSnapshot();
@@ -920,6 +1213,14 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
             "Only write the encoded binary config to stdout. Do not attach it to an executable. "
             "The encoded config can be used as input to the \"serve\" command, without the need "
             "for any other files to be present.")
+        .addOption({"code-cache"},
+            [this]() {
+      codeCache = true;
+      return true;
+    },
+            "Compile every ES module in the config ahead of time and embed the resulting V8 code "
+            "cache in the output, so that the modules don't need to be parsed and compiled from "
+            "source at startup. The cache is only used when run by the same workerd version.")
         .callAfterParsing(CLI_METHOD(compile))
         .build();
   }
@@ -956,7 +1257,7 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
 
   void overrideSocketAddr(kj::StringPtr param) {
     auto [name, value] = parseOverride(param);
-    server->overrideSocket(kj::mv(name), kj::str(value));
+    socketOverrides.upsert(kj::mv(name), kj::str(value));
   }
 
 #if _WIN32
@@ -1013,17 +1314,37 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
     validateSocketFd(fd, name);
 
     inheritedFds.add(fd);
-    server->overrideSocket(kj::mv(name),
+    socketOverrides.upsert(kj::mv(name),
         io.lowLevelProvider->wrapListenSocketFd(fd, kj::LowLevelAsyncIoProvider::TAKE_OWNERSHIP));
   }
 
+  // Passes any socket overrides given on the command line that haven't been consumed yet on to
+  // the server.
+  void applySocketOverrides() {
+    for (auto& entry: socketOverrides) {
+      KJ_SWITCH_ONEOF(entry.value) {
+        KJ_CASE_ONEOF(addr, kj::String) {
+          server->overrideSocket(kj::mv(entry.key), kj::mv(addr));
+        }
+        KJ_CASE_ONEOF(listener, kj::Own<kj::ConnectionReceiver>) {
+          server->overrideSocket(kj::mv(entry.key), kj::mv(listener));
+        }
+      }
+    }
+    socketOverrides.clear();
+  }
+
   void overrideDirectory(kj::StringPtr param) {
     auto [name, value] = parseOverride(param);
+    replicatedOptions.directoryOverrides.add(
+        ReplicatedServerOptions::NamedOverride{kj::str(name), kj::str(value)});
     server->overrideDirectory(kj::mv(name), kj::str(value));
   }
 
   void overrideExternal(kj::StringPtr param) {
     auto [name, value] = parseOverride(param);
+    replicatedOptions.externalOverrides.add(
+        ReplicatedServerOptions::NamedOverride{kj::str(name), kj::str(value)});
     server->overrideExternal(kj::mv(name), kj::str(value));
   }
 
@@ -1060,6 +1381,24 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
     server->setPyodideDiskCacheRoot(kj::mv(dir));
   }
 
+  void setCompileCacheDir(kj::StringPtr pathStr) {
+    kj::Path path = fs->getCurrentPath().evalNative(pathStr);
+    compileCacheDir = KJ_UNWRAP_OR(fs->getRoot().tryOpenSubdir(path,
+                                       kj::WriteMode::CREATE | kj::WriteMode::MODIFY |
+                                           kj::WriteMode::CREATE_PARENT),
+        CLI_ERROR("Could not open compile cache directory."));
+  }
+
+  void setCompileCacheMaxSize(kj::StringPtr param) {
+    compileCacheMaxSize =
+        KJ_UNWRAP_OR(param.tryParseAs<uint64_t>(), CLI_ERROR("Expected a size in bytes."));
+  }
+
+  void setLogBufferSize(kj::StringPtr param) {
+    stdioLogSinkOptions.maxBufferedBytes =
+        KJ_UNWRAP_OR(param.tryParseAs<size_t>(), CLI_ERROR("Expected a size in bytes."));
+  }
+
   void parsePythonCompatFlag(kj::StringPtr compatFlagStr) {
     auto builder = kj::heap<capnp::MallocMessageBuilder>();
     auto configBuilder = builder->initRoot<config::Config>();
@@ -1231,6 +1570,15 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
 
     config::Config::Reader config = getConfig();
 
+    kj::Own<capnp::MallocMessageBuilder> codeCacheMessage;
+    if (codeCache) {
+      codeCacheMessage = kj::heap<capnp::MallocMessageBuilder>();
+      codeCacheMessage->setRoot(config);
+      auto root = codeCacheMessage->getRoot<config::Config>();
+      addCodeCaches(root);
+      config = root.asReader();
+    }
+
 #if _WIN32
     if (_isatty(_fileno(stdout))) {
 #else
@@ -1318,6 +1666,32 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
     }
   }
 
+  // Fills in `compileCache` for every ES module in the config. See `Worker.Module.compileCache`.
+  void addCodeCaches(config::Config::Builder config) {
+    // The V8 flags must match those used at runtime, or V8 will reject the cache.
+    auto platform = jsg::defaultPlatform(0);
+    WorkerdPlatform v8Platform(*platform);
+    jsg::V8System v8System(v8Platform,
+        KJ_MAP(flag, config.getV8Flags()) -> kj::StringPtr { return flag; }, platform.get());
+
+    CodeCacheIsolate isolate(v8System, kj::heap<jsg::IsolateObserver>());
+    isolate.runInLockScope([&](CodeCacheIsolate::Lock& lock) {
+      JSG_WITHIN_CONTEXT_SCOPE(lock,
+          lock.newContext<CodeCacheGlobalScope>().getHandle(lock.v8Isolate), [&](jsg::Lock& js) {
+        for (auto service: config.getServices()) {
+          if (!service.isWorker() || !service.getWorker().isModules()) continue;
+          for (auto module: service.getWorker().getModules()) {
+            if (!module.isEsModule()) continue;
+            KJ_IF_SOME(cache,
+                jsg::generateEsmCompileCache(js, module.getName(), module.getEsModule())) {
+              module.setCompileCache(capnp::Data::Reader(cache.begin(), cache.size()));
+            }
+          }
+        }
+      });
+    });
+  }
+
   template <typename Func>
   void serveImpl(Func&& func) noexcept {
     if (hadErrors) {
@@ -1344,16 +1718,28 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
       TRACE_EVENT("workerd", "serveImpl()");
       auto config = getConfig();
 
-      // Initialize JSON logger if structured logging is enabled (similar to SyslogFriendlyLogger)
+      // Write console output from a background thread, so workers don't stall on a slow reader.
+      StdioLogSink stdioLogSink(stdioLogSinkOptions);
+
+      // Send log messages through the sink too, so they stay in order with console output. These
+      // are installed after the sink is created, so that its writer thread doesn't use them.
       kj::Maybe<JsonLogger> jsonLogger;
+      kj::Maybe<StdioLogSink::LogCallback> logCallback;
       if (config.getStructuredLogging()) {
         jsonLogger.emplace();  // Stack-allocated instance for the entire serve scope
+      } else {
+        logCallback.emplace();
       }
 
       auto platform = jsg::defaultPlatform(0);
       WorkerdPlatform v8Platform(*platform);
       jsg::V8System v8System(v8Platform,
           KJ_MAP(flag, config.getV8Flags()) -> kj::StringPtr { return flag; }, platform.get());
+      KJ_IF_SOME(dir, compileCacheDir) {
+        jsg::PersistentCompileCache::install(
+            kj::heap<jsg::PersistentCompileCache>(kj::mv(dir), compileCacheMaxSize));
+        compileCacheDir = kj::none;
+      }
       auto promise = func(v8System, config);
       KJ_IF_SOME(w, watcher) {
         promise = promise.exclusiveJoin(waitForChanges(w).then([this]() {
@@ -1370,9 +1756,16 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
 #endif
 
       if (getenv("KJ_CLEAN_SHUTDOWN") == nullptr) {
+        flushBeforeExit();
         context.exit();
       }
 
+      // The compile cache is never destroyed (see PersistentCompileCache::install()), so it has to
+      // be flushed even on a clean shutdown.
+      KJ_IF_SOME(cache, jsg::PersistentCompileCache::get()) {
+        cache.flush();
+      }
+
       // Server maintains a reference to the v8 platform. Clean up before destroying the platform.
       server = nullptr;
     }
@@ -1381,15 +1774,105 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
   void serve() noexcept {
     serveImpl([&](jsg::V8System& v8System, config::Config::Reader config) {
 #if _WIN32
+      applySocketOverrides();
       return server->run(v8System, config);
 #else
-      return server->run(v8System, config,
-          // Gracefully drain when SIGTERM is received.
-          io.unixEventPort.onSignal(SIGTERM).ignoreResult());
+      // Gracefully drain when SIGTERM is received.
+      auto drainWhen = io.unixEventPort.onSignal(SIGTERM).ignoreResult();
+      if (config.getThreads() > 1) {
+        return serveThreaded(v8System, config, kj::mv(drainWhen));
+      }
+      applySocketOverrides();
+      return server->run(v8System, config, kj::mv(drainWhen));
 #endif
     });
   }
 
+#if !_WIN32
+  // Implements `serve` when `Config.threads` is greater than 1. See ServeThreadPool.
+  kj::Promise<void> serveThreaded(
+      jsg::V8System& v8System, config::Config::Reader config, kj::Promise<void> drainWhen) {
+    for (auto service: config.getServices()) {
+      if (service.isWorker() && service.getWorker().getDurableObjectNamespaces().size() > 0) {
+        flushBeforeExit();
+        context.exitError(kj::str("Service \"", service.getName(),
+            "\" defines Durable Object namespaces, which are not supported when `threads` is "
+            "greater than 1."));
+      }
+    }
+
+    // Bind all sockets on this thread before starting any other threads. Sockets which can't be
+    // bound here (no address, unknown type) are left for the server to report as config errors.
+    kj::Vector<kj::Tuple<kj::StringPtr, kj::Own<kj::ConnectionReceiver>>> listeners;
+    for (auto sock: config.getSockets()) {
+      kj::StringPtr name = sock.getName();
+      uint defaultPort;
+      switch (sock.which()) {
+        case config::Socket::HTTP:
+          defaultPort = 80;
+          break;
+        case config::Socket::HTTPS:
+          defaultPort = 443;
+          break;
+        default:
+          continue;
+      }
+
+      kj::Own<kj::ConnectionReceiver> listener;
+      KJ_IF_SOME(override, socketOverrides.findEntry(name)) {
+        KJ_SWITCH_ONEOF(override.value) {
+          KJ_CASE_ONEOF(addr, kj::String) {
+            listener = network.parseAddress(addr, defaultPort).wait(io.waitScope)->listen();
+          }
+          KJ_CASE_ONEOF(l, kj::Own<kj::ConnectionReceiver>) {
+            listener = kj::mv(l);
+          }
+        }
+        socketOverrides.erase(override);
+      } else if (sock.hasAddress()) {
+        listener =
+            network.parseAddress(sock.getAddress(), defaultPort).wait(io.waitScope)->listen();
+      } else {
+        continue;
+      }
+      listeners.add(kj::tuple(name, kj::mv(listener)));
+    }
+
+    auto pool =
+        kj::heap<ServeThreadPool>(config.getThreads() - 1, v8System, config, replicatedOptions);
+    for (auto& listener: listeners) {
+      auto name = kj::get<0>(listener);
+      server->overrideSocket(
+          kj::str(name), kj::heap<DistributingReceiver>(kj::mv(kj::get<1>(listener)), *pool, name));
+    }
+    applySocketOverrides();
+
+    auto forkedDrainWhen = drainWhen.fork();
+    auto mainPromise = server->run(v8System, config, forkedDrainWhen.addBranch());
+    return runThreaded(kj::mv(mainPromise), forkedDrainWhen.addBranch(), kj::mv(pool));
+  }
+
+  kj::Promise<void> runThreaded(
+      kj::Promise<void> mainPromise, kj::Promise<void> drainWhen, kj::Own<ServeThreadPool> pool) {
+    // The other threads can't observe our signal handler, so forward the drain to them.
+    auto drainThreads =
+        drainWhen.then([&pool = *pool]() { pool.drain(); }).eagerlyEvaluate(nullptr);
+
+    // A failure of another thread's server is reported the same way as a failure of the main
+    // thread's server. Otherwise they only stop once drained.
+    auto allDone = pool->onAllDone().catch_([this](kj::Exception&& exception) {
+      flushBeforeExit();
+      context.exitError(kj::str("Serving thread failed: ", exception));
+    }).fork();
+
+    // If `mainPromise` rejects, destroying `pool` drains and joins the threads.
+    co_await mainPromise.exclusiveJoin(
+        allDone.addBranch().then([]() -> kj::Promise<void> { return kj::NEVER_DONE; }));
+    pool->drain();
+    co_await allDone.addBranch();
+  }
+#endif
+
   void test() {
     if (!noVerbose) {
       // Always turn on info logging when running tests so that uncaught exceptions are displayed.
@@ -1425,12 +1908,25 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
     });
   }
 
+  // Writes out output that is still buffered in memory. Must be called before anything which ends
+  // the process, or replaces it, without unwinding the stack.
+  void flushBeforeExit() {
+    KJ_IF_SOME(sink, StdioLogSink::current()) {
+      sink.flush();
+    }
+    KJ_IF_SOME(cache, jsg::PersistentCompileCache::get()) {
+      cache.flush();
+    }
+  }
+
 #if _WIN32
   void reloadFromConfigChange() {
     KJ_UNREACHABLE("Watching is not yet implemented on Windows");
   }
 #else
   [[noreturn]] void reloadFromConfigChange() {
+    flushBeforeExit();
+
     // Write extra spaces to fully overwrite the line that we wrote earlier with a CR but no LF:
     //     "Noticed configuration change, reloading shortly...\r"
     context.warning("Reloading due to config change...                                      ");
@@ -1465,10 +1961,16 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
 
   bool binaryConfig = false;
   bool configOnly = false;
+  bool codeCache = false;
   bool noVerbose = false;
   bool predictable = false;
   kj::Maybe<FileWatcher> watcher;
 
+  kj::Maybe<kj::Own<const kj::Directory>> compileCacheDir;
+  uint64_t compileCacheMaxSize = 256ull << 20;
+
+  StdioLogSink::Options stdioLogSinkOptions;
+
   kj::Own<kj::Filesystem> fs = kj::newDiskFilesystem();
   kj::AsyncIoContext io = kj::setupAsyncIo();
   NetworkWithLoopback network{io.provider->getNetwork(), *io.provider};
@@ -1484,6 +1986,12 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
 
   kj::Vector<int> inheritedFds;
 
+  // Socket overrides from the command line, held here until `serve()` knows whether the sockets
+  // need to be shared across threads.
+  kj::HashMap<kj::String, kj::OneOf<kj::String, kj::Own<kj::ConnectionReceiver>>> socketOverrides;
+
+  ReplicatedServerOptions replicatedOptions;
+
   kj::Maybe<kj::String> testServicePattern;
   kj::Maybe<kj::String> testEntrypointPattern;
 
@@ -1629,8 +2137,12 @@ class CliMain final: public SchemaFileImpl::ErrorReporter {
     // We don't include a newline but rather a carriage return so that when the next
     // line is written, this line disappears, to reduce noise.
     // TODO(cleanup): Writing directly to stderr is super-hacky.
-    auto message = "Noticed configuration change, reloading shortly...\r"_kjb;
-    kj::FdOutputStream(STDERR_FILENO).write(message);
+    auto message = "Noticed configuration change, reloading shortly...\r"_kj;
+    KJ_IF_SOME(sink, StdioLogSink::current()) {
+      sink.write(STDERR_FILENO, kj::str(message));
+    } else {
+      kj::FdOutputStream(STDERR_FILENO).write(message.asBytes());
+    }
 
     static auto const waitForResult = [](kj::Promise<void> promise,
                                           bool result = false) -> kj::Promise<bool> {
@@ -61,5 +61,52 @@ BENCHMARK_F(ApiHeaders, constructor)(benchmark::State& state) {
   });
 }
 
+// Request/Response cloning and `new Headers(other)` copy headers; copies share storage until
+// modified, so this should be independent of the number of headers.
+BENCHMARK_F(ApiHeaders, clone)(benchmark::State& state) {
+  fixture->runInIoContext([&](const TestFixture::Environment& env) {
+    auto& js = env.js;
+    auto headers = js.alloc<api::Headers>(js, *kjHeaders, api::Headers::Guard::REQUEST);
+    for (auto _: state) {
+      for (size_t i = 0; i < 10000; ++i) {
+        benchmark::DoNotOptimize(headers->clone(js));
+        benchmark::DoNotOptimize(i);
+      }
+    }
+  });
+}
+
+// Clone, then modify the copy, which forces the shared storage to be copied.
+BENCHMARK_F(ApiHeaders, cloneAndSet)(benchmark::State& state) {
+  fixture->runInIoContext([&](const TestFixture::Environment& env) {
+    auto& js = env.js;
+    auto headers = js.alloc<api::Headers>(js, *kjHeaders, api::Headers::Guard::REQUEST);
+    for (auto _: state) {
+      for (size_t i = 0; i < 10000; ++i) {
+        auto copy = js.alloc<api::Headers>(js, *headers);
+        copy->setUnguarded(js, "X-Forwarded-For"_kj, jsg::ByteString(kj::str("127.0.0.1")));
+        benchmark::DoNotOptimize(copy);
+        benchmark::DoNotOptimize(i);
+      }
+    }
+  });
+}
+
+// Iterate over all entries, as `for (const [k, v] of headers)` does.
+BENCHMARK_F(ApiHeaders, iterate)(benchmark::State& state) {
+  fixture->runInIoContext([&](const TestFixture::Environment& env) {
+    auto& js = env.js;
+    auto headers = js.alloc<api::Headers>(js, *kjHeaders, api::Headers::Guard::REQUEST);
+    for (auto _: state) {
+      for (size_t i = 0; i < 1000; ++i) {
+        auto iter = headers->entries(js);
+        while (!iter->next(js).done) {
+        }
+        benchmark::DoNotOptimize(i);
+      }
+    }
+  });
+}
+
 }  // namespace
 }  // namespace workerd
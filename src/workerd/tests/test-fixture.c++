@@ -337,7 +337,7 @@ TestFixture::TestFixture(SetupParams&& params)
           kj::none /* new module registry */,
           newWorkerFileSystem(kj::heap<FsMap>(), getTmpDirectoryImpl()))),
       workerIsolate(kj::atomicRefcounted<Worker::Isolate>(kj::mv(api),
-          kj::atomicRefcounted<IsolateObserver>(),
+          kj::mv(params.isolateObserver).orDefault(kj::atomicRefcounted<IsolateObserver>()),
           scriptId,
           kj::heap<MockIsolateLimitEnforcer>(),
           Worker::Isolate::InspectorPolicy::DISALLOW)),
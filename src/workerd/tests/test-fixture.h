@@ -26,6 +26,8 @@ struct TestFixture {
     kj::Maybe<kj::StringPtr> mainModuleSource;
     // If set, make a stub of an Actor with the given id.
     kj::Maybe<Worker::Actor::Id> actorId;
+    // Observer for the worker's isolate. One that observes nothing is used if missing.
+    kj::Maybe<kj::Own<IsolateObserver>> isolateObserver;
   };
 
   TestFixture(SetupParams&& params = {});
@@ -88,6 +90,10 @@ struct TestFixture {
   // Performs HTTP request on the default module handler, and waits for full response.
   Response runRequest(kj::HttpMethod method, kj::StringPtr url, kj::StringPtr body);
 
+  const Worker& getWorker() const {
+    return *worker;
+  }
+
  private:
   kj::Maybe<kj::WaitScope&> waitScope;
   capnp::MallocMessageBuilder configArena;
@@ -136,6 +136,96 @@ KJ_TEST("SQLite-KV") {
   }
 }
 
+KJ_TEST("SQLite-KV multi-key operations") {
+  auto dir = kj::newInMemoryDirectory(kj::nullClock());
+  SqliteDatabase::Vfs vfs(*dir);
+  SqliteDatabase db(vfs, kj::Path({"foo"}), kj::WriteMode::CREATE | kj::WriteMode::MODIFY);
+  SqliteKv kv(db);
+
+  // Use enough keys to exercise several chunk sizes, including the single-key statements.
+  constexpr uint COUNT = 203;
+  auto keys = KJ_MAP(i, kj::zeroTo(COUNT)) { return kj::str(kj::hex(i + 0x1000)); };
+  auto values = KJ_MAP(i, kj::zeroTo(COUNT)) { return kj::str("v", i); };
+  auto keyPtrs = KJ_MAP(key, keys) -> kj::StringPtr { return key; };
+
+  // Nothing to find before the table exists.
+  KJ_EXPECT(kv.get(keyPtrs, [&](kj::StringPtr, kj::ArrayPtr<const byte>) {
+    KJ_FAIL_EXPECT("should not call callback when table doesn't exist");
+  }) == 0);
+
+  {
+    kj::Vector<SqliteKv::KeyValuePtrPair> pairs;
+    for (auto i: kj::zeroTo(COUNT)) {
+      pairs.add(SqliteKv::KeyValuePtrPair{keys[i], values[i].asBytes()});
+    }
+    // If a key is repeated, the last value wins.
+    pairs.add(SqliteKv::KeyValuePtrPair{keys[5], "overwritten"_kj.asBytes()});
+    kv.put(pairs.asPtr());
+  }
+
+  auto getAll = [&](kj::ArrayPtr<const kj::StringPtr> lookup) {
+    kj::Vector<kj::String> results;
+    auto n = kv.get(lookup, [&](kj::StringPtr key, kj::ArrayPtr<const byte> value) {
+      results.add(kj::str(key, "=", value.asChars()));
+    });
+    KJ_EXPECT(results.size() == n);
+    return results.releaseAsArray();
+  };
+
+  {
+    auto results = getAll(keyPtrs);
+    KJ_ASSERT(results.size() == COUNT);
+    for (auto i: kj::zeroTo(COUNT)) {
+      if (i == 5) {
+        KJ_EXPECT(results[i] == kj::str(keys[i], "=overwritten"));
+      } else {
+        KJ_EXPECT(results[i] == kj::str(keys[i], "=", values[i]), i);
+      }
+    }
+  }
+
+  // Missing keys are skipped, duplicates are reported once, and results are in key order.
+  {
+    kj::StringPtr some[] = {keys[1], "corge"_kj, keys[3], keys[3], keys[100]};
+    auto results = getAll(some);
+    KJ_EXPECT(kj::strArray(results, ", ") ==
+        kj::str(keys[1], "=v1, ", keys[3], "=v3, ", keys[100], "=v100"));
+  }
+
+  // Duplicates are reported once even when they straddle two chunks.
+  {
+    kj::StringPtr some[] = {keys[1], keys[2], keys[3], keys[4], keys[4]};
+    auto results = getAll(some);
+    KJ_EXPECT(results.size() == 4);
+    KJ_EXPECT(results[3] == kj::str(keys[4], "=v4"));
+  }
+
+  // Delete every other key, along with a key that doesn't exist.
+  {
+    kj::Vector<kj::StringPtr> toDelete;
+    for (auto i = 0u; i < COUNT; i += 2) {
+      toDelete.add(keys[i]);
+    }
+    toDelete.add("corge"_kj);
+    KJ_EXPECT(kv.delete_(toDelete.asPtr()) == (COUNT + 1) / 2);
+  }
+
+  {
+    auto results = getAll(keyPtrs);
+    KJ_ASSERT(results.size() == COUNT / 2);
+    KJ_EXPECT(results[0] == kj::str(keys[1], "=v1"));
+    KJ_EXPECT(results[COUNT / 2 - 1] == kj::str(keys[COUNT - 2], "=v", COUNT - 2));
+  }
+
+  // Batch statements keep working after the database is reset.
+  KJ_EXPECT(kv.deleteAll() == COUNT / 2);
+  {
+    SqliteKv::KeyValuePtrPair pairs[] = {{keys[0], "a"_kj.asBytes()}, {keys[1], "b"_kj.asBytes()}};
+    kv.put(pairs);
+  }
+  KJ_EXPECT(kj::strArray(getAll(keyPtrs), ", ") == kj::str(keys[0], "=a, ", keys[1], "=b"));
+}
+
 KJ_TEST("large key") {
   auto dir = kj::newInMemoryDirectory(kj::nullClock());
   SqliteDatabase::Vfs vfs(*dir);
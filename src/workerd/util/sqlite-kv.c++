@@ -69,15 +69,106 @@ SqliteKv::Initialized& SqliteKv::ensureInitialized() {
   KJ_UNREACHABLE;
 }
 
+uint SqliteKv::nextBatchSize(size_t remaining) {
+  if (remaining >= MAX_BATCH_SIZE) return MAX_BATCH_SIZE;
+  uint size = 1;
+  while (size * 2 <= remaining) size *= 2;
+  return size;
+}
+
+SqliteDatabase::Statement& SqliteKv::Initialized::getBatchStatement(BatchOp op, uint batchSize) {
+  uint log2 = __builtin_ctz(batchSize);
+  KJ_IREQUIRE(batchSize == 1u << log2 && log2 <= MAX_BATCH_SIZE_LOG2);
+
+  auto& slot = batchStmts[op][log2];
+  KJ_IF_SOME(stmt, slot) {
+    return stmt;
+  }
+
+  kj::StringPtr placeholder = op == BATCH_PUT ? "(?, ?)"_kj : "?"_kj;
+  kj::Vector<char> placeholders;
+  for (uint i = 0; i < batchSize; i++) {
+    if (i > 0) placeholders.addAll(", "_kj);
+    placeholders.addAll(placeholder);
+  }
+
+  kj::String sql;
+  switch (op) {
+    case BATCH_GET:
+      sql = kj::str(
+          "SELECT key, value FROM _cf_KV WHERE key IN (", placeholders.asPtr(), ") ORDER BY key");
+      break;
+    case BATCH_PUT:
+      sql = kj::str("INSERT INTO _cf_KV VALUES ", placeholders.asPtr(),
+          " ON CONFLICT DO UPDATE SET value = excluded.value");
+      break;
+    case BATCH_DELETE:
+      sql = kj::str("DELETE FROM _cf_KV WHERE key IN (", placeholders.asPtr(), ")");
+      break;
+    case BATCH_OP_COUNT:
+      KJ_UNREACHABLE;
+  }
+
+  return slot.emplace(db.prepare(regulator, sql));
+}
+
 void SqliteKv::put(KeyPtr key, ValuePtr value) {
   ensureInitialized().stmtPut.run(key, value);
 }
 
+void SqliteKv::put(kj::ArrayPtr<const KeyValuePtrPair> pairs) {
+  if (pairs.size() == 0) return;
+  auto& stmts = ensureInitialized();
+
+  kj::Vector<SqliteDatabase::Query::ValuePtr> bindings(kj::min(pairs.size(), MAX_BATCH_SIZE) * 2);
+  while (pairs.size() > 0) {
+    uint batchSize = nextBatchSize(pairs.size());
+    if (batchSize == 1) {
+      stmts.stmtPut.run(pairs[0].key, pairs[0].value);
+    } else {
+      bindings.clear();
+      for (auto& pair: pairs.first(batchSize)) {
+        bindings.add(pair.key);
+        bindings.add(pair.value);
+      }
+      stmts.getBatchStatement(BATCH_PUT, batchSize)
+          .run(kj::ArrayPtr<const SqliteDatabase::Query::ValuePtr>(
+              bindings.begin(), bindings.size()));
+    }
+    pairs = pairs.slice(batchSize, pairs.size());
+  }
+}
+
 bool SqliteKv::delete_(KeyPtr key) {
   auto query = ensureInitialized().stmtDelete.run(key);
   return query.changeCount() > 0;
 }
 
+uint SqliteKv::delete_(kj::ArrayPtr<const KeyPtr> keys) {
+  if (keys.size() == 0) return 0;
+  auto& stmts = ensureInitialized();
+
+  uint count = 0;
+  kj::Vector<SqliteDatabase::Query::ValuePtr> bindings(kj::min(keys.size(), MAX_BATCH_SIZE));
+  while (keys.size() > 0) {
+    uint batchSize = nextBatchSize(keys.size());
+    if (batchSize == 1) {
+      count += stmts.stmtDelete.run(keys[0]).changeCount();
+    } else {
+      bindings.clear();
+      for (auto key: keys.first(batchSize)) {
+        bindings.add(key);
+      }
+      count += stmts.getBatchStatement(BATCH_DELETE, batchSize)
+                   .run(kj::ArrayPtr<const SqliteDatabase::Query::ValuePtr>(
+                       bindings.begin(), bindings.size()))
+                   .changeCount();
+    }
+    keys = keys.slice(batchSize, keys.size());
+  }
+  return count;
+}
+
 uint SqliteKv::deleteAll() {
   // TODO(perf): Consider introducing a compatibility flag that causes deleteAll() to always return
   //   1. Apps almost certainly don't care about the return value but historically we returned the
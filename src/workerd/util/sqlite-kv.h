@@ -40,6 +40,13 @@ class SqliteKv: private SqliteDatabase::ResetListener {
   template <typename Func>
   bool get(KeyPtr key, Func&& callback);
 
+  // Like get(), but looks up several keys at once. Calls the callback (with KeyPtr and ValuePtr
+  // parameters) for each key that is found, and returns the number found. As long as `keys` is
+  // sorted, rows are reported in key order and duplicate keys are reported once. Otherwise, a key
+  // that appears more than once may be reported more than once.
+  template <typename Func>
+  uint get(kj::ArrayPtr<const KeyPtr> keys, Func&& callback);
+
   enum Order { FORWARD, REVERSE };
 
   // Search for all known keys and values in a range, calling the callback (with KeyPtr and
@@ -49,20 +56,39 @@ class SqliteKv: private SqliteDatabase::ResetListener {
   uint list(
       KeyPtr begin, kj::Maybe<KeyPtr> end, kj::Maybe<uint> limit, Order order, Func&& callback);
 
+  struct KeyValuePtrPair {
+    KeyPtr key;
+    ValuePtr value;
+  };
+
   // Store a value into the table.
   void put(KeyPtr key, ValuePtr value);
 
+  // Store several values into the table. If a key appears more than once, the last value wins.
+  void put(kj::ArrayPtr<const KeyValuePtrPair> pairs);
+
   // Delete the key and return whether it was matched.
   bool delete_(KeyPtr key);
 
-  uint deleteAll();
+  // Delete several keys and return how many were matched.
+  uint delete_(kj::ArrayPtr<const KeyPtr> keys);
 
-  // TODO(perf): Should we provide multi-get, multi-put, and multi-delete? It's a bit tricky to
-  //   implement them as single SQL queries, while still using prepared statements. The c-array
-  //   extension might help here, though it can only support arrays of NUL-terminated strings, not
-  //   byte blobs or strings containing NUL bytes.
+  uint deleteAll();
 
  private:
+  // The multi-key operations above run one statement per chunk of keys, binding every key (and
+  // value) in the chunk as a separate parameter. Chunk sizes are powers of two up to
+  // MAX_BATCH_SIZE, so that only a handful of distinct statements ever need to be prepared, one
+  // per operation and size. A chunk of one uses the single-key statement.
+  static constexpr uint MAX_BATCH_SIZE_LOG2 = 6;
+  static constexpr uint MAX_BATCH_SIZE = 1u << MAX_BATCH_SIZE_LOG2;
+
+  // Returns the size of the next chunk to run when `remaining` keys are left: the largest power
+  // of two no greater than `remaining` or MAX_BATCH_SIZE.
+  static uint nextBatchSize(size_t remaining);
+
+  enum BatchOp { BATCH_GET, BATCH_PUT, BATCH_DELETE, BATCH_OP_COUNT };
+
   struct Uninitialized {};
 
   struct Initialized {
@@ -130,7 +156,15 @@ class SqliteKv: private SqliteDatabase::ResetListener {
       SELECT count(*) FROM _cf_KV
     )");
 
+    // Statements for multi-key operations, indexed by operation and then by log2 of the chunk
+    // size. Each is prepared the first time a chunk of that size is run.
+    kj::Maybe<SqliteDatabase::Statement> batchStmts[BATCH_OP_COUNT][MAX_BATCH_SIZE_LOG2 + 1];
+
     Initialized(SqliteDatabase& db): db(db) {}
+
+    // Get the statement for the given operation and chunk size, preparing it if needed.
+    // `batchSize` must be a power of two no greater than MAX_BATCH_SIZE.
+    SqliteDatabase::Statement& getBatchStatement(BatchOp op, uint batchSize);
   };
 
   kj::OneOf<Uninitialized, Initialized> state;
@@ -168,6 +202,50 @@ bool SqliteKv::get(KeyPtr key, Func&& callback) {
   }
 }
 
+template <typename Func>
+uint SqliteKv::get(kj::ArrayPtr<const KeyPtr> keys, Func&& callback) {
+  if (!tableCreated) return 0;
+  auto& stmts = KJ_UNWRAP_OR(state.tryGet<Initialized>(), return 0);
+
+  // Each chunk's statement dedupes its own keys, but duplicates in sorted input could straddle two
+  // chunks, so drop adjacent duplicates upfront.
+  kj::Vector<KeyPtr> uniqueKeys(keys.size());
+  for (auto key: keys) {
+    if (uniqueKeys.empty() || uniqueKeys.back() != key) {
+      uniqueKeys.add(key);
+    }
+  }
+  keys = uniqueKeys.asPtr();
+
+  uint count = 0;
+  kj::Vector<SqliteDatabase::Query::ValuePtr> bindings(kj::min(keys.size(), MAX_BATCH_SIZE));
+  while (keys.size() > 0) {
+    uint batchSize = nextBatchSize(keys.size());
+    if (batchSize == 1) {
+      auto query = stmts.stmtGet.run(keys[0]);
+      if (!query.isDone()) {
+        callback(keys[0], query.getBlob(0));
+        ++count;
+      }
+    } else {
+      bindings.clear();
+      for (auto key: keys.first(batchSize)) {
+        bindings.add(key);
+      }
+      auto query = stmts.getBatchStatement(BATCH_GET, batchSize)
+                       .run(kj::ArrayPtr<const SqliteDatabase::Query::ValuePtr>(
+                           bindings.begin(), bindings.size()));
+      while (!query.isDone()) {
+        callback(query.getText(0), query.getBlob(1));
+        query.nextRow();
+        ++count;
+      }
+    }
+    keys = keys.slice(batchSize, keys.size());
+  }
+  return count;
+}
+
 template <typename Func>
 uint SqliteKv::list(
     KeyPtr begin, kj::Maybe<KeyPtr> end, kj::Maybe<uint> limit, Order order, Func&& callback) {
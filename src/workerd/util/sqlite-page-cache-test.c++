@@ -0,0 +1,93 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "sqlite.h"
+
+#include <kj/test.h>
+
+namespace workerd {
+namespace {
+
+class TestSqliteObserver: public SqliteObserver {
+ public:
+  void addPageCacheStats(uint64_t hits, uint64_t misses) override {
+    this->hits += hits;
+    this->misses += misses;
+  }
+
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+};
+
+constexpr uint64_t BUDGET = 512 * 1024;
+
+// A little more than one page, including SQLite's and our own bookkeeping.
+constexpr uint64_t SLACK = 8192;
+
+void fill(SqliteDatabase& db) {
+  // Let the budget, not SQLite's own default cache size, be the limit.
+  db.run("PRAGMA cache_size = 100000");
+  db.run("CREATE TABLE data (value BLOB)");
+
+  // About one page per row, and about four times the budget in total. Each insert is its own
+  // transaction so that dirty pages don't stay pinned.
+  for (auto i KJ_UNUSED: kj::zeroTo(500)) {
+    db.run("INSERT INTO data VALUES (randomblob(3500))");
+  }
+}
+
+void scan(SqliteDatabase& db) {
+  KJ_EXPECT(db.run("SELECT count(*), sum(length(value)) FROM data").getInt(0) == 500);
+}
+
+KJ_TEST("SQLite page cache divides its budget between databases") {
+  SqliteDatabase::setPageCacheBudget(BUDGET);
+  KJ_DEFER(SqliteDatabase::setPageCacheBudget(128u << 20));
+
+  auto dir = kj::newInMemoryDirectory(kj::nullClock());
+  SqliteDatabase::Vfs vfs(*dir);
+  auto mode = kj::WriteMode::CREATE | kj::WriteMode::MODIFY;
+
+  TestSqliteObserver observerA;
+  SqliteDatabase a(vfs, kj::Path({"a"}), mode, observerA);
+  SqliteDatabase b(vfs, kj::Path({"b"}), mode);
+
+  // While `b` is idle, `a` can use the whole budget, but no more.
+  fill(a);
+  KJ_EXPECT(a.getPageCacheBytes() > BUDGET / 2 + SLACK, a.getPageCacheBytes());
+  KJ_EXPECT(a.getPageCacheBytes() <= BUDGET + SLACK, a.getPageCacheBytes());
+
+  // Once `b` is busy too, `a`, having gone cold, is evicted down to its fair share, and `b`
+  // stops there too rather than evicting `a` further.
+  fill(b);
+  KJ_EXPECT(a.getPageCacheBytes() <= BUDGET / 2 + SLACK, a.getPageCacheBytes());
+  KJ_EXPECT(b.getPageCacheBytes() <= BUDGET / 2 + SLACK, b.getPageCacheBytes());
+  KJ_EXPECT(a.getPageCacheBytes() + b.getPageCacheBytes() > BUDGET / 2);
+
+  // Scanning `a` again misses on the pages that were evicted, and hits on the rest.
+  observerA.hits = 0;
+  observerA.misses = 0;
+  scan(a);
+  KJ_EXPECT(observerA.misses > 0);
+  KJ_EXPECT(observerA.hits > 0);
+}
+
+KJ_TEST("SQLite page cache honors per-database limits") {
+  auto dir = kj::newInMemoryDirectory(kj::nullClock());
+  SqliteDatabase::Vfs vfs(*dir);
+  SqliteDatabase db(vfs, kj::Path({"db"}), kj::WriteMode::CREATE | kj::WriteMode::MODIFY);
+
+  db.setPageCacheLimit(64 * 1024);
+  fill(db);
+  scan(db);
+  KJ_EXPECT(db.getPageCacheBytes() <= 64 * 1024 + SLACK, db.getPageCacheBytes());
+
+  // Removing the limit lets the cache grow again.
+  db.setPageCacheLimit(kj::none);
+  scan(db);
+  KJ_EXPECT(db.getPageCacheBytes() > 64 * 1024 + SLACK, db.getPageCacheBytes());
+}
+
+}  // namespace
+}  // namespace workerd
@@ -0,0 +1,532 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "sqlite-page-cache.h"
+
+#include <kj/debug.h>
+#include <kj/list.h>
+#include <kj/map.h>
+#include <kj/mutex.h>
+#include <kj/time.h>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace workerd {
+
+namespace {
+
+static thread_local kj::Maybe<SqlitePageCache::Owner&> currentOwner;
+
+}  // namespace
+
+// One page, allocated together with its buffer and SQLite's per-page extra space.
+//
+// `base` must be the first member, and the struct standard-layout, since SQLite hands pointers to
+// `base` back to us.
+struct SqlitePageCache::Page {
+  sqlite3_pcache_page base;
+  Cache* cache;
+  unsigned key;
+  bool pinned;
+
+  // Link in `cache->state.lru` while unpinned.
+  kj::ListLink<Page> lruLink;
+
+  static Page& from(sqlite3_pcache_page* base) {
+    return *reinterpret_cast<Page*>(base);
+  }
+};
+
+// One `sqlite3_pcache`. SQLite creates one of these for each database file a connection opens.
+struct SqlitePageCache::Cache {
+  Cache(uint pageSize, uint extraSize, bool purgeable, kj::Maybe<Owner&> owner)
+      : pageSize(pageSize),
+        extraSize(extraSize),
+        purgeable(purgeable),
+        footprint(sizeof(Page) + pageSize + extraSize),
+        owner(owner) {}
+
+  const uint pageSize;
+  const uint extraSize;
+  const bool purgeable;
+
+  // Memory used by each page, including our own bookkeeping.
+  const uint64_t footprint;
+
+  // The cache's pages. Cache hits and unpins only need this lock, so that databases which fit in
+  // their share of the budget don't contend with each other. Pages are only added or removed
+  // with the arena's lock held as well, and eviction takes this lock for each cache it shrinks.
+  struct State {
+    kj::HashMap<unsigned, Page*> pages;
+
+    // Unpinned pages, least recently used first.
+    kj::List<Page, &Page::lruLink> lru;
+  };
+  kj::MutexGuarded<State> state;
+
+  // The remaining members are protected by the arena's lock, unless noted otherwise.
+
+  // The suggested maximum number of pages, set by SQLite from the `cache_size` pragma. Zero means
+  // no suggestion.
+  uint maxPages = 0;
+
+  // Number of entries in `state.pages`, so that the arena can account for the cache without
+  // taking its lock.
+  uint pageCount = 0;
+
+  // None if the cache was created outside of any OwnerScope, or its owner was destroyed first.
+  // Only changed with both locks held, so either one suffices to read it.
+  kj::Maybe<Owner&> owner;
+
+  // Link in `Arena::caches`, if purgeable.
+  kj::ListLink<Cache> arenaLink;
+
+  // When the cache was last fetched from, in nanoseconds on the coarse monotonic clock. Updated
+  // without any lock, and used to evict from the coldest caches first.
+  std::atomic<int64_t> lastUsed = 0;
+
+  // Whether the cache was over its limits or the budget when the arena last looked. While set,
+  // unpin() takes the arena's lock to check whether to free the page instead of keeping it.
+  // Written with the arena's lock held, read without it.
+  std::atomic<bool> overLimits = false;
+
+  uint64_t cachedBytes() const {
+    return pageCount * footprint;
+  }
+
+  void touch() {
+    auto now = kj::systemCoarseMonotonicClock().now() - kj::origin<kj::TimePoint>();
+    lastUsed.store(now / kj::NANOSECONDS, std::memory_order_relaxed);
+  }
+
+  sqlite3_pcache* asSqlite() {
+    return reinterpret_cast<sqlite3_pcache*>(this);
+  }
+  static Cache& from(sqlite3_pcache* pcache) {
+    return *reinterpret_cast<Cache*>(pcache);
+  }
+};
+
+// State shared by all caches, protected by a single lock. SQLite serializes calls for any one
+// cache, but eviction touches other caches, so every method that may add or remove pages takes
+// the lock. Taking a cache's own lock while holding this one is allowed, but not the reverse.
+struct SqlitePageCache::Arena {
+  uint64_t budget = 128u << 20;
+
+  // Memory used by all purgeable caches.
+  uint64_t cachedBytes = 0;
+
+  // Purgeable caches, in no particular order.
+  kj::List<Cache, &Cache::arenaLink> caches;
+  uint cacheCount = 0;
+
+  static kj::MutexGuarded<Arena>& get() {
+    // Intentionally leaked, since caches may outlive static destructors.
+    static kj::MutexGuarded<Arena>& instance = *new kj::MutexGuarded<Arena>();
+    return instance;
+  }
+
+  uint64_t fairShare() const {
+    return budget / kj::max(cacheCount, 1u);
+  }
+
+  // Would `cache` exceed its own limits if it grew by `extraPages`? These are the `cache_size`
+  // suggested by SQLite and the owner's limit, if any.
+  bool isOverLimit(Cache& cache, uint extraPages) const {
+    if (cache.maxPages > 0 && cache.pageCount + extraPages > cache.maxPages) {
+      return true;
+    }
+    KJ_IF_SOME(owner, cache.owner) {
+      KJ_IF_SOME(limit, owner.limit) {
+        if (owner.cachedBytes + extraPages * cache.footprint > limit) return true;
+      }
+    }
+    return false;
+  }
+
+  // Would growing `cache` by `extraPages` exceed the budget while `cache` is over its fair share?
+  bool isOverBudget(Cache& cache, uint extraPages) const {
+    auto extraBytes = extraPages * cache.footprint;
+    return cachedBytes + extraBytes > budget && cache.cachedBytes() + extraBytes > fairShare();
+  }
+
+  // Records whether unpin() should consider freeing `cache`'s pages.
+  void updateOverLimits(Cache& cache) {
+    cache.overLimits.store(cache.purgeable && (isOverLimit(cache, 0) || isOverBudget(cache, 0)),
+        std::memory_order_relaxed);
+  }
+
+  void accountAdded(Cache& cache) {
+    ++cache.pageCount;
+    if (cache.purgeable) {
+      cachedBytes += cache.footprint;
+      KJ_IF_SOME(owner, cache.owner) {
+        owner.cachedBytes += cache.footprint;
+      }
+    }
+  }
+
+  void accountRemoved(Cache& cache) {
+    --cache.pageCount;
+    if (cache.purgeable) {
+      cachedBytes -= cache.footprint;
+      KJ_IF_SOME(owner, cache.owner) {
+        owner.cachedBytes -= cache.footprint;
+      }
+    }
+  }
+
+  kj::Maybe<Page&> allocatePage(Cache& cache, Cache::State& state, unsigned key) {
+    void* memory = sqlite3_malloc64(cache.footprint);
+    if (memory == nullptr) return kj::none;
+
+    auto buffer = reinterpret_cast<kj::byte*>(memory) + sizeof(Page);
+    auto page = new (memory) Page{
+      .base = {.pBuf = buffer, .pExtra = buffer + cache.pageSize},
+      .cache = &cache,
+      .key = key,
+      .pinned = true,
+    };
+    // SQLite expects the extra space of a new page to start out zeroed.
+    memset(page->base.pExtra, 0, cache.extraSize);
+
+    state.pages.insert(key, page);
+    accountAdded(cache);
+    return *page;
+  }
+
+  void freePage(Cache::State& state, Page& page) {
+    auto& cache = *page.cache;
+    if (!page.pinned) state.lru.remove(page);
+    state.pages.erase(page.key);
+    accountRemoved(cache);
+    page.~Page();
+    sqlite3_free(&page);
+  }
+
+  // Takes the cache's least recently used unpinned page and reassigns it to `key`, avoiding a
+  // round trip through the allocator.
+  kj::Maybe<Page&> recyclePage(Cache& cache, Cache::State& state, unsigned key) {
+    if (state.lru.empty()) return kj::none;
+    auto& page = *state.lru.begin();
+    state.lru.remove(page);
+    state.pages.erase(page.key);
+    page.key = key;
+    page.pinned = true;
+    memset(page.base.pExtra, 0, cache.extraSize);
+    state.pages.insert(key, &page);
+    return page;
+  }
+
+  // Evicts unpinned pages from caches other than `requester` which are over their fair share,
+  // coldest first, until one more page for `requester` fits within the budget or nothing is left
+  // to evict.
+  void makeRoom(Cache& requester) {
+    auto bytes = requester.footprint;
+    if (cachedBytes + bytes <= budget) return;
+
+    auto share = fairShare();
+    kj::Vector<Cache*> victims;
+    for (auto& victim: caches) {
+      if (&victim != &requester && victim.cachedBytes() > share) victims.add(&victim);
+    }
+    std::sort(victims.begin(), victims.end(), [](Cache* a, Cache* b) {
+      return a->lastUsed.load(std::memory_order_relaxed) <
+          b->lastUsed.load(std::memory_order_relaxed);
+    });
+
+    for (auto victim: victims) {
+      auto state = victim->state.lockExclusive();
+      while (victim->cachedBytes() > share && !state->lru.empty() &&
+          cachedBytes + bytes > budget) {
+        freePage(*state, *state->lru.begin());
+      }
+      if (cachedBytes + bytes <= budget) return;
+    }
+  }
+};
+
+SqlitePageCache::Owner::~Owner() noexcept(false) {
+  // Caches normally go away when the database is closed, but a database closed with
+  // sqlite3_close_v2() may linger. Detach from any that remain.
+  auto lock = Arena::get().lockExclusive();
+  for (auto cache: caches) {
+    auto state = cache->state.lockExclusive();
+    cache->owner = kj::none;
+  }
+}
+
+void SqlitePageCache::Owner::setLimit(kj::Maybe<uint64_t> bytes) {
+  auto lock = Arena::get().lockExclusive();
+  limit = bytes;
+  for (auto cache: caches) {
+    lock->updateOverLimits(*cache);
+  }
+}
+
+uint64_t SqlitePageCache::Owner::getCachedBytes() {
+  auto lock = Arena::get().lockExclusive();
+  return cachedBytes;
+}
+
+SqlitePageCache::Stats SqlitePageCache::Owner::takeStats() {
+  return {
+    .hits = hits.exchange(0, std::memory_order_relaxed),
+    .misses = misses.exchange(0, std::memory_order_relaxed),
+  };
+}
+
+SqlitePageCache::OwnerScope::OwnerScope(Owner& owner): previous(currentOwner) {
+  currentOwner = owner;
+}
+
+SqlitePageCache::OwnerScope::~OwnerScope() noexcept(false) {
+  currentOwner = previous;
+}
+
+// Implementations of the sqlite3_pcache_methods2 callbacks.
+struct SqlitePageCache::Methods {
+  static int init(void*) {
+    return SQLITE_OK;
+  }
+
+  static void shutdown(void*) {}
+
+  static sqlite3_pcache* create(int pageSize, int extraSize, int purgeable) {
+    auto lock = Arena::get().lockExclusive();
+    auto cache = new Cache(pageSize, extraSize, purgeable, currentOwner);
+    if (cache->purgeable) {
+      lock->caches.add(*cache);
+      ++lock->cacheCount;
+    }
+    KJ_IF_SOME(owner, cache->owner) {
+      owner.caches.add(cache);
+    }
+    return cache->asSqlite();
+  }
+
+  static void cachesize(sqlite3_pcache* pcache, int maxPages) {
+    auto lock = Arena::get().lockExclusive();
+    auto& cache = Cache::from(pcache);
+    auto state = cache.state.lockExclusive();
+    cache.maxPages = kj::max(maxPages, 0);
+    while (cache.maxPages > 0 && cache.pageCount > cache.maxPages && !state->lru.empty()) {
+      lock->freePage(*state, *state->lru.begin());
+    }
+    lock->updateOverLimits(cache);
+  }
+
+  static int pagecount(sqlite3_pcache* pcache) {
+    return Cache::from(pcache).state.lockExclusive()->pages.size();
+  }
+
+  // `createFlag` is 0 to only look up the page, 1 to allocate it if that's easy, and 2 to
+  // allocate it unless memory is exhausted. SQLite follows a failed attempt at 1 by spilling dirty
+  // pages and then trying again with 2.
+  static sqlite3_pcache_page* fetch(sqlite3_pcache* pcache, unsigned key, int createFlag) {
+    auto& cache = Cache::from(pcache);
+    cache.touch();
+
+    {
+      auto state = cache.state.lockExclusive();
+      KJ_IF_SOME(page, state->pages.find(key)) {
+        if (!page->pinned) {
+          state->lru.remove(*page);
+          page->pinned = true;
+        }
+        if (createFlag != 0) countHit(cache);
+        return &page->base;
+      }
+    }
+
+    if (createFlag == 0) return nullptr;
+
+    // A miss. SQLite serializes calls for this cache, so the page can't appear while we switch to
+    // the arena's lock; eviction only ever removes pages.
+    auto lock = Arena::get().lockExclusive();
+    auto& arena = *lock;
+    auto state = cache.state.lockExclusive();
+    KJ_DEFER(arena.updateOverLimits(cache));
+
+    // Don't count the retry after a failed first attempt as a second miss.
+    if (createFlag == 1 || !cache.purgeable) countMiss(cache);
+
+    if (cache.purgeable) {
+      if (arena.isOverLimit(cache, 1)) {
+        KJ_IF_SOME(page, arena.recyclePage(cache, *state, key)) {
+          return &page.base;
+        }
+        if (createFlag == 1) return nullptr;
+      } else {
+        arena.makeRoom(cache);
+        if (arena.isOverBudget(cache, 1)) {
+          KJ_IF_SOME(page, arena.recyclePage(cache, *state, key)) {
+            return &page.base;
+          }
+          if (createFlag == 1) return nullptr;
+        }
+      }
+    }
+
+    KJ_IF_SOME(page, arena.allocatePage(cache, *state, key)) {
+      return &page.base;
+    }
+
+    // Out of memory. As a last resort, reuse one of our own pages.
+    KJ_IF_SOME(page, arena.recyclePage(cache, *state, key)) {
+      return &page.base;
+    }
+    return nullptr;
+  }
+
+  static void unpin(sqlite3_pcache* pcache, sqlite3_pcache_page* base, int discard) {
+    auto& cache = Cache::from(pcache);
+    auto& page = Page::from(base);
+
+    if (!discard && !cache.overLimits.load(std::memory_order_relaxed)) {
+      auto state = cache.state.lockExclusive();
+      page.pinned = false;
+      state->lru.add(page);
+      return;
+    }
+
+    auto lock = Arena::get().lockExclusive();
+    auto& arena = *lock;
+    auto state = cache.state.lockExclusive();
+
+    // Free the page right away if it was allocated beyond our limits under pressure.
+    if (discard ||
+        (cache.purgeable && (arena.isOverLimit(cache, 0) || arena.isOverBudget(cache, 0)))) {
+      arena.freePage(*state, page);
+    } else {
+      page.pinned = false;
+      state->lru.add(page);
+    }
+    arena.updateOverLimits(cache);
+  }
+
+  static void rekey(
+      sqlite3_pcache* pcache, sqlite3_pcache_page* base, unsigned oldKey, unsigned newKey) {
+    auto lock = Arena::get().lockExclusive();
+    auto& cache = Cache::from(pcache);
+    auto state = cache.state.lockExclusive();
+    auto& page = Page::from(base);
+
+    // Any page already at `newKey` is guaranteed to be unpinned, and must be discarded.
+    KJ_IF_SOME(existing, state->pages.find(newKey)) {
+      lock->freePage(*state, *existing);
+    }
+
+    state->pages.erase(oldKey);
+    page.key = newKey;
+    state->pages.insert(newKey, &page);
+  }
+
+  // Discards all pages with keys at or above `limit`, pinned or not.
+  static void truncate(sqlite3_pcache* pcache, unsigned limit) {
+    auto lock = Arena::get().lockExclusive();
+    auto& cache = Cache::from(pcache);
+    auto state = cache.state.lockExclusive();
+
+    kj::Vector<Page*> doomed;
+    for (auto& entry: state->pages) {
+      if (entry.key >= limit) doomed.add(entry.value);
+    }
+    for (auto page: doomed) {
+      lock->freePage(*state, *page);
+    }
+    lock->updateOverLimits(cache);
+  }
+
+  static void destroy(sqlite3_pcache* pcache) {
+    auto lock = Arena::get().lockExclusive();
+    auto& cache = Cache::from(pcache);
+
+    {
+      auto state = cache.state.lockExclusive();
+      kj::Vector<Page*> doomed(state->pages.size());
+      for (auto& entry: state->pages) {
+        doomed.add(entry.value);
+      }
+      for (auto page: doomed) {
+        lock->freePage(*state, *page);
+      }
+    }
+
+    if (cache.purgeable) {
+      lock->caches.remove(cache);
+      --lock->cacheCount;
+    }
+    KJ_IF_SOME(owner, cache.owner) {
+      for (auto i: kj::indices(owner.caches)) {
+        if (owner.caches[i] == &cache) {
+          owner.caches.removeAt(i);
+          break;
+        }
+      }
+    }
+    delete &cache;
+  }
+
+  static void shrink(sqlite3_pcache* pcache) {
+    auto lock = Arena::get().lockExclusive();
+    auto& cache = Cache::from(pcache);
+    auto state = cache.state.lockExclusive();
+    while (!state->lru.empty()) {
+      lock->freePage(*state, *state->lru.begin());
+    }
+    lock->updateOverLimits(cache);
+  }
+
+  static void countHit(Cache& cache) {
+    KJ_IF_SOME(owner, cache.owner) {
+      owner.hits.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  static void countMiss(Cache& cache) {
+    KJ_IF_SOME(owner, cache.owner) {
+      owner.misses.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+};
+
+void SqlitePageCache::install() {
+  static bool doOnce KJ_UNUSED = []() {
+    static const sqlite3_pcache_methods2 methods = {
+      .iVersion = 1,
+      .pArg = nullptr,
+      .xInit = &Methods::init,
+      .xShutdown = &Methods::shutdown,
+      .xCreate = &Methods::create,
+      .xCachesize = &Methods::cachesize,
+      .xPagecount = &Methods::pagecount,
+      .xFetch = &Methods::fetch,
+      .xUnpin = &Methods::unpin,
+      .xRekey = &Methods::rekey,
+      .xTruncate = &Methods::truncate,
+      .xDestroy = &Methods::destroy,
+      .xShrink = &Methods::shrink,
+    };
+    int err = sqlite3_config(SQLITE_CONFIG_PCACHE2, &methods);
+    if (err != SQLITE_OK) {
+      KJ_LOG(WARNING, "couldn't install SQLite page cache; SQLite was already initialized",
+          sqlite3_errstr(err));
+    }
+    return false;
+  }();
+}
+
+void SqlitePageCache::setBudget(uint64_t bytes) {
+  auto lock = Arena::get().lockExclusive();
+  lock->budget = bytes;
+  for (auto& cache: lock->caches) {
+    lock->updateOverLimits(cache);
+  }
+}
+
+}  // namespace workerd
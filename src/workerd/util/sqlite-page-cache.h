@@ -0,0 +1,103 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#pragma once
+
+#include <kj/common.h>
+#include <kj/vector.h>
+
+#include <atomic>
+
+namespace workerd {
+
+using kj::uint;
+
+// A page cache implementation for SQLite (see `sqlite3_pcache_methods2`) which shares a single
+// memory budget across all databases open in the process.
+//
+// SQLite's built-in page cache only bounds each connection individually (via `cache_size`), so
+// with thousands of databases open the only process-wide control is the heap limit, which any one
+// busy database can use up. Instead, this cache divides the budget fairly: each open database is
+// entitled to an equal share, but may use more while others don't need it. When the budget is
+// exhausted, pages are evicted from databases that are over their share, least recently used
+// database first, so cold databases give up their pages before hot ones.
+//
+// Caches for non-purgeable databases (in-memory and some temporary databases), whose pages can't
+// be evicted without losing data, are not subject to the budget.
+//
+// SqliteDatabase installs this automatically; application code normally only needs
+// SqliteDatabase::setPageCacheBudget() and SqliteDatabase::setPageCacheLimit().
+class SqlitePageCache {
+ public:
+  class Owner;
+  class OwnerScope;
+
+  // Installs the page cache into SQLite. This must happen before SQLite is initialized, which
+  // happens implicitly the first time most SQLite functions are called; SqliteDatabase::Vfs calls
+  // this before touching SQLite. Later calls do nothing. If SQLite was already initialized, logs
+  // a warning and leaves SQLite's default page cache in place.
+  static void install();
+
+  // Sets the total memory, in bytes, that all purgeable caches in the process may use together.
+  // Defaults to 128MiB.
+  static void setBudget(uint64_t bytes);
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+  };
+
+ private:
+  struct Cache;
+  struct Page;
+  struct Arena;
+  struct Methods;
+};
+
+// Groups the caches which SQLite creates for one database connection, so that they can be
+// limited and observed together. Each SqliteDatabase has one.
+class SqlitePageCache::Owner {
+ public:
+  Owner() = default;
+  ~Owner() noexcept(false);
+  KJ_DISALLOW_COPY_AND_MOVE(Owner);
+
+  // Limits the memory that this owner's caches may use, in addition to the fair share of the
+  // global budget. kj::none removes the limit.
+  void setLimit(kj::Maybe<uint64_t> bytes);
+
+  // Returns the memory currently used by this owner's purgeable caches.
+  uint64_t getCachedBytes();
+
+  // Returns the number of page cache hits and misses since the last call.
+  Stats takeStats();
+
+ private:
+  // The remaining members are protected by the arena's lock, except for the counters.
+  kj::Maybe<uint64_t> limit;
+  uint64_t cachedBytes = 0;
+  kj::Vector<Cache*> caches;
+
+  std::atomic<uint64_t> hits = 0;
+  std::atomic<uint64_t> misses = 0;
+
+  friend struct SqlitePageCache::Arena;
+  friend struct SqlitePageCache::Methods;
+};
+
+// While in scope, caches that SQLite creates on the current thread are attributed to `owner`.
+// SQLite doesn't tell the page cache which connection a cache belongs to, so SqliteDatabase
+// places one of these around every call that might create a cache: opening the database,
+// preparing statements and stepping them.
+class SqlitePageCache::OwnerScope {
+ public:
+  explicit OwnerScope(Owner& owner);
+  ~OwnerScope() noexcept(false);
+  KJ_DISALLOW_COPY_AND_MOVE(OwnerScope);
+
+ private:
+  kj::Maybe<Owner&> previous;
+};
+
+}  // namespace workerd
@@ -475,6 +475,7 @@ SqliteDatabase::SqliteDatabase(const Vfs& vfs,
 
 void SqliteDatabase::init(kj::Maybe<kj::WriteMode> maybeMode) {
   KJ_ASSERT(maybeDb == kj::none);
+  SqlitePageCache::OwnerScope pageCacheScope(pageCacheOwner);
   sqlite3* db = nullptr;
 
   KJ_IF_SOME(mode, maybeMode) {
@@ -665,6 +666,7 @@ SqliteDatabase::StatementAndEffect SqliteDatabase::prepareSql(const Regulator& r
     Multi multi,
     kj::Maybe<kj::Vector<Statement>&> prelude) {
   sqlite3* db = &KJ_ASSERT_NONNULL(maybeDb, "previous reset() failed");
+  SqlitePageCache::OwnerScope pageCacheScope(pageCacheOwner);
 
   ParseContext parseContext;
   KJ_ASSERT(currentParseContext == kj::none, "recursive prepareSql()?");
@@ -1264,14 +1266,11 @@ void SqliteDatabase::setupSecurity(sqlite3* db) {
   // This happens inside LimitEnforcer.
 
   // 5. Limit heap size.
-  // Annoyingly, this sets a process-wide limit. We'll set 128MB "soft" limit (to try to control
-  // how much page caching SQLite does) and 512MB "hard" limit (to block DoS attacks from taking
-  // down the whole system).
-  // TODO(perf): Revisit as popularity grows. Maybe make configurable? Maybe patch SQLite to allow
-  //   these to be controlled per-database? Is page caching even all that important when the kernel
-  //   does its own page caching?
+  // Annoyingly, this sets a process-wide limit. We'll set a 512MB "hard" limit (to block DoS
+  // attacks from taking down the whole system). Page caching, which is what most of SQLite's
+  // memory goes to, is instead controlled by SqlitePageCache's budget, which is divided fairly
+  // across databases (see setPageCacheBudget()).
   static bool doOnce KJ_UNUSED = []() {
-    sqlite3_soft_heap_limit64(128u << 20);
     sqlite3_hard_heap_limit64(512u << 20);
     return false;
   }();
@@ -1288,6 +1287,10 @@ void SqliteDatabase::setupSecurity(sqlite3* db) {
   // (handled in BUILD.sqlite3)
 }
 
+void SqliteDatabase::setPageCacheBudget(uint64_t bytes) {
+  SqlitePageCache::setBudget(bytes);
+}
+
 SqliteDatabase::Statement SqliteDatabase::prepare(
     const Regulator& regulator, kj::StringPtr sqlCode) {
   return Statement(
@@ -1355,6 +1358,11 @@ void SqliteDatabase::Query::destroy() {
     db.sqliteObserver.addQueryStats(rowsRead, rowsWritten);
   }
 
+  auto pageCacheStats = db.pageCacheOwner.takeStats();
+  if (pageCacheStats.hits > 0 || pageCacheStats.misses > 0) {
+    db.sqliteObserver.addPageCacheStats(pageCacheStats.hits, pageCacheStats.misses);
+  }
+
   queryEvent.setQueryEventStats(rowsRead, rowsWritten, !(regulator.shouldAddQueryStats()));
 
   try {
@@ -1488,6 +1496,9 @@ void SqliteDatabase::Query::nextRow(bool first) {
   KJ_DEFER(db.currentRegulator = kj::none);
   db.currentRegulator = regulator;
 
+  // Stepping may open a temporary database, creating a new page cache.
+  SqlitePageCache::OwnerScope pageCacheScope(db.pageCacheOwner);
+
   SQLITE_CALL_SCOPE {
     int err = sqlite3_step(statement);
     queryEvent.setQueryResult(err);
@@ -2467,12 +2478,19 @@ class SqliteDatabase::Vfs::DefaultLockManager final: public SqliteDatabase::Lock
   };
 };
 
+// Looks up SQLite's default VFS, which SQLite initializes itself to provide. Our page cache has
+// to be installed before that happens.
+static sqlite3_vfs& findNativeVfs() {
+  SqlitePageCache::install();
+  return *sqlite3_vfs_find(nullptr);
+}
+
 SqliteDatabase::Vfs::Vfs(const kj::Directory& directory, Options options)
     : directory(directory),
       ownLockManager(kj::heap<DefaultLockManager>()),
       lockManager(*ownLockManager),
       options(kj::mv(options)),
-      native(*sqlite3_vfs_find(nullptr)) {
+      native(findNativeVfs()) {
 #if _WIN32
   vfs = kj::heap(makeKjVfs());
 #else
@@ -2491,7 +2509,7 @@ SqliteDatabase::Vfs::Vfs(
     : directory(directory),
       lockManager(lockManager),
       options(kj::mv(options)),
-      native(*sqlite3_vfs_find(nullptr)),
+      native(findNativeVfs()),
       // Always use KJ VFS when using a custom LockManager.
       vfs(kj::heap(makeKjVfs())) {
   sqlite3_vfs_register(vfs, false);
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <workerd/util/account-limits.h>
+#include <workerd/util/sqlite-page-cache.h>
 
 #include <kj/filesystem.h>
 #include <kj/function.h>
@@ -38,6 +39,8 @@ class SqliteObserver {
     return monotonicClock.now();
   }
   virtual void addQueryStats(uint64_t rowsRead, uint64_t rowsWritten) {}
+  // Page cache hits and misses since the last report, reported after each query.
+  virtual void addPageCacheStats(uint64_t hits, uint64_t misses) {}
   // The method is not used by the SqliteDatabase, it is added here for convenience
   virtual void setSqliteStoredBytes(uint64_t sqliteStoredBytes) {}
 
@@ -241,6 +244,22 @@ class SqliteDatabase {
   // may throw if they depend on tables that haven't been recreated yet).
   void reset();
 
+  // Sets the total memory that all databases in the process may use to cache pages. Each open
+  // database is entitled to an equal share, but may use more while others don't need it. See
+  // SqlitePageCache for details. Defaults to 128MiB.
+  static void setPageCacheBudget(uint64_t bytes);
+
+  // Limits the memory this database may use to cache pages, regardless of how much of the
+  // process-wide budget is available. kj::none (the default) removes the limit.
+  void setPageCacheLimit(kj::Maybe<uint64_t> bytes) {
+    pageCacheOwner.setLimit(bytes);
+  }
+
+  // Returns the memory currently used to cache this database's pages.
+  uint64_t getPageCacheBytes() {
+    return pageCacheOwner.getCachedBytes();
+  }
+
   // Objects that need to be notified when reset() is called may inherit `ResetListener`.
   class ResetListener {
    public:
@@ -304,6 +323,9 @@ class SqliteDatabase {
   SqliteObserver& sqliteObserver;
   kj::Maybe<const ActorAccountLimits&> actorAccountLimits;
 
+  // Caches that SQLite creates for this database are attributed to this owner.
+  SqlitePageCache::Owner pageCacheOwner;
+
   // This pointer can be left null if a call to reset() failed to re-open the database.
   kj::Maybe<sqlite3&> maybeDb;
 
@@ -0,0 +1,109 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "stdio-log-sink.h"
+
+#include <kj/io.h>
+#include <kj/test.h>
+
+#if !_WIN32
+#include <unistd.h>
+
+namespace workerd {
+namespace {
+
+struct Pipe {
+  kj::AutoCloseFd in;
+  kj::AutoCloseFd out;
+};
+
+Pipe makePipe() {
+  int fds[2];
+  KJ_SYSCALL(pipe(fds));
+  return {kj::AutoCloseFd(fds[0]), kj::AutoCloseFd(fds[1])};
+}
+
+KJ_TEST("StdioLogSink writes lines in order across file descriptors") {
+  auto a = makePipe();
+  auto b = makePipe();
+  {
+    StdioLogSink sink;
+    KJ_EXPECT(&KJ_ASSERT_NONNULL(StdioLogSink::current()) == &sink);
+
+    for (auto i: kj::zeroTo(100)) {
+      sink.write(i % 3 == 0 ? b.out.get() : a.out.get(), kj::str(i, '\n'));
+    }
+    sink.flush();
+  }
+  KJ_EXPECT(StdioLogSink::current() == kj::none);
+
+  a.out = nullptr;
+  b.out = nullptr;
+  auto aText = kj::FdInputStream(kj::mv(a.in)).readAllText();
+  auto bText = kj::FdInputStream(kj::mv(b.in)).readAllText();
+
+  kj::Vector<kj::String> expectedA, expectedB;
+  for (auto i: kj::zeroTo(100)) {
+    (i % 3 == 0 ? expectedB : expectedA).add(kj::str(i, '\n'));
+  }
+  KJ_EXPECT(aText == kj::strArray(expectedA, ""));
+  KJ_EXPECT(bText == kj::strArray(expectedB, ""));
+}
+
+KJ_TEST("StdioLogSink drops lines when full if asked to") {
+  auto pipe = makePipe();
+  kj::String text;
+  {
+    StdioLogSink sink(
+        {.maxBufferedBytes = 10, .overflowPolicy = StdioLogSink::OverflowPolicy::DROP});
+
+    // Nobody is reading the pipe yet, so the writer thread gets stuck on this line, which is
+    // bigger than any pipe buffer. (It's let through despite exceeding maxBufferedBytes because
+    // the queue is empty.)
+    auto big = kj::heapString(1 << 20);
+    big.asArray().fill('x');
+    big[big.size() - 1] = '\n';
+    sink.write(pipe.out.get(), kj::mv(big));
+
+    // While the writer is stuck, at most one of these fits in the queue.
+    for (auto i: kj::zeroTo(3)) {
+      sink.write(pipe.out.get(), kj::str("line", i, '\n'));
+    }
+
+    kj::Thread reader([&]() { text = kj::FdInputStream(kj::mv(pipe.in)).readAllText(); });
+    sink.flush();
+    sink.write(pipe.out.get(), kj::str("end\n"));
+    sink.flush();
+    pipe.out = nullptr;
+  }
+
+  KJ_EXPECT(text.size() > 1 << 20);
+  auto tail = text.slice(1 << 20);
+  KJ_EXPECT(tail.endsWith(" log lines dropped]\nend\n"), tail);
+}
+
+KJ_TEST("StdioLogSink::LogCallback sends log messages through the sink") {
+  auto pipe = makePipe();
+  kj::AutoCloseFd savedStderr(dup(STDERR_FILENO));
+  KJ_SYSCALL(dup2(pipe.out, STDERR_FILENO));
+  {
+    KJ_DEFER(dup2(savedStderr, STDERR_FILENO));
+    StdioLogSink sink;
+    StdioLogSink::LogCallback callback;
+
+    sink.write(stderr, kj::str("before\n"));
+    KJ_LOG(WARNING, "logged through the sink");
+    sink.write(stderr, kj::str("after\n"));
+  }
+  pipe.out = nullptr;
+
+  auto text = kj::FdInputStream(kj::mv(pipe.in)).readAllText();
+  KJ_EXPECT(text.startsWith("before\n"), text);
+  KJ_EXPECT(text.contains("warning: logged through the sink\n"), text);
+  KJ_EXPECT(text.endsWith("after\n"), text);
+}
+
+}  // namespace
+}  // namespace workerd
+#endif  // !_WIN32
@@ -0,0 +1,140 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#include "stdio-log-sink.h"
+
+#include <kj/debug.h>
+#include <kj/io.h>
+
+namespace workerd {
+
+namespace {
+StdioLogSink* currentSink = nullptr;
+}  // namespace
+
+StdioLogSink::StdioLogSink(Options options)
+    : options(options) {
+  KJ_REQUIRE(currentSink == nullptr, "only one StdioLogSink may exist at a time");
+  thread = kj::heap<kj::Thread>([this]() { run(); });
+  currentSink = this;
+}
+
+StdioLogSink::~StdioLogSink() noexcept(false) {
+  currentSink = nullptr;
+  state.lockExclusive()->shuttingDown = true;
+  // Destroying `thread` joins the writer, which exits once the queue is empty.
+}
+
+kj::Maybe<StdioLogSink&> StdioLogSink::current() {
+  return currentSink;
+}
+
+void StdioLogSink::write(int fd, kj::String text) {
+  auto lock = state.lockExclusive();
+
+  if (lock->queuedBytes > 0 && lock->queuedBytes + text.size() > options.maxBufferedBytes) {
+    switch (options.overflowPolicy) {
+      case OverflowPolicy::BLOCK:
+        // A line larger than the whole buffer is let through once the queue is empty, so that it
+        // can't block forever.
+        lock.wait([&](const State& s) {
+          return s.queuedBytes == 0 || s.queuedBytes + text.size() <= options.maxBufferedBytes;
+        });
+        break;
+      case OverflowPolicy::DROP:
+        ++lock->droppedCount;
+        return;
+    }
+  }
+
+  if (lock->droppedCount > 0) {
+    auto note = kj::str("[", lock->droppedCount, " log lines dropped]\n");
+    lock->queuedBytes += note.size();
+    lock->queue.add(Entry{fd, kj::mv(note)});
+    lock->droppedCount = 0;
+  }
+
+  lock->queuedBytes += text.size();
+  lock->queue.add(Entry{fd, kj::mv(text)});
+}
+
+void StdioLogSink::write(FILE* stream, kj::String text) {
+#if _WIN32
+  write(_fileno(stream), kj::mv(text));
+#else
+  write(fileno(stream), kj::mv(text));
+#endif
+}
+
+void StdioLogSink::flush() {
+  state.lockExclusive().wait([](const State& s) { return s.queue.empty() && !s.writing; });
+}
+
+void StdioLogSink::run() {
+  for (;;) {
+    kj::Vector<Entry> batch;
+    {
+      auto lock = state.lockExclusive();
+      lock->writing = false;
+      lock.wait([](const State& s) { return !s.queue.empty() || s.shuttingDown; });
+      if (lock->queue.empty()) {
+        return;
+      }
+      batch = kj::mv(lock->queue);
+      lock->queuedBytes = 0;
+      lock->writing = true;
+    }
+
+    writeBatch(batch);
+  }
+}
+
+void StdioLogSink::writeBatch(kj::ArrayPtr<Entry> batch) {
+  kj::Vector<kj::ArrayPtr<const kj::byte>> pieces(batch.size());
+
+  while (batch.size() > 0) {
+    // Write each run of consecutive lines for the same fd with one writev().
+    int fd = batch[0].fd;
+    size_t n = 1;
+    while (n < batch.size() && batch[n].fd == fd) ++n;
+
+    pieces.clear();
+    for (auto& entry: batch.first(n)) {
+      pieces.add(entry.text.asBytes());
+    }
+
+    // There's nowhere to report a failure except stdio itself, which is likely what failed. Like
+    // fprintf(), just carry on.
+    (void)kj::runCatchingExceptions([&]() { kj::FdOutputStream(fd).write(pieces); });
+
+    batch = batch.slice(n);
+  }
+}
+
+void StdioLogSink::LogCallback::logMessage(
+    kj::LogSeverity severity, const char* file, int line, int contextDepth, kj::String&& text) {
+  KJ_IF_SOME(sink, current()) {
+    // The same format kj uses when writing to stderr itself.
+    sink.write(stderr,
+        kj::str(kj::repeat('_', contextDepth), file, ":", line, ": ", severity, ": ", text, '\n'));
+  } else {
+    next.logMessage(severity, file, line, contextDepth, kj::mv(text));
+  }
+}
+
+kj::Function<void(kj::Function<void()>)> StdioLogSink::LogCallback::getThreadInitializer() {
+  auto nextInit = next.getThreadInitializer();
+
+  return [nextInit = kj::mv(nextInit)](kj::Function<void()> func) mutable {
+    nextInit([&]() {
+      LogCallback callback;
+
+      // Make sure func is destroyed before the callback is destroyed.
+      auto ownFunc = kj::mv(func);
+      ownFunc();
+    });
+  };
+}
+
+}  // namespace workerd
@@ -0,0 +1,105 @@
+// Copyright (c) 2025 Cloudflare, Inc.
+// Licensed under the Apache 2.0 license found in the LICENSE file or at:
+//     https://opensource.org/licenses/Apache-2.0
+
+#pragma once
+
+#include <kj/exception.h>
+#include <kj/mutex.h>
+#include <kj/string.h>
+#include <kj/thread.h>
+#include <kj/vector.h>
+
+#include <cstdio>
+
+namespace workerd {
+
+// Writes log lines to stdout/stderr from a dedicated thread, so that the thread producing them
+// (typically while holding an isolate lock for console.log()) doesn't stall when the reader of
+// the pipe is slow. Lines queued together are written with a single gathering write.
+//
+// Lines are written in the order they were queued, even across file descriptors.
+//
+// Only one StdioLogSink may exist at a time. While it exists, `current()` returns it; code that
+// would otherwise write to stdio directly should check for it. Since lines still in the queue are
+// lost if the process ends abruptly, call `flush()` before exiting without unwinding.
+class StdioLogSink {
+ public:
+  class LogCallback;
+
+  enum class OverflowPolicy {
+    // The writer waits for the queue to drain. No output is lost.
+    BLOCK,
+    // The line is discarded. A note saying how many lines were dropped is written once the queue
+    // has room again.
+    DROP,
+  };
+
+  struct Options {
+    // Maximum number of bytes that may be queued but not yet written.
+    size_t maxBufferedBytes = 1u << 20;
+
+    OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK;
+  };
+
+  explicit StdioLogSink(Options options);
+  StdioLogSink(): StdioLogSink(Options()) {}
+
+  // Waits for all queued lines to be written.
+  ~StdioLogSink() noexcept(false);
+
+  KJ_DISALLOW_COPY_AND_MOVE(StdioLogSink);
+
+  static kj::Maybe<StdioLogSink&> current();
+
+  // Queue `text` to be written to `fd`. `text` should include any trailing newline.
+  void write(int fd, kj::String text);
+
+  // Queue `text` to be written to the file descriptor underlying `stream`, typically stdout or
+  // stderr. Anything already buffered in `stream` itself is not flushed first.
+  void write(FILE* stream, kj::String text);
+
+  // Blocks until everything queued so far has been written.
+  void flush();
+
+ private:
+  struct Entry {
+    int fd;
+    kj::String text;
+  };
+
+  struct State {
+    kj::Vector<Entry> queue;
+    size_t queuedBytes = 0;
+    size_t droppedCount = 0;
+
+    // True while the writer thread is writing out a batch it took from `queue`.
+    bool writing = false;
+    bool shuttingDown = false;
+  };
+
+  Options options;
+  kj::MutexGuarded<State> state;
+
+  // Declared last so that the thread is joined before the state it uses is destroyed.
+  kj::Own<kj::Thread> thread;
+
+  void run();
+  static void writeBatch(kj::ArrayPtr<Entry> batch);
+};
+
+// Sends KJ_LOG() output, which kj otherwise writes straight to stderr, through the current
+// StdioLogSink, if any, so that it stays in order with console output. Construct it after the
+// sink, so that the sink's own thread doesn't log through it.
+class StdioLogSink::LogCallback final: public kj::ExceptionCallback {
+ public:
+  void logMessage(kj::LogSeverity severity,
+      const char* file,
+      int line,
+      int contextDepth,
+      kj::String&& text) override;
+
+  kj::Function<void(kj::Function<void()>)> getThreadInitializer() override;
+};
+
+}  // namespace workerd